@@ -0,0 +1,162 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+// Spectral purity check of the waveform generator, run by 'make check'.
+// Each case renders one channel through a WaveGenerator and takes the power
+// spectrum of CHECK_FFT_SIZE frames. The frequency is moved to the nearest
+// odd FFT bin, so that the record holds a whole number of periods and needs
+// no window: every harmonic falls on a bin of its own, and so does every
+// alias of a harmonic above the Nyquist frequency. The strongest bin that
+// is neither DC nor a harmonic below the Nyquist frequency is reported
+// relative to the fundamental; the check fails if it exceeds the limit of
+// its case. The amplitude leaves room for the overshoot of band-limited
+// waveforms, which would otherwise clip.
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include <complex>
+#include <vector>
+#include <memory>
+#include <iostream>
+
+#include "wavex-engine_generator.h"
+
+#define CHECK_SAMPLE_RATE 48000
+#define CHECK_FFT_BITS 16
+#define CHECK_FFT_SIZE (1 << CHECK_FFT_BITS)
+#define CHECK_AMPLITUDE 16000.0
+
+struct SpectrumCase {
+	const char*	name;
+	unsigned int	waveform;
+	bool		band_limited;
+	double		frequency;
+	double		limit_dbc;
+};
+
+// In-place radix-2 FFT of CHECK_FFT_SIZE points.
+static void wXs_check_fft(std::vector< std::complex<double> > & x)
+{
+	size_t n = x.size();
+	for (size_t i = 1, j = 0; i < n; i++) {
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if (i < j)
+			std::swap(x[i], x[j]);
+	}
+	for (size_t length = 2; length <= n; length <<= 1) {
+		std::complex<double> w_length = std::polar(1.0, -2.0 * M_PI / (double) length);
+		for (size_t i = 0; i < n; i += length) {
+			std::complex<double> w = 1.0;
+			for (size_t k = 0; k < length / 2; k++) {
+				std::complex<double> u = x[i + k];
+				std::complex<double> v = x[i + k + length / 2] * w;
+				x[i + k] = u + v;
+				x[i + k + length / 2] = u - v;
+				w *= w_length;
+			}
+		}
+	}
+	return;
+}
+
+// Nearest frequency to the given one lying on an odd FFT bin.
+static double wXs_check_frequency(double frequency)
+{
+	double bin_width = (double) CHECK_SAMPLE_RATE / (double) CHECK_FFT_SIZE;
+	long k = 2 * lround(0.5 * (frequency / bin_width - 1.0)) + 1;
+	return k * bin_width;
+}
+
+// Renders the case and returns the level of its worst spur in dBc.
+static double wXs_check_worst_spur(const SpectrumCase & test)
+{
+	double frequency = wXs_check_frequency(test.frequency);
+	GeneratorSettings settings;
+	for (int c = 0; c < GENERATOR_CHANNELS; c++) {
+		OscillatorSettings & s = settings.channels[c];
+		s.enabled = (c == 0);
+		s.band_limited = test.band_limited;
+		s.waveform = test.waveform;
+		s.frequency = frequency;
+		s.amplitude = CHECK_AMPLITUDE;
+		s.delay = 0.0;
+		s.ramp_time = 0.0;
+		s.seed = 1;
+		wXs_parse_sweep("off", CHECK_SAMPLE_RATE, &s.sweep);
+		wXs_parse_modulation("off", CHECK_SAMPLE_RATE, &s.modulation);
+	}
+	std::shared_ptr<WaveformFile> files[GENERATOR_CHANNELS];
+	WaveGenerator generator(CHECK_SAMPLE_RATE);
+	std::vector<int16_t> frames(GENERATOR_CHANNELS * CHECK_FFT_SIZE);
+	generator.render(settings, files, frames.data(), CHECK_FFT_SIZE);
+
+	std::vector< std::complex<double> > x(CHECK_FFT_SIZE);
+	for (size_t j = 0; j < CHECK_FFT_SIZE; j++)
+		x[j] = frames[GENERATOR_CHANNELS * j];
+	wXs_check_fft(x);
+
+	size_t nr_bins = CHECK_FFT_SIZE / 2;
+	size_t fundamental = lround(frequency * CHECK_FFT_SIZE / CHECK_SAMPLE_RATE);
+	std::vector<bool> expected(nr_bins, false);
+	for (size_t k = 0; k < nr_bins; k += fundamental)
+		expected[k] = true;
+	double worst = 0.0;
+	for (size_t k = 0; k < nr_bins; k++) {
+		if (!expected[k] && (std::norm(x[k]) > worst))
+			worst = std::norm(x[k]);
+	}
+	return 10.0 * log10((worst + 1e-300) / std::norm(x[fundamental]));
+}
+
+int main()
+{
+	const SpectrumCase cases[] = {
+		{"sine", SINE, true, 1000.3, -110.0},
+		{"sine", SINE, true, 19997.1, -110.0},
+		{"band-limited square", SQUARE, true, 440.7, -100.0},
+		{"band-limited square", SQUARE, true, 5003.9, -100.0},
+		{"band-limited square", SQUARE, true, 9001.7, -100.0},
+		{"band-limited square", SQUARE, true, 15007.3, -100.0},
+		{"band-limited triangle", TRIANGULAR, true, 440.7, -100.0},
+		{"band-limited triangle", TRIANGULAR, true, 7001.9, -100.0},
+		{"band-limited triangle", TRIANGULAR, true, 17003.3, -100.0}
+	};
+	unsigned int nr_failed = 0;
+	for (const SpectrumCase & test : cases) {
+		double spur = wXs_check_worst_spur(test);
+		bool passed = (spur < test.limit_dbc);
+		printf("%-24s %9.1f Hz: worst spur %7.1f dBc, limit %6.1f dBc ... %s\n", test.name, wXs_check_frequency(test.frequency), spur, test.limit_dbc, passed? "ok" : "FAILED");
+		if (!passed)
+			nr_failed++;
+	}
+	if (nr_failed > 0) {
+		std::cerr << nr_failed << " spectral purity check(s) failed.\n";
+		return 1;
+	}
+	return 0;
+}
@@ -35,19 +35,15 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/un.h>
-#include <alsa/asoundlib.h>
 
 #define BUF_SIZE 441
 #define CHN_SIZE 2
-#define SAMPLING_RATE 44100
 
 #ifndef INCLUDED_MAINAPP
 	#include "wavex-console_main.hpp"
 	#define INCLUDED_MAINAPP
 #endif
 
-int wXs_hardware_setup_playback(snd_pcm_t*, snd_pcm_hw_params_t*, unsigned int*);
-
 void GuiFrame::onWorkerStart()
 {
 	wxThread	*thread = new WorkerThread(this);
@@ -58,8 +54,8 @@ void GuiFrame::onWorkerStart()
 		thread->Delete();
 		return;
 	}
-	thread->Run();
 	thread_is_running = true;
+	thread->Run();
 }
 
 WorkerThread::WorkerThread (GuiFrame *frame)
@@ -71,163 +67,80 @@ WorkerThread::WorkerThread (GuiFrame *frame)
 
 void WorkerThread::OnExit () {}
 
+// The worker thread generates the waveform ahead of time, one buffer at a
+// time, as long as the playback ring is below the target latency; the
+// device itself is fed by the playback thread.
 wxThread::ExitCode WorkerThread::Entry ()
 {
-	snd_pcm_t *device_handle;
-	snd_pcm_hw_params_t *device_parameters;
+	PlaybackDevice playback;
 	unsigned int sample_rate = SAMPLING_RATE;
 
-	if (snd_pcm_open(&device_handle, "default", SND_PCM_STREAM_PLAYBACK, 0) < 0) {
-		std::cerr <<  "Could not open audio device <default>\n",
-		exit(1);
+	// A device that cannot be opened is reported from the GUI thread, and
+	// the console goes back to the stopped state.
+	if (!playback.open(PLAYBACK_DEFAULT_DEVICE, &sample_rate, CHN_SIZE, this->wave_parameters->latency_ms, BUF_SIZE)) {
+		wxString message = wxString::Format("Runtime error:\ncannot open playback device (%s).", snd_strerror(playback.openError()));
+		parent_frame->CallAfter([message] {
+			wxMessageBox(message, "Error", wxOK | wxICON_ERROR, NULL, wxDefaultCoord, wxDefaultCoord);
+		});
+		parent_frame->thread_is_running = false;
+		parent_frame->thread_shall_be_cancelled = false;
+		return (wxThread::ExitCode) 1;
 	}
-	wXs_hardware_setup_playback(device_handle, device_parameters, &sample_rate);
 
 	int16_t* buf = (int16_t *) malloc(sizeof(int16_t) * BUF_SIZE * CHN_SIZE);
-	double t = 0.0, dt = 1.0 / sample_rate;
-	double f, A, d, y, triang_sign;
-	int n = 0;
-	long int nr_written, nr_available, nr_rewinded;
-	clock_t old_clk, new_clk;
-	double timer_ms = 0.0;
-	old_clk = clock();
+	WaveGenerator generator(sample_rate);
+	std::shared_ptr<WaveformFile> files[CHN_SIZE];
+	GeneratorSettings settings;
+	useconds_t idle_us = (useconds_t) (500000.0 * playback.periodFrames() / sample_rate);
 	while (true) {
-		bzero(buf, BUF_SIZE * CHN_SIZE * sizeof(int16_t));
-		for (int i = 0; i < BUF_SIZE * CHN_SIZE; i = i + 2) {
-			if (this->wave_parameters->output_1) {
-				f = this->wave_parameters->f1;
-				A = this->wave_parameters->A1 / this->wave_parameters->y1_vps;
-				d = this->wave_parameters->delay1;
-				y = sin(8.0*atan(1.0)*f*(t-d));
-				switch(this->wave_parameters->waveshape_1) {
-					case 0 :
-						buf[i] = (int16_t) floor(A * y);
-						break;
-					case 1 :
-						triang_sign = (((int) floor(2.0*(t-d)*f + 0.5)) % 2 == 0)? 1.0 : -1.0;
-						buf[i] = (int16_t) floor(A * 4.0 * f * ((t-d) - 1.0/(2.0*f) * floor(2.0*(t-d)*f + 0.5)) * triang_sign);
-						break;
-					case 2 :
-						buf[i] = (int16_t) (y > 0)? floor(A) : ((y < 0)? floor(-A) : 0.0);
-						break;
-					default :
-						buf[i] = (int16_t) 0;
-						break;
-				}
-			} else {
-				buf[i] = (int16_t) 0;
-			}
-			if (this->wave_parameters->output_2) {
-				f = this->wave_parameters->f2;
-				A = this->wave_parameters->A2 / this->wave_parameters->y2_vps;
-				d = this->wave_parameters->delay2;
-				y = sin(8.0*atan(1.0)*f*(t-d));
-				switch(this->wave_parameters->waveshape_2) {
-					case 0 :
-						buf[i+1] = (int16_t) floor(A * y);
-						break;
-					case 1 :
-						triang_sign = (((int) floor(2.0*(t-d)*f + 0.5)) % 2 == 0)? 1.0 : -1.0;
-						buf[i+1] = (int16_t) floor(A * 4.0 * f * ((t-d) - 1.0/(2.0*f) * floor(2.0*(t-d)*f + 0.5)) * triang_sign);
-						break;
-					case 2 :
-						buf[i+1] = (int16_t) (y > 0)? floor(A) : ((y < 0)? floor(-A) : 0.0);
-						break;
-					default :
-						buf[i+1] = (int16_t) 0;
-						break;
-				}
-			} else {
-				buf[i+1] = (int16_t) 0;
-			}
-			t += dt;
-		}
-		if (t > 30.0)
-			t = 0.0;
-
-		nr_written = snd_pcm_writei(device_handle, buf, BUF_SIZE);
-		if (nr_written == -EPIPE) {
-			free(buf);
-			snd_pcm_close(device_handle);
-			snd_pcm_hw_params_free(device_parameters);
-			usleep(10000);
-			parent_frame->thread_is_running = false;
-			parent_frame->onWorkerStart();
-			return (wxThread::ExitCode) 1;
+		if (playback.roomFrames() > 0) {
+			// The parameters are read once per buffer.
+			this->wave_parameters->settings.read(settings);
+			if (this->wave_parameters->align_phases.exchange(false))
+				generator.align();
+			files[0] = std::atomic_load(&this->wave_parameters->file_1);
+			files[1] = std::atomic_load(&this->wave_parameters->file_2);
+			generator.render(settings, files, buf, BUF_SIZE);
+			playback.write(buf, BUF_SIZE);
+		} else {
+			playback.start();
+			usleep(idle_us);
 		}
 
-		if (this->wave_parameters->changed) {
-			std::cerr.flush();
-			usleep(10000);
-			snd_pcm_drop(device_handle);
-			snd_pcm_close(device_handle);
-			usleep(10000);
-			if (snd_pcm_open(&device_handle, "default", SND_PCM_STREAM_PLAYBACK, 0) < 0) {
-				std::cerr <<  "Could not open audio device <default>\n",
-				exit(1);
-			}
-			wXs_hardware_setup_playback(device_handle, device_parameters, &sample_rate);
-			usleep(10000);
-			this->wave_parameters->changed = false;
-		}
-
-		if (parent_frame->thread_shall_be_cancelled || TestDestroy()) {
-			free(buf);
-			snd_pcm_close(device_handle);
-			snd_pcm_hw_params_free(device_parameters);
-			parent_frame->thread_is_running = false;
-			parent_frame->thread_shall_be_cancelled = false;
-			return (wxThread::ExitCode) 0;
-		}
-
-		n++;
+		if (parent_frame->thread_shall_be_cancelled || TestDestroy())
+			break;
 	}
 
+	playback.close();
 	free(buf);
-	snd_pcm_close(device_handle);
-	snd_pcm_hw_params_free(device_parameters);
 	parent_frame->thread_is_running = false;
 	parent_frame->thread_shall_be_cancelled = false;
 	return (wxThread::ExitCode) 0;
 }
 
-
-int wXs_hardware_setup_playback(snd_pcm_t* device_handle, snd_pcm_hw_params_t* device_parameters, unsigned int* sample_rate)
+// Amplitudes are converted from volts to sample units through the
+// calibration of each channel.
+void wXs_oscillator_settings(const ParametersWorkspace* parameters, OscillatorSettings* settings)
 {
-	int err;
-
-	if (snd_pcm_hw_params_malloc(&device_parameters) < 0) {
-		std::cerr <<  "Could not allocate hardware parameter structure\n";
-		exit(1);
-	}
-	if ((err = snd_pcm_hw_params_any(device_handle, device_parameters)) < 0) {
-		std::cerr <<  "Cannot initialize hardware parameter structure\n";
-		exit(1);
-	}
-	if ((err = snd_pcm_hw_params_set_access(device_handle, device_parameters, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0) {
-		std::cerr <<  "Cannot set access type\n";
-		exit(1);
-	}
-	if ((err = snd_pcm_hw_params_set_format(device_handle, device_parameters, SND_PCM_FORMAT_S16_LE)) < 0) {
-		std::cerr <<  "Cannot set sample format\n";
-		exit(1);
-	}
-	if ((err = snd_pcm_hw_params_set_rate_near(device_handle, device_parameters, sample_rate, 0)) < 0) {
-		std::cerr <<  "Cannot set sample rate\n";
-		exit(1);
-	}
-	if ((err = snd_pcm_hw_params_set_channels(device_handle, device_parameters, 2)) < 0) {
-		std::cerr <<  "Cannot set channel count\n";
-		exit(1);
-	}
-	if ((err = snd_pcm_hw_params(device_handle, device_parameters)) < 0) {
-		std::cerr <<  "Cannot set parameters\n";
-		exit(1);
-	}
-	if ((err = snd_pcm_prepare(device_handle)) < 0) {
-		std::cerr <<  "Cannot prepare audio interface for use\n";
-		exit(1);
-	}
-
-	return 0;
+	settings[0].enabled = parameters->output_1;
+	settings[0].band_limited = parameters->band_limited_1;
+	settings[0].waveform = parameters->waveshape_1;
+	settings[0].frequency = parameters->f1;
+	settings[0].amplitude = parameters->A1 / parameters->y1_vps;
+	settings[0].delay = parameters->delay1;
+	settings[0].ramp_time = 0.001 * parameters->ramp_ms;
+	settings[0].seed = parameters->noise_seed;
+	settings[0].sweep = parameters->sweep_1;
+	settings[0].modulation = parameters->modulation_1;
+	settings[1].enabled = parameters->output_2;
+	settings[1].band_limited = parameters->band_limited_2;
+	settings[1].waveform = parameters->waveshape_2;
+	settings[1].frequency = parameters->f2;
+	settings[1].amplitude = parameters->A2 / parameters->y2_vps;
+	settings[1].delay = parameters->delay2;
+	settings[1].ramp_time = 0.001 * parameters->ramp_ms;
+	settings[1].seed = parameters->noise_seed;
+	settings[1].sweep = parameters->sweep_2;
+	settings[1].modulation = parameters->modulation_2;
+	return;
 }
@@ -64,6 +64,9 @@ GuiFrame::GuiFrame (const wxString& title)
 	m_list_waveforms.Add(wxT("Sinusoidal"));
 	m_list_waveforms.Add(wxT("Triangular"));
 	m_list_waveforms.Add(wxT("Square"));
+	m_list_waveforms.Add(wxT("Arbitrary"));
+	m_list_waveforms.Add(wxT("White noise"));
+	m_list_waveforms.Add(wxT("Pink noise"));
 	radiobox_waveshape_1 = new wxRadioBox(this, EVENT_CHOSEN_WAVESHAPE_1, wxT("Waveform"), wxDefaultPosition, wxDefaultSize, m_list_waveforms, 0, wxRA_SPECIFY_ROWS);
 	Connect(EVENT_CHOSEN_WAVESHAPE_1, wxEVT_RADIOBOX, wxCommandEventHandler(GuiFrame::changedParameters));
 	radiobox_waveshape_2 = new wxRadioBox(this, EVENT_CHOSEN_WAVESHAPE_2, wxT("Waveform"), wxDefaultPosition, wxDefaultSize, m_list_waveforms, 0, wxRA_SPECIFY_ROWS);
@@ -80,12 +83,23 @@ GuiFrame::GuiFrame (const wxString& title)
 	statictext_title_d1 = new wxStaticText(this, wxID_ANY, wxT("Delay (s)"), wxDefaultPosition, wxDefaultSize, 0);
 	checkbox_output_1 = new wxCheckBox(this, EVENT_TOGGLE_OUTPUT_1, wxT("Output on"), wxDefaultPosition, wxDefaultSize, wxCHK_2STATE);
 	Connect(EVENT_TOGGLE_OUTPUT_1, wxEVT_CHECKBOX, wxCommandEventHandler(GuiFrame::changedParameters));
+	checkbox_band_limited_1 = new wxCheckBox(this, EVENT_TOGGLE_BAND_LIMITED_1, wxT("Band-limited"), wxDefaultPosition, wxDefaultSize, wxCHK_2STATE);
+	Connect(EVENT_TOGGLE_BAND_LIMITED_1, wxEVT_CHECKBOX, wxCommandEventHandler(GuiFrame::changedParameters));
 	staticline_calibr_ch1 = new wxStaticLine(this, wxID_ANY, wxDefaultPosition, wxSize(-1,1));
 	statictext_title_calibration_ch1 = new wxStaticText(this, wxID_ANY, "Calibration:", wxDefaultPosition, wxDefaultSize);
 	statictext_title_calibration_ch1->SetFont(font_bold);
 	statictext_calibration_ch1 = new wxStaticText(this, wxID_ANY, "No calibration", wxDefaultPosition, wxDefaultSize, wxST_NO_AUTORESIZE);
 	button_calibrate_ch1 = new wxButton(this, EVENT_CALIBRATION_CH1, "Set", wxDefaultPosition, wxDefaultSize);
 	Connect(EVENT_CALIBRATION_CH1, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::changedCalibrationCh1));
+	statictext_file_1 = new wxStaticText(this, wxID_ANY, "No file", wxDefaultPosition, wxSize(160,-1), wxST_NO_AUTORESIZE | wxST_ELLIPSIZE_MIDDLE);
+	button_file_1 = new wxButton(this, EVENT_BUTTON_FILE_1, "File...", wxDefaultPosition, wxDefaultSize);
+	Connect(EVENT_BUTTON_FILE_1, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::chosenFileCh1));
+	statictext_sweep_1 = new wxStaticText(this, wxID_ANY, "No sweep", wxDefaultPosition, wxSize(160,-1), wxST_NO_AUTORESIZE | wxST_ELLIPSIZE_END);
+	button_sweep_1 = new wxButton(this, EVENT_BUTTON_SWEEP_1, "Sweep...", wxDefaultPosition, wxDefaultSize);
+	Connect(EVENT_BUTTON_SWEEP_1, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::chosenSweepCh1));
+	statictext_modulation_1 = new wxStaticText(this, wxID_ANY, "No modulation", wxDefaultPosition, wxSize(160,-1), wxST_NO_AUTORESIZE | wxST_ELLIPSIZE_END);
+	button_modulation_1 = new wxButton(this, EVENT_BUTTON_MODULATION_1, "Modulation...", wxDefaultPosition, wxDefaultSize);
+	Connect(EVENT_BUTTON_MODULATION_1, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::chosenModulationCh1));
 
 	spinner_f2 = new wxSpinCtrlDouble(this, EVENT_SPINNER_F_2, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_VERTICAL, 0.1, 22000.0, 100.0);
 	Connect(EVENT_SPINNER_F_2, wxEVT_SPINCTRLDOUBLE, wxCommandEventHandler(GuiFrame::changedParameters));
@@ -98,12 +112,23 @@ GuiFrame::GuiFrame (const wxString& title)
 	statictext_title_d2 = new wxStaticText(this, wxID_ANY, wxT("Delay (s)"), wxDefaultPosition, wxDefaultSize, 0);
 	checkbox_output_2 = new wxCheckBox(this, EVENT_TOGGLE_OUTPUT_2, wxT("Output on"), wxDefaultPosition, wxDefaultSize, wxCHK_2STATE);
 	Connect(EVENT_TOGGLE_OUTPUT_2, wxEVT_CHECKBOX, wxCommandEventHandler(GuiFrame::changedParameters));
+	checkbox_band_limited_2 = new wxCheckBox(this, EVENT_TOGGLE_BAND_LIMITED_2, wxT("Band-limited"), wxDefaultPosition, wxDefaultSize, wxCHK_2STATE);
+	Connect(EVENT_TOGGLE_BAND_LIMITED_2, wxEVT_CHECKBOX, wxCommandEventHandler(GuiFrame::changedParameters));
 	staticline_calibr_ch2 = new wxStaticLine(this, wxID_ANY, wxDefaultPosition, wxSize(-1,1));
 	statictext_title_calibration_ch2 = new wxStaticText(this, wxID_ANY, "Calibration:", wxDefaultPosition, wxDefaultSize);
 	statictext_title_calibration_ch2->SetFont(font_bold);
 	statictext_calibration_ch2 = new wxStaticText(this, wxID_ANY, "No calibration", wxDefaultPosition, wxDefaultSize, wxST_NO_AUTORESIZE);
 	button_calibrate_ch2 = new wxButton(this, EVENT_CALIBRATION_CH2, "Set", wxDefaultPosition, wxDefaultSize);
 	Connect(EVENT_CALIBRATION_CH2, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::changedCalibrationCh2));
+	statictext_file_2 = new wxStaticText(this, wxID_ANY, "No file", wxDefaultPosition, wxSize(160,-1), wxST_NO_AUTORESIZE | wxST_ELLIPSIZE_MIDDLE);
+	button_file_2 = new wxButton(this, EVENT_BUTTON_FILE_2, "File...", wxDefaultPosition, wxDefaultSize);
+	Connect(EVENT_BUTTON_FILE_2, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::chosenFileCh2));
+	statictext_sweep_2 = new wxStaticText(this, wxID_ANY, "No sweep", wxDefaultPosition, wxSize(160,-1), wxST_NO_AUTORESIZE | wxST_ELLIPSIZE_END);
+	button_sweep_2 = new wxButton(this, EVENT_BUTTON_SWEEP_2, "Sweep...", wxDefaultPosition, wxDefaultSize);
+	Connect(EVENT_BUTTON_SWEEP_2, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::chosenSweepCh2));
+	statictext_modulation_2 = new wxStaticText(this, wxID_ANY, "No modulation", wxDefaultPosition, wxSize(160,-1), wxST_NO_AUTORESIZE | wxST_ELLIPSIZE_END);
+	button_modulation_2 = new wxButton(this, EVENT_BUTTON_MODULATION_2, "Modulation...", wxDefaultPosition, wxDefaultSize);
+	Connect(EVENT_BUTTON_MODULATION_2, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::chosenModulationCh2));
 
 	spinner_f1->SetDigits(2);
 	spinner_f1->SetIncrement(0.01);
@@ -119,6 +144,21 @@ GuiFrame::GuiFrame (const wxString& title)
 	staticline_title_misc = new wxStaticLine(this, wxID_ANY, wxDefaultPosition, wxSize(-1,1));
 	button_run = new wxButton(this, EVENT_BUTTON_RUN, wxT("Run"), wxDefaultPosition,  wxSize(100,50));
 	Connect(EVENT_BUTTON_RUN, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::runStopButton));
+	button_align_phases = new wxButton(this, EVENT_BUTTON_ALIGN, wxT("Align phases"), wxDefaultPosition,  wxSize(120,50));
+	Connect(EVENT_BUTTON_ALIGN, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::alignPhasesButton));
+	spinner_latency = new wxSpinCtrlDouble(this, EVENT_SPINNER_LATENCY, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_VERTICAL, PLAYBACK_MIN_LATENCY_MS, PLAYBACK_MAX_LATENCY_MS, PLAYBACK_DEFAULT_LATENCY_MS);
+	Connect(EVENT_SPINNER_LATENCY, wxEVT_SPINCTRLDOUBLE, wxCommandEventHandler(GuiFrame::changedParameters));
+	statictext_title_latency = new wxStaticText(this, wxID_ANY, wxT("Latency (ms)"), wxDefaultPosition, wxDefaultSize, 0);
+	spinner_latency->SetDigits(0);
+	spinner_latency->SetIncrement(1.0);
+	spinner_ramp = new wxSpinCtrlDouble(this, EVENT_SPINNER_RAMP, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_VERTICAL, 0.0, 1000.0, 0.0);
+	Connect(EVENT_SPINNER_RAMP, wxEVT_SPINCTRLDOUBLE, wxCommandEventHandler(GuiFrame::changedParameters));
+	statictext_title_ramp = new wxStaticText(this, wxID_ANY, wxT("Ramp (ms)"), wxDefaultPosition, wxDefaultSize, 0);
+	spinner_ramp->SetDigits(0);
+	spinner_ramp->SetIncrement(1.0);
+	spinner_seed = new wxSpinCtrl(this, EVENT_SPINNER_SEED, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 1, 999999, 1);
+	Connect(EVENT_SPINNER_SEED, wxEVT_SPINCTRL, wxCommandEventHandler(GuiFrame::changedParameters));
+	statictext_title_seed = new wxStaticText(this, wxID_ANY, wxT("Noise seed"), wxDefaultPosition, wxDefaultSize, 0);
 
 	wxBoxSizer *hbox_ch1_title = new wxBoxSizer(wxHORIZONTAL);
 	hbox_ch1_title->Add(statictext_title_1, 1, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
@@ -142,6 +182,15 @@ GuiFrame::GuiFrame (const wxString& title)
 	wxBoxSizer *hbox_ch1_calibr = new wxBoxSizer(wxHORIZONTAL);
 	hbox_ch1_calibr->Add(statictext_calibration_ch1, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 	hbox_ch1_calibr->Add(button_calibrate_ch1, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+	wxBoxSizer *hbox_ch1_file = new wxBoxSizer(wxHORIZONTAL);
+	hbox_ch1_file->Add(statictext_file_1, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+	hbox_ch1_file->Add(button_file_1, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+	wxBoxSizer *hbox_ch1_sweep = new wxBoxSizer(wxHORIZONTAL);
+	hbox_ch1_sweep->Add(statictext_sweep_1, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+	hbox_ch1_sweep->Add(button_sweep_1, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+	wxBoxSizer *hbox_ch1_modulation = new wxBoxSizer(wxHORIZONTAL);
+	hbox_ch1_modulation->Add(statictext_modulation_1, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+	hbox_ch1_modulation->Add(button_modulation_1, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 
 	wxBoxSizer *hbox_ch2_title = new wxBoxSizer(wxHORIZONTAL);
 	hbox_ch2_title->Add(statictext_title_2, 1, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
@@ -165,12 +214,25 @@ GuiFrame::GuiFrame (const wxString& title)
 	wxBoxSizer *hbox_ch2_calibr = new wxBoxSizer(wxHORIZONTAL);
 	hbox_ch2_calibr->Add(statictext_calibration_ch2, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 	hbox_ch2_calibr->Add(button_calibrate_ch2, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+	wxBoxSizer *hbox_ch2_file = new wxBoxSizer(wxHORIZONTAL);
+	hbox_ch2_file->Add(statictext_file_2, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+	hbox_ch2_file->Add(button_file_2, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+	wxBoxSizer *hbox_ch2_sweep = new wxBoxSizer(wxHORIZONTAL);
+	hbox_ch2_sweep->Add(statictext_sweep_2, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+	hbox_ch2_sweep->Add(button_sweep_2, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+	wxBoxSizer *hbox_ch2_modulation = new wxBoxSizer(wxHORIZONTAL);
+	hbox_ch2_modulation->Add(statictext_modulation_2, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+	hbox_ch2_modulation->Add(button_modulation_2, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 
 	wxBoxSizer *hbox_two_channels = new wxBoxSizer(wxHORIZONTAL);
 		wxBoxSizer *vbox_ch1_all = new wxBoxSizer(wxVERTICAL);
 		vbox_ch1_all->Add(hbox_ch1_title, 0, wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 		vbox_ch1_all->Add(hbox_ch1_controls_all, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 		vbox_ch1_all->Add(checkbox_output_1, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+		vbox_ch1_all->Add(checkbox_band_limited_1, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+		vbox_ch1_all->Add(hbox_ch1_file, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+		vbox_ch1_all->Add(hbox_ch1_sweep, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+		vbox_ch1_all->Add(hbox_ch1_modulation, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 		vbox_ch1_all->Add(staticline_calibr_ch1, 1, wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
 		vbox_ch1_all->Add(statictext_title_calibration_ch1, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
 		vbox_ch1_all->Add(hbox_ch1_calibr, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
@@ -178,6 +240,10 @@ GuiFrame::GuiFrame (const wxString& title)
 		vbox_ch2_all->Add(hbox_ch2_title, 0, wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 		vbox_ch2_all->Add(hbox_ch2_controls_all, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 		vbox_ch2_all->Add(checkbox_output_2, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+		vbox_ch2_all->Add(checkbox_band_limited_2, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+		vbox_ch2_all->Add(hbox_ch2_file, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+		vbox_ch2_all->Add(hbox_ch2_sweep, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+		vbox_ch2_all->Add(hbox_ch2_modulation, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 		vbox_ch2_all->Add(staticline_calibr_ch2, 1, wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
 		vbox_ch2_all->Add(statictext_title_calibration_ch2, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
 		vbox_ch2_all->Add(hbox_ch2_calibr, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
@@ -191,6 +257,13 @@ GuiFrame::GuiFrame (const wxString& title)
 		hbox_misc_title->Add(staticline_title_misc, 2, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
 		wxBoxSizer *hbox_misc_buttons = new wxBoxSizer(wxHORIZONTAL);
 		hbox_misc_buttons->Add(button_run, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
+		hbox_misc_buttons->Add(button_align_phases, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
+		hbox_misc_buttons->Add(statictext_title_latency, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
+		hbox_misc_buttons->Add(spinner_latency, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
+		hbox_misc_buttons->Add(statictext_title_ramp, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
+		hbox_misc_buttons->Add(spinner_ramp, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
+		hbox_misc_buttons->Add(statictext_title_seed, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
+		hbox_misc_buttons->Add(spinner_seed, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
 	vbox_misc_all->Add(hbox_misc_title, 0, wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 	vbox_misc_all->Add(hbox_misc_buttons, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 
@@ -200,8 +273,8 @@ GuiFrame::GuiFrame (const wxString& title)
 
 	this->SetSizer(vbox_all);
 	initializeConstants();
-	SetSize(1000,160,900,420);
-	SetMinSize(wxSize(900,420));
+	SetSize(1000,160,900,560);
+	SetMinSize(wxSize(900,560));
 	Show();
 }
 
@@ -214,6 +287,8 @@ void GuiFrame::changedParameters (wxCommandEvent& WXUNUSED(event))
 {
 	this->wave_parameters->output_1 = (this->checkbox_output_1->GetValue() == 1)? true : false;
 	this->wave_parameters->output_2 = (this->checkbox_output_2->GetValue() == 1)? true : false;
+	this->wave_parameters->band_limited_1 = (this->checkbox_band_limited_1->GetValue() == 1)? true : false;
+	this->wave_parameters->band_limited_2 = (this->checkbox_band_limited_2->GetValue() == 1)? true : false;
 
 	this->wave_parameters->waveshape_1 = this->radiobox_waveshape_1->GetSelection();
 	this->wave_parameters->waveshape_2 = this->radiobox_waveshape_2->GetSelection();
@@ -224,24 +299,48 @@ void GuiFrame::changedParameters (wxCommandEvent& WXUNUSED(event))
 	this->wave_parameters->A2 = this->spinner_A2->GetValue();
 	this->wave_parameters->delay1 = this->spinner_d1->GetValue();
 	this->wave_parameters->delay2 = this->spinner_d2->GetValue();
+	this->wave_parameters->latency_ms = this->spinner_latency->GetValue();
+	this->wave_parameters->ramp_ms = this->spinner_ramp->GetValue();
+	this->wave_parameters->noise_seed = this->spinner_seed->GetValue();
 
-	this->wave_parameters->changed = true;
+	this->publishParameters();
 
 	return;
 }
 
+// The worker thread picks the new settings up at its next buffer; the
+// output device is left untouched.
+void GuiFrame::publishParameters()
+{
+	GeneratorSettings	settings;
+	wXs_oscillator_settings(this->wave_parameters, settings.channels);
+	this->wave_parameters->settings.publish(settings);
+	return;
+}
+
 void GuiFrame::runStopButton(wxCommandEvent& WXUNUSED(event))
 {
 	if (thread_is_running) {
 		thread_shall_be_cancelled = true;
 		this->button_run->SetLabel("Run");
+		this->spinner_latency->Enable(true);
 	} else {
 		onWorkerStart();
 		this->button_run->SetLabel("Stop");
+		this->spinner_latency->Enable(false);
 	}
 	return;
 }
 
+// Frequency changes keep each channel phase continuous, so channels at the
+// same frequency may drift apart from the relation set by their delays;
+// aligning restores it.
+void GuiFrame::alignPhasesButton(wxCommandEvent& WXUNUSED(event))
+{
+	this->wave_parameters->align_phases = true;
+	return;
+}
+
 void GuiFrame::changedCalibrationCh1(wxCommandEvent& WXUNUSED(event))
 {
 	int user_value = (int) wxGetNumberFromUser("Insert calibration factor, i.e. an integer number corresponding to 1 Volt.", "[1,65535]", "Set calibration for Channel 1", 1, 1, 65535, this, wxDefaultPosition);
@@ -261,6 +360,8 @@ void GuiFrame::changedCalibrationCh1(wxCommandEvent& WXUNUSED(event))
 		this->statictext_calibration_ch1->Refresh();
 	}
 	this->updateA1range();
+	this->wave_parameters->A1 = this->spinner_A1->GetValue();
+	this->publishParameters();
 
 	free(display_label);
 	return;
@@ -285,11 +386,116 @@ void GuiFrame::changedCalibrationCh2(wxCommandEvent& WXUNUSED(event))
 		this->statictext_calibration_ch2->Refresh();
 	}
 	this->updateA2range();
+	this->wave_parameters->A2 = this->spinner_A2->GetValue();
+	this->publishParameters();
 
 	free(display_label);
 	return;
 }
 
+void GuiFrame::chosenFileCh1(wxCommandEvent& WXUNUSED(event))
+{
+	this->loadWaveformFile(&this->wave_parameters->file_1, this->statictext_file_1);
+	return;
+}
+
+void GuiFrame::chosenFileCh2(wxCommandEvent& WXUNUSED(event))
+{
+	this->loadWaveformFile(&this->wave_parameters->file_2, this->statictext_file_2);
+	return;
+}
+
+void GuiFrame::chosenSweepCh1(wxCommandEvent& WXUNUSED(event))
+{
+	if (this->editSweep(&this->wave_parameters->sweep_1, this->statictext_sweep_1, "Set sweep for Channel 1"))
+		this->publishParameters();
+	return;
+}
+
+void GuiFrame::chosenSweepCh2(wxCommandEvent& WXUNUSED(event))
+{
+	if (this->editSweep(&this->wave_parameters->sweep_2, this->statictext_sweep_2, "Set sweep for Channel 2"))
+		this->publishParameters();
+	return;
+}
+
+// The sweep is typed in the syntax of the generator daemon; it starts over
+// from its first step whenever it is changed or the phases are aligned.
+bool GuiFrame::editSweep(SweepSettings* sweep, wxStaticText* label, const char* caption)
+{
+	wxString text = wxGetTextFromUser("Sweep, one of:\n  off\n  linear <start Hz> <stop Hz> <steps> <dwell s> [once]\n  log <start Hz> <stop Hz> <steps> <dwell s> [once]\n  chirp <start Hz> <stop Hz> <duration s> [once]\n  burst <cycles> <gap cycles> [once]", caption, wXs_sweep_description(*sweep), this);
+	if (text.IsEmpty())
+		return false;
+
+	SweepSettings new_sweep;
+	if (!wXs_parse_sweep(std::string(text.mb_str()), SAMPLING_RATE, &new_sweep)) {
+		wxMessageBox("Invalid sweep.", "Error", wxOK | wxICON_ERROR, this, wxDefaultCoord, wxDefaultCoord);
+		return false;
+	}
+	*sweep = new_sweep;
+	label->SetLabel((sweep->mode == SWEEP_OFF)? "No sweep" : wXs_sweep_description(*sweep));
+	label->Refresh();
+	return true;
+}
+
+void GuiFrame::chosenModulationCh1(wxCommandEvent& WXUNUSED(event))
+{
+	if (this->editModulation(&this->wave_parameters->modulation_1, this->statictext_modulation_1, "Set modulation for Channel 1"))
+		this->publishParameters();
+	return;
+}
+
+void GuiFrame::chosenModulationCh2(wxCommandEvent& WXUNUSED(event))
+{
+	if (this->editModulation(&this->wave_parameters->modulation_2, this->statictext_modulation_2, "Set modulation for Channel 2"))
+		this->publishParameters();
+	return;
+}
+
+// Same syntax as the "modulation" command of the generator daemon. The
+// depth is the modulation index for AM, the peak deviation in Hz for FM
+// and in radians for PM.
+bool GuiFrame::editModulation(ModulationSettings* modulation, wxStaticText* label, const char* caption)
+{
+	wxString text = wxGetTextFromUser("Modulation, one of:\n  off\n  am|fm|pm <depth> sine|triangle|square <frequency Hz>\n  am|fm|pm <depth> noise <bandwidth Hz>\n  am|fm|pm <depth> channel\nDepth: index (AM), deviation in Hz (FM) or in rad (PM).", caption, wXs_modulation_description(*modulation), this);
+	if (text.IsEmpty())
+		return false;
+
+	ModulationSettings new_modulation;
+	if (!wXs_parse_modulation(std::string(text.mb_str()), SAMPLING_RATE, &new_modulation)) {
+		wxMessageBox("Invalid modulation.", "Error", wxOK | wxICON_ERROR, this, wxDefaultCoord, wxDefaultCoord);
+		return false;
+	}
+	*modulation = new_modulation;
+	label->SetLabel((modulation->type == MODULATION_OFF)? "No modulation" : wXs_modulation_description(*modulation));
+	label->Refresh();
+	return true;
+}
+
+// The file is only mapped, so that even a huge one is ready at once; the
+// worker thread switches to it at its next buffer.
+bool GuiFrame::loadWaveformFile(std::shared_ptr<WaveformFile>* target, wxStaticText* label)
+{
+	wxFileDialog dialog(this, "Choose waveform file", "", "", "Waveform files (*.wav;*.raw;*.s16;*.f32)|*.wav;*.WAV;*.raw;*.s16;*.f32|All files (*)|*", wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+	if (dialog.ShowModal() != wxID_OK)
+		return false;
+
+	std::shared_ptr<WaveformFile> file = std::make_shared<WaveformFile>();
+	if (!file->open(std::string(dialog.GetPath().mb_str()))) {
+		wxMessageBox("Cannot use this file:\nonly WAV files with 16-bit integer or 32-bit float samples,\nor raw int16 (.raw, .s16) and float32 (.f32) files are supported.", "Error", wxOK | wxICON_ERROR, this, wxDefaultCoord, wxDefaultCoord);
+		return false;
+	}
+	std::atomic_store(target, file);
+
+	char	*display_label = (char*) malloc(256 * sizeof(char));
+	snprintf(display_label, 256, "%s (%u Hz)", (const char*) wxFileName(dialog.GetPath()).GetFullName().mb_str(), file->rate());
+	label->SetLabel(display_label);
+	label->SetToolTip(dialog.GetPath());
+	label->Refresh();
+	free(display_label);
+	return true;
+}
+
 void GuiFrame::updateA1range()
 {
 	if (this->wave_parameters->y1_vps == 1.0) {
@@ -324,6 +530,8 @@ void GuiFrame::initializeConstants()
 {
 	this->wave_parameters->output_1 = false;
 	this->wave_parameters->output_2 = false;
+	this->wave_parameters->band_limited_1 = true;
+	this->wave_parameters->band_limited_2 = true;
 	this->wave_parameters->f1 = 100.0;
 	this->wave_parameters->f2 = 100.0;
 	this->wave_parameters->A1 = 1;
@@ -334,17 +542,27 @@ void GuiFrame::initializeConstants()
 	this->wave_parameters->waveshape_2 = 0;
 	this->wave_parameters->y1_vps = 1.0;
 	this->wave_parameters->y2_vps = 1.0;
+	this->wave_parameters->latency_ms = PLAYBACK_DEFAULT_LATENCY_MS;
+	this->wave_parameters->ramp_ms = 0.0;
+	this->wave_parameters->noise_seed = 1;
+	wXs_parse_sweep("off", SAMPLING_RATE, &this->wave_parameters->sweep_1);
+	wXs_parse_sweep("off", SAMPLING_RATE, &this->wave_parameters->sweep_2);
+	wXs_parse_modulation("off", SAMPLING_RATE, &this->wave_parameters->modulation_1);
+	wXs_parse_modulation("off", SAMPLING_RATE, &this->wave_parameters->modulation_2);
 
 	this->radiobox_waveshape_1->SetSelection(this->wave_parameters->waveshape_1);
 	this->radiobox_waveshape_2->SetSelection(this->wave_parameters->waveshape_2);
+	this->checkbox_band_limited_1->SetValue(this->wave_parameters->band_limited_1);
+	this->checkbox_band_limited_2->SetValue(this->wave_parameters->band_limited_2);
 
-	this->wave_parameters->changed = false;
+	this->wave_parameters->align_phases = false;
 
 	this->thread_is_running = false;
 	this->thread_shall_be_cancelled = false;
 
 	this->updateA1range();
 	this->updateA2range();
+	this->publishParameters();
 
 	return;
 }
@@ -49,6 +49,14 @@
 #include "wx/statline.h"
 #include "wx/spinctrl.h"
 #include "wx/aboutdlg.h"
+#include "wx/filedlg.h"
+#include "wx/filename.h"
+
+#include "wavex-engine_generator.h"
+#include "wavex-engine_playback.h"
+#include "wavex-engine_snapshot.h"
+
+#define SAMPLING_RATE 44100
 
 class MainApp;
 class GuiFrame;
@@ -73,13 +81,19 @@ enum
 	EVENT_BUTTON_RUN = wxID_HIGHEST + 12,
 	EVENT_WORKER_NEEDS_RESTART = wxID_HIGHEST + 13,
 	EVENT_CALIBRATION_CH1 = wxID_HIGHEST + 14,
-	EVENT_CALIBRATION_CH2 = wxID_HIGHEST + 15
-};
-
-enum Waveform : unsigned int {
-	SINE = 0,
-	TRIANGULAR = 1,
-	SQUARE = 2
+	EVENT_CALIBRATION_CH2 = wxID_HIGHEST + 15,
+	EVENT_BUTTON_ALIGN = wxID_HIGHEST + 16,
+	EVENT_TOGGLE_BAND_LIMITED_1 = wxID_HIGHEST + 17,
+	EVENT_TOGGLE_BAND_LIMITED_2 = wxID_HIGHEST + 18,
+	EVENT_SPINNER_LATENCY = wxID_HIGHEST + 19,
+	EVENT_SPINNER_RAMP = wxID_HIGHEST + 20,
+	EVENT_BUTTON_FILE_1 = wxID_HIGHEST + 21,
+	EVENT_BUTTON_FILE_2 = wxID_HIGHEST + 22,
+	EVENT_SPINNER_SEED = wxID_HIGHEST + 23,
+	EVENT_BUTTON_SWEEP_1 = wxID_HIGHEST + 24,
+	EVENT_BUTTON_SWEEP_2 = wxID_HIGHEST + 25,
+	EVENT_BUTTON_MODULATION_1 = wxID_HIGHEST + 26,
+	EVENT_BUTTON_MODULATION_2 = wxID_HIGHEST + 27
 };
 
 class MainApp : public wxApp
@@ -97,10 +111,21 @@ public:
 	void showAboutDialog(wxCommandEvent&);
 	void initializeConstants();
 	void changedParameters(wxCommandEvent&);
+	void publishParameters();
 	void onWorkerStart();
 	void runStopButton(wxCommandEvent&);
+	void alignPhasesButton(wxCommandEvent&);
 	void changedCalibrationCh1(wxCommandEvent&);
 	void changedCalibrationCh2(wxCommandEvent&);
+	void chosenFileCh1(wxCommandEvent&);
+	void chosenFileCh2(wxCommandEvent&);
+	bool loadWaveformFile(std::shared_ptr<WaveformFile>*, wxStaticText*);
+	void chosenSweepCh1(wxCommandEvent&);
+	void chosenSweepCh2(wxCommandEvent&);
+	bool editSweep(SweepSettings*, wxStaticText*, const char*);
+	void chosenModulationCh1(wxCommandEvent&);
+	void chosenModulationCh2(wxCommandEvent&);
+	bool editModulation(ModulationSettings*, wxStaticText*, const char*);
 	void updateA1range();
 	void updateA2range();
 
@@ -117,6 +142,7 @@ private:
 	wxSpinCtrlDouble *spinner_A1;
 	wxSpinCtrlDouble *spinner_d1;
 	wxCheckBox	*checkbox_output_1;
+	wxCheckBox	*checkbox_band_limited_1;
 	wxStaticText	*statictext_title_f1;
 	wxStaticText	*statictext_title_A1;
 	wxStaticText	*statictext_title_d1;
@@ -124,6 +150,12 @@ private:
 	wxStaticText	*statictext_title_calibration_ch1;
 	wxStaticText	*statictext_calibration_ch1;
 	wxButton	*button_calibrate_ch1;
+	wxButton	*button_file_1;
+	wxStaticText	*statictext_file_1;
+	wxButton	*button_sweep_1;
+	wxStaticText	*statictext_sweep_1;
+	wxButton	*button_modulation_1;
+	wxStaticText	*statictext_modulation_1;
 
 	wxStaticText	*statictext_title_2;
 	wxStaticLine	*staticline_title_2;
@@ -132,6 +164,7 @@ private:
 	wxSpinCtrlDouble *spinner_A2;
 	wxSpinCtrlDouble *spinner_d2;
 	wxCheckBox	*checkbox_output_2;
+	wxCheckBox	*checkbox_band_limited_2;
 	wxStaticText	*statictext_title_f2;
 	wxStaticText	*statictext_title_A2;
 	wxStaticText	*statictext_title_d2;
@@ -139,6 +172,12 @@ private:
 	wxStaticText	*statictext_title_calibration_ch2;
 	wxStaticText	*statictext_calibration_ch2;
 	wxButton	*button_calibrate_ch2;
+	wxButton	*button_file_2;
+	wxStaticText	*statictext_file_2;
+	wxButton	*button_sweep_2;
+	wxStaticText	*statictext_sweep_2;
+	wxButton	*button_modulation_2;
+	wxStaticText	*statictext_modulation_2;
 
 	wxStaticLine	*staticline_separate_channels;
 
@@ -146,6 +185,12 @@ private:
 	wxStaticLine	*staticline_title_misc;
 	wxButton	*button_run;
 	wxButton	*button_align_phases;
+	wxSpinCtrlDouble *spinner_latency;
+	wxStaticText	*statictext_title_latency;
+	wxSpinCtrlDouble *spinner_ramp;
+	wxStaticText	*statictext_title_ramp;
+	wxSpinCtrl	*spinner_seed;
+	wxStaticText	*statictext_title_seed;
 
 	wxDECLARE_EVENT_TABLE();
 };
@@ -162,12 +207,19 @@ public:
 	GuiFrame		*parent_frame;
 };
 
+// Filled by the GUI thread. The worker thread only reads the published
+// snapshot of the channel settings, picking it up at the next buffer, and
+// consumes the align_phases request. The waveform files are swapped with
+// std::atomic_store and read with std::atomic_load; a file is unmapped
+// once neither thread holds it any more.
 class ParametersWorkspace
 {
 public:
-	bool	changed;
+	std::atomic<bool>	align_phases;
 	bool	output_1;
 	bool	output_2;
+	bool	band_limited_1;
+	bool	band_limited_2;
 	double	f1;
 	double	f2;
 	double	A1;
@@ -176,8 +228,20 @@ public:
 	double	delay2;
 	double	y1_vps;
 	double	y2_vps;
+	double	latency_ms;
+	double	ramp_ms;
 	unsigned int	waveshape_1;
 	unsigned int	waveshape_2;
+	unsigned int	noise_seed;
+	SweepSettings	sweep_1;
+	SweepSettings	sweep_2;
+	ModulationSettings	modulation_1;
+	ModulationSettings	modulation_2;
+	Snapshot<GeneratorSettings>	settings;
+	std::shared_ptr<WaveformFile>	file_1;
+	std::shared_ptr<WaveformFile>	file_2;
 };
 
+void wXs_oscillator_settings(const ParametersWorkspace*, OscillatorSettings*);
+
 static const unsigned char icon_64_wavex_png[3934] = {0211,'P','N','G',015,012,032,012,0,0,0,015,'I','H','D','R',0,0,0,'@',0,0,0,'@',010,06,0,0,0,0252,'i','q',0336,0,0,0,011,'p','H','Y','s',0,0,035,0207,0,0,035,0207,01,0217,0345,0361,'e',0,0,0,031,'t','E','X','t','S','o','f','t','w','a','r','e',0,'w','w','w','.','i','n','k','s','c','a','p','e','.','o','r','g',0233,0356,'<',032,0,0,016,0353,'I','D','A','T','x',0234,0345,0233,0371,'W','[','g','z',0307,'?','W',013,0210,035,'!','6',0261,0231,0325,0354,0306,0340,0200,'m',034,0333,'x','#','`',0217,0343,0330,'I',0235,'4','s',':',0247,0247,'m',':',0355,0231,0323,0376,'3',0375,0251,'3',0277,'L',0323,'N',0323,0311,'L',0223,0231,'8',023,0333,0261,035,'o',030,0274,'c',0313,'b',0337,04,02,0304,0216,'A',02,'m','H',0267,'?',0134,0270,'F',' ','$','a','d',047,0347,0364,0373,0223,0336,0345,'>',0367,'y',0237,0373,0276,0317,0373,'l',022,'~',0177,0373,0271,0310,':',030,':',':',0271,'z',0375,06,';','A',0311,0356,'"',0316,'6','7',0355,0210,0306,0333,0202,'b','c',0307,0330,0370,0370,0216,0211,0216,'[','&','v','L',0343,'m','A',0265,0261,0303,022,06,0346,027,0255,'V',0254,'6',033,'q',0261,0261,';',0242,0323,0323,0327,0307,0363,027,035,'D','F','F',' ',010,033,0277,0225,0210,0303,0341,'D',0253,'M',0344,0324,0261,06,0271,0327,0345,'t',0361,0347,0357,'.',0243,'T','*','Q',0251,'|',0227,0347,'v',0273,0321,'%','i','i','8',0374,0256,0334,0347,'3',0303,0341,'t','2',0367,0362,0345,0216,0230,'^',0303,0270,0305,'B','q','Q',0321,0216,'h',0330,0355,'N',0314,'c',0243,'x',0275,0242,0337,'q','A',020,'P','(','|',05,0343,025,0275,'L',0315,0314,0260,0274,0274,0274,'i',0276,'B',0241,'@',0255,0366,025,0212,'O',0313,'2','1',0211,'(',0372,0177,0331,'v','1','3',';',0273,'c',01,0354,0335,'S','A','E','Y',')',035,']',']',0334,'i','m',0305,0341,'p',0312,'c',031,'z','=',027,0317,0177,0260,'i','A',032,0215,0206,'_','}',0366,0367,'t',0366,0364,0360,0227,'+',0337,03,0220,0230,0220,'@',0303,0341,'C',0344,0345,0346,0242,'R','*','}',0346,0373,0210,'o','~','>','<','_',037,'`','a',0321,032,026,':','*',0225,0222,0252,0312,012,'>',0275,0370,'W',0304,'D',0307,0310,0375,0223,'S',0323,0330,0226,'m','[','>','7',':','&',0351,0262,0264,0324,024,'~',0361,0351,047,024,025,024,'l','Z','<','l',020,0300,0242,'u','1',',','L','K',0264,0302,'#',0200,'5',0350,0264,'Z',0336,'?',0323,'$','o','y',0217,'g',0205,'+',0327,'~',0360,0273,'c',0207,0315,'f',014,0306,016,0342,0343,0343,0370,0360,0334,'9','"','#','"',0266,0244,0353,'#',0200,0205,0305,0360,011,' ',0234,0264,0326,0220,0225,0221,0301,0201,0332,'w',0344,0366,0350,0330,030,'O',0332,0237,0371,0314,'q','8',0234,0134,0276,'v',03,0205,'B',0311,0271,0323,0247,0211,0211,0216,012,'H','s',0203,0,0266,0336,'R',0333,0205,0315,'f',0333,'R','y',0355,04,07,0353,0352,0320,0247,0247,0311,0355,0273,0255,'m',0314,0314,0316,0311,0355,0357,0177,0270,0211,0325,'j',0345,0324,0361,0243,0244,0247,0245,06,0245,0347,'#',0,'k',030,0217,0200,0327,'+',0262,'l',0337,0254,0211,'w',012,0205,'B',0240,0271,0361,024,'*',0225,'t',0236,'W','<',036,'.','_',0273,0206,0327,0353,0345,0371,013,'#','=','}','}','T','W','V','R','Y','V',026,032,0275,0265,037,0242,'(','b','w','8',0302,0312,0254,0333,0345,016,'+',0275,'5',0350,0264,'Z',0336,0255,0257,0227,0333,023,0223,'S','|','u',0351,'[','n',0336,0275,0213,'>','=',0215,0206,0243,0207,'C',0246,'%',013,0300,0343,0361,0206,0355,012,0134,0303,0312,0312,0233,021,0,0300,';','{',0253,0310,0316,0312,0224,0333,'C',0246,'a',0224,'J','%',0347,0316,0234,0366,0253,0355,0267,0202,',',0200,'7',0301,0254,'{','e','%',0354,'4',0327,' ',010,02,0315,0247,'N',022,0241,'V',0277,0352,024,0245,0376,0355,'@',026,0300,0233,'`','v',0345,015,012,0,' ','>','.',016,0255,'6','Q','n',';',0234,'N',0376,'r',0365,0332,0266,'v',0362,0272,035,0340,011,'/','w',0200,0333,035,'~',0232,0353,0361,0340,0361,023,'&',0247,0246,'}',0356,0371,021,0263,0231,0307,033,0256,0306,'@','x',0243,'G','`',0223,0377,022,'F',014,0233,0315,0264,0264,0335,047,'+','C',0317,'?',0375,0303,0337,0221,0232,0222,',',0217,0265,0264,0266,'1','5','=',023,022,035,0231,0305,0204,0204,04,022,023,022,0302,0306,'`',0336,0256,034,0362,'v',0355,012,033,0275,0365,0260,'Z',0255,'|','{',0371,'*','*',0245,0212,0246,'F','I',017,0274,0177,0246,0231,0210,0325,0235,0260,0342,0361,0360,0355,0225,0253,'!',0355,'j','Y',0,021,'j','5','g',0233,0233,'6','y','W',0257,0203,0230,0350,'(',0232,033,'O','n','[','!',0205,02,0257,0327,0313,0245,'+','W','Y',0266,0333,'9','q',0354,010,0332,04,'I',07,'h',023,022,'9','v',0344,0325,0365,'7',';','7',0307,0355,0226,'{','A',0351,0371,0254,'6','=','-',0325,0307,0324,'|',035,010,0202,0300,'{',047,'O',0372,'8','.',0341,0304,0215,0333,0267,031,033,0267,'P',0220,0227,0267,0311,0330,0331,'S','^','F','q','Q',0241,0334,'n','7',030,030,030,032,012,'H','o','S','@',0344,'`',']',035,013,013,0213,0330,0226,0226,'p','8',035,'L','N','M',0207,0304,0330,0351,0367,'N',0241,0323,'&',0241,'R',0251,'H',0326,'%',0205,0364,0314,'v',0361,0360,0311,023,0236,031,0214,'D','i',0242,'h',':','y',0334,0357,0234,0223,0307,032,030,'6',0233,'q','8',0234,0210,0242,0310,'w',0337,'_',0343,'o','>',0371,'x',0313,0343,0275,'i',0277,'+',024,02,0247,0337,';',0305,0305,013,037,'p',0361,0374,0371,0220,0231,0323,'i',0223,'H','O','K','}','#',0213,0367,'z',0275,0264,0264,0335,0347,0316,0275,'6',0,'j',0252,0367,020,035,035,0355,'w','n','t','T',024,'{','+','*',0344,0266,0303,0341,0344,0313,0257,0376,0304,0314,0354,0254,0337,0371,0233,'v',0300,'O',011,'}',03,0203,0364,0364,0367,'c','6',0233,0261,'-',0275,0362,'+',0236,033,0214,'X',0255,'6',0216,0324,0327,023,025,0245,0221,0373,']','N',027,'7','[','Z',0350,0353,037,0364,0241,0263,0260,0270,0310,'o',0177,0367,05,'Y',031,031,0350,'t','Z',0352,0367,037,0220,0275,0304,'7','x','Q',0355,034,0375,03,0203,'t','u',0367,'`','[','Z','F',0251,'T',0311,016,0220,'m','i',011,0203,0261,03,0253,0315,'7',0346,0260,'d',0267,'c','0','v','`','w',0330,0345,0276,0310,0210,010,0224,'J','%',0242,'(','b',036,033,0343,0231,0301,0210,'u',']',0254,0342,047,0275,03,032,'O','4',0320,'t',0352,0204,0337,0333,0304,0345,'v',0243,0336,020,0364,0324,'&','&',0360,0257,0377,0374,0313,0200,01,0220,0215,0317,0375,0244,05,0240,'T','n',0315,0236,0217,017,0260,016,0201,026,0357,0357,0271,0237,0364,021,'x',033,0370,0177,'%',0,0227,0313,0265,0311,'Q',0372,0311,034,01,0227,0313,0205,'J',0245,'F',0241,010,0277,0365,0330,0321,0335,0315,0275,0266,07,',',',','.',0242,0321,'D','R','Q','V',0306,0241,03,0373,0211,'P',0253,0177,'|',01,0364,015,014,'r',0347,'^','+','s',0363,0363,'D',0250,0325,0224,026,027,'s',0344,0320,'A','4',032,'M',0360,0207,'C','@',0333,0303,'G',0264,0264,0335,0227,0333,016,0207,0223,0307,'O',0333,'1',0217,0216,'s',0361,0302,0271,037,'W',0,0317,014,'/',0270,'~',0353,0266,0274,'-',']','n','7',0317,0215,'F','F',0307,0306,0270,0370,0341,05,'b','c',0374,033,';',0241,'b',0320,'d',0222,027,0237,0237,0237,'K','}','m',035,'&',0363,010,0367,0332,036,'0','9','5',0311,0265,037,'n',0376,'x',':','`',0334,'b',0221,027,0237,0235,0231,0311,0317,'/','~',0304,0361,0243,'G','P',')',0225,0314,0316,0317,0363,0335,0325,0357,'w',024,0242,'s',0273,'W',0270,'z',0375,07,'@',012,0247,0237,'?','s',06,'}','z',032,07,'k','k',0345,0134,'b','w','o',0337,0217,'#',0,0257,'W',0344,0312,0265,033,0210,0242,'H','J','J',012,037,'}','p',0216,014,0275,0236,'}','{',0253,'8',0323,0364,036,' ',0371,0373,0355,0317,'_',0274,0366,';',014,'F','#',0266,0245,'%','T','J','%',0315,0215,047,'}',0274,0334,0252,0312,012,0362,0363,'s',0201,' ','J','P',0245,'V',0321,'x',0342,'X','H','/',0214,0217,0217,013,0231,0271,0256,0336,036,'f',0347,0347,021,04,0201,0323,0247,'N',0310,026,036,0300,0356,0302,02,'*',0312,'J','1','v','v','q',0267,0265,0225,0262,0222,0335,0333,0326,07,'^',0257,0310,0303,0247,'O',01,0250,'(','/',0365,0353,010,'5','6','4',0360,0233,0341,0377,014,'"',0,0245,0222,0252,'u',0216,'E',0270,0360,0340,0321,023,'@','Z','l','j','J',0312,0246,0361,'c',0207,017,0323,0333,'?',0200,0313,0345,0342,0251,0301,'@','}',']',0335,0266,0350,017,015,0233,0260,0331,0226,020,04,0201,0332,0232,032,0277,'s',0342,0342,0342,'(','+','.','~',0373,'G','`',0334,'b','a','v','N',0312,0344,0324,0355,0333,0347,'w',0216,'F',023,0311,0336,0312,'J',0,0236,'>','{',0276,0355,'x',0245,0261,0263,013,0200,0354,0314,0314,0200,'Q',0256,0332,'}',0325,'o','_',0,0306,0316,'n',0,'R',0222,'u',01,'S','W',0373,0252,0367,0242,'P',010,0330,0355,0216,0240,'A',0215,0365,'p',0257,0270,031,030,032,06,0240,0242,0254,'4',0340,0134,']','R','R',0340,'#',0340,'p',':',0371,0315,'o',0377,'#',0244,027,0177,'|',0341,0274,0337,0355,0274,036,0242,'(',0322,0333,'?',0,'@','y',0220,0324,'U','l','L','4','9','Y',0331,0230,'F','F','0','v','v',0372,'D','z',02,'a','x',0330,0214,0307,0263,0202,'B','!','P',0220,0227,027,'t','~','`',';','@',0304,0247,'(','!',020,'B','I',0204,0216,'Y','&','d','W','u','w','A','~',0320,0371,0331,0231,0231,0230,'F','F',030,032,036,0306,0355,'^',0331,'T',014,0341,017,'/',0272,0244,0355,0257,'O',0327,0243,0321,'D',06,0235,0377,'V',0217,0200,0261,0263,023,0200,'$',0255,0226,0204,0370,0370,0240,0363,'K',0212,'w','#',0,0242,010,0346,0261,0321,0240,0363,'E','Q','d',0320,'d',02,0244,0244,'I','(','x',0253,0226,'`','O','o','?',0,'q','q',0241,025,'O','%','&',0304,0243,0327,0353,031,0267,'X',030,030,'2',0221,0237,0233,033,'p',0376,0344,0324,'4','^',0217,027,0200,0232,0252,'J',0271,0177,'d','t',0224,0326,07,017,0231,0236,0236,'!','6','6',0226,'=',0345,'e','T','W','U',0241,'P',010,'o','O',0,013,'V','+','.',0267,013,0200,0352,'=',0257,0230,0263,'L','L',0322,0322,'v',0237,0211,0251,'I',0242,0242,0242,'(','/',')',0241,'v','_',0215,0234,0340,',',0310,0313,'e',0334,'b','a','h',0310,0204,0330,' ',06,014,0265,017,014,'J',0312,'R',0233,0220,'H',0206,'^',017,'H',0273,0356,0312,0365,'W',0225,'$',016,0247,0223,037,0356,0334,0305,'4','b',0346,0203,0237,'5',0207,0357,010,'x',0275,0336,0200,0343,03,03,022,'s','Q',0232,'(',012,0363,0245,0363,0337,'7','0',0310,0177,0377,0341,0217,0230,'F','F','p','8',0234,0314,0317,0277,0244,0245,0355,'>','_','~',0365,'5','.',0247,'$',0254,0302,'|','I',0221,'-','X',0255,'X','&',02,0227,0360,0365,0257,0336,026,05,05,0322,'3',0343,023,023,0362,0342,0323,0323,'R','y',0377,'t',0223,'l',0327,014,0232,'L',0334,0272,0333,032,'>',01,04,'+',0216,0354,037,0224,02,0225,0371,'y',0273,020,04,0201,0331,0271,'9','.',']',0276,0212,0327,0353,'%','Y',0247,0343,'l','s',023,0265,'5',0325,010,0202,0300,0330,0270,0205,0253,'7','%',';','>','Y',0247,'#','%','Y',07,'@','W','O',0337,0226,0364,0347,0346,0347,0231,0236,0221,0322,'a',0205,0371,'y','x',0275,'^','.',0177,0177,']','2',0267,0223,'u','|','|',0341,'<',0305,'E','E','4',0236,'8','F',0375,'~',0311,0260,'j','7',030,0302,047,0200,0241,0221,0341,'-',0307,0226,0226,0227,'0',0217,0215,0255,'2',0227,0217,'(',0212,0134,0276,'v',035,0217,'g',0205,0204,0370,'x','>',0371,0350,'<','%',0273,0213,'h','8',0374,'.',047,0216,036,01,0240,0273,0247,0217,0256,0336,'^',0,'J','w',0357,06,'$',023,0332,0343,0361,0237,'q','6',030,';',020,'E',0221,0204,0270,'8',0262,'2','2',0350,0350,0356,'f','n',0315,0334,'n','l',0224,0323,'f',0,0365,0373,0353,0310,0320,0353,021,'E','1','|',02,'0',0217,0216,0341,0330,0242,0302,0344,'E','g','7','^',0257,027,0215,'F','C','A',0336,'.',06,0206,'L','X','&','&',01,'h',':','u',0202,'(',0315,0253,'B',0246,0352,0252,'=',0262,0243,'r',0343,0326,'m',0334,'+','n',0312,0313,'J','Q','(',024,0330,0355,016,0272,'z','z','7',0321,'_',0361,'x',0350,0350,0222,014,0254,0212,0362,'r',0,036,'<','z',014,'@','I','Q',0221,'O',0342,024,0244,0354,'U',0323,0311,0343,010,'B',020,'%',0250,014,0301,027,0360,'x',0275,'t','v','w',0343,0361,'x','0','t','t','R',0267,0317,0327,0366,026,'E',0221,027,0306,016,0,0312,'K',0212,'Q','*','U',0334,0177,0364,010,0200,0334,0234,034,'r',0262,0262,'6',0321,'|',0357,0330,'q','~','=',0374,'9','v',0273,03,0303,0213,016,0366,'U',0357,'e','w','a',01,0335,0275,'}','<','|',0332,'N','y','i',0251,0217,'2',0354,0356,0351,'a',0331,'n','G',020,04,'*',0313,'K',031,031,035,'c',0376,0345,02,0,0373,'k',0375,0233,0333,0272,0244,'$',0212,012,0362,03,013,'@',035,0242,'7',0250,'V',0253,'h',0177,'n',0340,0351,'s',03,'5','U','U','>',0336,0335,0240,0311,0304,0313,05,0211,0231,'=',025,0345,'L',0317,0314,0310,'_',0177,'+',0346,'b','c','c',0250,',','/',0341,0231,0301,0310,0243,0366,'g','T','W',0355,0241,0266,0246,0206,0236,0276,'~','f','g',0347,'0','t','t',0310,037,0306,0275,0342,0246,0365,0376,'C',0,0212,0213,012,0211,0213,0215,0345,'n',0253,0224,'A',0322,0247,0247,0221,0222,0234,0354,0367,035,' ',0371,'"','a','9',02,0357,'T',0357,'E',0251,'T','b',0265,'Z','y',0334,0336,'.',0367,'{',0275,'^','9',0235,0225,0223,0235,'M',0262,'N',0207,'q','u',0253,'&','&','$',0220,0235,0231,0351,0227,036,'@','m','M',015,0202,' ','`',0265,'Z','1',0215,0214,0220,0236,0226,'J','I',0261,0244,013,'n',0335,0275,0307,0314,0354,',',0242,'(','r',0375,0346,'m',026,0254,'V','T','J','%',0357,036,'8',0300,0212,0307,'C',0237,'l','n',07,0366,05,0364,0351,'i',0341,021,'@','b','B',02,'{','W',0357,0366,0266,07,017,031,033,0267,0,'p',0247,'E','b','T',020,04,0216,036,0252,'G',024,'E',0272,'W',025,0333,0306,'m',0354,0217,'f',0246,'>',035,0200,0316,0356,036,0,0216,037,'9','L','l','L',014,'.',0227,0213,0337,'}',0371,'G','>',0377,0342,0367,0262,0347,'w',0360,0300,'~',0264,0332,'D',0314,0243,'c',0270,0334,'n',04,'A',010,0311,0334,016,0354,014,'9',0234,0374,0333,0277,0377,':','(',021,0200,0277,0376,0360,02,'&',0323,'0',0263,0363,0363,'|',0371,0365,0327,0350,0222,0222,0231,0234,0222,0266,0372,';','5',0325,0244,0247,0245,'2','1','9',0205,0315,0266,04,'@','q','Q','A','P',0232,'9',0331,0331,0214,0216,'[',0350,0356,0355,0243,0371,0324,'I',0242,0243,0242,0370,0360,0334,'Y',0276,0372,0346,'[',0254,'6',033,'S',0323,'R',0346,0272,0246,0252,0212,0375,0253,0272,0247,0273,'W',022,'V','Z','j','J','H',')',0372,0260,'Y',0202,'*',0265,0232,0363,0357,0237,0345,0177,0277,0371,0206,0371,0371,0227,0362,0342,0313,'J',0212,'9','z',0250,0336,0207,0271,0370,0370,'x','t','I',0301,0263,0310,'E',05,0205,0264,'>','x',0210,'(',0212,0214,'Y',',',0344,'d','e',0221,0232,0222,0302,0337,0376,0374,'S','z',0372,0372,'X',0262,'/',0223,0223,0225,'E','V','F',0206,0374,'L','W',0217,'d','n',0207,'Z',0355,022,'X',0,02,0262,'G',0345,'t','n','N','*',0254,'!','"','B',0212,0347,'k',023,023,0370,0305,047,037,0323,0333,'?',0300,0242,0325,'J',0206,'>',0235,0334,0234,034,'y',0236,0301,'(','m',0327,0304,020,034,'!',0200,0324,024,035,0251,')',0311,'L','M',0317,'0','8','d',0222,'o',014,0215,'&',0222,0252,0312,0315,0267,0323,0354,0334,0234,'l',047,0224,0227,0224,0204,0364,0216,0200,':','@',023,031,0311,0277,0374,0362,037,0371,0325,'g',0237,0241,0336,'"',027,07,'P','T',0360,'*',0264,025,021,021,'A','E','Y',')',0365,0373,0353,'|',026,0277,0264,0274,0204,'s',0325,027,'X','S','f',0241,'`',0315,0247,037,030,'2',05,0235,0333,0267,0352,013,0304,0306,0304,0220,0227,033,'Z','}','R','H','J','p','|',0302,0202,0313,0345,0332,'r','|',0310,'4',034,'4',0204,'=','0','h',02,'Q','$','"','"',0202,0362,0322,0320,0276,016,' ',0373,015,'s',0363,0363,'L','O',07,0256,'V','Y','s',0206,012,013,0362,'B',0256,'O',012,'I',0,0303,'#','#',01,'F',05,0226,0355,'v',0314,0243,0201,0375,0365,0376,'U',0346,0362,'v',0355,0332,'V',')','k','Z','j',0212,'|',0236,';',03,0370,02,0326,'u',0316,'R','a','^','p',0355,0277,0206,0220,04,'`',032,0331,'z','q','k',0271,0274,0316,0356,0315,'&',0352,032,034,'N',047,0303,'f','I',0210,05,0253,'f','n',0250,020,04,0201,0322,0325,'#',0323,0325,0323,0263,'e',0344,0311,0320,0321,0211,'(',0212,'D','G','G',0223,0223,0275,0331,0272,0334,012,'A',05,0340,'r',0272,0230,0230,0234,0334,'r','|',0315,015,0356,0355,0357,0307,0275,'E',0261,'e','g','w','7','+','+',036,0324,'*','5','E',0333,0370,':','k','X',0263,031,0254,'6',033,'}',03,03,0233,0306,'E','Q',0344,0305,0252,'=','P','Q','Z',0212,0362,'u',0212,0245,0267,0302,0360,0250,'9',0250,0257,0257,'P',010,'8',']','.',':',':','{',0374,0216,033,0214,'R','(',0254,'d','w',021,021,0221,0201,013,030,0374,'A',0233,0230,' ',027,']','>','~',0332,0276,'I',0337,0364,017,014,'b',0265,'Z',021,04,0201,'=',025,0345,0333,0242,035,0134,0,0346,0340,0261,0270,0230,'(',0311,0340,'x',0362,0354,0331,0246,'-','j',036,035,0223,0375,0364,'=',0225,0333,'c','n','=','j',0367,'U',03,'R',0220,'c','-',0262,014,0322,016,0274,'{','_','J',0200,0346,0346,0344,0240,'M',0334,'^',0265,'k','P',01,0230,02,'*','@',011,'v',0247,035,01,0201,0271,0371,'y',0236,'w',030,0345,'~','Q',024,0271,0263,0352,0230,0244,0247,0245,0222,0221,0236,0276,'-',0346,0326,'#',047,'+',0213,0202,0274,0134,0,'n',0334,0272,0205,0325,'&',0375,0275,0347,'^',0333,'}','f','g',0347,020,04,0201,'w',017,036,0330,'6',0335,0200,0206,0220,'(',0212,0250,'U','[',0337,0377,'k',0210,0216,0212,'&','S',0257,0247,0253,0267,0227,';','-',0255,0344,'d','e',0241,0323,'j','y',0374,0264,0235,'q',0213,0344,027,034,'9','T',037,0204,'J','p',0234,'h','8',0312,0230,0305,0302,0322,0262,0235,0377,0372,0237,'/','I','O','K',0225,'o',0227,'w',0366,'V',0205,0364,037,0241,0215,020,'6',0376,'y','z','#',034,'N',047,0177,0370,0372,'O','L','L','N',0371,035,0217,0213,0213,0343,0223,017,0317,0243,'V','G',0360,0371,027,'_','`',0263,'-',021,025,0245,'!',';','3',0223,0276,0201,'A','D','Q',0244,0242,0264,0224,0346,0306,0223,0333,'f',0316,037,0206,0315,'f',0376,0374,0355,'w','8',0327,0331,'%',0205,05,0371,0234,';',0335,0374,'Z','u',0316,'A',05,0,0340,'p','8',0270,'w',0377,'!','N',0227,0213,0211,'U','_','>','=','=',025,0225,'J','E',0335,0276,032,0371,0236,0266,'L','L',0362,0365,0245,'K',',','-',0277,0252,0323,0313,0311,0312,0342,0302,0373,'g','C','J','j',0204,0212,0227,013,013,030,':',':',0261,'/','/',0223,0235,0225,'E','i',0361,0356,0327,'.',0314,016,'I',0,0333,0201,'m','i',011,'C','G',07,0213,013,0222,'/','P','Y','^',0366,'F',0252,0306,0303,0205,0377,03,0373,'/',03,033,'u','_',017,026,0,0,0,0,'I','E','N','D',0256,'B','`',0202,};
@@ -0,0 +1,245 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+
+#include "wavex-engine_bode.h"
+
+FrequencyResponse::FrequencyResponse(StimulusResponse & measuring_device) : device(measuring_device)
+{
+	frequency = 0.0;
+	amplitude = 0.0;
+	nr_captured = 0;
+	nr_skipped = 0;
+	max_frames = 0;
+	block_frames = 1;
+	block_position = 0;
+	nr_blocks = 0;
+}
+
+// Measures one point, the stimulus amplitude being in sample units; the
+// point ends at the latest after max_time seconds of response.
+bool FrequencyResponse::measure(double f, double A, double max_time, BodePoint* point)
+{
+	unsigned int sample_rate = device.rate();
+	if ((f <= 0.0) || (f >= 0.5 * sample_rate) || (A <= 0.0)) {
+		std::cerr << "Cannot measure at " << f << " Hz with amplitude " << A << "\n";
+		return false;
+	}
+	frequency = f;
+	amplitude = (A < 32767.0)? A : 32767.0;
+	double w = 8.0 * atan(1.0) * frequency / sample_rate;
+	step = std::polar(1.0, w);
+	stimulus_phasor = 1.0;
+	reference_phasor = 1.0;
+
+	// Among the blocks of K to 2K cycles, the one closest to a whole number
+	// of frames, so that the term at twice the frequency cancels.
+	double frames_per_cycle = sample_rate / frequency;
+	unsigned int min_cycles = (unsigned int) ceil(BODE_BLOCK_SECONDS * frequency);
+	if (min_cycles < 1)
+		min_cycles = 1;
+	unsigned int best_cycles = min_cycles;
+	for (unsigned int k = min_cycles; k <= 2 * min_cycles; k++) {
+		double n = k * frames_per_cycle, best = best_cycles * frames_per_cycle;
+		if (fabs(n - round(n)) < fabs(best - round(best)) - 1e-9)
+			best_cycles = k;
+	}
+	block_frames = (unsigned int) llround(best_cycles * frames_per_cycle);
+
+	double max_latency = 0.0;
+	for (int c = 0; c < MEASURE_CHANNELS; c++) {
+		correction[c] = std::complex<double>(0.0, 2.0 / amplitude) * std::polar(1.0, w * device.latency(c));
+		accumulator[c] = 0.0;
+		previous[c] = 0.0;
+		sum[c] = 0.0;
+		sum_squares[c] = 0.0;
+		nr_averaged[c] = 0;
+		settled[c] = false;
+		converged[c] = false;
+		if (device.latency(c) > max_latency)
+			max_latency = device.latency(c);
+	}
+	nr_captured = 0;
+	nr_skipped = (uint64_t) ceil(max_latency);
+	max_frames = nr_skipped + (uint64_t) (max_time * sample_rate);
+	if (max_frames < nr_skipped + 2 * BODE_MIN_BLOCKS * block_frames)
+		max_frames = nr_skipped + 2 * BODE_MIN_BLOCKS * block_frames;
+	block_position = 0;
+	nr_blocks = 0;
+
+	StimulusTask produce = [this](int16_t* buf, unsigned int nr_frames) {
+		double re = stimulus_phasor.real(), im = stimulus_phasor.imag();
+		double step_re = step.real(), step_im = step.imag();
+		for (unsigned int j = 0; j < nr_frames; j++) {
+			int16_t value = (int16_t) lrint(amplitude * im);
+			for (int c = 0; c < MEASURE_CHANNELS; c++)
+				buf[j * MEASURE_CHANNELS + c] = value;
+			double next_re = re * step_re - im * step_im;
+			im = re * step_im + im * step_re;
+			re = next_re;
+		}
+		stimulus_phasor = std::complex<double>(re, im) / hypot(re, im);
+	};
+	ResponseTask consume = [this](const int16_t* buf, unsigned int nr_frames) {
+		return demodulate(buf, nr_frames);
+	};
+	if (!device.stream(produce, consume))
+		return false;
+
+	point->frequency = frequency;
+	point->converged = true;
+	for (int c = 0; c < MEASURE_CHANNELS; c++) {
+		std::complex<double> gain = (nr_averaged[c] > 0)? sum[c] / (double) nr_averaged[c] : previous[c];
+		point->gain_db[c] = 20.0 * log10(std::max(std::abs(gain), 1e-12));
+		point->phase_deg[c] = 45.0 / atan(1.0) * std::arg(gain);
+		point->converged = point->converged && converged[c];
+	}
+	point->duration = (double) nr_captured / sample_rate;
+	point->nr_blocks = nr_blocks;
+	return true;
+}
+
+// Multiplies each input by the conjugate of the phasor of its frame and
+// integrates; the phasor is renormalized once per call.
+bool FrequencyResponse::demodulate(const int16_t* buf, unsigned int nr_frames)
+{
+	double re = reference_phasor.real(), im = reference_phasor.imag();
+	double step_re = step.real(), step_im = step.imag();
+	double sum_re[MEASURE_CHANNELS], sum_im[MEASURE_CHANNELS];
+	for (int c = 0; c < MEASURE_CHANNELS; c++) {
+		sum_re[c] = accumulator[c].real();
+		sum_im[c] = accumulator[c].imag();
+	}
+	for (unsigned int j = 0; j < nr_frames; j++) {
+		if (nr_captured++ >= nr_skipped) {
+			for (int c = 0; c < MEASURE_CHANNELS; c++) {
+				double y = buf[j * MEASURE_CHANNELS + c];
+				sum_re[c] += y * re;
+				sum_im[c] -= y * im;
+			}
+			if (++block_position == block_frames) {
+				for (int c = 0; c < MEASURE_CHANNELS; c++) {
+					accumulator[c] = std::complex<double>(sum_re[c], sum_im[c]);
+					sum_re[c] = 0.0;
+					sum_im[c] = 0.0;
+				}
+				endBlock();
+			}
+		}
+		double next_re = re * step_re - im * step_im;
+		im = re * step_im + im * step_re;
+		re = next_re;
+	}
+	for (int c = 0; c < MEASURE_CHANNELS; c++)
+		accumulator[c] = std::complex<double>(sum_re[c], sum_im[c]);
+	reference_phasor = std::complex<double>(re, im) / hypot(re, im);
+
+	bool done = true;
+	for (int c = 0; c < MEASURE_CHANNELS; c++)
+		done = done && converged[c];
+	return !done && (nr_captured < max_frames);
+}
+
+void FrequencyResponse::endBlock()
+{
+	nr_blocks++;
+	for (int c = 0; c < MEASURE_CHANNELS; c++) {
+		std::complex<double> gain = correction[c] * accumulator[c] / (double) block_frames;
+		if (!settled[c] && (nr_blocks > 1) && (std::abs(gain - previous[c]) <= BODE_SETTLE_TOLERANCE * std::abs(gain) + BODE_SETTLE_FLOOR))
+			settled[c] = true;
+		previous[c] = gain;
+		if (!settled[c])
+			continue;
+		sum[c] += gain;
+		sum_squares[c] += std::norm(gain);
+		nr_averaged[c]++;
+		if (nr_averaged[c] >= BODE_MIN_BLOCKS) {
+			double n = nr_averaged[c];
+			std::complex<double> mean = sum[c] / n;
+			double variance = (sum_squares[c] - n * std::norm(mean)) / (n - 1.0);
+			double error = (variance > 0.0)? sqrt(variance / n) : 0.0;
+			if (error <= BODE_TOLERANCE * std::abs(mean) + BODE_ABSOLUTE_TOLERANCE)
+				converged[c] = true;
+		}
+	}
+	block_position = 0;
+	return;
+}
+
+// Measures the frequencies of a linear or logarithmic sweep, its dwell
+// being the time limit of each point; the phases are unwrapped along the
+// sweep.
+bool FrequencyResponse::sweep(const SweepSettings & grid, double A, std::vector<BodePoint> & points)
+{
+	if ((grid.mode != SWEEP_LINEAR) && (grid.mode != SWEEP_LOGARITHMIC)) {
+		std::cerr << "The frequencies are those of a linear or log sweep\n";
+		return false;
+	}
+	points.clear();
+	for (unsigned int k = 0; k < grid.nr_steps; k++) {
+		BodePoint point;
+		if (!measure(wXs_sweep_frequency(grid, k), A, grid.dwell, &point))
+			return false;
+		if (!points.empty()) {
+			for (int c = 0; c < MEASURE_CHANNELS; c++) {
+				double last = points.back().phase_deg[c];
+				point.phase_deg[c] -= 360.0 * round((point.phase_deg[c] - last) / 360.0);
+			}
+		}
+		points.push_back(point);
+		fprintf(stderr, "%10.3f Hz: %8.3f dB %8.2f deg, %8.3f dB %8.2f deg (%.2f s%s)\n", point.frequency, point.gain_db[0], point.phase_deg[0], point.gain_db[1], point.phase_deg[1], point.duration, point.converged? "" : ", not converged");
+	}
+	return true;
+}
+
+// Writes the points as a table, and next to it ("<file>.gp") a gnuplot
+// script plotting gain and phase against frequency.
+bool wXs_write_bode(const char* file_name, const std::vector<BodePoint> & points)
+{
+	FILE* file = fopen(file_name, "w");
+	if (file == NULL) {
+		std::cerr << "Cannot create <" << file_name << ">\n";
+		return false;
+	}
+	fprintf(file, "# frequency (Hz)\tgain 1 (dB)\tphase 1 (deg)\tgain 2 (dB)\tphase 2 (deg)\ttime (s)\tblocks\tconverged\n");
+	for (size_t k = 0; k < points.size(); k++) {
+		const BodePoint & p = points[k];
+		fprintf(file, "%.6f\t%.4f\t%.3f\t%.4f\t%.3f\t%.3f\t%u\t%d\n", p.frequency, p.gain_db[0], p.phase_deg[0], p.gain_db[1], p.phase_deg[1], p.duration, p.nr_blocks, p.converged? 1 : 0);
+	}
+	fclose(file);
+
+	std::string script_name = std::string(file_name) + BODE_PLOT_SUFFIX;
+	FILE* script = fopen(script_name.c_str(), "w");
+	if (script == NULL) {
+		std::cerr << "Cannot create <" << script_name << ">\n";
+		return false;
+	}
+	fprintf(script, "set logscale x\nset grid\nset key bottom left\nset multiplot layout 2,1\n");
+	fprintf(script, "set ylabel \"Gain (dB)\"\n");
+	fprintf(script, "plot \"%s\" using 1:2 with linespoints title \"Input 1\", \"\" using 1:4 with linespoints title \"Input 2\"\n", file_name);
+	fprintf(script, "set xlabel \"Frequency (Hz)\"\nset ylabel \"Phase (deg)\"\n");
+	fprintf(script, "plot \"%s\" using 1:3 with linespoints title \"Input 1\", \"\" using 1:5 with linespoints title \"Input 2\"\n", file_name);
+	fprintf(script, "unset multiplot\n");
+	fclose(script);
+	return true;
+}
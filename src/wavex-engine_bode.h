@@ -0,0 +1,112 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+
+#ifndef INCLUDED_WAVEX_BODE
+#define INCLUDED_WAVEX_BODE
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <complex>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <string>
+
+#include "wavex-engine_measure.h"
+#include "wavex-engine_sweep.h"
+
+#define BODE_BLOCK_SECONDS 0.01
+#define BODE_MIN_BLOCKS 4
+#define BODE_SETTLE_TOLERANCE 0.01
+#define BODE_SETTLE_FLOOR 0.001
+#define BODE_TOLERANCE 0.001
+#define BODE_ABSOLUTE_TOLERANCE 0.00001
+#define BODE_PLOT_SUFFIX ".gp"
+
+// Response of both inputs at one frequency: complex gain relative to the
+// stimulus, as gain in dB and phase in degrees, with the time it took and
+// whether it converged before the time limit.
+struct BodePoint {
+	double		frequency;
+	double		gain_db[MEASURE_CHANNELS];
+	double		phase_deg[MEASURE_CHANNELS];
+	double		duration;
+	unsigned int	nr_blocks;
+	bool		converged;
+};
+
+// Frequency response analyzer. At each frequency of the grid a sine of the
+// given amplitude is played on both outputs, and each input is demodulated
+// by a digital lock-in: it is multiplied by exp(-i w n), n being the frame
+// count of the linked streams, and integrated over blocks spanning a whole
+// number of cycles (at least BODE_BLOCK_SECONDS), each block giving one
+// estimate of the complex gain. The phasor is a complex rotator, so that
+// no frame needs a trigonometric function, and the latency found by
+// StimulusResponse::calibrate() is taken out of the phase.
+//
+// The device under test has settled once two consecutive blocks agree
+// within BODE_SETTLE_TOLERANCE; the blocks from then on are averaged until
+// the standard error of the mean falls below BODE_TOLERANCE of its value
+// (plus BODE_ABSOLUTE_TOLERANCE, for responses lost in the noise), over at
+// least BODE_MIN_BLOCKS blocks. Quiet, fast-settling points thus take a
+// few blocks, noisy ones longer, up to the time limit of each point.
+class FrequencyResponse
+{
+public:
+	FrequencyResponse(StimulusResponse &);
+
+	bool measure(double, double, double, BodePoint*);
+	bool sweep(const SweepSettings &, double, std::vector<BodePoint> &);
+
+private:
+	bool demodulate(const int16_t*, unsigned int);
+	void endBlock();
+
+	StimulusResponse &	device;
+	double			frequency;
+	double			amplitude;
+	std::complex<double>	step;
+	std::complex<double>	stimulus_phasor;
+	std::complex<double>	reference_phasor;
+	std::complex<double>	correction[MEASURE_CHANNELS];
+	std::complex<double>	accumulator[MEASURE_CHANNELS];
+	std::complex<double>	previous[MEASURE_CHANNELS];
+	std::complex<double>	sum[MEASURE_CHANNELS];
+	double			sum_squares[MEASURE_CHANNELS];
+	unsigned int		nr_averaged[MEASURE_CHANNELS];
+	bool			settled[MEASURE_CHANNELS];
+	bool			converged[MEASURE_CHANNELS];
+	uint64_t		nr_captured;
+	uint64_t		nr_skipped;
+	uint64_t		max_frames;
+	unsigned int		block_frames;
+	unsigned int		block_position;
+	unsigned int		nr_blocks;
+};
+
+bool wXs_write_bode(const char*, const std::vector<BodePoint> &);
+
+#endif
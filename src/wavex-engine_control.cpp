@@ -0,0 +1,339 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+
+#include "wavex-engine_control.h"
+
+static const char* waveform_names[] = {"sine", "triangular", "square", "arbitrary", "white", "pink"};
+
+bool wXs_parse_waveform(const std::string & name, unsigned int* waveform)
+{
+	for (unsigned int k = 0; k < sizeof(waveform_names) / sizeof(waveform_names[0]); k++) {
+		if (name == waveform_names[k]) {
+			*waveform = k;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* wXs_waveform_name(unsigned int waveform)
+{
+	if (waveform >= sizeof(waveform_names) / sizeof(waveform_names[0]))
+		return "unknown";
+	return waveform_names[waveform];
+}
+
+static bool wXs_parse_switch(const std::string & word, bool* value)
+{
+	if ((word == "on") || (word == "1")) {
+		*value = true;
+		return true;
+	} else if ((word == "off") || (word == "0")) {
+		*value = false;
+		return true;
+	}
+	return false;
+}
+
+// Defaults are those of the console: 100 Hz sine waves of amplitude 1,
+// band-limited, outputs off, no calibration.
+GeneratorControl::GeneratorControl(unsigned int rate)
+{
+	sample_rate = rate;
+	for (int c = 0; c < GENERATOR_CHANNELS; c++) {
+		OscillatorSettings & s = channels[c].settings;
+		s.enabled = false;
+		s.band_limited = true;
+		s.waveform = SINE;
+		s.frequency = 100.0;
+		s.amplitude = 1.0;
+		s.delay = 0.0;
+		s.ramp_time = 0.0;
+		s.seed = 1;
+		wXs_parse_sweep("off", sample_rate, &s.sweep);
+		wXs_parse_modulation("off", sample_rate, &s.modulation);
+		channels[c].amplitude = 1.0;
+		channels[c].units_per_volt = 0.0;
+	}
+	align_phases = false;
+	wants_running = false;
+	wants_quit = false;
+	running = false;
+	underruns = 0;
+	publish();
+}
+
+void GeneratorControl::publish()
+{
+	GeneratorSettings	published;
+	for (int c = 0; c < GENERATOR_CHANNELS; c++) {
+		published.channels[c] = channels[c].settings;
+		published.channels[c].amplitude = (channels[c].units_per_volt > 0.0)? channels[c].amplitude * channels[c].units_per_volt : channels[c].amplitude;
+	}
+	settings.publish(published);
+	return;
+}
+
+bool GeneratorControl::execute(const std::string & line, std::string & reply)
+{
+	std::istringstream	words(line);
+	std::string		command, word;
+	std::ostringstream	error;
+	if (!(words >> command)) {
+		reply = "error empty command";
+		return false;
+	}
+
+	if (command == "start") {
+		wants_running = true;
+	} else if (command == "stop") {
+		wants_running = false;
+	} else if (command == "quit") {
+		wants_quit = true;
+	} else if (command == "align") {
+		align_phases = true;
+	} else if (command == "status") {
+		reply = "ok " + status();
+		return true;
+	} else if (command == "markers") {
+		std::vector<SweepMarker> pending;
+		std::ostringstream text;
+		markers.take(pending);
+		text << "ok " << pending.size();
+		for (size_t k = 0; k < pending.size(); k++)
+			text << " " << pending[k].channel + 1 << ":" << pending[k].frame << ":" << pending[k].step << ":" << pending[k].frequency;
+		reply = text.str();
+		return true;
+	} else if (command == "ramp") {
+		double ramp_ms;
+		if (!(words >> ramp_ms) || (ramp_ms < 0.0)) {
+			reply = "error usage: ramp <ms>";
+			return false;
+		}
+		for (int c = 0; c < GENERATOR_CHANNELS; c++)
+			channels[c].settings.ramp_time = 0.001 * ramp_ms;
+	} else if (command == "seed") {
+		unsigned long seed;
+		if (!(words >> seed)) {
+			reply = "error usage: seed <n>";
+			return false;
+		}
+		for (int c = 0; c < GENERATOR_CHANNELS; c++)
+			channels[c].settings.seed = (unsigned int) seed;
+	} else {
+		int channel;
+		if (!(words >> channel) || (channel < 1) || (channel > GENERATOR_CHANNELS)) {
+			reply = "error unknown command or invalid channel";
+			return false;
+		}
+		ChannelControl & target = channels[channel - 1];
+		OscillatorSettings & s = target.settings;
+		bool valid = true;
+		if (command == "waveform") {
+			valid = (words >> word) && wXs_parse_waveform(word, &s.waveform);
+		} else if (command == "frequency") {
+			double f;
+			valid = (words >> f) && (f >= 0.0);
+			if (valid)
+				s.frequency = f;
+		} else if (command == "amplitude") {
+			double a;
+			valid = (words >> a) && (a >= 0.0);
+			if (valid)
+				target.amplitude = a;
+		} else if (command == "delay") {
+			double d;
+			valid = (bool) (words >> d);
+			if (valid)
+				s.delay = d;
+		} else if (command == "output") {
+			valid = (words >> word) && wXs_parse_switch(word, &s.enabled);
+		} else if (command == "band-limited") {
+			valid = (words >> word) && wXs_parse_switch(word, &s.band_limited);
+		} else if (command == "sweep") {
+			std::string spec;
+			std::getline(words, spec);
+			valid = wXs_parse_sweep(spec, sample_rate, &s.sweep);
+		} else if (command == "modulation") {
+			std::string spec;
+			std::getline(words, spec);
+			valid = wXs_parse_modulation(spec, sample_rate, &s.modulation);
+		} else if (command == "calibration") {
+			double units_per_volt;
+			valid = (words >> units_per_volt) && (units_per_volt >= 0.0);
+			if (valid)
+				target.units_per_volt = units_per_volt;
+		} else if (command == "file") {
+			std::string name;
+			std::getline(words >> std::ws, name);
+			std::shared_ptr<WaveformFile> file = std::make_shared<WaveformFile>();
+			if (name.empty() || !file->open(name)) {
+				reply = "error cannot use waveform file";
+				return false;
+			}
+			std::atomic_store(&files[channel - 1], file);
+		} else {
+			reply = "error unknown command";
+			return false;
+		}
+		if (!valid) {
+			reply = "error invalid value for " + command;
+			return false;
+		}
+	}
+
+	publish();
+	reply = "ok";
+	return true;
+}
+
+std::string GeneratorControl::status() const
+{
+	std::ostringstream	text;
+	text << (running? "running" : "stopped") << " underruns " << underruns;
+	for (int c = 0; c < GENERATOR_CHANNELS; c++) {
+		const OscillatorSettings & s = channels[c].settings;
+		text << "; ch" << c + 1 << " " << (s.enabled? "on" : "off") << " " << wXs_waveform_name(s.waveform);
+		text << " f " << s.frequency << " A " << channels[c].amplitude << ((channels[c].units_per_volt > 0.0)? " V" : "");
+		text << " delay " << s.delay;
+		if (s.sweep.mode != SWEEP_OFF)
+			text << " sweep " << wXs_sweep_description(s.sweep);
+		if (s.modulation.type != MODULATION_OFF)
+			text << " modulation " << wXs_modulation_description(s.modulation);
+		if (files[c])
+			text << " file " << files[c]->name();
+	}
+	return text.str();
+}
+
+MarkerQueue::MarkerQueue() {}
+
+void MarkerQueue::push(const std::vector<SweepMarker> & new_markers)
+{
+	if (new_markers.empty())
+		return;
+	std::lock_guard<std::mutex> guard(markers_lock);
+	markers.insert(markers.end(), new_markers.begin(), new_markers.end());
+	while (markers.size() > CONTROL_MAX_MARKERS)
+		markers.pop_front();
+	return;
+}
+
+void MarkerQueue::take(std::vector<SweepMarker> & taken)
+{
+	std::lock_guard<std::mutex> guard(markers_lock);
+	taken.assign(markers.begin(), markers.end());
+	markers.clear();
+	return;
+}
+
+void MarkerQueue::clear()
+{
+	std::lock_guard<std::mutex> guard(markers_lock);
+	markers.clear();
+	return;
+}
+
+GeneratorPlayer::GeneratorPlayer()
+{
+	control = NULL;
+	stopping = false;
+	running = false;
+	sample_rate = 0;
+}
+
+GeneratorPlayer::~GeneratorPlayer()
+{
+	stop();
+}
+
+bool GeneratorPlayer::start(GeneratorControl* generator_control, const char* device_name, unsigned int rate, double latency_ms)
+{
+	if (running)
+		return true;
+	control = generator_control;
+	sample_rate = rate;
+	if (!playback.open(device_name, &sample_rate, GENERATOR_CHANNELS, latency_ms, CONTROL_BUFFER_FRAMES))
+		return false;
+	control->markers.clear();
+	stopping = false;
+	producer = std::thread(&GeneratorPlayer::run, this);
+	running = true;
+	return true;
+}
+
+void GeneratorPlayer::stop()
+{
+	if (!running)
+		return;
+	stopping = true;
+	producer.join();
+	playback.close();
+	running = false;
+	return;
+}
+
+bool GeneratorPlayer::isRunning() const
+{
+	return running;
+}
+
+uint64_t GeneratorPlayer::underruns() const
+{
+	return running? playback.underruns() : 0;
+}
+
+// ALSA error code of the last failed start.
+int GeneratorPlayer::openError() const
+{
+	return playback.openError();
+}
+
+// Every start plays the waveform from its beginning, with the phases set
+// by the delays.
+void GeneratorPlayer::run()
+{
+	WaveGenerator generator(sample_rate);
+	GeneratorSettings settings;
+	std::shared_ptr<WaveformFile> files[GENERATOR_CHANNELS];
+	int16_t* buf = (int16_t *) malloc(sizeof(int16_t) * CONTROL_BUFFER_FRAMES * GENERATOR_CHANNELS);
+	useconds_t idle_us = (useconds_t) (500000.0 * playback.periodFrames() / sample_rate);
+	while (!stopping) {
+		if (playback.roomFrames() > 0) {
+			control->settings.read(settings);
+			if (control->align_phases.exchange(false))
+				generator.align();
+			for (int c = 0; c < GENERATOR_CHANNELS; c++)
+				files[c] = std::atomic_load(&control->files[c]);
+			generator.render(settings, files, buf, CONTROL_BUFFER_FRAMES);
+			control->markers.push(generator.markers());
+			playback.write(buf, CONTROL_BUFFER_FRAMES);
+		} else {
+			playback.start();
+			usleep(idle_us);
+		}
+	}
+	free(buf);
+	return;
+}
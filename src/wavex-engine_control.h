@@ -0,0 +1,147 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+
+#ifndef INCLUDED_WAVEX_CONTROL
+#define INCLUDED_WAVEX_CONTROL
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <unistd.h>
+
+#include "wavex-engine_generator.h"
+#include "wavex-engine_playback.h"
+#include "wavex-engine_snapshot.h"
+
+#define CONTROL_BUFFER_FRAMES 441
+#define CONTROL_MAX_MARKERS 65536
+
+// Sweep markers on their way from the thread generating the waveform to
+// the one answering commands. There are seldom more than a few per
+// buffer, so that a lock costs next to nothing; beyond CONTROL_MAX_MARKERS
+// the oldest ones are dropped.
+class MarkerQueue
+{
+public:
+	MarkerQueue();
+
+	void push(const std::vector<SweepMarker> &);
+	void take(std::vector<SweepMarker> &);
+	void clear();
+
+private:
+	std::deque<SweepMarker>	markers;
+	std::mutex		markers_lock;
+};
+
+// Settings of one channel as given by commands: the amplitude is in volts
+// if a calibration (sample units per volt) is set, in sample units
+// otherwise, as in the console.
+struct ChannelControl {
+	OscillatorSettings	settings;
+	double			amplitude;
+	double			units_per_volt;
+};
+
+// Interprets the text commands of the generator daemon, one per line:
+//	waveform <ch> sine|triangular|square|arbitrary|white|pink
+//	frequency <ch> <Hz>		amplitude <ch> <value>
+//	delay <ch> <s>			output <ch> on|off
+//	band-limited <ch> on|off	file <ch> <path>
+//	calibration <ch> <units per volt, 0 for none>
+//	ramp <ms>			seed <n>
+//	sweep <ch> <sweep, see wXs_parse_sweep()>
+//	modulation <ch> <modulation, see wXs_parse_modulation()>
+//	align	start	stop	status	markers	quit
+// Channels are numbered from 1. Every command is answered by one line,
+// "ok" possibly followed by information, or "error" and the reason. The
+// settings are published after each command for the thread generating
+// the waveform, which picks them up at its next buffer; starting,
+// stopping and quitting are left to the caller (see wants_running and
+// wants_quit). "markers" returns the sweep markers queued since the last
+// call, as channel:frame:step:frequency items, frames being counted from
+// the start of the playback.
+class GeneratorControl
+{
+public:
+	GeneratorControl(unsigned int);
+
+	bool execute(const std::string &, std::string &);
+	void publish();
+
+	ChannelControl				channels[GENERATOR_CHANNELS];
+	Snapshot<GeneratorSettings>		settings;
+	std::atomic<bool>			align_phases;
+	std::shared_ptr<WaveformFile>		files[GENERATOR_CHANNELS];
+	MarkerQueue				markers;
+	bool					wants_running;
+	bool					wants_quit;
+	bool					running;
+	uint64_t				underruns;
+	unsigned int				sample_rate;
+
+private:
+	std::string status() const;
+};
+
+// Plays the waveform described by a GeneratorControl in real time. The
+// producer thread renders one buffer at a time as long as the playback
+// ring is below the target latency, like the worker thread of the console.
+class GeneratorPlayer
+{
+public:
+	GeneratorPlayer();
+	~GeneratorPlayer();
+
+	bool start(GeneratorControl*, const char*, unsigned int, double);
+	void stop();
+	bool isRunning() const;
+	uint64_t underruns() const;
+	int openError() const;
+
+private:
+	void run();
+
+	GeneratorControl*	control;
+	PlaybackDevice		playback;
+	std::thread		producer;
+	std::atomic<bool>	stopping;
+	bool			running;
+	unsigned int		sample_rate;
+};
+
+bool wXs_parse_waveform(const std::string &, unsigned int*);
+const char* wXs_waveform_name(unsigned int);
+
+#endif
@@ -0,0 +1,539 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#include "wavex-engine_dds.h"
+
+// One period of each waveform, plus a copy of the first entry so that the
+// interpolation never wraps. The phase conventions are those of sin(): the
+// triangle rises through zero at the start of the period, the square is
+// positive over its first half.
+//
+// The band-limited levels are summed from the Fourier series of square
+// and triangle waves, which contain odd harmonics only:
+//	square(x) = 4/pi * sum_k sin(2 pi k x) / k
+//	triangle(x) = 8/pi^2 * sum_k (-1)^((k-1)/2) sin(2 pi k x) / k^2
+// The sines of the harmonics are taken from a table of one period, index
+// k*n modulo the table size being exact.
+class WavetableSet
+{
+public:
+	WavetableSet()
+	{
+		tables.assign(NR_WAVEFORMS, std::vector<float>(DDS_TABLE_SIZE + 1));
+		for (int k = 0; k <= DDS_TABLE_SIZE; k++) {
+			double x = (double) (k % DDS_TABLE_SIZE) / DDS_TABLE_SIZE;
+			tables[SINE][k] = sin(8.0 * atan(1.0) * x);
+			if (x < 0.25)
+				tables[TRIANGULAR][k] = 4.0 * x;
+			else if (x < 0.75)
+				tables[TRIANGULAR][k] = 2.0 - 4.0 * x;
+			else
+				tables[TRIANGULAR][k] = 4.0 * x - 4.0;
+			if ((k % (DDS_TABLE_SIZE / 2)) == 0)
+				tables[SQUARE][k] = 0.0;
+			else
+				tables[SQUARE][k] = (x < 0.5)? 1.0 : -1.0;
+		}
+
+		double pi = 4.0 * atan(1.0);
+		std::vector<double> sine(DDS_TABLE_SIZE);
+		for (int n = 0; n < DDS_TABLE_SIZE; n++)
+			sine[n] = sin(2.0 * pi * n / DDS_TABLE_SIZE);
+		std::vector<double> square(DDS_TABLE_SIZE), triangle(DDS_TABLE_SIZE);
+		band_limited.assign(NR_WAVEFORMS, std::vector< std::vector<float> >(DDS_TABLE_BITS));
+		int last_harmonic = 0;
+		for (int l = 0; l < DDS_TABLE_BITS; l++) {
+			for (int k = last_harmonic + 1; k <= (1 << l); k++) {
+				if ((k % 2) == 0)
+					continue;
+				double b_square = 4.0 / (pi * k);
+				double b_triangle = 8.0 / (pi * pi * k * k) * (((k / 2) % 2 == 0)? 1.0 : -1.0);
+				for (int n = 0; n < DDS_TABLE_SIZE; n++) {
+					double y = sine[((int64_t) k * n) % DDS_TABLE_SIZE];
+					square[n] += b_square * y;
+					triangle[n] += b_triangle * y;
+				}
+			}
+			last_harmonic = 1 << l;
+			band_limited[SINE][l] = tables[SINE];
+			band_limited[TRIANGULAR][l].resize(DDS_TABLE_SIZE + 1);
+			band_limited[SQUARE][l].resize(DDS_TABLE_SIZE + 1);
+			for (int n = 0; n <= DDS_TABLE_SIZE; n++) {
+				band_limited[TRIANGULAR][l][n] = triangle[n % DDS_TABLE_SIZE];
+				band_limited[SQUARE][l][n] = square[n % DDS_TABLE_SIZE];
+			}
+		}
+	}
+
+	std::vector< std::vector<float> >			tables;
+	std::vector< std::vector< std::vector<float> > >	band_limited;
+};
+
+static const WavetableSet & wXs_wavetables()
+{
+	static const WavetableSet wavetables;
+	return wavetables;
+}
+
+const float* wXs_wavetable(unsigned int waveform)
+{
+	if (waveform >= NR_WAVEFORMS)
+		return NULL;
+	return wXs_wavetables().tables[waveform].data();
+}
+
+// Picks the level whose highest harmonic, 2^l times the frequency, does not
+// exceed half the sample rate, i.e. 2^l * increment <= 2^63.
+const float* wXs_band_limited_wavetable(unsigned int waveform, uint64_t increment)
+{
+	if (waveform >= NR_WAVEFORMS)
+		return NULL;
+	int level = DDS_TABLE_BITS - 1;
+	if (increment > 0) {
+		int exponent;
+		frexp(ldexp((double) increment, -64), &exponent);
+		level = -exponent - 1;
+		level = (level < 0)? 0 : ((level > DDS_TABLE_BITS - 1)? DDS_TABLE_BITS - 1 : level);
+	}
+	return wXs_wavetables().band_limited[waveform][level].data();
+}
+
+// Phase increment per sample of a frequency, in units of 2^-64 turns.
+uint64_t wXs_phase_increment(double frequency, unsigned int sample_rate)
+{
+	double turns = frequency / sample_rate;
+	turns -= floor(turns);
+	double increment = ldexp(turns, 64);
+	if (increment >= ldexp(1.0, 64))
+		return 0;
+	return (uint64_t) increment;
+}
+
+// Phase offset corresponding to a delay, in units of 2^-64 turns.
+uint64_t wXs_phase_offset(double frequency, double delay)
+{
+	double turns = -frequency * delay;
+	turns -= floor(turns);
+	return (turns < 1.0)? (uint64_t) ldexp(turns, 64) : 0;
+}
+
+Oscillator::Oscillator()
+{
+	table = wXs_wavetable(SINE);
+	accumulator = 0;
+	increment = 0;
+	target_increment = 0;
+	increment_step = 0;
+	offset = 0;
+	frequency = 0.0;
+	delay = 0.0;
+	amplitude = 0.0;
+	target_amplitude = 0.0;
+	amplitude_step = 0.0;
+	ramp_remaining = 0;
+	configured = false;
+	sweep.mode = SWEEP_OFF;
+	sweep_rate = 0;
+	sweep_step = 0;
+	sweep_position = 0;
+	sweep_length = 1;
+	chirp_start = 0.0;
+	chirp_log_ratio = 0.0;
+	burst_cycle = 0;
+	burst_count = 0;
+	sweep_done = false;
+	sweep_mark_pending = false;
+	sweep_markers.reserve(16);
+	modulation_type = MODULATION_OFF;
+	modulation_scale = 0.0;
+	modulation_depth = 0.0;
+}
+
+// Called once per buffer with the current settings: a ramp is started
+// only when the frequency or the amplitude actually differs from the one
+// being approached. The first settings are applied at once.
+void Oscillator::configure(const OscillatorSettings & settings, unsigned int sample_rate)
+{
+	bool valid = settings.waveform < NR_WAVEFORMS;
+	uint64_t new_increment = wXs_phase_increment(settings.frequency, sample_rate);
+	float new_amplitude = (settings.enabled && valid)? settings.amplitude : 0.0;
+	if (!configured || (settings.delay != delay)) {
+		delay = settings.delay;
+		offset = wXs_phase_offset(settings.frequency, delay);
+	}
+	frequency = settings.frequency;
+
+	if (!configured || (new_increment != target_increment) || (new_amplitude != target_amplitude)) {
+		unsigned int nr_frames = (unsigned int) (settings.ramp_time * sample_rate);
+		target_increment = new_increment;
+		target_amplitude = new_amplitude;
+		if (!configured || (nr_frames == 0)) {
+			increment = target_increment;
+			amplitude = target_amplitude;
+			ramp_remaining = 0;
+		} else {
+			increment_step = (int64_t) (((double) target_increment - (double) increment) / nr_frames);
+			amplitude_step = (target_amplitude - amplitude) / nr_frames;
+			ramp_remaining = nr_frames;
+		}
+		configured = true;
+	}
+
+	sweep_rate = sample_rate;
+	if (!wXs_same_sweep(settings.sweep, sweep)) {
+		sweep = settings.sweep;
+		if (sweep.mode == SWEEP_OFF)
+			increment = target_increment;
+		else
+			startSweep();
+	}
+
+	// The deviations are in units of 2^-32 turn (per sample for FM); the
+	// FM deviation is held at the Nyquist frequency at most.
+	modulation_type = settings.modulation.type;
+	modulation_depth = settings.modulation.depth;
+	if (modulation_type == MODULATION_FM)
+		modulation_scale = ldexp(fmin(settings.modulation.depth, 0.5 * sample_rate) / sample_rate, 32);
+	else if (modulation_type == MODULATION_PM)
+		modulation_scale = ldexp(settings.modulation.depth / (8.0 * atan(1.0)), 32);
+	else
+		modulation_scale = 0.0;
+
+	// While ramping, the table must suit the higher of the two frequencies;
+	// during a sweep, the highest one it reaches; under FM or PM, the peak
+	// instantaneous frequency.
+	uint64_t widest = (increment > target_increment)? increment : target_increment;
+	if ((sweep.mode != SWEEP_OFF) && (sweep.mode != SWEEP_BURST))
+		widest = wXs_phase_increment(wXs_sweep_max_frequency(sweep, frequency), sample_rate);
+	else if (modulation_type == MODULATION_FM)
+		widest += wXs_phase_increment(settings.modulation.depth, sample_rate);
+	else if (modulation_type == MODULATION_PM)
+		widest += wXs_phase_increment(settings.modulation.depth * settings.modulation.frequency, sample_rate);
+	if (!valid)
+		table = wXs_wavetable(SINE);
+	else if (settings.band_limited)
+		table = wXs_band_limited_wavetable(settings.waveform, widest);
+	else
+		table = wXs_wavetable(settings.waveform);
+	return;
+}
+
+// Sets the phase to the one the oscillator would have after sample_index
+// samples at the current frequency, so that oscillators aligned at the same
+// index keep the phase relation set by their delays.
+void Oscillator::align(uint64_t sample_index)
+{
+	accumulator = increment * sample_index;
+	offset = wXs_phase_offset(frequency, delay);
+	if (sweep.mode != SWEEP_OFF)
+		startSweep();
+	return;
+}
+
+const std::vector<SweepMarker> & Oscillator::markers() const
+{
+	return sweep_markers;
+}
+
+void Oscillator::mark(uint64_t frame, unsigned int step, double step_frequency)
+{
+	SweepMarker marker;
+	marker.frame = frame;
+	marker.channel = 0;
+	marker.step = step;
+	marker.frequency = step_frequency;
+	sweep_markers.push_back(marker);
+	return;
+}
+
+// Every run of the sweep starts with the phase at zero; its first marker
+// is published at the first frame of the next render().
+void Oscillator::startSweep()
+{
+	accumulator = 0;
+	sweep_step = 0;
+	sweep_position = 0;
+	burst_cycle = 0;
+	burst_count = 0;
+	sweep_done = false;
+	sweep_length = (uint64_t) llround(sweep.dwell * sweep_rate);
+	if (sweep_length < 1)
+		sweep_length = 1;
+	if ((sweep.mode == SWEEP_LINEAR) || (sweep.mode == SWEEP_LOGARITHMIC)) {
+		increment = wXs_phase_increment(wXs_sweep_frequency(sweep, 0), sweep_rate);
+	} else if (sweep.mode == SWEEP_CHIRP) {
+		// Held at the Nyquist frequency at most, so that the increment
+		// always fits in the accumulator.
+		double nyquist = 0.5 * sweep_rate;
+		double start_frequency = (sweep.start_frequency < nyquist)? sweep.start_frequency : nyquist;
+		double stop_frequency = (sweep.stop_frequency < nyquist)? sweep.stop_frequency : nyquist;
+		chirp_start = ldexp(start_frequency / sweep_rate, 64);
+		chirp_log_ratio = log(stop_frequency / start_frequency) / sweep_length;
+	}
+	sweep_mark_pending = true;
+	return;
+}
+
+// The phases of a block are computed first and the table lookups done in
+// a separate loop, both free of branches, so that the compiler can
+// vectorize them. During a ramp the phases and gains are computed sample
+// by sample.
+inline void Oscillator::lookup(const uint64_t* phase, float* y, unsigned int n) const
+{
+	for (unsigned int j = 0; j < n; j++) {
+		uint32_t index = (uint32_t) (phase[j] >> DDS_INDEX_SHIFT);
+		float fraction = (float) ((phase[j] >> DDS_FRACTION_SHIFT) & 0xFFFFFF) * (1.0f / 16777216.0f);
+		float y0 = table[index];
+		float y1 = table[index + 1];
+		y[j] = y0 + fraction * (y1 - y0);
+	}
+	return;
+}
+
+void Oscillator::render(float* out, unsigned int nr_frames)
+{
+	sweep_markers.clear();
+	if (sweep.mode != SWEEP_OFF) {
+		renderSweep(out, nr_frames);
+		return;
+	}
+	if ((amplitude == 0.0) && (ramp_remaining == 0)) {
+		for (unsigned int j = 0; j < nr_frames; j++)
+			out[j] = 0.0;
+		accumulator += increment * nr_frames;
+		return;
+	}
+	uint64_t phase[DDS_BLOCK_SIZE];
+	float gain[DDS_BLOCK_SIZE];
+	for (unsigned int first = 0; first < nr_frames; first += DDS_BLOCK_SIZE) {
+		unsigned int n = (nr_frames - first < DDS_BLOCK_SIZE)? nr_frames - first : DDS_BLOCK_SIZE;
+		bool ramping = (ramp_remaining > 0);
+		if (!ramping) {
+			uint64_t start = accumulator + offset;
+			for (unsigned int j = 0; j < n; j++)
+				phase[j] = start + increment * j;
+			accumulator += increment * n;
+		} else {
+			for (unsigned int j = 0; j < n; j++) {
+				phase[j] = accumulator + offset;
+				gain[j] = amplitude;
+				accumulator += increment;
+				if (ramp_remaining > 0) {
+					increment += increment_step;
+					amplitude += amplitude_step;
+					if (--ramp_remaining == 0) {
+						increment = target_increment;
+						amplitude = target_amplitude;
+					}
+				}
+			}
+		}
+		float* y = out + first;
+		lookup(phase, y, n);
+		if (ramping) {
+			for (unsigned int j = 0; j < n; j++)
+				y[j] *= gain[j];
+		} else {
+			for (unsigned int j = 0; j < n; j++)
+				y[j] *= amplitude;
+		}
+	}
+	return;
+}
+
+// The increments and gains of a block are laid out first, ramps included;
+// the modulation then enters through loops of its own, which vectorize,
+// leaving only the running sum of the increments to be done serially.
+void Oscillator::renderModulated(float* out, const float* modulation, unsigned int nr_frames)
+{
+	if ((sweep.mode != SWEEP_OFF) || (modulation_type == MODULATION_OFF)) {
+		render(out, nr_frames);
+		return;
+	}
+	sweep_markers.clear();
+	uint64_t phase[DDS_BLOCK_SIZE];
+	uint64_t step[DDS_BLOCK_SIZE];
+	float gain[DDS_BLOCK_SIZE];
+	for (unsigned int first = 0; first < nr_frames; first += DDS_BLOCK_SIZE) {
+		unsigned int n = (nr_frames - first < DDS_BLOCK_SIZE)? nr_frames - first : DDS_BLOCK_SIZE;
+		const float* m = modulation + first;
+		if (ramp_remaining == 0) {
+			for (unsigned int j = 0; j < n; j++) {
+				step[j] = increment;
+				gain[j] = amplitude;
+			}
+		} else {
+			for (unsigned int j = 0; j < n; j++) {
+				step[j] = increment;
+				gain[j] = amplitude;
+				if (ramp_remaining > 0) {
+					increment += increment_step;
+					amplitude += amplitude_step;
+					if (--ramp_remaining == 0) {
+						increment = target_increment;
+						amplitude = target_amplitude;
+					}
+				}
+			}
+		}
+		if (modulation_type == MODULATION_FM) {
+			for (unsigned int j = 0; j < n; j++)
+				step[j] += (uint64_t) (int64_t) (m[j] * modulation_scale) << 32;
+		}
+		for (unsigned int j = 0; j < n; j++) {
+			phase[j] = accumulator + offset;
+			accumulator += step[j];
+		}
+		if (modulation_type == MODULATION_PM) {
+			for (unsigned int j = 0; j < n; j++)
+				phase[j] += (uint64_t) (int64_t) (m[j] * modulation_scale) << 32;
+		}
+
+		float* y = out + first;
+		lookup(phase, y, n);
+		if (modulation_type == MODULATION_AM) {
+			for (unsigned int j = 0; j < n; j++)
+				y[j] *= gain[j] * (1.0f + modulation_depth * m[j]);
+		} else {
+			for (unsigned int j = 0; j < n; j++)
+				y[j] *= gain[j];
+		}
+	}
+	return;
+}
+
+// Moves a stepped sweep to its next frequency at the given frame.
+void Oscillator::nextStep(uint64_t frame)
+{
+	sweep_position = 0;
+	if (++sweep_step == sweep.nr_steps) {
+		if (sweep.once) {
+			endSweep(frame, sweep.nr_steps);
+			return;
+		}
+		sweep_step = 0;
+		accumulator = 0;
+	}
+	double step_frequency = wXs_sweep_frequency(sweep, sweep_step);
+	increment = wXs_phase_increment(step_frequency, sweep_rate);
+	mark(frame, sweep_step, step_frequency);
+	return;
+}
+
+void Oscillator::endSweep(uint64_t frame, unsigned int step)
+{
+	sweep_done = true;
+	mark(frame, step, 0.0);
+	return;
+}
+
+// Same as render(), the phase being advanced sample by sample. The chirp
+// increment of a sample is the frequency at its middle, so that the phase
+// follows the analytic one of the exponential sweep; it is recomputed
+// exactly at the start of each block and updated by the constant ratio in
+// between, so that rounding errors cannot build up. Amplitude ramps apply,
+// frequency ramps only to bursts.
+void Oscillator::renderSweep(float* out, unsigned int nr_frames)
+{
+	uint64_t phase[DDS_BLOCK_SIZE];
+	float gain[DDS_BLOCK_SIZE];
+	unsigned int burst_period = sweep.burst_cycles + sweep.gap_cycles;
+	for (unsigned int first = 0; first < nr_frames; first += DDS_BLOCK_SIZE) {
+		unsigned int n = (nr_frames - first < DDS_BLOCK_SIZE)? nr_frames - first : DDS_BLOCK_SIZE;
+		double chirp_increment = chirp_start * exp(chirp_log_ratio * (sweep_position + 0.5));
+		double chirp_ratio = exp(chirp_log_ratio);
+		for (unsigned int j = 0; j < n; j++) {
+			uint64_t frame = first + j;
+			if (sweep_mark_pending) {
+				mark(frame, 0, (sweep.mode == SWEEP_BURST)? frequency : ((sweep.mode == SWEEP_CHIRP)? sweep.start_frequency : wXs_sweep_frequency(sweep, 0)));
+				sweep_mark_pending = false;
+			}
+			phase[j] = accumulator + offset;
+			gain[j] = sweep_done? 0.0f : amplitude;
+			if (ramp_remaining > 0) {
+				amplitude += amplitude_step;
+				if (sweep.mode == SWEEP_BURST)
+					increment += increment_step;
+				if (--ramp_remaining == 0) {
+					amplitude = target_amplitude;
+					if (sweep.mode == SWEEP_BURST)
+						increment = target_increment;
+				}
+			}
+			if (sweep_done) {
+				accumulator += increment;
+				continue;
+			}
+
+			if (sweep.mode == SWEEP_BURST) {
+				if (burst_cycle >= sweep.burst_cycles)
+					gain[j] = 0.0f;
+				uint64_t next = accumulator + increment;
+				if (next < accumulator) {
+					if (++burst_cycle == burst_period) {
+						burst_cycle = 0;
+						burst_count++;
+						if (sweep.once)
+							endSweep(frame + 1, burst_count);
+						else
+							mark(frame + 1, burst_count, frequency);
+					}
+				}
+				accumulator = next;
+			} else if (sweep.mode == SWEEP_CHIRP) {
+				accumulator += (uint64_t) chirp_increment;
+				chirp_increment *= chirp_ratio;
+				if (++sweep_position == sweep_length) {
+					sweep_position = 0;
+					chirp_increment = chirp_start * exp(0.5 * chirp_log_ratio);
+					accumulator = 0;
+					if (sweep.once)
+						endSweep(frame + 1, 1);
+					else
+						mark(frame + 1, 0, sweep.start_frequency);
+				}
+			} else {
+				accumulator += increment;
+				if (++sweep_position == sweep_length)
+					nextStep(frame + 1);
+			}
+		}
+		float* y = out + first;
+		lookup(phase, y, n);
+		for (unsigned int j = 0; j < n; j++)
+			y[j] *= gain[j];
+	}
+	return;
+}
+
+// Converts a block of one channel to int16, with saturation, into an
+// interleaved buffer of nr_channels channels.
+void wXs_interleave(const float* in, int16_t* buf, unsigned int channel, unsigned int nr_channels, unsigned int nr_frames)
+{
+	for (unsigned int j = 0; j < nr_frames; j++) {
+		float v = in[j];
+		v = (v > 32767.0f)? 32767.0f : ((v < -32768.0f)? -32768.0f : v);
+		buf[j * nr_channels + channel] = (int16_t) lrintf(v);
+	}
+	return;
+}
@@ -0,0 +1,156 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#ifndef INCLUDED_WAVEX_DDS
+#define INCLUDED_WAVEX_DDS
+
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+
+#include "wavex-engine_sweep.h"
+#include "wavex-engine_modulation.h"
+
+#define DDS_TABLE_BITS 12
+#define DDS_TABLE_SIZE (1 << DDS_TABLE_BITS)
+#define DDS_INDEX_SHIFT (64 - DDS_TABLE_BITS)
+#define DDS_FRACTION_SHIFT (DDS_INDEX_SHIFT - 24)
+#define DDS_BLOCK_SIZE 256
+
+// Waveforms synthesized from wavetables; ARBITRARY, played from a file by
+// a FilePlayer, and the noises of a NoiseGenerator come after them.
+enum Waveform : unsigned int {
+	SINE = 0,
+	TRIANGULAR = 1,
+	SQUARE = 2,
+	NR_WAVEFORMS = 3,
+	ARBITRARY = 3,
+	WHITE_NOISE = 4,
+	PINK_NOISE = 5
+};
+
+// Settings of one output channel; the amplitude is in sample units and the
+// delay in seconds, a positive delay shifting the waveform to the right.
+// A band-limited waveform contains no harmonics above the Nyquist frequency
+// and is therefore free of aliasing; its edges ring slightly (about 9%
+// overshoot for the square wave). Changes of frequency and amplitude,
+// including switching the output on and off, are spread linearly over
+// ramp_time seconds; zero applies them at once. The seed only matters for
+// noise, the sweep only for the waveforms synthesized by an Oscillator; so
+// does the modulation, except AM, which applies to every waveform.
+struct OscillatorSettings {
+	bool		enabled;
+	bool		band_limited;
+	unsigned int	waveform;
+	double		frequency;
+	double		amplitude;
+	double		delay;
+	double		ramp_time;
+	unsigned int	seed;
+	SweepSettings	sweep;
+	ModulationSettings	modulation;
+};
+
+// Direct digital synthesis: the phase is a 64-bit accumulator, one full
+// turn being 2^64, so that it wraps exactly and the output stays phase
+// continuous however long it runs. The top DDS_TABLE_BITS bits address a
+// wavetable of one period, the next 24 bits interpolate linearly between
+// entries. Settings can be changed at any time without a phase jump: a new
+// frequency only changes the increment. The delay is an offset added to
+// the accumulator, set when the delay itself changes or when the phase is
+// aligned.
+//
+// Band-limited waveforms are read from mip-mapped wavetables: level l holds
+// the Fourier series truncated at harmonic 2^l, and the level with the
+// most harmonics still below the Nyquist frequency is picked whenever the
+// frequency changes. The rendering cost is the same as for naive tables.
+//
+// A sweep drives the increment (or, for bursts, the gain) sample by
+// sample, so that its steps fall on exact frames; it restarts whenever its
+// settings change, and on align(), which thus also synchronizes the
+// sweeps of several channels. The markers of a render() call, with frames
+// counted from its first frame, remain available until the next call.
+//
+// renderModulated() takes the modulating signal, one value per frame, and
+// works on the phases and gains of the same blocks as render(): FM adds
+// the deviation to the increment of each sample, PM to its phase, AM
+// scales its gain. Both deviations are fixed-point multiples of 2^-32
+// turn, so that no sample needs a transcendental function and no depth can
+// overflow the accumulator. A sweep takes precedence over the modulation.
+class Oscillator
+{
+public:
+	Oscillator();
+
+	void configure(const OscillatorSettings &, unsigned int);
+	void align(uint64_t);
+	void render(float*, unsigned int);
+	void renderModulated(float*, const float*, unsigned int);
+	const std::vector<SweepMarker> & markers() const;
+
+private:
+	void lookup(const uint64_t*, float*, unsigned int) const;
+	void startSweep();
+	void nextStep(uint64_t);
+	void endSweep(uint64_t, unsigned int);
+	void mark(uint64_t, unsigned int, double);
+	void renderSweep(float*, unsigned int);
+
+	const float*	table;
+	uint64_t	accumulator;
+	uint64_t	increment;
+	uint64_t	target_increment;
+	int64_t		increment_step;
+	uint64_t	offset;
+	double		frequency;
+	double		delay;
+	float		amplitude;
+	float		target_amplitude;
+	float		amplitude_step;
+	unsigned int	ramp_remaining;
+	bool		configured;
+	SweepSettings	sweep;
+	unsigned int	sweep_rate;
+	unsigned int	sweep_step;
+	uint64_t	sweep_position;
+	uint64_t	sweep_length;
+	double		chirp_start;
+	double		chirp_log_ratio;
+	unsigned int	burst_cycle;
+	unsigned int	burst_count;
+	bool		sweep_done;
+	bool		sweep_mark_pending;
+	std::vector<SweepMarker>	sweep_markers;
+	unsigned int	modulation_type;
+	double		modulation_scale;
+	float		modulation_depth;
+};
+
+const float* wXs_wavetable(unsigned int);
+const float* wXs_band_limited_wavetable(unsigned int, uint64_t);
+uint64_t wXs_phase_increment(double, unsigned int);
+uint64_t wXs_phase_offset(double, double);
+void wXs_interleave(const float*, int16_t*, unsigned int, unsigned int, unsigned int);
+
+#endif
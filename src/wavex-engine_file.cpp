@@ -0,0 +1,478 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+
+#include "wavex-engine_file.h"
+
+static uint16_t wXs_read_u16(const char* p)
+{
+	const unsigned char* b = (const unsigned char*) p;
+	return (uint16_t) (b[0] | (b[1] << 8));
+}
+
+static uint32_t wXs_read_u32(const char* p)
+{
+	const unsigned char* b = (const unsigned char*) p;
+	return (uint32_t) b[0] | ((uint32_t) b[1] << 8) | ((uint32_t) b[2] << 16) | ((uint32_t) b[3] << 24);
+}
+
+static void wXs_write_u16(char* p, uint16_t v)
+{
+	p[0] = (char) (v & 0xFF);
+	p[1] = (char) (v >> 8);
+	return;
+}
+
+static void wXs_write_u32(char* p, uint32_t v)
+{
+	for (int k = 0; k < 4; k++)
+		p[k] = (char) ((v >> (8 * k)) & 0xFF);
+	return;
+}
+
+static inline uint64_t wXs_wrap(uint64_t k, uint64_t length)
+{
+	return (k < length)? k : k % length;
+}
+
+WaveformFile::WaveformFile()
+{
+	fd = -1;
+	map = NULL;
+	map_size = 0;
+	data_offset = 0;
+	nr_frames = 0;
+	nr_channels = 0;
+	sample_rate = 0;
+	format = 0;
+	frame_size = 0;
+	prefetched_from = 0;
+	prefetched_until = 0;
+}
+
+WaveformFile::~WaveformFile()
+{
+	close();
+}
+
+bool WaveformFile::open(const std::string & name)
+{
+	close();
+	file_name = name;
+	fd = ::open(name.c_str(), O_RDONLY);
+	if (fd < 0) {
+		std::cerr << "Cannot open waveform file <" << name << ">\n";
+		return false;
+	}
+	struct stat file_status;
+	if ((fstat(fd, &file_status) < 0) || (file_status.st_size == 0)) {
+		std::cerr << "Waveform file <" << name << "> is empty\n";
+		close();
+		return false;
+	}
+	map_size = (size_t) file_status.st_size;
+	void* address = mmap(NULL, map_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (address == MAP_FAILED) {
+		std::cerr << "Cannot map waveform file <" << name << ">\n";
+		map = NULL;
+		close();
+		return false;
+	}
+	map = (char*) address;
+	madvise(map, map_size, MADV_SEQUENTIAL);
+
+	bool is_wav = (map_size >= 12) && (memcmp(map, "RIFF", 4) == 0) && (memcmp(map + 8, "WAVE", 4) == 0);
+	if (is_wav) {
+		if (!parseWav()) {
+			close();
+			return false;
+		}
+	} else {
+		size_t dot = name.rfind('.');
+		std::string extension = (dot == std::string::npos)? "" : name.substr(dot);
+		format = (extension == ".f32")? FILE_FORMAT_F32 : FILE_FORMAT_S16;
+		nr_channels = 1;
+		sample_rate = FILE_RAW_SAMPLE_RATE;
+		frame_size = (format == FILE_FORMAT_F32)? 4 : 2;
+		data_offset = 0;
+		nr_frames = map_size / frame_size;
+	}
+	if (nr_frames == 0) {
+		std::cerr << "Waveform file <" << name << "> contains no samples\n";
+		close();
+		return false;
+	}
+	prefetch(0);
+	return true;
+}
+
+// Walks the chunks of a RIFF/WAVE file for the format and the samples.
+// A data chunk whose size exceeds the file, as left by an interrupted
+// recording, is truncated to what is actually there.
+bool WaveformFile::parseWav()
+{
+	bool has_format = false;
+	size_t position = 12;
+	while (position + 8 <= map_size) {
+		const char* chunk = map + position;
+		size_t chunk_size = wXs_read_u32(chunk + 4);
+		if (memcmp(chunk, "fmt ", 4) == 0) {
+			if ((chunk_size < 16) || (position + 8 + 16 > map_size))
+				break;
+			unsigned int tag = wXs_read_u16(chunk + 8);
+			nr_channels = wXs_read_u16(chunk + 10);
+			sample_rate = wXs_read_u32(chunk + 12);
+			unsigned int bits = wXs_read_u16(chunk + 22);
+			if ((tag == 0xFFFE) && (chunk_size >= 40) && (position + 8 + 40 <= map_size))
+				tag = wXs_read_u16(chunk + 32);
+			if ((tag == 1) && (bits == 16))
+				format = FILE_FORMAT_S16;
+			else if ((tag == 3) && (bits == 32))
+				format = FILE_FORMAT_F32;
+			else {
+				std::cerr << "Waveform file <" << file_name << ">: only 16-bit integer and 32-bit float samples are supported\n";
+				return false;
+			}
+			frame_size = nr_channels * bits / 8;
+			has_format = (nr_channels > 0) && (sample_rate > 0);
+		} else if (memcmp(chunk, "data", 4) == 0) {
+			if (!has_format)
+				break;
+			data_offset = position + 8;
+			if (chunk_size > map_size - data_offset)
+				chunk_size = map_size - data_offset;
+			nr_frames = chunk_size / frame_size;
+			return true;
+		}
+		position += 8 + chunk_size + (chunk_size & 1);
+	}
+	std::cerr << "Waveform file <" << file_name << "> is not a valid WAV file\n";
+	return false;
+}
+
+void WaveformFile::close()
+{
+	if (map != NULL)
+		munmap(map, map_size);
+	if (fd >= 0)
+		::close(fd);
+	fd = -1;
+	map = NULL;
+	map_size = 0;
+	nr_frames = 0;
+	prefetched_from = 0;
+	prefetched_until = 0;
+	return;
+}
+
+uint64_t WaveformFile::frames() const
+{
+	return nr_frames;
+}
+
+unsigned int WaveformFile::channels() const
+{
+	return nr_channels;
+}
+
+unsigned int WaveformFile::rate() const
+{
+	return sample_rate;
+}
+
+const std::string & WaveformFile::name() const
+{
+	return file_name;
+}
+
+float WaveformFile::sample(uint64_t k, unsigned int c) const
+{
+	const char* p = map + data_offset + k * frame_size;
+	if (format == FILE_FORMAT_F32) {
+		float v;
+		memcpy(&v, p + 4 * c, sizeof(float));
+		return v;
+	}
+	int16_t v;
+	memcpy(&v, p + 2 * c, sizeof(int16_t));
+	return v * (1.0f / 32768.0f);
+}
+
+void WaveformFile::advise(size_t from, size_t until)
+{
+	size_t page = (size_t) sysconf(_SC_PAGESIZE);
+	from -= from % page;
+	if (until > map_size)
+		until = map_size;
+	if (until > from)
+		madvise(map + from, until - from, MADV_WILLNEED);
+	return;
+}
+
+// Asks the kernel to read the next FILE_PREFETCH_SIZE bytes from the
+// playback position in the background, once half of the previous window
+// has been played, and releases the pages already played; the start of
+// the file is requested too when the window reaches the end, for looping.
+void WaveformFile::prefetch(uint64_t k)
+{
+	size_t position = data_offset + k * frame_size;
+	if ((position >= prefetched_from) && (position + FILE_PREFETCH_SIZE / 2 < prefetched_until))
+		return;
+	size_t page = (size_t) sysconf(_SC_PAGESIZE);
+	size_t start = position - position % page;
+	if ((prefetched_until > prefetched_from) && (start > prefetched_from))
+		madvise(map + prefetched_from, start - prefetched_from, MADV_DONTNEED);
+	advise(start, start + FILE_PREFETCH_SIZE);
+	if (start + FILE_PREFETCH_SIZE > map_size)
+		advise(data_offset, data_offset + start + FILE_PREFETCH_SIZE - map_size);
+	prefetched_from = start;
+	prefetched_until = start + FILE_PREFETCH_SIZE;
+	return;
+}
+
+// Right half of the windowed-sinc kernel, sampled at FILE_SINC_PHASES
+// points per zero crossing up to FILE_SINC_ZEROS zero crossings, plus one
+// point for the interpolation between phases. The Blackman window keeps
+// the stop band below -74 dB.
+static std::vector<float> wXs_sinc_table()
+{
+	double pi = 4.0 * atan(1.0);
+	std::vector<float> table(FILE_SINC_ZEROS * FILE_SINC_PHASES + 2, 0.0f);
+	table[0] = 1.0f;
+	for (int n = 1; n <= FILE_SINC_ZEROS * FILE_SINC_PHASES; n++) {
+		double x = (double) n / FILE_SINC_PHASES;
+		double u = x / FILE_SINC_ZEROS;
+		double window = 0.42 + 0.5 * cos(pi * u) + 0.08 * cos(2.0 * pi * u);
+		table[n] = (float) (window * sin(pi * x) / (pi * x));
+	}
+	return table;
+}
+
+static const std::vector<float> & wXs_sinc_kernel()
+{
+	static const std::vector<float> kernel = wXs_sinc_table();
+	return kernel;
+}
+
+FilePlayer::FilePlayer()
+{
+	frame = 0;
+	fraction = 0;
+	step = 0;
+	channel = 0;
+	gain = 0.0;
+	sinc_scale = 1.0;
+	sinc_width = 0;
+}
+
+// A new file starts from its beginning.
+void FilePlayer::configure(const OscillatorSettings & settings, const std::shared_ptr<WaveformFile> & new_file, unsigned int output_channel, unsigned int sample_rate)
+{
+	if (new_file != file) {
+		file = new_file;
+		frame = 0;
+		fraction = 0;
+	}
+	if (!file) {
+		gain = 0.0;
+		return;
+	}
+	channel = (output_channel < file->channels())? output_channel : 0;
+	step = (uint64_t) ldexp((double) file->rate() / sample_rate, 32);
+	if (step > ((uint64_t) 1 << 32)) {
+		sinc_scale = FILE_SINC_CUTOFF * sample_rate / file->rate();
+		sinc_width = (int) ceil(FILE_SINC_ZEROS / sinc_scale);
+	} else {
+		sinc_width = 0;
+	}
+	gain = settings.enabled? settings.amplitude : 0.0;
+	return;
+}
+
+// Output sample at the current position, filtered by the kernel
+// stretched by the rate ratio: its zero crossings are 1 / sinc_scale file
+// frames apart, which puts the cut-off below the device Nyquist frequency.
+// The weights are normalized by their sum, so that the gain at DC is one
+// whatever the fraction. The base is a multiple of the file length larger
+// than the kernel, for the frames before the position to wrap.
+float FilePlayer::decimate(uint64_t base) const
+{
+	const std::vector<float> & kernel = wXs_sinc_kernel();
+	float t = fraction * (1.0f / 4294967296.0f);
+	float phases = (float) (sinc_scale * FILE_SINC_PHASES);
+	float sum = 0.0f, weights = 0.0f;
+	uint64_t length = file->frames();
+	for (int i = 1 - sinc_width; i <= sinc_width; i++) {
+		float x = fabsf((float) i - t) * phases;
+		int n = (int) x;
+		if (n >= FILE_SINC_ZEROS * FILE_SINC_PHASES)
+			continue;
+		float weight = kernel[n] + (x - n) * (kernel[n + 1] - kernel[n]);
+		sum += weight * file->sample(wXs_wrap(frame + base + i, length), channel);
+		weights += weight;
+	}
+	return sum / weights;
+}
+
+// The position is a 32.32 fixed-point frame index; the four samples around
+// it are interpolated by a Catmull-Rom spline, wrapping at the end of the
+// file, unless the file is decimated.
+void FilePlayer::render(float* out, unsigned int nr_frames)
+{
+	if (!file || (gain == 0.0)) {
+		for (unsigned int j = 0; j < nr_frames; j++)
+			out[j] = 0.0;
+		return;
+	}
+	uint64_t length = file->frames();
+	file->prefetch(frame);
+	if (sinc_width > 0) {
+		uint64_t base = length * (sinc_width / length + 1);
+		for (unsigned int j = 0; j < nr_frames; j++) {
+			out[j] = gain * decimate(base);
+			uint64_t position = (uint64_t) fraction + step;
+			fraction = (uint32_t) position;
+			frame = wXs_wrap(frame + (position >> 32), length);
+		}
+		return;
+	}
+	for (unsigned int j = 0; j < nr_frames; j++) {
+		uint64_t k0 = wXs_wrap(frame + length - 1, length);
+		uint64_t k2 = wXs_wrap(frame + 1, length);
+		uint64_t k3 = wXs_wrap(frame + 2, length);
+		float y0 = file->sample(k0, channel);
+		float y1 = file->sample(frame, channel);
+		float y2 = file->sample(k2, channel);
+		float y3 = file->sample(k3, channel);
+		float t = fraction * (1.0f / 4294967296.0f);
+		float a = -0.5f * y0 + 1.5f * y1 - 1.5f * y2 + 0.5f * y3;
+		float b = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
+		float c = 0.5f * (y2 - y0);
+		out[j] = gain * (((a * t + b) * t + c) * t + y1);
+		uint64_t position = (uint64_t) fraction + step;
+		fraction = (uint32_t) position;
+		frame = wXs_wrap(frame + (position >> 32), length);
+	}
+	return;
+}
+
+WaveformWriter::WaveformWriter()
+{
+	fd = -1;
+	nr_channels = 0;
+	sample_rate = 0;
+	nr_frames = 0;
+	write_failed = false;
+}
+
+WaveformWriter::~WaveformWriter()
+{
+	close();
+}
+
+bool WaveformWriter::open(const std::string & name, unsigned int rate, unsigned int channels)
+{
+	close();
+	fd = ::open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (fd < 0) {
+		std::cerr << "Cannot create waveform file <" << name << ">: " << strerror(errno) << "\n";
+		return false;
+	}
+	file_name = name;
+	sample_rate = rate;
+	nr_channels = channels;
+	nr_frames = 0;
+	write_failed = false;
+
+	char buf[FILE_WAV_HEADER_SIZE];
+	header(buf, 0);
+	if (::write(fd, buf, FILE_WAV_HEADER_SIZE) != FILE_WAV_HEADER_SIZE) {
+		std::cerr << "Cannot write waveform file <" << name << ">\n";
+		close();
+		return false;
+	}
+	return true;
+}
+
+// Canonical 44-byte header of a 16-bit PCM file; sizes beyond 4 GB are
+// clipped.
+void WaveformWriter::header(char* buf, uint64_t frames) const
+{
+	uint64_t data_size = frames * nr_channels * sizeof(int16_t);
+	if (data_size > 0xFFFFFFFFull - FILE_WAV_HEADER_SIZE)
+		data_size = 0xFFFFFFFFull - FILE_WAV_HEADER_SIZE;
+	memcpy(buf, "RIFF", 4);
+	wXs_write_u32(buf + 4, (uint32_t) (data_size + FILE_WAV_HEADER_SIZE - 8));
+	memcpy(buf + 8, "WAVEfmt ", 8);
+	wXs_write_u32(buf + 16, 16);
+	wXs_write_u16(buf + 20, 1);
+	wXs_write_u16(buf + 22, (uint16_t) nr_channels);
+	wXs_write_u32(buf + 24, sample_rate);
+	wXs_write_u32(buf + 28, sample_rate * nr_channels * sizeof(int16_t));
+	wXs_write_u16(buf + 32, (uint16_t) (nr_channels * sizeof(int16_t)));
+	wXs_write_u16(buf + 34, 16);
+	memcpy(buf + 36, "data", 4);
+	wXs_write_u32(buf + 40, (uint32_t) data_size);
+	return;
+}
+
+bool WaveformWriter::write(const int16_t* buf, unsigned int frames)
+{
+	if ((fd < 0) || write_failed)
+		return false;
+	size_t size = (size_t) frames * nr_channels * sizeof(int16_t);
+	const char* p = (const char*) buf;
+	while (size > 0) {
+		ssize_t written = ::write(fd, p, size);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			std::cerr << "Error while writing waveform file <" << file_name << ">: " << strerror(errno) << "\n";
+			write_failed = true;
+			return false;
+		}
+		p += written;
+		size -= written;
+	}
+	nr_frames += frames;
+	return true;
+}
+
+// Completes the header; returns false if any sample could not be written.
+bool WaveformWriter::close()
+{
+	if (fd < 0)
+		return false;
+	char buf[FILE_WAV_HEADER_SIZE];
+	header(buf, nr_frames);
+	if (pwrite(fd, buf, FILE_WAV_HEADER_SIZE, 0) != FILE_WAV_HEADER_SIZE)
+		write_failed = true;
+	::close(fd);
+	fd = -1;
+	return !write_failed;
+}
+
+uint64_t WaveformWriter::frames() const
+{
+	return nr_frames;
+}
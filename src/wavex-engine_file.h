@@ -0,0 +1,148 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+
+#ifndef INCLUDED_WAVEX_FILE
+#define INCLUDED_WAVEX_FILE
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <memory>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <errno.h>
+
+#include "wavex-engine_dds.h"
+
+#define FILE_FORMAT_S16 1
+#define FILE_FORMAT_F32 2
+#define FILE_RAW_SAMPLE_RATE 44100
+#define FILE_PREFETCH_SIZE 8388608
+#define FILE_WAV_HEADER_SIZE 44
+#define FILE_SINC_ZEROS 16
+#define FILE_SINC_PHASES 512
+#define FILE_SINC_CUTOFF 0.9
+
+// A waveform stored in a file, mapped in memory rather than loaded: WAV
+// files with int16 or float32 samples, or headerless mono files of int16
+// samples ("*.raw", "*.s16") or float32 samples ("*.f32") at
+// FILE_RAW_SAMPLE_RATE. Opening takes no time whatever the size; pages are
+// read by the kernel ahead of the playback position (see prefetch()) and
+// dropped behind it, so that files larger than the memory play as well.
+// Samples are returned normalized to full scale, i.e. within [-1, 1].
+class WaveformFile
+{
+public:
+	WaveformFile();
+	~WaveformFile();
+
+	bool open(const std::string &);
+	void close();
+	uint64_t frames() const;
+	unsigned int channels() const;
+	unsigned int rate() const;
+	const std::string & name() const;
+	float sample(uint64_t, unsigned int) const;
+	void prefetch(uint64_t);
+
+private:
+	bool parseWav();
+	void advise(size_t, size_t);
+
+	std::string	file_name;
+	int		fd;
+	char*		map;
+	size_t		map_size;
+	size_t		data_offset;
+	uint64_t	nr_frames;
+	unsigned int	nr_channels;
+	unsigned int	sample_rate;
+	unsigned int	format;
+	unsigned int	frame_size;
+	size_t		prefetched_from;
+	size_t		prefetched_until;
+};
+
+// Plays one channel of a WaveformFile in a loop, resampled to the device
+// rate when the rates differ: by cubic Hermite interpolation when the file
+// rate is the lower one, and through a windowed-sinc low-pass filter at
+// FILE_SINC_CUTOFF times the device Nyquist frequency when it is the
+// higher one, so that the content of the file above the device Nyquist
+// frequency does not alias. The output channel c plays the channel c of
+// the file, or its first channel if the file has fewer. The amplitude of
+// the settings is the one of a full-scale sample, so that the calibration
+// of the output channel applies as for the synthesized waveforms.
+class FilePlayer
+{
+public:
+	FilePlayer();
+
+	void configure(const OscillatorSettings &, const std::shared_ptr<WaveformFile> &, unsigned int, unsigned int);
+	void render(float*, unsigned int);
+
+private:
+	float decimate(uint64_t) const;
+
+	std::shared_ptr<WaveformFile>	file;
+	uint64_t			frame;
+	uint32_t			fraction;
+	uint64_t			step;
+	unsigned int			channel;
+	float				gain;
+	double				sinc_scale;
+	int				sinc_width;
+};
+
+// Writes interleaved int16 frames to a WAV file. The sizes in the header
+// are only filled in by close(); a file left unfinished is still read by
+// WaveformFile, which takes whatever samples are there.
+class WaveformWriter
+{
+public:
+	WaveformWriter();
+	~WaveformWriter();
+
+	bool open(const std::string &, unsigned int, unsigned int);
+	bool write(const int16_t*, unsigned int);
+	bool close();
+	uint64_t frames() const;
+
+private:
+	void header(char*, uint64_t) const;
+
+	std::string	file_name;
+	int		fd;
+	unsigned int	nr_channels;
+	unsigned int	sample_rate;
+	uint64_t	nr_frames;
+	bool		write_failed;
+};
+
+#endif
@@ -0,0 +1,178 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+
+#include "wavex-engine_generator.h"
+
+WaveGenerator::WaveGenerator(unsigned int rate)
+{
+	sample_rate = rate;
+	sample_index = 0;
+	align_pending = false;
+}
+
+unsigned int WaveGenerator::rate() const
+{
+	return sample_rate;
+}
+
+uint64_t WaveGenerator::position() const
+{
+	return sample_index;
+}
+
+const std::vector<SweepMarker> & WaveGenerator::markers() const
+{
+	return sweep_markers;
+}
+
+// Restores the phase relation set by the delays, as if all channels had
+// started together at the current frame.
+void WaveGenerator::align()
+{
+	align_pending = true;
+	return;
+}
+
+// Settings of the oscillator or noise source modulating a channel, which
+// runs at unit amplitude; the noise keeps the seed of the channel.
+static OscillatorSettings wXs_modulator_settings(const OscillatorSettings & channel)
+{
+	OscillatorSettings source = channel;
+	source.enabled = true;
+	source.band_limited = false;
+	source.waveform = (channel.modulation.source == MODULATOR_NOISE)? WHITE_NOISE : channel.modulation.source;
+	source.frequency = channel.modulation.frequency;
+	source.amplitude = 1.0;
+	source.delay = 0.0;
+	source.ramp_time = 0.0;
+	source.sweep.mode = SWEEP_OFF;
+	source.modulation.type = MODULATION_OFF;
+	return source;
+}
+
+// Fills the modulating signal of channel c, or returns NULL if there is
+// none.
+const float* WaveGenerator::modulate(unsigned int c, const OscillatorSettings* channels, const bool* rendered, unsigned int nr_frames)
+{
+	const ModulationSettings & m = channels[c].modulation;
+	if ((m.type == MODULATION_OFF) || (m.type > MODULATION_PM))
+		return NULL;
+	if (modulation.size() < nr_frames)
+		modulation.resize(nr_frames);
+
+	if (m.source == MODULATOR_CHANNEL) {
+		unsigned int other = 1 - c;
+		float scale = (rendered[other] && (channels[other].amplitude > 0.0))? 1.0 / channels[other].amplitude : 0.0;
+		for (unsigned int j = 0; j < nr_frames; j++)
+			modulation[j] = blocks[other][j] * scale;
+		return modulation.data();
+	}
+
+	if (m.source == MODULATOR_NOISE) {
+		modulation_noises[c].configure(wXs_modulator_settings(channels[c]), c + GENERATOR_CHANNELS, sample_rate);
+		modulation_noises[c].render(modulation.data(), nr_frames);
+	} else {
+		modulators[c].render(modulation.data(), nr_frames);
+	}
+	return modulation.data();
+}
+
+void WaveGenerator::render(const GeneratorSettings & settings, const std::shared_ptr<WaveformFile>* files, int16_t* buf, unsigned int nr_frames)
+{
+	sweep_markers.clear();
+	OscillatorSettings channels[GENERATOR_CHANNELS];
+	for (int c = 0; c < GENERATOR_CHANNELS; c++) {
+		if (blocks[c].size() < nr_frames)
+			blocks[c].resize(nr_frames);
+		channels[c] = settings.channels[c];
+	}
+
+	// A channel modulating the other comes first; its frequency stands for
+	// the modulating one when picking the wavetable of the other.
+	bool by_other[GENERATOR_CHANNELS];
+	for (int c = 0; c < GENERATOR_CHANNELS; c++)
+		by_other[c] = (channels[c].modulation.type != MODULATION_OFF) && (channels[c].modulation.source == MODULATOR_CHANNEL);
+	if (by_other[0] && by_other[1])
+		channels[0].modulation.type = MODULATION_OFF;
+	for (int c = 0; c < GENERATOR_CHANNELS; c++) {
+		if (by_other[c])
+			channels[c].modulation.frequency = channels[1 - c].frequency;
+	}
+	unsigned int order[GENERATOR_CHANNELS] = {0, 1};
+	if (by_other[0] && !by_other[1]) {
+		order[0] = 1;
+		order[1] = 0;
+	}
+
+	for (int c = 0; c < GENERATOR_CHANNELS; c++) {
+		oscillators[c].configure(channels[c], sample_rate);
+		const ModulationSettings & m = channels[c].modulation;
+		if ((m.type != MODULATION_OFF) && (m.source <= MODULATOR_SQUARE))
+			modulators[c].configure(wXs_modulator_settings(channels[c]), sample_rate);
+	}
+	if (align_pending) {
+		for (int c = 0; c < GENERATOR_CHANNELS; c++) {
+			oscillators[c].align(sample_index);
+			modulators[c].align(sample_index);
+		}
+		align_pending = false;
+	}
+
+	bool rendered[GENERATOR_CHANNELS] = {false, false};
+	for (int k = 0; k < GENERATOR_CHANNELS; k++) {
+		unsigned int c = order[k];
+		const OscillatorSettings & channel = channels[c];
+		float* block = blocks[c].data();
+		const float* m = modulate(c, channels, rendered, nr_frames);
+		if ((channel.waveform == ARBITRARY) || (channel.waveform == WHITE_NOISE) || (channel.waveform == PINK_NOISE)) {
+			if (channel.waveform == ARBITRARY) {
+				players[c].configure(channel, files[c], c, sample_rate);
+				players[c].render(block, nr_frames);
+			} else {
+				noises[c].configure(channel, c, sample_rate);
+				noises[c].render(block, nr_frames);
+			}
+			if ((m != NULL) && (channel.modulation.type == MODULATION_AM)) {
+				float depth = channel.modulation.depth;
+				for (unsigned int j = 0; j < nr_frames; j++)
+					block[j] *= 1.0f + depth * m[j];
+			}
+		} else {
+			if (m != NULL)
+				oscillators[c].renderModulated(block, m, nr_frames);
+			else
+				oscillators[c].render(block, nr_frames);
+			for (size_t i = 0; i < oscillators[c].markers().size(); i++) {
+				SweepMarker marker = oscillators[c].markers()[i];
+				marker.frame += sample_index;
+				marker.channel = c;
+				sweep_markers.push_back(marker);
+			}
+		}
+		wXs_interleave(block, buf, c, GENERATOR_CHANNELS, nr_frames);
+		rendered[c] = true;
+	}
+	sample_index += nr_frames;
+	return;
+}
@@ -0,0 +1,87 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+
+#ifndef INCLUDED_WAVEX_GENERATOR
+#define INCLUDED_WAVEX_GENERATOR
+
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+#include <memory>
+
+#include "wavex-engine_dds.h"
+#include "wavex-engine_file.h"
+#include "wavex-engine_noise.h"
+
+#define GENERATOR_CHANNELS 2
+
+// Settings of both channels, as published to the thread generating the
+// waveform.
+struct GeneratorSettings {
+	OscillatorSettings	channels[GENERATOR_CHANNELS];
+};
+
+// The waveform generator proper, free of any user interface: the console,
+// the daemon and the offline renderer all produce their frames through it.
+// Each call of render() applies the given settings, then fills nr_frames
+// interleaved int16 frames; channel c plays the oscillator, the file c or
+// the noise source selected by its waveform. A phase alignment requested
+// by align() is applied by the next render(), once the new settings are
+// in place. The output only depends on the settings and on the number of
+// frames rendered so far. The sweep markers of the last render() call are
+// returned by markers(), with frames counted from the first frame ever
+// rendered.
+//
+// A modulated channel gets its modulating signal from an oscillator or a
+// noise source of its own, or from the other channel; in the latter case
+// the other channel is rendered first. Should each channel be modulated by
+// the other, channel 2 is modulated by channel 1, which has no modulation.
+class WaveGenerator
+{
+public:
+	WaveGenerator(unsigned int);
+
+	void render(const GeneratorSettings &, const std::shared_ptr<WaveformFile>*, int16_t*, unsigned int);
+	void align();
+	unsigned int rate() const;
+	uint64_t position() const;
+	const std::vector<SweepMarker> & markers() const;
+
+private:
+	const float* modulate(unsigned int, const OscillatorSettings*, const bool*, unsigned int);
+
+	Oscillator		oscillators[GENERATOR_CHANNELS];
+	FilePlayer		players[GENERATOR_CHANNELS];
+	NoiseGenerator		noises[GENERATOR_CHANNELS];
+	Oscillator		modulators[GENERATOR_CHANNELS];
+	NoiseGenerator		modulation_noises[GENERATOR_CHANNELS];
+	std::vector<float>	blocks[GENERATOR_CHANNELS];
+	std::vector<float>	modulation;
+	std::vector<SweepMarker>	sweep_markers;
+	unsigned int		sample_rate;
+	uint64_t		sample_index;
+	bool			align_pending;
+};
+
+#endif
@@ -0,0 +1,432 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+
+#include "wavex-engine_main.h"
+
+// Waveform generator without user interface. By default it plays on the
+// sound card and takes its commands (see GeneratorControl) from a Unix
+// socket, e.g.
+//	echo "frequency 1 1000" | socat - UNIX-CONNECT:wavex.socket
+// With --render it writes the given duration to a WAV file instead, as
+// fast as it can, and exits; the commands are then taken from --script
+// files and --command options, in the order given, and the sweep markers
+// are written next to the file ("<file>.markers").
+//
+// With --measure, the same output is played on the device as a stimulus
+// while its inputs are recorded, both streams being started together on
+// the same card; the file gets the stimulus on channels 1-2 and the
+// response on channels 3-4, aligned frame by frame once the round-trip
+// latency has been measured by --calibrate, with each output looped back
+// to the matching input. With --bode, the frequency response is measured
+// at the frequencies of the sweep of channel 1 (see FrequencyResponse),
+// with its amplitude, and written as a table; --plot shows it with gnuplot.
+int main (int argc, char *argv[])
+{
+	GeneratorControl control(SAMPLING_RATE);
+	PlaybackOptions options;
+	const char* socket_name = SOCKET_DEFAULT_NAME;
+	const char* render_file = NULL;
+	const char* measure_file = NULL;
+	const char* latency_file = MEASURE_DEFAULT_LATENCY_FILE;
+	const char* bode_file = NULL;
+	bool calibrate = false;
+	bool plot = false;
+	double duration = 0.0;
+	options.device_name = PLAYBACK_DEFAULT_DEVICE;
+	options.sample_rate = SAMPLING_RATE;
+	options.latency_ms = PLAYBACK_DEFAULT_LATENCY_MS;
+	std::string reply;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--socket") && (i + 1 < argc)) {
+			socket_name = argv[++i];
+		} else if (!strcmp(argv[i], "--device") && (i + 1 < argc)) {
+			options.device_name = argv[++i];
+		} else if (!strcmp(argv[i], "--latency") && (i + 1 < argc) && (atof(argv[i + 1]) >= PLAYBACK_MIN_LATENCY_MS) && (atof(argv[i + 1]) <= PLAYBACK_MAX_LATENCY_MS)) {
+			options.latency_ms = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "--rate") && (i + 1 < argc) && (atoi(argv[i + 1]) > 0)) {
+			options.sample_rate = atoi(argv[++i]);
+			control.sample_rate = options.sample_rate;
+		} else if (!strcmp(argv[i], "--render") && (i + 1 < argc)) {
+			render_file = argv[++i];
+		} else if (!strcmp(argv[i], "--measure") && (i + 1 < argc)) {
+			measure_file = argv[++i];
+		} else if (!strcmp(argv[i], "--bode") && (i + 1 < argc)) {
+			bode_file = argv[++i];
+		} else if (!strcmp(argv[i], "--plot")) {
+			plot = true;
+		} else if (!strcmp(argv[i], "--calibrate")) {
+			calibrate = true;
+		} else if (!strcmp(argv[i], "--latency-file") && (i + 1 < argc)) {
+			latency_file = argv[++i];
+		} else if (!strcmp(argv[i], "--duration") && (i + 1 < argc) && (atof(argv[i + 1]) > 0.0)) {
+			duration = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "--script") && (i + 1 < argc)) {
+			if (!wXs_run_script(control, argv[++i]))
+				exit(1);
+		} else if (!strcmp(argv[i], "--command") && (i + 1 < argc)) {
+			if (!control.execute(argv[++i], reply)) {
+				std::cerr << "Command <" << argv[i] << ">: " << reply << "\n";
+				exit(1);
+			}
+		} else {
+			std::cerr << "Usage: " << argv[0] << " [--socket <name>] [--device <name>] [--latency <ms>] [--rate <Hz>] [--script <file>]... [--command <command>]... [--render <file.wav> --duration <s>] [--calibrate] [--measure <file.wav> --duration <s>] [--bode <file> [--plot]] [--latency-file <name>]\n";
+			std::cerr << "  Without --render, the generator plays on the device and is controlled through the socket (default " << SOCKET_DEFAULT_NAME << ").\n";
+			std::cerr << "  --script and --command set up the generator before it starts, one command per line (e.g. \"waveform 1 square\").\n";
+			std::cerr << "  --calibrate measures the round-trip latency of the device, outputs looped back to inputs, into the latency file (default " << MEASURE_DEFAULT_LATENCY_FILE << ").\n";
+			std::cerr << "  --measure plays the generator output and records the inputs of the same device, aligned frame by frame.\n";
+			std::cerr << "  --bode measures gain and phase of both inputs at the frequencies of the sweep of channel 1 (e.g. \"sweep 1 log 10 20000 100 2\").\n";
+			exit(1);
+		}
+	}
+	if (((render_file != NULL) || (measure_file != NULL)) && (duration <= 0.0)) {
+		std::cerr << "Offline rendering and measurements require --duration\n";
+		exit(1);
+	}
+
+	requested_termination = false;
+	signal(SIGINT, signalHandler);
+	signal(SIGTERM, signalHandler);
+	signal(SIGPIPE, SIG_IGN);
+
+	if (calibrate)
+		exit(wXs_calibrate_latency(options, latency_file));
+	if (bode_file != NULL)
+		exit(wXs_measure_bode(control, bode_file, plot, options, latency_file));
+	if (measure_file != NULL)
+		exit(wXs_measure_response(control, measure_file, duration, options, latency_file));
+	if (render_file != NULL)
+		exit(wXs_render_offline(control, render_file, duration, options.sample_rate));
+	exit(wXs_serve(control, socket_name, options));
+}
+
+void signalHandler(int signum)
+{
+	requested_termination = true;
+	return;
+}
+
+// Runs the commands of a file, one per line; empty lines and lines
+// starting with '#' are skipped.
+bool wXs_run_script(GeneratorControl & control, const char* file_name)
+{
+	std::ifstream script(file_name);
+	if (!script) {
+		std::cerr << "Cannot open script <" << file_name << ">\n";
+		return false;
+	}
+	std::string line, reply;
+	unsigned int line_number = 0;
+	while (std::getline(script, line)) {
+		line_number++;
+		size_t first = line.find_first_not_of(" \t\r");
+		if ((first == std::string::npos) || (line[first] == '#'))
+			continue;
+		if (!control.execute(line, reply)) {
+			std::cerr << "Script <" << file_name << ">, line " << line_number << ": " << reply << "\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+// Renders the generator output block after block, with no device and no
+// pacing, so that it takes far less than the duration; the result depends
+// on the commands only.
+int wXs_render_offline(GeneratorControl & control, const char* file_name, double duration, unsigned int sample_rate)
+{
+	WaveformWriter writer;
+	if (!writer.open(file_name, sample_rate, GENERATOR_CHANNELS))
+		return 1;
+
+	WaveGenerator generator(sample_rate);
+	GeneratorSettings settings;
+	FILE* marker_file = NULL;
+	int16_t* buf = (int16_t *) malloc(sizeof(int16_t) * RENDER_BLOCK_SIZE * GENERATOR_CHANNELS);
+	uint64_t nr_frames = (uint64_t) llround(duration * sample_rate);
+	uint64_t rendered = 0;
+	control.settings.read(settings);
+	if (control.align_phases.exchange(false))
+		generator.align();
+	std::cerr << "Rendering " << nr_frames << " frames to <" << file_name << ">...";
+	while ((rendered < nr_frames) && !requested_termination) {
+		unsigned int n = (nr_frames - rendered < RENDER_BLOCK_SIZE)? (unsigned int) (nr_frames - rendered) : RENDER_BLOCK_SIZE;
+		generator.render(settings, control.files, buf, n);
+		if (!writer.write(buf, n))
+			break;
+		if (!generator.markers().empty() && (marker_file == NULL))
+			marker_file = wXs_open_marker_file(file_name);
+		if (marker_file != NULL)
+			wXs_write_markers(marker_file, generator.markers(), sample_rate);
+		rendered += n;
+	}
+	free(buf);
+	if (marker_file != NULL)
+		fclose(marker_file);
+	bool complete = writer.close() && (rendered == nr_frames);
+	std::cerr << (complete? " done.\n" : " interrupted.\n");
+	return complete? 0 : 1;
+}
+
+int wXs_calibrate_latency(const PlaybackOptions & options, const char* latency_file)
+{
+	StimulusResponse device;
+	unsigned int sample_rate = options.sample_rate;
+	if (!device.open(options.device_name, &sample_rate))
+		return 1;
+	std::cerr << "Measuring round-trip latency at " << sample_rate << " Hz...";
+	if (!device.calibrate()) {
+		std::cerr << " failed.\n";
+		return 1;
+	}
+	std::cerr << " done.\n";
+	for (int c = 0; c < MEASURE_CHANNELS; c++)
+		std::cerr << "Channel " << c + 1 << ": " << device.latency(c) << " frames (" << 1000.0 * device.latency(c) / sample_rate << " ms)\n";
+	return device.saveLatency(latency_file)? 0 : 1;
+}
+
+// The stimulus is rendered in full before the measurement starts, so that
+// the transfer is not paced by the generator; without a latency file the
+// response is left uncompensated.
+int wXs_measure_response(GeneratorControl & control, const char* file_name, double duration, const PlaybackOptions & options, const char* latency_file)
+{
+	StimulusResponse device;
+	unsigned int sample_rate = options.sample_rate;
+	if (!device.open(options.device_name, &sample_rate))
+		return 1;
+	if (!device.loadLatency(latency_file))
+		std::cerr << "No valid latency in <" << latency_file << ">; the response is not compensated (see --calibrate)\n";
+
+	WaveGenerator generator(sample_rate);
+	GeneratorSettings settings;
+	unsigned int nr_frames = (unsigned int) llround(duration * sample_rate);
+	std::vector<int16_t> stimulus((size_t) nr_frames * GENERATOR_CHANNELS);
+	std::vector<int16_t> response((size_t) nr_frames * MEASURE_CHANNELS);
+	control.settings.read(settings);
+	if (control.align_phases.exchange(false))
+		generator.align();
+	for (unsigned int first = 0; first < nr_frames; first += RENDER_BLOCK_SIZE) {
+		unsigned int n = (nr_frames - first < RENDER_BLOCK_SIZE)? nr_frames - first : RENDER_BLOCK_SIZE;
+		generator.render(settings, control.files, stimulus.data() + (size_t) first * GENERATOR_CHANNELS, n);
+	}
+
+	std::cerr << "Measuring " << nr_frames << " frames...";
+	if (!device.measure(stimulus.data(), response.data(), nr_frames)) {
+		std::cerr << " failed.\n";
+		return 1;
+	}
+	std::cerr << " done.\n";
+
+	WaveformWriter writer;
+	if (!writer.open(file_name, sample_rate, GENERATOR_CHANNELS + MEASURE_CHANNELS))
+		return 1;
+	int16_t* buf = (int16_t *) malloc(sizeof(int16_t) * RENDER_BLOCK_SIZE * (GENERATOR_CHANNELS + MEASURE_CHANNELS));
+	bool complete = true;
+	for (unsigned int first = 0; (first < nr_frames) && complete; first += RENDER_BLOCK_SIZE) {
+		unsigned int n = (nr_frames - first < RENDER_BLOCK_SIZE)? nr_frames - first : RENDER_BLOCK_SIZE;
+		int16_t* frame = buf;
+		for (unsigned int j = first; j < first + n; j++) {
+			for (int c = 0; c < GENERATOR_CHANNELS; c++)
+				*frame++ = stimulus[(size_t) j * GENERATOR_CHANNELS + c];
+			for (int c = 0; c < MEASURE_CHANNELS; c++)
+				*frame++ = response[(size_t) j * MEASURE_CHANNELS + c];
+		}
+		complete = writer.write(buf, n);
+	}
+	free(buf);
+	return (writer.close() && complete)? 0 : 1;
+}
+
+int wXs_measure_bode(GeneratorControl & control, const char* file_name, bool plot, const PlaybackOptions & options, const char* latency_file)
+{
+	StimulusResponse device;
+	unsigned int sample_rate = options.sample_rate;
+	GeneratorSettings settings;
+	control.settings.read(settings);
+	if (!device.open(options.device_name, &sample_rate))
+		return 1;
+	if (!device.loadLatency(latency_file))
+		std::cerr << "No valid latency in <" << latency_file << ">; phases are not compensated (see --calibrate)\n";
+
+	FrequencyResponse analyzer(device);
+	std::vector<BodePoint> points;
+	if (!analyzer.sweep(settings.channels[0].sweep, settings.channels[0].amplitude, points))
+		return 1;
+	double total = 0.0;
+	for (size_t k = 0; k < points.size(); k++)
+		total += points[k].duration;
+	std::cerr << points.size() << " points measured in " << total << " s of response.\n";
+	if (!wXs_write_bode(file_name, points))
+		return 1;
+	if (plot) {
+		std::string command = std::string("gnuplot -persist \"") + file_name + BODE_PLOT_SUFFIX + "\"";
+		if (system(command.c_str()) != 0)
+			std::cerr << "Cannot run gnuplot\n";
+	}
+	return 0;
+}
+
+FILE* wXs_open_marker_file(const char* file_name)
+{
+	std::string marker_name = std::string(file_name) + MARKER_FILE_SUFFIX;
+	FILE* marker_file = fopen(marker_name.c_str(), "w");
+	if (marker_file == NULL) {
+		std::cerr << "Cannot create marker file <" << marker_name << ">\n";
+		return NULL;
+	}
+	fprintf(marker_file, "# channel\tframe\ttime (s)\tstep\tfrequency (Hz)\n");
+	return marker_file;
+}
+
+void wXs_write_markers(FILE* marker_file, const std::vector<SweepMarker> & markers, unsigned int sample_rate)
+{
+	for (size_t k = 0; k < markers.size(); k++)
+		fprintf(marker_file, "%u\t%llu\t%.9f\t%u\t%.6f\n", markers[k].channel + 1, (unsigned long long) markers[k].frame, (double) markers[k].frame / sample_rate, markers[k].step, markers[k].frequency);
+	return;
+}
+
+// Serves the control socket until a "quit" command or a signal. Several
+// clients may be connected at once, their commands being run in the order
+// received. Settings given before "start" (e.g. by --script) apply from
+// the first frame.
+int wXs_serve(GeneratorControl & control, const char* socket_name, const PlaybackOptions & options)
+{
+	std::cerr << "Setting up control socket...";
+	struct sockaddr_un serv_addr;
+	int sockfd;
+	if (strlen(socket_name) >= sizeof(serv_addr.sun_path)) {
+		std::cerr << "Socket name too long... exiting.\n";
+		return 1;
+	}
+	bzero((char *) &serv_addr, sizeof(serv_addr));
+	serv_addr.sun_family = AF_UNIX;
+	strcpy(serv_addr.sun_path, socket_name);
+	if ((sockfd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+		std::cerr << "Error in creating socket... exiting.\n";
+		return 1;
+	}
+	unlink(socket_name);
+	if (bind(sockfd, (struct sockaddr *) &serv_addr, sizeof(serv_addr)) < 0) {
+		std::cerr << "Error while binding socket... exiting.\n";
+		close(sockfd);
+		return 1;
+	}
+	listen(sockfd, SOCKET_MAX_CLIENTS);
+	std::cerr << " done.\n";
+
+	GeneratorPlayer player;
+	std::vector<ControlClient> clients;
+	wXs_update_player(control, player, options);
+	std::cerr << "Waveform generator ready on <" << socket_name << ">.\n";
+	while (!requested_termination && !control.wants_quit) {
+		std::vector<struct pollfd> fds(clients.size() + 1);
+		fds[0].fd = sockfd;
+		fds[0].events = POLLIN;
+		for (size_t k = 0; k < clients.size(); k++) {
+			fds[k + 1].fd = clients[k].fd;
+			fds[k + 1].events = POLLIN;
+		}
+		if (poll(fds.data(), fds.size(), SOCKET_POLL_TIMEOUT_MS) < 0) {
+			if (errno == EINTR)
+				continue;
+			std::cerr << "Error while polling control socket... exiting.\n";
+			break;
+		}
+
+		for (size_t k = clients.size(); k > 0; k--) {
+			if (fds[k].revents == 0)
+				continue;
+			if (!wXs_serve_client(control, player, options, clients[k - 1])) {
+				close(clients[k - 1].fd);
+				clients.erase(clients.begin() + (k - 1));
+			}
+		}
+
+		if (fds[0].revents & POLLIN) {
+			int newsockfd = accept(sockfd, NULL, NULL);
+			if (newsockfd >= 0) {
+				if (clients.size() < SOCKET_MAX_CLIENTS) {
+					ControlClient client;
+					client.fd = newsockfd;
+					clients.push_back(client);
+				} else {
+					close(newsockfd);
+				}
+			}
+		}
+	}
+
+	player.stop();
+	for (size_t k = 0; k < clients.size(); k++)
+		close(clients[k].fd);
+	close(sockfd);
+	unlink(socket_name);
+	std::cerr << "Waveform generator terminated.\n";
+	return 0;
+}
+
+// Runs the complete lines received from a client and sends the replies;
+// returns false once the client has gone or misbehaved.
+bool wXs_serve_client(GeneratorControl & control, GeneratorPlayer & player, const PlaybackOptions & options, ControlClient & client)
+{
+	char socket_buffer[SOCKET_MAX_LINE];
+	ssize_t readbytes = read(client.fd, socket_buffer, SOCKET_MAX_LINE);
+	if (readbytes <= 0)
+		return (readbytes < 0) && (errno == EINTR);
+	client.pending.append(socket_buffer, readbytes);
+
+	size_t end;
+	while ((end = client.pending.find('\n')) != std::string::npos) {
+		std::string line = client.pending.substr(0, end);
+		client.pending.erase(0, end + 1);
+		if (!line.empty() && (line.back() == '\r'))
+			line.pop_back();
+		if (line.find_first_not_of(" \t") == std::string::npos)
+			continue;
+		std::string reply;
+		control.underruns = player.underruns();
+		if (control.execute(line, reply) && !wXs_update_player(control, player, options))
+			reply = std::string("error cannot open playback device (") + snd_strerror(player.openError()) + ")";
+		reply += "\n";
+		if (write(client.fd, reply.c_str(), reply.size()) != (ssize_t) reply.size())
+			return false;
+		if (control.wants_quit)
+			break;
+	}
+	return client.pending.size() < SOCKET_MAX_LINE;
+}
+
+// Starts or stops the playback as last requested; a failed start is
+// withdrawn.
+bool wXs_update_player(GeneratorControl & control, GeneratorPlayer & player, const PlaybackOptions & options)
+{
+	bool success = true;
+	if (control.wants_running && !player.isRunning()) {
+		success = player.start(&control, options.device_name, options.sample_rate, options.latency_ms);
+		control.wants_running = success;
+	} else if (!control.wants_running && player.isRunning()) {
+		player.stop();
+	}
+	control.running = player.isRunning();
+	return success;
+}
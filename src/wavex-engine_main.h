@@ -0,0 +1,82 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <csignal>
+#include <iostream>
+#include <fstream>
+#include <unistd.h>
+#include <vector>
+#include <string>
+#include <errno.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "wavex-engine_generator.h"
+#include "wavex-engine_control.h"
+#include "wavex-engine_file.h"
+#include "wavex-engine_measure.h"
+#include "wavex-engine_bode.h"
+
+#define SAMPLING_RATE 44100
+#define SOCKET_DEFAULT_NAME "wavex.socket"
+#define SOCKET_MAX_CLIENTS 8
+#define SOCKET_MAX_LINE 4096
+#define SOCKET_POLL_TIMEOUT_MS 200
+#define RENDER_BLOCK_SIZE 4096
+#define MARKER_FILE_SUFFIX ".markers"
+
+// A client of the control socket, with the part of a command line
+// received so far.
+struct ControlClient {
+	int		fd;
+	std::string	pending;
+};
+
+struct PlaybackOptions {
+	const char*	device_name;
+	unsigned int	sample_rate;
+	double		latency_ms;
+};
+
+bool requested_termination;
+void signalHandler(int);
+
+bool wXs_run_script(GeneratorControl &, const char*);
+int wXs_render_offline(GeneratorControl &, const char*, double, unsigned int);
+int wXs_calibrate_latency(const PlaybackOptions &, const char*);
+int wXs_measure_response(GeneratorControl &, const char*, double, const PlaybackOptions &, const char*);
+int wXs_measure_bode(GeneratorControl &, const char*, bool, const PlaybackOptions &, const char*);
+FILE* wXs_open_marker_file(const char*);
+void wXs_write_markers(FILE*, const std::vector<SweepMarker> &, unsigned int);
+int wXs_serve(GeneratorControl &, const char*, const PlaybackOptions &);
+bool wXs_serve_client(GeneratorControl &, GeneratorPlayer &, const PlaybackOptions &, ControlClient &);
+bool wXs_update_player(GeneratorControl &, GeneratorPlayer &, const PlaybackOptions &);
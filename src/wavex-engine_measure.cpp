@@ -0,0 +1,363 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+
+#include "wavex-engine_measure.h"
+
+StimulusResponse::StimulusResponse()
+{
+	playback = NULL;
+	capture = NULL;
+	sample_rate = 0;
+	period_size = 0;
+	buffer_size = 0;
+	for (int c = 0; c < MEASURE_CHANNELS; c++)
+		latencies[c] = 0.0;
+}
+
+StimulusResponse::~StimulusResponse()
+{
+	close();
+}
+
+// Both directions of the device must accept the same sample rate, and be
+// linkable, i.e. share the clock of one card.
+bool StimulusResponse::open(const char* name, unsigned int* rate)
+{
+	if ((snd_pcm_open(&playback, name, SND_PCM_STREAM_PLAYBACK, 0) < 0) || (snd_pcm_open(&capture, name, SND_PCM_STREAM_CAPTURE, 0) < 0)) {
+		std::cerr <<  "Could not open audio device <" << name << "> for both playback and capture\n";
+		close();
+		return false;
+	}
+	unsigned int capture_rate = *rate;
+	snd_pcm_uframes_t capture_period = MEASURE_PERIOD_FRAMES;
+	snd_pcm_uframes_t capture_buffer = MEASURE_PERIOD_FRAMES * MEASURE_NR_PERIODS;
+	period_size = MEASURE_PERIOD_FRAMES;
+	buffer_size = MEASURE_PERIOD_FRAMES * MEASURE_NR_PERIODS;
+	if ((wXs_hardware_setup_linked(playback, rate, &period_size, &buffer_size) < 0) || (wXs_hardware_setup_linked(capture, &capture_rate, &capture_period, &capture_buffer) < 0)) {
+		std::cerr << "Cannot configure audio device <" << name << ">\n";
+		close();
+		return false;
+	}
+	if (capture_rate != *rate) {
+		std::cerr << "Playback and capture of <" << name << "> cannot run at the same sample rate\n";
+		close();
+		return false;
+	}
+	if (snd_pcm_link(playback, capture) < 0) {
+		std::cerr << "Cannot link playback and capture of <" << name << ">; they must belong to the same card\n";
+		close();
+		return false;
+	}
+	sample_rate = *rate;
+	period.assign(period_size * MEASURE_CHANNELS, 0);
+	captured.assign(period_size * MEASURE_CHANNELS, 0);
+	return true;
+}
+
+void StimulusResponse::close()
+{
+	if ((playback != NULL) && (capture != NULL))
+		snd_pcm_unlink(capture);
+	if (playback != NULL)
+		snd_pcm_close(playback);
+	if (capture != NULL)
+		snd_pcm_close(capture);
+	playback = NULL;
+	capture = NULL;
+	return;
+}
+
+unsigned int StimulusResponse::rate() const
+{
+	return sample_rate;
+}
+
+double StimulusResponse::latency(unsigned int channel) const
+{
+	return latencies[channel];
+}
+
+double StimulusResponse::residual(unsigned int channel) const
+{
+	return latencies[channel] - (double) llround(latencies[channel]);
+}
+
+bool StimulusResponse::stream(const StimulusTask & produce, const ResponseTask & consume)
+{
+	if ((playback == NULL) || (capture == NULL))
+		return false;
+	snd_pcm_drop(playback);
+	snd_pcm_drop(capture);
+	snd_pcm_prepare(playback);
+	snd_pcm_prepare(capture);
+	for (snd_pcm_uframes_t k = 0; k + period_size <= buffer_size; k += period_size) {
+		produce(period.data(), period_size);
+		if (snd_pcm_writei(playback, period.data(), period_size) < 0) {
+			std::cerr << "Cannot fill the playback buffer\n";
+			return false;
+		}
+	}
+	if (snd_pcm_start(playback) < 0) {
+		std::cerr << "Cannot start playback and capture\n";
+		return false;
+	}
+
+	bool success = true;
+	while (true) {
+		snd_pcm_sframes_t nr_read = snd_pcm_readi(capture, captured.data(), period_size);
+		if (nr_read < 0) {
+			std::cerr << "Capture overrun during the measurement\n";
+			success = false;
+			break;
+		}
+		if (!consume(captured.data(), nr_read))
+			break;
+		produce(period.data(), period_size);
+		if (snd_pcm_writei(playback, period.data(), period_size) < 0) {
+			std::cerr << "Playback underrun during the measurement\n";
+			success = false;
+			break;
+		}
+	}
+	snd_pcm_drop(playback);
+	snd_pcm_drop(capture);
+	return success;
+}
+
+// Plays nr_stimulus frames and records nr_response frames from the same
+// starting frame, both interleaved over MEASURE_CHANNELS channels.
+bool StimulusResponse::transfer(const int16_t* stimulus, unsigned int nr_stimulus, int16_t* response, unsigned int nr_response)
+{
+	unsigned int nr_played = 0;
+	unsigned int nr_recorded = 0;
+	StimulusTask produce = [&](int16_t* buf, unsigned int nr_frames) {
+		unsigned int n = (nr_stimulus - nr_played < nr_frames)? nr_stimulus - nr_played : nr_frames;
+		memcpy(buf, stimulus + (size_t) nr_played * MEASURE_CHANNELS, sizeof(int16_t) * n * MEASURE_CHANNELS);
+		memset(buf + (size_t) n * MEASURE_CHANNELS, 0, sizeof(int16_t) * (nr_frames - n) * MEASURE_CHANNELS);
+		nr_played += n;
+	};
+	ResponseTask consume = [&](const int16_t* buf, unsigned int nr_frames) {
+		unsigned int n = (nr_response - nr_recorded < nr_frames)? nr_response - nr_recorded : nr_frames;
+		memcpy(response + (size_t) nr_recorded * MEASURE_CHANNELS, buf, sizeof(int16_t) * n * MEASURE_CHANNELS);
+		nr_recorded += n;
+		return nr_recorded < nr_response;
+	};
+	return stream(produce, consume) && (nr_recorded == nr_response);
+}
+
+// Response frame k is aligned with stimulus frame k, to the nearest frame,
+// on each channel.
+bool StimulusResponse::measure(const int16_t* stimulus, int16_t* response, unsigned int nr_frames)
+{
+	unsigned int shift[MEASURE_CHANNELS];
+	unsigned int max_shift = 0;
+	for (int c = 0; c < MEASURE_CHANNELS; c++) {
+		shift[c] = (latencies[c] > 0.0)? (unsigned int) llround(latencies[c]) : 0;
+		if (shift[c] > max_shift)
+			max_shift = shift[c];
+	}
+	recording.resize((size_t) (nr_frames + max_shift) * MEASURE_CHANNELS);
+	if (!transfer(stimulus, nr_frames, recording.data(), nr_frames + max_shift))
+		return false;
+	for (unsigned int j = 0; j < nr_frames; j++) {
+		for (int c = 0; c < MEASURE_CHANNELS; c++)
+			response[(size_t) j * MEASURE_CHANNELS + c] = recording[(size_t) (j + shift[c]) * MEASURE_CHANNELS + c];
+	}
+	return true;
+}
+
+// The probe is a pseudo-random binary sequence, the same on both channels;
+// the correlation coefficient at the best lag must be clearly above
+// chance, otherwise the loopback is missing or the level too low.
+bool StimulusResponse::calibrate()
+{
+	std::vector<int16_t> probe((size_t) MEASURE_PROBE_FRAMES * MEASURE_CHANNELS);
+	uint32_t state = 2463534242u;
+	for (unsigned int j = 0; j < MEASURE_PROBE_FRAMES; j++) {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		uint32_t bit = state >> 31;
+		for (int c = 0; c < MEASURE_CHANNELS; c++)
+			probe[(size_t) j * MEASURE_CHANNELS + c] = bit? MEASURE_PROBE_AMPLITUDE : -MEASURE_PROBE_AMPLITUDE;
+	}
+	unsigned int nr_frames = MEASURE_PROBE_FRAMES + MEASURE_MAX_LATENCY_FRAMES;
+	recording.resize((size_t) nr_frames * MEASURE_CHANNELS);
+	if (!transfer(probe.data(), MEASURE_PROBE_FRAMES, recording.data(), nr_frames))
+		return false;
+
+	std::vector<int32_t> x(MEASURE_PROBE_FRAMES);
+	std::vector<int32_t> y(nr_frames);
+	std::vector<double> correlation(MEASURE_MAX_LATENCY_FRAMES + 1);
+	for (unsigned int j = 0; j < MEASURE_PROBE_FRAMES; j++)
+		x[j] = probe[(size_t) j * MEASURE_CHANNELS];
+	for (int c = 0; c < MEASURE_CHANNELS; c++) {
+		for (unsigned int j = 0; j < nr_frames; j++)
+			y[j] = recording[(size_t) j * MEASURE_CHANNELS + c];
+		unsigned int best = 0;
+		for (unsigned int lag = 0; lag <= MEASURE_MAX_LATENCY_FRAMES; lag++) {
+			int64_t sum = 0;
+			for (unsigned int j = 0; j < MEASURE_PROBE_FRAMES; j++)
+				sum += x[j] * y[j + lag];
+			correlation[lag] = fabs((double) sum);
+			if (correlation[lag] > correlation[best])
+				best = lag;
+		}
+
+		double energy = 0.0;
+		for (unsigned int j = 0; j < MEASURE_PROBE_FRAMES; j++)
+			energy += (double) y[j + best] * y[j + best];
+		double coefficient = correlation[best] / sqrt(energy * MEASURE_PROBE_FRAMES * MEASURE_PROBE_AMPLITUDE * MEASURE_PROBE_AMPLITUDE);
+		if (!(coefficient >= MEASURE_MIN_CORRELATION)) {
+			std::cerr << "No loopback signal found on channel " << c + 1 << "\n";
+			return false;
+		}
+		double delta = 0.0;
+		if ((best > 0) && (best < MEASURE_MAX_LATENCY_FRAMES)) {
+			double curvature = correlation[best - 1] - 2.0 * correlation[best] + correlation[best + 1];
+			if (curvature < 0.0)
+				delta = 0.5 * (correlation[best - 1] - correlation[best + 1]) / curvature;
+		}
+		latencies[c] = best + delta;
+	}
+	return true;
+}
+
+// The latency file holds one line: the sample rate, then the latency of
+// each channel in frames.
+bool StimulusResponse::loadLatency(const char* file_name)
+{
+	std::ifstream file(file_name);
+	unsigned int rate;
+	double values[MEASURE_CHANNELS];
+	if (!(file >> rate))
+		return false;
+	for (int c = 0; c < MEASURE_CHANNELS; c++) {
+		if (!(file >> values[c]) || (values[c] < 0.0)) {
+			std::cerr << "Invalid latency file <" << file_name << ">\n";
+			return false;
+		}
+	}
+	if (rate != sample_rate) {
+		std::cerr << "Latency in <" << file_name << "> was measured at " << rate << " Hz, not " << sample_rate << " Hz\n";
+		return false;
+	}
+	for (int c = 0; c < MEASURE_CHANNELS; c++)
+		latencies[c] = values[c];
+	return true;
+}
+
+bool StimulusResponse::saveLatency(const char* file_name) const
+{
+	FILE* file = fopen(file_name, "w");
+	if (file == NULL) {
+		std::cerr << "Cannot write latency file <" << file_name << ">\n";
+		return false;
+	}
+	fprintf(file, "%u", sample_rate);
+	for (int c = 0; c < MEASURE_CHANNELS; c++)
+		fprintf(file, " %.3f", latencies[c]);
+	fprintf(file, "\n");
+	fclose(file);
+	return true;
+}
+
+// Interleaved read/write access; the start threshold is set to the
+// boundary, so that the stream only starts on snd_pcm_start. Returns 0, or
+// the negative error code of the first step that failed.
+int wXs_hardware_setup_linked(snd_pcm_t* device_handle, unsigned int* sample_rate, snd_pcm_uframes_t* period_size, snd_pcm_uframes_t* buffer_size)
+{
+	int err;
+	snd_pcm_hw_params_t* device_parameters;
+	if ((err = snd_pcm_hw_params_malloc(&device_parameters)) < 0) {
+		std::cerr <<  "Could not allocate hardware parameter structure\n";
+		return err;
+	}
+	if ((err = snd_pcm_hw_params_any(device_handle, device_parameters)) < 0) {
+		std::cerr <<  "Cannot initialize hardware parameter structure\n";
+		snd_pcm_hw_params_free(device_parameters);
+		return err;
+	}
+	if ((err = snd_pcm_hw_params_set_access(device_handle, device_parameters, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0) {
+		std::cerr <<  "Cannot set access type\n";
+		snd_pcm_hw_params_free(device_parameters);
+		return err;
+	}
+	if ((err = snd_pcm_hw_params_set_format(device_handle, device_parameters, SND_PCM_FORMAT_S16_LE)) < 0) {
+		std::cerr <<  "Cannot set sample format\n";
+		snd_pcm_hw_params_free(device_parameters);
+		return err;
+	}
+	if ((err = snd_pcm_hw_params_set_rate_near(device_handle, device_parameters, sample_rate, 0)) < 0) {
+		std::cerr <<  "Cannot set sample rate\n";
+		snd_pcm_hw_params_free(device_parameters);
+		return err;
+	}
+	if ((err = snd_pcm_hw_params_set_channels(device_handle, device_parameters, MEASURE_CHANNELS)) < 0) {
+		std::cerr <<  "Cannot set channel count\n";
+		snd_pcm_hw_params_free(device_parameters);
+		return err;
+	}
+	if ((err = snd_pcm_hw_params_set_buffer_size_near(device_handle, device_parameters, buffer_size)) < 0) {
+		std::cerr <<  "Cannot set buffer size\n";
+		snd_pcm_hw_params_free(device_parameters);
+		return err;
+	}
+	if ((err = snd_pcm_hw_params_set_period_size_near(device_handle, device_parameters, period_size, 0)) < 0) {
+		std::cerr <<  "Cannot set period size\n";
+		snd_pcm_hw_params_free(device_parameters);
+		return err;
+	}
+	if ((err = snd_pcm_hw_params(device_handle, device_parameters)) < 0) {
+		std::cerr <<  "Cannot set parameters\n";
+		snd_pcm_hw_params_free(device_parameters);
+		return err;
+	}
+	snd_pcm_hw_params_get_buffer_size(device_parameters, buffer_size);
+	snd_pcm_hw_params_get_period_size(device_parameters, period_size, 0);
+	snd_pcm_hw_params_free(device_parameters);
+
+	snd_pcm_sw_params_t* software_parameters;
+	snd_pcm_uframes_t boundary;
+	if ((err = snd_pcm_sw_params_malloc(&software_parameters)) < 0) {
+		std::cerr <<  "Could not allocate software parameter structure\n";
+		return err;
+	}
+	snd_pcm_sw_params_current(device_handle, software_parameters);
+	snd_pcm_sw_params_get_boundary(software_parameters, &boundary);
+	snd_pcm_sw_params_set_start_threshold(device_handle, software_parameters, boundary);
+	snd_pcm_sw_params_set_avail_min(device_handle, software_parameters, *period_size);
+	if ((err = snd_pcm_sw_params(device_handle, software_parameters)) < 0) {
+		std::cerr <<  "Cannot set software parameters\n";
+		snd_pcm_sw_params_free(software_parameters);
+		return err;
+	}
+	snd_pcm_sw_params_free(software_parameters);
+	if ((err = snd_pcm_prepare(device_handle)) < 0) {
+		std::cerr <<  "Cannot prepare audio interface for use\n";
+		return err;
+	}
+
+	return 0;
+}
@@ -0,0 +1,104 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+
+#ifndef INCLUDED_WAVEX_MEASURE
+#define INCLUDED_WAVEX_MEASURE
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <functional>
+#include <alsa/asoundlib.h>
+
+#define MEASURE_CHANNELS 2
+#define MEASURE_PERIOD_FRAMES 1024
+#define MEASURE_NR_PERIODS 4
+#define MEASURE_PROBE_FRAMES 8192
+#define MEASURE_PROBE_AMPLITUDE 8192
+#define MEASURE_MAX_LATENCY_FRAMES 16384
+#define MEASURE_MIN_CORRELATION 0.3
+#define MEASURE_DEFAULT_LATENCY_FILE "wavex.latency"
+
+// Fills a period of stimulus frames / takes a period of recorded frames,
+// returning false once no more are needed.
+typedef std::function<void(int16_t*, unsigned int)> StimulusTask;
+typedef std::function<bool(const int16_t*, unsigned int)> ResponseTask;
+
+// Playback and capture on the same sound card, linked through snd_pcm_link
+// so that both streams start at the same frame of the same clock. Neither
+// starts by itself: stream() fills the playback buffer with the start of
+// the stimulus, starts the pair with a single snd_pcm_start, then reads one
+// period and writes the next in lockstep until the response task has had
+// enough; transfer() does so for a stimulus held in memory, followed by
+// silence. Frame k of the recording is thus the input sampled at the tick on which
+// frame k of the stimulus was handed to the converter; an xrun makes the
+// transfer fail rather than slip.
+//
+// What remains is the round-trip latency of the converters and their
+// filters, the same at every run. calibrate() measures it once per channel
+// with output k looped back to input k: a pseudo-random probe is played
+// and the lag maximizing its cross-correlation with the recording is
+// refined by a parabola through the three best lags. measure() then drops
+// the whole frames of latency, so that response frame k is the response
+// to stimulus frame k; residual() gives the fraction of a frame left, for
+// phase corrections. The latencies only hold for the sample rate at which
+// they were measured, which the latency file records.
+class StimulusResponse
+{
+public:
+	StimulusResponse();
+	~StimulusResponse();
+
+	bool open(const char*, unsigned int*);
+	void close();
+	bool stream(const StimulusTask &, const ResponseTask &);
+	bool transfer(const int16_t*, unsigned int, int16_t*, unsigned int);
+	bool measure(const int16_t*, int16_t*, unsigned int);
+	bool calibrate();
+	bool loadLatency(const char*);
+	bool saveLatency(const char*) const;
+	double latency(unsigned int) const;
+	double residual(unsigned int) const;
+	unsigned int rate() const;
+
+private:
+	snd_pcm_t*		playback;
+	snd_pcm_t*		capture;
+	unsigned int		sample_rate;
+	snd_pcm_uframes_t	period_size;
+	snd_pcm_uframes_t	buffer_size;
+	std::vector<int16_t>	period;
+	std::vector<int16_t>	captured;
+	std::vector<int16_t>	recording;
+	double			latencies[MEASURE_CHANNELS];
+};
+
+int wXs_hardware_setup_linked(snd_pcm_t*, unsigned int*, snd_pcm_uframes_t*, snd_pcm_uframes_t*);
+
+#endif
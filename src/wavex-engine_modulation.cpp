@@ -0,0 +1,88 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+
+#include "wavex-engine_modulation.h"
+
+static const char* type_names[] = {"off", "am", "fm", "pm"};
+static const char* source_names[] = {"sine", "triangle", "square", "noise", "channel"};
+
+// Reads a modulation from its text form, also used by the daemon commands:
+//	off
+//	am|fm|pm <depth> sine|triangle|square|noise <frequency Hz>
+//	am|fm|pm <depth> channel
+// The FM deviation must lie below the Nyquist frequency of sample_rate.
+bool wXs_parse_modulation(const std::string & text, unsigned int sample_rate, ModulationSettings* modulation)
+{
+	std::istringstream	words(text);
+	std::string		type, source, extra;
+	ModulationSettings	m = {MODULATION_OFF, MODULATOR_SINE, 0.0, 0.0};
+	if (!(words >> type))
+		return false;
+	if (type == "off") {
+		if (words >> extra)
+			return false;
+		*modulation = m;
+		return true;
+	}
+
+	bool valid = false;
+	for (unsigned int k = MODULATION_AM; k <= MODULATION_PM; k++) {
+		if (type == type_names[k]) {
+			m.type = k;
+			valid = true;
+		}
+	}
+	if (!valid || !(words >> m.depth >> source) || (m.depth < 0.0))
+		return false;
+	if ((m.type == MODULATION_FM) && (m.depth >= 0.5 * sample_rate))
+		return false;
+	valid = false;
+	for (unsigned int k = MODULATOR_SINE; k <= MODULATOR_CHANNEL; k++) {
+		if (source == source_names[k]) {
+			m.source = k;
+			valid = true;
+		}
+	}
+	if (!valid)
+		return false;
+	if (m.source != MODULATOR_CHANNEL) {
+		if (!(words >> m.frequency) || (m.frequency <= 0.0))
+			return false;
+	}
+	if (words >> extra)
+		return false;
+	*modulation = m;
+	return true;
+}
+
+std::string wXs_modulation_description(const ModulationSettings & m)
+{
+	if ((m.type == MODULATION_OFF) || (m.type > MODULATION_PM) || (m.source > MODULATOR_CHANNEL))
+		return "off";
+	std::ostringstream	text;
+	text << type_names[m.type] << " " << m.depth << " " << source_names[m.source];
+	if (m.source != MODULATOR_CHANNEL)
+		text << " " << m.frequency;
+	return text.str();
+}
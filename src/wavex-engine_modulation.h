@@ -0,0 +1,67 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+
+#ifndef INCLUDED_WAVEX_MODULATION
+#define INCLUDED_WAVEX_MODULATION
+
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <sstream>
+#include <string>
+
+enum ModulationType : unsigned int {
+	MODULATION_OFF = 0,
+	MODULATION_AM = 1,
+	MODULATION_FM = 2,
+	MODULATION_PM = 3
+};
+
+// The first three match the waveforms SINE, TRIANGULAR and SQUARE.
+enum ModulatorSource : unsigned int {
+	MODULATOR_SINE = 0,
+	MODULATOR_TRIANGLE = 1,
+	MODULATOR_SQUARE = 2,
+	MODULATOR_NOISE = 3,
+	MODULATOR_CHANNEL = 4
+};
+
+// Modulation of one channel by a signal m(t), normally within [-1, 1]:
+// a sine, triangle or square wave of the given frequency, Gaussian noise
+// of unit RMS value band-limited to the given frequency, or the output of
+// the other channel divided by its amplitude. The depth is the modulation
+// index for AM, the output being multiplied by 1 + depth m(t); the peak
+// frequency deviation in hertz for FM; the peak phase deviation in
+// radians for PM.
+struct ModulationSettings {
+	unsigned int	type;
+	unsigned int	source;
+	double		frequency;
+	double		depth;
+};
+
+bool wXs_parse_modulation(const std::string &, unsigned int, ModulationSettings*);
+std::string wXs_modulation_description(const ModulationSettings &);
+
+#endif
@@ -0,0 +1,266 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+
+#include "wavex-engine_noise.h"
+
+// Ziggurat tables of Marsaglia and Tsang for the standard normal
+// distribution: layer i is accepted at once when |h| < k[i], h being a
+// signed 32-bit random number, and the deviate is then h * w[i].
+class ZigguratTables
+{
+public:
+	ZigguratTables()
+	{
+		double m = 2147483648.0;
+		double d = 3.442619855899, t = d, v = 9.91256303526217e-3;
+		double q = v / exp(-0.5 * d * d);
+		k[0] = (uint32_t) ((d / q) * m);
+		k[1] = 0;
+		w[0] = q / m;
+		w[NOISE_ZIGGURAT_LAYERS - 1] = d / m;
+		f[0] = 1.0;
+		f[NOISE_ZIGGURAT_LAYERS - 1] = exp(-0.5 * d * d);
+		for (int i = NOISE_ZIGGURAT_LAYERS - 2; i >= 1; i--) {
+			d = sqrt(-2.0 * log(v / d + exp(-0.5 * d * d)));
+			k[i + 1] = (uint32_t) ((d / t) * m);
+			t = d;
+			f[i] = exp(-0.5 * d * d);
+			w[i] = d / m;
+		}
+	}
+
+	uint32_t	k[NOISE_ZIGGURAT_LAYERS];
+	double		w[NOISE_ZIGGURAT_LAYERS];
+	double		f[NOISE_ZIGGURAT_LAYERS];
+};
+
+static const ZigguratTables ziggurat;
+
+static inline uint64_t wXs_rotl(uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t wXs_splitmix64(uint64_t & x)
+{
+	uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+// Variance of the output of the filter
+//	H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+// driven by unit white noise, from the discrete Lyapunov equation of its
+// transposed direct form II.
+double wXs_biquad_noise_gain(double b0, double b1, double b2, double a1, double a2)
+{
+	double g1 = b1 - a1 * b0;
+	double g2 = b2 - a2 * b0;
+	double p11 = (g1 * g1 + g2 * g2 - 2.0 * a1 * g1 * g2 / (1.0 + a2)) / ((1.0 - a1 * a1 - a2 * a2) + 2.0 * a1 * a1 * a2 / (1.0 + a2));
+	return b0 * b0 + p11;
+}
+
+NoiseGenerator::NoiseGenerator()
+{
+	pool_index = NOISE_POOL_SIZE;
+	rows_sum = 0.0;
+	counter = 0;
+	b0 = 1.0;
+	b1 = b2 = a1 = a2 = 0.0;
+	s1 = s2 = 0.0;
+	filtered = false;
+	gain = 0.0;
+	waveform = WHITE_NOISE;
+	seed_value = 0;
+	bandwidth = 0.0;
+	amplitude = 0.0;
+	seeded = false;
+	for (int r = 0; r < NOISE_PINK_ROWS; r++)
+		rows[r] = 0.0;
+	seed(0);
+}
+
+// The lanes are seeded from the seed by splitmix64, as recommended for
+// xoshiro; the state of the filter and of the pink rows is reset as well,
+// so that a given seed always produces the same output.
+void NoiseGenerator::seed(uint64_t value)
+{
+	uint64_t x = value;
+	for (int l = 0; l < NOISE_LANES; l++)
+		for (int i = 0; i < 4; i++)
+			state[i][l] = wXs_splitmix64(x);
+	pool_index = NOISE_POOL_SIZE;
+	counter = 0;
+	s1 = s2 = 0.0;
+	rows_sum = 0.0;
+	for (int r = 0; r < NOISE_PINK_ROWS; r++) {
+		rows[r] = gaussian();
+		rows_sum += rows[r];
+	}
+	return;
+}
+
+void NoiseGenerator::configure(const OscillatorSettings & settings, unsigned int channel, unsigned int sample_rate)
+{
+	uint64_t new_seed = ((uint64_t) settings.seed << 8) | channel;
+	if (!seeded || (new_seed != seed_value)) {
+		seed_value = new_seed;
+		seed(seed_value);
+		seeded = true;
+	}
+	double new_amplitude = settings.enabled? settings.amplitude : 0.0;
+	if ((settings.waveform == waveform) && (settings.frequency == bandwidth) && (new_amplitude == amplitude))
+		return;
+	waveform = settings.waveform;
+	bandwidth = settings.frequency;
+	amplitude = new_amplitude;
+
+	double noise_gain = 1.0;
+	filtered = (waveform == WHITE_NOISE) && (bandwidth > 0.0) && (bandwidth < NOISE_MAX_BANDWIDTH * sample_rate);
+	if (filtered) {
+		double w0 = 8.0 * atan(1.0) * bandwidth / sample_rate;
+		double alpha = sin(w0) / sqrt(2.0);
+		double a0 = 1.0 + alpha;
+		b0 = 0.5 * (1.0 - cos(w0)) / a0;
+		b1 = (1.0 - cos(w0)) / a0;
+		b2 = b0;
+		a1 = -2.0 * cos(w0) / a0;
+		a2 = (1.0 - alpha) / a0;
+		noise_gain = wXs_biquad_noise_gain(b0, b1, b2, a1, a2);
+	}
+	gain = amplitude / sqrt(noise_gain);
+	return;
+}
+
+// Advances all lanes over the pool; the lanes are the inner loop so that
+// it vectorizes.
+void NoiseGenerator::refill()
+{
+	for (int j = 0; j < NOISE_POOL_SIZE; j += NOISE_LANES) {
+		for (int l = 0; l < NOISE_LANES; l++) {
+			pool[j + l] = state[0][l] + state[3][l];
+			uint64_t t = state[1][l] << 17;
+			state[2][l] ^= state[0][l];
+			state[3][l] ^= state[1][l];
+			state[1][l] ^= state[2][l];
+			state[0][l] ^= state[3][l];
+			state[2][l] ^= t;
+			state[3][l] = wXs_rotl(state[3][l], 45);
+		}
+	}
+	pool_index = 0;
+	return;
+}
+
+inline uint64_t NoiseGenerator::next()
+{
+	if (pool_index == NOISE_POOL_SIZE)
+		refill();
+	return pool[pool_index++];
+}
+
+// In (0, 1), from the upper 53 bits, the lower ones of xoshiro256+ being
+// weaker.
+inline double NoiseGenerator::uniform()
+{
+	return ((next() >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+// The layer index and the signed value are taken from different upper
+// bits of one random number.
+inline float NoiseGenerator::gaussian()
+{
+	uint64_t r = next();
+	int32_t h = (int32_t) (r >> 32);
+	unsigned int i = (unsigned int) (r >> 25) & (NOISE_ZIGGURAT_LAYERS - 1);
+	uint32_t magnitude = (h < 0)? (uint32_t) (-(int64_t) h) : (uint32_t) h;
+	if (magnitude < ziggurat.k[i])
+		return (float) (h * ziggurat.w[i]);
+	return gaussianSlow(h, i);
+}
+
+// Wedges and tail of the Ziggurat, reached about once in 80 draws.
+float NoiseGenerator::gaussianSlow(int32_t h, unsigned int i)
+{
+	const double r = 3.442620;
+	while (true) {
+		double x = h * ziggurat.w[i];
+		if (i == 0) {
+			double y;
+			do {
+				x = -log(uniform()) / r;
+				y = -log(uniform());
+			} while (y + y < x * x);
+			return (float) ((h > 0)? r + x : -r - x);
+		}
+		if (ziggurat.f[i] + uniform() * (ziggurat.f[i - 1] - ziggurat.f[i]) < exp(-0.5 * x * x))
+			return (float) x;
+		uint64_t b = next();
+		h = (int32_t) (b >> 32);
+		i = (unsigned int) (b >> 25) & (NOISE_ZIGGURAT_LAYERS - 1);
+		uint32_t magnitude = (h < 0)? (uint32_t) (-(int64_t) h) : (uint32_t) h;
+		if (magnitude < ziggurat.k[i])
+			return (float) (h * ziggurat.w[i]);
+	}
+}
+
+void NoiseGenerator::render(float* out, unsigned int nr_frames)
+{
+	if (gain == 0.0) {
+		for (unsigned int j = 0; j < nr_frames; j++)
+			out[j] = 0.0;
+		return;
+	}
+	if (waveform == PINK_NOISE) {
+		double scale = 1.0 / sqrt((double) (NOISE_PINK_ROWS + 1));
+		for (unsigned int j = 0; j < nr_frames; j++) {
+			counter++;
+			if (counter != 0) {
+				unsigned int r = __builtin_ctz(counter);
+				if (r < NOISE_PINK_ROWS) {
+					float v = gaussian();
+					rows_sum += v - rows[r];
+					rows[r] = v;
+				}
+			}
+			out[j] = (float) ((rows_sum + gaussian()) * scale);
+		}
+	} else {
+		for (unsigned int j = 0; j < nr_frames; j++)
+			out[j] = gaussian();
+	}
+	if (filtered) {
+		for (unsigned int j = 0; j < nr_frames; j++) {
+			double x = out[j];
+			double y = b0 * x + s1;
+			s1 = b1 * x - a1 * y + s2;
+			s2 = b2 * x - a2 * y;
+			out[j] = (float) y;
+		}
+	}
+	for (unsigned int j = 0; j < nr_frames; j++)
+		out[j] *= gain;
+	return;
+}
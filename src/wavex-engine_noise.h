@@ -0,0 +1,92 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+
+#ifndef INCLUDED_WAVEX_NOISE
+#define INCLUDED_WAVEX_NOISE
+
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+
+#include "wavex-engine_dds.h"
+
+#define NOISE_LANES 8
+#define NOISE_POOL_SIZE 1024
+#define NOISE_ZIGGURAT_LAYERS 128
+#define NOISE_PINK_ROWS 16
+#define NOISE_MAX_BANDWIDTH 0.45
+
+// Gaussian noise generator. Random numbers come from NOISE_LANES
+// interleaved xoshiro256+ generators, advanced together over a pool of
+// NOISE_POOL_SIZE values in a loop the compiler vectorizes; the Ziggurat
+// method turns them into normal deviates, almost always with a single
+// table comparison.
+//
+// White noise is Gaussian with the given amplitude as RMS value. Pink noise
+// is shaped by the Voss-McCartney algorithm: NOISE_PINK_ROWS Gaussian
+// values, row k being redrawn every 2^k samples, are summed with a white
+// one, giving a -3 dB/octave spectrum down to sample_rate/2^17; its RMS
+// value is the amplitude too. For white noise, a frequency setting below
+// NOISE_MAX_BANDWIDTH times the sample rate is the bandwidth of a
+// second-order Butterworth low-pass filter, the output being scaled so that
+// its RMS value is still the amplitude.
+//
+// The same seed gives the same sequence; the channel number is mixed into
+// the seed so that the two outputs are uncorrelated.
+class NoiseGenerator
+{
+public:
+	NoiseGenerator();
+
+	void configure(const OscillatorSettings &, unsigned int, unsigned int);
+	void render(float*, unsigned int);
+
+private:
+	void seed(uint64_t);
+	void refill();
+	uint64_t next();
+	double uniform();
+	float gaussian();
+	float gaussianSlow(int32_t, unsigned int);
+
+	uint64_t	state[4][NOISE_LANES];
+	uint64_t	pool[NOISE_POOL_SIZE];
+	unsigned int	pool_index;
+	float		rows[NOISE_PINK_ROWS];
+	double		rows_sum;
+	uint32_t	counter;
+	double		b0, b1, b2, a1, a2;
+	double		s1, s2;
+	bool		filtered;
+	float		gain;
+	unsigned int	waveform;
+	uint64_t	seed_value;
+	double		bandwidth;
+	double		amplitude;
+	bool		seeded;
+};
+
+double wXs_biquad_noise_gain(double, double, double, double, double);
+
+#endif
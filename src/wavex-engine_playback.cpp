@@ -0,0 +1,323 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+
+#include "wavex-engine_playback.h"
+
+FrameRing::FrameRing()
+{
+	nr_channels = 0;
+	nr_frames = 0;
+	write_position = 0;
+	read_position = 0;
+}
+
+// The capacity is rounded up to a power of two.
+void FrameRing::allocate(unsigned int capacity, unsigned int channels)
+{
+	nr_frames = 1;
+	while (nr_frames < capacity)
+		nr_frames *= 2;
+	nr_channels = channels;
+	data.assign((size_t) nr_frames * nr_channels, 0);
+	clear();
+	return;
+}
+
+// Only valid while neither side is running.
+void FrameRing::clear()
+{
+	write_position = 0;
+	read_position = 0;
+	return;
+}
+
+unsigned int FrameRing::readable() const
+{
+	return (unsigned int) (write_position.load(std::memory_order_acquire) - read_position.load(std::memory_order_relaxed));
+}
+
+unsigned int FrameRing::writable() const
+{
+	return nr_frames - (unsigned int) (write_position.load(std::memory_order_relaxed) - read_position.load(std::memory_order_acquire));
+}
+
+unsigned int FrameRing::write(const int16_t* buf, unsigned int n)
+{
+	unsigned int available = writable();
+	if (n > available)
+		n = available;
+	uint64_t position = write_position.load(std::memory_order_relaxed);
+	unsigned int first = (unsigned int) (position & (nr_frames - 1));
+	unsigned int head = (n < nr_frames - first)? n : nr_frames - first;
+	memcpy(&data[(size_t) first * nr_channels], buf, sizeof(int16_t) * head * nr_channels);
+	memcpy(&data[0], buf + (size_t) head * nr_channels, sizeof(int16_t) * (n - head) * nr_channels);
+	write_position.store(position + n, std::memory_order_release);
+	return n;
+}
+
+unsigned int FrameRing::read(int16_t* buf, unsigned int n)
+{
+	unsigned int available = readable();
+	if (n > available)
+		n = available;
+	uint64_t position = read_position.load(std::memory_order_relaxed);
+	unsigned int first = (unsigned int) (position & (nr_frames - 1));
+	unsigned int head = (n < nr_frames - first)? n : nr_frames - first;
+	memcpy(buf, &data[(size_t) first * nr_channels], sizeof(int16_t) * head * nr_channels);
+	memcpy(buf + (size_t) head * nr_channels, &data[0], sizeof(int16_t) * (n - head) * nr_channels);
+	read_position.store(position + n, std::memory_order_release);
+	return n;
+}
+
+PlaybackDevice::PlaybackDevice()
+{
+	handle = NULL;
+	stopping = false;
+	nr_underruns = 0;
+	running = false;
+	nr_channels = 0;
+	sample_rate = 0;
+	ring_target = 0;
+	period_size = 0;
+	buffer_size = 0;
+	open_error = 0;
+}
+
+PlaybackDevice::~PlaybackDevice()
+{
+	close();
+}
+
+bool PlaybackDevice::open(const char* name, unsigned int* rate, unsigned int channels, double latency_ms, unsigned int block_frames)
+{
+	if ((open_error = snd_pcm_open(&handle, name, SND_PCM_STREAM_PLAYBACK, 0)) < 0) {
+		std::cerr <<  "Could not open audio device <" << name << ">\n";
+		handle = NULL;
+		return false;
+	}
+	if (latency_ms < PLAYBACK_MIN_LATENCY_MS)
+		latency_ms = PLAYBACK_MIN_LATENCY_MS;
+	if (latency_ms > PLAYBACK_MAX_LATENCY_MS)
+		latency_ms = PLAYBACK_MAX_LATENCY_MS;
+	unsigned int latency_frames = (unsigned int) (latency_ms * 0.001 * (*rate));
+	buffer_size = latency_frames / 2;
+	period_size = buffer_size / PLAYBACK_NR_PERIODS;
+	if ((open_error = wXs_hardware_setup_playback(handle, rate, channels, &period_size, &buffer_size)) < 0) {
+		snd_pcm_close(handle);
+		handle = NULL;
+		return false;
+	}
+	nr_channels = channels;
+	sample_rate = *rate;
+	ring_target = (latency_frames > buffer_size)? latency_frames - buffer_size : period_size;
+	frames.allocate(ring_target + block_frames, nr_channels);
+	nr_underruns = 0;
+	return true;
+}
+
+void PlaybackDevice::close()
+{
+	stop();
+	if (handle != NULL)
+		snd_pcm_close(handle);
+	handle = NULL;
+	return;
+}
+
+void PlaybackDevice::start()
+{
+	if (running || (handle == NULL))
+		return;
+	stopping = false;
+	running = true;
+	player = std::thread(&PlaybackDevice::run, this);
+	return;
+}
+
+void PlaybackDevice::stop()
+{
+	if (!running)
+		return;
+	stopping = true;
+	player.join();
+	running = false;
+	snd_pcm_drop(handle);
+	snd_pcm_prepare(handle);
+	frames.clear();
+	if (nr_underruns > 0)
+		std::cerr << "Playback underruns: " << nr_underruns << "\n";
+	return;
+}
+
+// Frames the producer may add without exceeding the target latency.
+unsigned int PlaybackDevice::roomFrames() const
+{
+	unsigned int nr_buffered = frames.readable();
+	return (nr_buffered < ring_target)? ring_target - nr_buffered : 0;
+}
+
+unsigned int PlaybackDevice::periodFrames() const
+{
+	return (unsigned int) period_size;
+}
+
+uint64_t PlaybackDevice::underruns() const
+{
+	return nr_underruns;
+}
+
+int PlaybackDevice::openError() const
+{
+	return open_error;
+}
+
+unsigned int PlaybackDevice::write(const int16_t* buf, unsigned int nr_frames)
+{
+	return frames.write(buf, nr_frames);
+}
+
+void PlaybackDevice::recover(int err)
+{
+	if (err == -EPIPE)
+		nr_underruns++;
+	if (snd_pcm_recover(handle, err, 1) < 0) {
+		std::cerr << "Playback: cannot recover from error " << err << "\n";
+		usleep(1000 * PLAYBACK_WAIT_TIMEOUT_MS);
+	}
+	return;
+}
+
+void PlaybackDevice::run()
+{
+	useconds_t idle_us = (useconds_t) (250000.0 * period_size / sample_rate);
+	while (!stopping) {
+		snd_pcm_sframes_t nr_available = snd_pcm_avail_update(handle);
+		if (nr_available < 0) {
+			recover(nr_available);
+			continue;
+		}
+		snd_pcm_uframes_t nr_frames = frames.readable();
+		if (nr_frames > (snd_pcm_uframes_t) nr_available)
+			nr_frames = nr_available;
+		if (((snd_pcm_uframes_t) nr_available < period_size) && (snd_pcm_state(handle) == SND_PCM_STATE_RUNNING)) {
+			snd_pcm_wait(handle, PLAYBACK_WAIT_TIMEOUT_MS);
+			continue;
+		}
+		if (nr_frames == 0) {
+			usleep(idle_us);
+			continue;
+		}
+
+		const snd_pcm_channel_area_t* areas;
+		snd_pcm_uframes_t offset;
+		int err = snd_pcm_mmap_begin(handle, &areas, &offset, &nr_frames);
+		if (err < 0) {
+			recover(err);
+			continue;
+		}
+		int16_t* dst = (int16_t*) ((char*) areas[0].addr + areas[0].first / 8 + offset * areas[0].step / 8);
+		frames.read(dst, nr_frames);
+		snd_pcm_sframes_t nr_committed = snd_pcm_mmap_commit(handle, offset, nr_frames);
+		if ((nr_committed < 0) || ((snd_pcm_uframes_t) nr_committed != nr_frames))
+			recover((nr_committed < 0)? nr_committed : -EPIPE);
+	}
+	return;
+}
+
+// The device starts by itself once its buffer is full, and is woken up
+// whenever a whole period is free. Returns 0, or the negative error code
+// of the first step that failed, the device being then left unconfigured.
+int wXs_hardware_setup_playback(snd_pcm_t* device_handle, unsigned int* sample_rate, unsigned int nr_channels, snd_pcm_uframes_t* period_size, snd_pcm_uframes_t* buffer_size)
+{
+	int err;
+	snd_pcm_hw_params_t* device_parameters;
+	if ((err = snd_pcm_hw_params_malloc(&device_parameters)) < 0) {
+		std::cerr <<  "Could not allocate hardware parameter structure\n";
+		return err;
+	}
+	if ((err = snd_pcm_hw_params_any(device_handle, device_parameters)) < 0) {
+		std::cerr <<  "Cannot initialize hardware parameter structure\n";
+		snd_pcm_hw_params_free(device_parameters);
+		return err;
+	}
+	if ((err = snd_pcm_hw_params_set_access(device_handle, device_parameters, SND_PCM_ACCESS_MMAP_INTERLEAVED)) < 0) {
+		std::cerr <<  "Cannot set access type\n";
+		snd_pcm_hw_params_free(device_parameters);
+		return err;
+	}
+	if ((err = snd_pcm_hw_params_set_format(device_handle, device_parameters, SND_PCM_FORMAT_S16_LE)) < 0) {
+		std::cerr <<  "Cannot set sample format\n";
+		snd_pcm_hw_params_free(device_parameters);
+		return err;
+	}
+	if ((err = snd_pcm_hw_params_set_rate_near(device_handle, device_parameters, sample_rate, 0)) < 0) {
+		std::cerr <<  "Cannot set sample rate\n";
+		snd_pcm_hw_params_free(device_parameters);
+		return err;
+	}
+	if ((err = snd_pcm_hw_params_set_channels(device_handle, device_parameters, nr_channels)) < 0) {
+		std::cerr <<  "Cannot set channel count\n";
+		snd_pcm_hw_params_free(device_parameters);
+		return err;
+	}
+	if ((err = snd_pcm_hw_params_set_buffer_size_near(device_handle, device_parameters, buffer_size)) < 0) {
+		std::cerr <<  "Cannot set buffer size\n";
+		snd_pcm_hw_params_free(device_parameters);
+		return err;
+	}
+	if ((err = snd_pcm_hw_params_set_period_size_near(device_handle, device_parameters, period_size, 0)) < 0) {
+		std::cerr <<  "Cannot set period size\n";
+		snd_pcm_hw_params_free(device_parameters);
+		return err;
+	}
+	if ((err = snd_pcm_hw_params(device_handle, device_parameters)) < 0) {
+		std::cerr <<  "Cannot set parameters\n";
+		snd_pcm_hw_params_free(device_parameters);
+		return err;
+	}
+	snd_pcm_hw_params_get_buffer_size(device_parameters, buffer_size);
+	snd_pcm_hw_params_get_period_size(device_parameters, period_size, 0);
+	snd_pcm_hw_params_free(device_parameters);
+
+	snd_pcm_sw_params_t* software_parameters;
+	if ((err = snd_pcm_sw_params_malloc(&software_parameters)) < 0) {
+		std::cerr <<  "Could not allocate software parameter structure\n";
+		return err;
+	}
+	snd_pcm_sw_params_current(device_handle, software_parameters);
+	snd_pcm_sw_params_set_start_threshold(device_handle, software_parameters, *buffer_size);
+	snd_pcm_sw_params_set_avail_min(device_handle, software_parameters, *period_size);
+	if ((err = snd_pcm_sw_params(device_handle, software_parameters)) < 0) {
+		std::cerr <<  "Cannot set software parameters\n";
+		snd_pcm_sw_params_free(software_parameters);
+		return err;
+	}
+	snd_pcm_sw_params_free(software_parameters);
+	if ((err = snd_pcm_prepare(device_handle)) < 0) {
+		std::cerr <<  "Cannot prepare audio interface for use\n";
+		return err;
+	}
+
+	return 0;
+}
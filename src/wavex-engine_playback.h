@@ -0,0 +1,117 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+
+#ifndef INCLUDED_WAVEX_PLAYBACK
+#define INCLUDED_WAVEX_PLAYBACK
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <unistd.h>
+#include <errno.h>
+#include <alsa/asoundlib.h>
+
+#define PLAYBACK_DEFAULT_DEVICE "default"
+#define PLAYBACK_DEFAULT_LATENCY_MS 50.0
+#define PLAYBACK_MIN_LATENCY_MS 5.0
+#define PLAYBACK_MAX_LATENCY_MS 1000.0
+#define PLAYBACK_NR_PERIODS 4
+#define PLAYBACK_WAIT_TIMEOUT_MS 100
+
+// Ring of interleaved int16 frames between one producer and one consumer.
+// The positions only grow: the producer alone advances write_position and
+// the consumer alone read_position, so that no lock is needed.
+class FrameRing
+{
+public:
+	FrameRing();
+
+	void allocate(unsigned int, unsigned int);
+	void clear();
+	unsigned int readable() const;
+	unsigned int writable() const;
+	unsigned int write(const int16_t*, unsigned int);
+	unsigned int read(int16_t*, unsigned int);
+
+private:
+	std::vector<int16_t>	data;
+	unsigned int		nr_channels;
+	unsigned int		nr_frames;
+	std::atomic<uint64_t>	write_position;
+	std::atomic<uint64_t>	read_position;
+};
+
+// Playback through the mmap interface of ALSA. A dedicated thread moves
+// frames from the ring into the device buffer as soon as a period is free,
+// so that the thread generating the waveform never blocks on the device
+// and a late block only delays the ring, not the output. The target
+// latency is split evenly between the ring and the device buffer; the
+// producer adds a block of frames whenever roomFrames() is not zero, the
+// ring having space for one block beyond the target.
+//
+// An underrun of the device is recovered in place and counted; playback
+// resumes once the device buffer is full again. If open() fails, the
+// device stays closed and openError() returns the ALSA error code.
+class PlaybackDevice
+{
+public:
+	PlaybackDevice();
+	~PlaybackDevice();
+
+	bool open(const char*, unsigned int*, unsigned int, double, unsigned int);
+	void close();
+	void start();
+	void stop();
+	unsigned int roomFrames() const;
+	unsigned int periodFrames() const;
+	uint64_t underruns() const;
+	int openError() const;
+	unsigned int write(const int16_t*, unsigned int);
+
+private:
+	void run();
+	void recover(int);
+
+	snd_pcm_t*		handle;
+	FrameRing		frames;
+	std::thread		player;
+	std::atomic<bool>	stopping;
+	std::atomic<uint64_t>	nr_underruns;
+	bool			running;
+	unsigned int		nr_channels;
+	unsigned int		sample_rate;
+	unsigned int		ring_target;
+	snd_pcm_uframes_t	period_size;
+	snd_pcm_uframes_t	buffer_size;
+	int			open_error;
+};
+
+int wXs_hardware_setup_playback(snd_pcm_t*, unsigned int*, unsigned int, snd_pcm_uframes_t*, snd_pcm_uframes_t*);
+
+#endif
@@ -0,0 +1,89 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+
+#ifndef INCLUDED_WAVEX_SNAPSHOT
+#define INCLUDED_WAVEX_SNAPSHOT
+
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <type_traits>
+
+// Publishes a value from one writer thread to reader threads without locks
+// (sequence lock). The writer makes the sequence odd while it stores the
+// value and even again once done; a reader copies the value and retries if
+// the sequence was odd or changed meanwhile, so that it never sees a mix of
+// two updates. The value is stored as atomic words, T being trivially
+// copyable. Readers never block the writer, and the writer, updating a few
+// dozen bytes, delays readers by a few retries at most.
+template <typename T>
+class Snapshot
+{
+public:
+	Snapshot()
+	{
+		sequence = 0;
+		for (size_t k = 0; k < NR_WORDS; k++)
+			words[k] = 0;
+	}
+
+	void publish(const T & value)
+	{
+		uint64_t buf[NR_WORDS] = {0};
+		memcpy(buf, &value, sizeof(T));
+		uint32_t s = sequence.load(std::memory_order_relaxed);
+		sequence.store(s + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		for (size_t k = 0; k < NR_WORDS; k++)
+			words[k].store(buf[k], std::memory_order_relaxed);
+		sequence.store(s + 2, std::memory_order_release);
+		return;
+	}
+
+	// Returns the sequence number of the copy, which changes with every
+	// update.
+	uint32_t read(T & value) const
+	{
+		uint64_t buf[NR_WORDS];
+		uint32_t before, after;
+		do {
+			before = sequence.load(std::memory_order_acquire);
+			for (size_t k = 0; k < NR_WORDS; k++)
+				buf[k] = words[k].load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			after = sequence.load(std::memory_order_relaxed);
+		} while ((before & 1) || (before != after));
+		memcpy(&value, buf, sizeof(T));
+		return before;
+	}
+
+private:
+	static_assert(std::is_trivially_copyable<T>::value, "Snapshot requires a trivially copyable type");
+	static const size_t NR_WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+	std::atomic<uint32_t>	sequence;
+	std::atomic<uint64_t>	words[NR_WORDS];
+};
+
+#endif
@@ -0,0 +1,120 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+
+#include "wavex-engine_sweep.h"
+
+// Reads a sweep from its text form, also used by the daemon commands:
+//	off
+//	linear|log <start Hz> <stop Hz> <steps> <dwell s> [once]
+//	chirp <start Hz> <stop Hz> <duration s> [once]
+//	burst <cycles> <gap cycles> [once]
+// Frequencies must lie below the Nyquist frequency of sample_rate.
+bool wXs_parse_sweep(const std::string & text, unsigned int sample_rate, SweepSettings* sweep)
+{
+	double			nyquist = 0.5 * sample_rate;
+	std::istringstream	words(text);
+	std::string		mode, option;
+	SweepSettings		s = {SWEEP_OFF, 0.0, 0.0, 0, 0.0, 0, 0, false};
+	if (!(words >> mode))
+		return false;
+
+	bool valid = true;
+	if (mode == "off") {
+		s.mode = SWEEP_OFF;
+	} else if ((mode == "linear") || (mode == "log")) {
+		s.mode = (mode == "linear")? SWEEP_LINEAR : SWEEP_LOGARITHMIC;
+		valid = (bool) (words >> s.start_frequency >> s.stop_frequency >> s.nr_steps >> s.dwell);
+		valid = valid && (s.start_frequency >= 0.0) && (s.stop_frequency >= 0.0) && (s.nr_steps >= 1) && (s.nr_steps <= SWEEP_MAX_STEPS) && (s.dwell > 0.0);
+		valid = valid && (s.start_frequency < nyquist) && (s.stop_frequency < nyquist);
+		if (s.mode == SWEEP_LOGARITHMIC)
+			valid = valid && (s.start_frequency > 0.0) && (s.stop_frequency > 0.0);
+	} else if (mode == "chirp") {
+		s.mode = SWEEP_CHIRP;
+		valid = (bool) (words >> s.start_frequency >> s.stop_frequency >> s.dwell);
+		valid = valid && (s.start_frequency > 0.0) && (s.stop_frequency > 0.0) && (s.dwell > 0.0);
+		valid = valid && (s.start_frequency < nyquist) && (s.stop_frequency < nyquist);
+	} else if (mode == "burst") {
+		s.mode = SWEEP_BURST;
+		valid = (bool) (words >> s.burst_cycles >> s.gap_cycles);
+		valid = valid && (s.burst_cycles >= 1);
+	} else {
+		return false;
+	}
+	if (words >> option) {
+		if (option != "once")
+			return false;
+		s.once = true;
+	}
+	if (!valid)
+		return false;
+	*sweep = s;
+	return true;
+}
+
+std::string wXs_sweep_description(const SweepSettings & s)
+{
+	std::ostringstream	text;
+	switch (s.mode) {
+	case SWEEP_LINEAR:
+	case SWEEP_LOGARITHMIC:
+		text << ((s.mode == SWEEP_LINEAR)? "linear " : "log ") << s.start_frequency << " " << s.stop_frequency << " " << s.nr_steps << " " << s.dwell;
+		break;
+	case SWEEP_CHIRP:
+		text << "chirp " << s.start_frequency << " " << s.stop_frequency << " " << s.dwell;
+		break;
+	case SWEEP_BURST:
+		text << "burst " << s.burst_cycles << " " << s.gap_cycles;
+		break;
+	default:
+		return "off";
+	}
+	if (s.once)
+		text << " once";
+	return text.str();
+}
+
+bool wXs_same_sweep(const SweepSettings & a, const SweepSettings & b)
+{
+	return (a.mode == b.mode) && (a.start_frequency == b.start_frequency) && (a.stop_frequency == b.stop_frequency) && (a.nr_steps == b.nr_steps) && (a.dwell == b.dwell) && (a.burst_cycles == b.burst_cycles) && (a.gap_cycles == b.gap_cycles) && (a.once == b.once);
+}
+
+// Frequency of step k of a stepped sweep.
+double wXs_sweep_frequency(const SweepSettings & s, unsigned int k)
+{
+	if (s.nr_steps < 2)
+		return s.start_frequency;
+	double x = (double) k / (double) (s.nr_steps - 1);
+	if (s.mode == SWEEP_LOGARITHMIC)
+		return s.start_frequency * pow(s.stop_frequency / s.start_frequency, x);
+	return s.start_frequency + (s.stop_frequency - s.start_frequency) * x;
+}
+
+// Highest frequency reached, which sets the wavetable of band-limited
+// waveforms; frequency is the one of the channel.
+double wXs_sweep_max_frequency(const SweepSettings & s, double frequency)
+{
+	if ((s.mode == SWEEP_OFF) || (s.mode == SWEEP_BURST))
+		return frequency;
+	return (s.start_frequency > s.stop_frequency)? s.start_frequency : s.stop_frequency;
+}
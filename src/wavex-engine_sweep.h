@@ -0,0 +1,85 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+
+#ifndef INCLUDED_WAVEX_SWEEP
+#define INCLUDED_WAVEX_SWEEP
+
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <sstream>
+#include <string>
+
+#define SWEEP_MAX_STEPS 100000
+
+enum SweepMode : unsigned int {
+	SWEEP_OFF = 0,
+	SWEEP_LINEAR = 1,
+	SWEEP_LOGARITHMIC = 2,
+	SWEEP_CHIRP = 3,
+	SWEEP_BURST = 4
+};
+
+// Frequency program of one channel, run by its Oscillator:
+//	linear, logarithmic: nr_steps frequencies from start_frequency to
+//		stop_frequency, evenly spaced or in geometric progression, each
+//		held for dwell seconds; the phase is continuous across steps.
+//	chirp: exponential sweep from start_frequency to stop_frequency in
+//		dwell seconds, the instantaneous frequency growing by the same
+//		ratio every sample.
+//	burst: burst_cycles periods at the channel frequency, then
+//		gap_cycles periods of silence; switching happens where the phase
+//		wraps, i.e. at the zero crossings of a sine wave.
+// The program repeats, each repetition starting with the phase at zero,
+// unless once is set, in which case the output falls silent at its end.
+struct SweepSettings {
+	unsigned int	mode;
+	double		start_frequency;
+	double		stop_frequency;
+	unsigned int	nr_steps;
+	double		dwell;
+	unsigned int	burst_cycles;
+	unsigned int	gap_cycles;
+	bool		once;
+};
+
+// Published at the first frame of every step, chirp or burst, step being
+// its number within the run (bursts are numbered on), and at the end of a
+// program run once, step being then the number of steps, chirps or bursts
+// played and frequency zero. Frames are counted from the first frame
+// rendered by the generator.
+struct SweepMarker {
+	uint64_t	frame;
+	unsigned int	channel;
+	unsigned int	step;
+	double		frequency;
+};
+
+bool wXs_parse_sweep(const std::string &, unsigned int, SweepSettings*);
+std::string wXs_sweep_description(const SweepSettings &);
+bool wXs_same_sweep(const SweepSettings &, const SweepSettings &);
+double wXs_sweep_frequency(const SweepSettings &, unsigned int);
+double wXs_sweep_max_frequency(const SweepSettings &, double);
+
+#endif
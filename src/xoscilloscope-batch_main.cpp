@@ -0,0 +1,452 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#include "xoscilloscope-batch_main.h"
+
+// Runs the acquisition pipeline of the engine over recorded files. Every
+// file is cut into segments processed in parallel: trigger candidates are
+// found per segment (the crossing between the last frame of a segment and
+// the first of the next is found by the latter), then the hold-off is
+// applied in order, and finally frames, averages and measurements are
+// computed from the whole mapped file, so frames may straddle segments.
+// Results do not depend on the number of threads.
+int main (int argc, char *argv[])
+{
+	BatchOptions options;
+	options.mode = MODE_ANALOG;
+	oXs_default_scope_parameters(&options.scope);
+	options.scope.tdiv = 1e-3;
+	options.scope.navg = 0;
+	options.raw_sample_rate = BATCH_DEFAULT_RATE;
+	options.nr_threads = std::thread::hardware_concurrency();
+	options.max_frames = BATCH_DEFAULT_MAX_FRAMES;
+	options.group_size = 0;
+	options.output_directory.clear();
+
+	std::vector<std::string> file_names;
+	for (int i = 1; i < argc; i++) {
+		std::string option = argv[i];
+		bool has_value = (i + 1 < argc);
+		if ((option == "--mode") && has_value) {
+			std::string mode = argv[++i];
+			if (mode == "analog")
+				options.mode = MODE_ANALOG;
+			else if (mode == "digital")
+				options.mode = MODE_DIGITAL;
+			else if (mode == "voltmeter")
+				options.mode = MODE_VOLTMETER;
+			else
+				oXs_batch_usage(argv[0]);
+		} else if ((option == "--tdiv") && has_value) {
+			options.scope.tdiv = atof(argv[++i]);
+		} else if ((option == "--trig-chan") && has_value) {
+			options.scope.trig_chan = atoi(argv[++i]);
+		} else if ((option == "--trig-level") && has_value) {
+			options.scope.trig_level = atof(argv[++i]);
+		} else if ((option == "--trig-edge") && has_value) {
+			options.scope.trig_rising_edge = (argv[++i][0] != 'f');
+		} else if ((option == "--average") && has_value) {
+			options.group_size = atoi(argv[++i]);
+		} else if ((option == "--y1-vps") && has_value) {
+			options.scope.y_vps[0] = atof(argv[++i]);
+		} else if ((option == "--y2-vps") && has_value) {
+			options.scope.y_vps[1] = atof(argv[++i]);
+		} else if ((option == "--rate") && has_value) {
+			options.raw_sample_rate = atoi(argv[++i]);
+		} else if ((option == "--threads") && has_value) {
+			options.nr_threads = atoi(argv[++i]);
+		} else if ((option == "--max-frames") && has_value) {
+			options.max_frames = atoi(argv[++i]);
+		} else if ((option == "--output-dir") && has_value) {
+			options.output_directory = argv[++i];
+		} else if ((option.size() > 0) && (option[0] == '-')) {
+			oXs_batch_usage(argv[0]);
+		} else {
+			file_names.push_back(option);
+		}
+	}
+	if (file_names.empty() || (options.scope.tdiv <= 0.0) || (options.scope.trig_chan < 1) || (options.scope.trig_chan > CHN_SIZE) || (options.raw_sample_rate == 0))
+		oXs_batch_usage(argv[0]);
+
+	std::vector<BatchFile> files(file_names.size());
+	for (int k = 0; k < files.size(); k++) {
+		files[k].name = file_names[k];
+		if (!oXs_batch_open(files[k], options))
+			exit(1);
+	}
+
+	auto start_time = std::chrono::steady_clock::now();
+	WorkStealingPool pool(options.nr_threads);
+	std::cerr << "Analyzing " << files.size() << " file(s) on " << pool.size() << " threads...";
+
+	// Digital levels depend on the preceding frames only, which are read
+	// from the file: each segment is computed on its own.
+	if (options.mode == MODE_DIGITAL) {
+		for (int k = 0; k < files.size(); k++) {
+			for (uint64_t s = 0; s < files[k].candidates.size(); s++)
+				pool.submit(std::bind(oXs_batch_digital_segment, &files[k], s));
+		}
+		pool.wait();
+	}
+
+	for (int k = 0; k < files.size(); k++) {
+		for (uint64_t s = 0; s < files[k].candidates.size(); s++)
+			pool.submit(std::bind(oXs_batch_scan_segment, &files[k], &options, s));
+	}
+	pool.wait();
+
+	for (int k = 0; k < files.size(); k++) {
+		BatchFile & file = files[k];
+		std::vector<uint64_t> candidates;
+		for (uint64_t s = 0; s < file.candidates.size(); s++)
+			candidates.insert(candidates.end(), file.candidates[s].begin(), file.candidates[s].end());
+		oXs_select_triggers(candidates, file.trace_size, file.nr_frames, file.triggers);
+
+		uint64_t nr_shown = (file.triggers.size() < options.max_frames)? file.triggers.size() : options.max_frames;
+		file.frame_text.resize((nr_shown + BATCH_FRAMES_PER_TASK - 1) / BATCH_FRAMES_PER_TASK);
+		for (uint64_t t = 0; t < file.frame_text.size(); t++)
+			pool.submit(std::bind(oXs_batch_frames, &file, &options, t));
+
+		if ((options.mode == MODE_ANALOG) && !file.triggers.empty()) {
+			uint64_t group_size = (options.group_size > 0)? options.group_size : file.triggers.size();
+			file.averages.resize((file.triggers.size() + group_size - 1) / group_size);
+			for (uint64_t g = 0; g < file.averages.size(); g++)
+				pool.submit(std::bind(oXs_batch_average, &file, &options, g));
+		}
+	}
+	pool.wait();
+
+	int err = 0;
+	double recorded_time = 0.0;
+	for (int k = 0; k < files.size(); k++) {
+		if (oXs_batch_write(files[k], options) < 0) {
+			std::cerr << "\nCould not write the results of '" << files[k].name << "'";
+			err = 1;
+		}
+		recorded_time += files[k].nr_frames / (double) files[k].sample_rate;
+	}
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	std::cerr << " done.\n";
+	for (int k = 0; k < files.size(); k++) {
+		std::cerr << files[k].name << ": " << files[k].nr_frames << " frames, " << files[k].triggers.size() << " triggered frames\n";
+		oXs_batch_close(files[k]);
+	}
+	std::cerr << recorded_time << " s of recordings analyzed in " << elapsed << " s (" << recorded_time / elapsed << "x real time).\n";
+
+	return err;
+}
+
+void oXs_batch_usage(const char* name)
+{
+	std::cerr << "Usage: " << name << " [options] <file.wav|file.raw> ...\n"
+		<< "  --mode analog|digital|voltmeter   pipeline to run (default analog)\n"
+		<< "  --tdiv <s>                        time per division, frames span " << HORIZ_DIVS << " divisions (default 1e-3)\n"
+		<< "  --trig-chan 1|2                   trigger channel (default 1)\n"
+		<< "  --trig-level <units>              trigger level in sample units (default 0)\n"
+		<< "  --trig-edge r|f                   rising or falling edge (default r)\n"
+		<< "  --average <n>                     average groups of n frames (default: all frames)\n"
+		<< "  --y1-vps, --y2-vps <V>            volts per sample unit (default 1)\n"
+		<< "  --rate <Hz>                       sample rate of raw int16 stereo files (default " << BATCH_DEFAULT_RATE << ")\n"
+		<< "  --threads <n>                     worker threads (default: all cores)\n"
+		<< "  --max-frames <n>                  triggered frames written per file (default " << BATCH_DEFAULT_MAX_FRAMES << ")\n"
+		<< "  --output-dir <dir>                where results are written (default: next to the inputs)\n";
+	exit(1);
+}
+
+static uint32_t oXs_read_u32(const char* p)
+{
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static uint16_t oXs_read_u16(const char* p)
+{
+	uint16_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+bool oXs_batch_open(BatchFile & file, const BatchOptions & options)
+{
+	file.map = NULL;
+	file.map_size = 0;
+	int fd = open(file.name.c_str(), O_RDONLY);
+	struct stat file_status;
+	if ((fd < 0) || (fstat(fd, &file_status) < 0) || (file_status.st_size == 0)) {
+		std::cerr << "Could not open '" << file.name << "'\n";
+		if (fd >= 0)
+			close(fd);
+		return false;
+	}
+	file.map_size = file_status.st_size;
+	void* map = mmap(NULL, file.map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		std::cerr << "Could not map '" << file.name << "'\n";
+		return false;
+	}
+	file.map = (const char*) map;
+	madvise(map, file.map_size, MADV_SEQUENTIAL);
+
+	const char* data = file.map;
+	size_t data_size = file.map_size;
+	unsigned int channels = CHN_SIZE, bits = 16, format = WAV_FORMAT_PCM;
+	file.sample_rate = options.raw_sample_rate;
+	if ((file.map_size >= 12) && !memcmp(file.map, "RIFF", 4) && !memcmp(file.map + 8, "WAVE", 4)) {
+		bool have_format = false;
+		data = NULL;
+		size_t offset = 12;
+		while (offset + 8 <= file.map_size) {
+			const char* chunk = file.map + offset;
+			size_t chunk_size = oXs_read_u32(chunk + 4);
+			if (!memcmp(chunk, "fmt ", 4) && (chunk_size >= 16) && (offset + 8 + chunk_size <= file.map_size)) {
+				format = oXs_read_u16(chunk + 8);
+				channels = oXs_read_u16(chunk + 10);
+				file.sample_rate = oXs_read_u32(chunk + 12);
+				bits = oXs_read_u16(chunk + 22);
+				if ((format == WAV_FORMAT_EXTENSIBLE) && (chunk_size >= 26))
+					format = oXs_read_u16(chunk + 32);
+				have_format = true;
+			} else if (!memcmp(chunk, "data", 4)) {
+				data = chunk + 8;
+				data_size = (offset + 8 + chunk_size <= file.map_size)? chunk_size : file.map_size - offset - 8;
+				break;
+			}
+			offset += 8 + chunk_size + (chunk_size & 1);
+		}
+		if (!have_format || (data == NULL) || (channels == 0) || (file.sample_rate == 0)
+		    || !(((format == WAV_FORMAT_PCM) && (bits == 16)) || ((format == WAV_FORMAT_IEEE_FLOAT) && (bits == 32)))) {
+			std::cerr << "'" << file.name << "': only 16-bit PCM and 32-bit float WAV files are supported\n";
+			oXs_batch_close(file);
+			return false;
+		}
+	}
+
+	unsigned int frame_size = channels * bits / 8;
+	file.nr_frames = data_size / frame_size;
+	if ((format == WAV_FORMAT_PCM) && (channels == CHN_SIZE) && ((uintptr_t) data % sizeof(int16_t) == 0)) {
+		file.frames = (const int16_t*) data;
+	} else {
+		// Missing channels are zero, extra channels are ignored
+		file.converted.assign(file.nr_frames * CHN_SIZE, 0);
+		for (uint64_t i = 0; i < file.nr_frames; i++) {
+			for (unsigned int c = 0; (c < channels) && (c < CHN_SIZE); c++) {
+				const char* p = data + i * frame_size + c * bits / 8;
+				if (format == WAV_FORMAT_PCM) {
+					file.converted[i * CHN_SIZE + c] = (int16_t) oXs_read_u16(p);
+				} else {
+					float y;
+					memcpy(&y, p, sizeof(y));
+					y = (y > 1.0f)? 1.0f : ((y < -1.0f)? -1.0f : y);
+					file.converted[i * CHN_SIZE + c] = lrintf(y * INT16_MAX);
+				}
+			}
+		}
+		file.frames = file.converted.data();
+	}
+
+	file.trace_size = ceil(options.scope.tdiv * HORIZ_DIVS * file.sample_rate);
+	if (file.trace_size < 2)
+		file.trace_size = 2;
+	// Segments hold whole measurement windows
+	file.segment_frames = (BATCH_SEGMENT_FRAMES + file.trace_size - 1) / file.trace_size * file.trace_size;
+	uint64_t nr_segments = (file.nr_frames + file.segment_frames - 1) / file.segment_frames;
+	file.candidates.resize(nr_segments);
+	file.measurements.resize(nr_segments);
+	if (options.mode == MODE_DIGITAL)
+		file.states.assign(file.nr_frames * CHN_SIZE, 0);
+
+	size_t slash = file.name.find_last_of('/');
+	std::string base = (slash == std::string::npos)? file.name : file.name.substr(slash + 1);
+	size_t dot = base.find_last_of('.');
+	if ((dot != std::string::npos) && (dot > 0))
+		base.erase(dot);
+	if (options.output_directory.empty())
+		file.output_base = ((slash == std::string::npos)? std::string("") : file.name.substr(0, slash + 1)) + base;
+	else
+		file.output_base = options.output_directory + "/" + base;
+
+	return true;
+}
+
+void oXs_batch_close(BatchFile & file)
+{
+	if (file.map != NULL)
+		munmap((void*) file.map, file.map_size);
+	file.map = NULL;
+	file.frames = NULL;
+	file.converted.clear();
+	file.states.clear();
+	return;
+}
+
+void oXs_batch_digital_segment(BatchFile* file, uint64_t segment)
+{
+	uint64_t first = segment * file->segment_frames;
+	uint64_t last = (first + file->segment_frames < file->nr_frames)? first + file->segment_frames : file->nr_frames;
+	oXs_digital_states(file->frames, first, last, file->states.data());
+	return;
+}
+
+void oXs_batch_scan_segment(BatchFile* file, const BatchOptions* options, uint64_t segment)
+{
+	uint64_t first = segment * file->segment_frames;
+	uint64_t last = (first + file->segment_frames < file->nr_frames)? first + file->segment_frames : file->nr_frames;
+
+	if (options->mode != MODE_VOLTMETER) {
+		const uint8_t* states = (options->mode == MODE_DIGITAL)? file->states.data() : NULL;
+		oXs_find_triggers(file->frames, states, first, last, &options->scope, file->candidates[segment]);
+	}
+
+	std::vector<WindowMeasurement> & measurements = file->measurements[segment];
+	for (uint64_t window = first; window + file->trace_size <= last; window += file->trace_size) {
+		measurements.push_back(WindowMeasurement());
+		oXs_measure_window(file->frames, window, window + file->trace_size, &options->scope, measurements.back());
+	}
+	return;
+}
+
+// Serializes triggered frames [BATCH_FRAMES_PER_TASK * task, ...) with the
+// same time axis as the screen (trigger at t = 0), one data block each.
+void oXs_batch_frames(BatchFile* file, const BatchOptions* options, uint64_t task)
+{
+	uint64_t nr_shown = (file->triggers.size() < options->max_frames)? file->triggers.size() : options->max_frames;
+	uint64_t first = task * BATCH_FRAMES_PER_TASK;
+	uint64_t last = (first + BATCH_FRAMES_PER_TASK < nr_shown)? first + BATCH_FRAMES_PER_TASK : nr_shown;
+	double dt = 1.0 / (double) file->sample_rate;
+	bool digital = (options->mode == MODE_DIGITAL);
+
+	TextSerializer* text = new TextSerializer(TEXT_DOUBLE);
+	DisplayFrame rows;
+	rows.resize(file->trace_size, 3);
+	char comment[128];
+	for (uint64_t k = first; k < last; k++) {
+		uint64_t start = file->triggers[k] - file->trace_size / 2;
+		double t = -0.5 * file->trace_size * dt;
+		for (uint64_t j = 0; j < file->trace_size; j++) {
+			rows.at(j, 0) = t;
+			if (digital) {
+				rows.at(j, 1) = file->states[(start + j) * CHN_SIZE];
+				rows.at(j, 2) = file->states[(start + j) * CHN_SIZE + 1];
+			} else {
+				rows.at(j, 1) = file->frames[(start + j) * CHN_SIZE] * options->scope.y_vps[0];
+				rows.at(j, 2) = file->frames[(start + j) * CHN_SIZE + 1] * options->scope.y_vps[1];
+			}
+			t += dt;
+		}
+		sprintf(comment, "# frame %lu, trigger at t = %.9g s\n", (unsigned long) k, file->triggers[k] * dt);
+		text->appendText(comment);
+		text->appendRows(rows);
+		text->appendText("\n\n");
+	}
+	file->frame_text[task].reset(text);
+	return;
+}
+
+// Averages a group of consecutive triggered frames, with the same arithmetic
+// as the averaging of the engine.
+void oXs_batch_average(BatchFile* file, const BatchOptions* options, uint64_t group)
+{
+	uint64_t group_size = (options->group_size > 0)? options->group_size : file->triggers.size();
+	uint64_t first = group * group_size;
+	uint64_t last = (first + group_size < file->triggers.size())? first + group_size : file->triggers.size();
+	double n = last - first;
+	double dt = 1.0 / (double) file->sample_rate;
+
+	DisplayFrame & average = file->averages[group];
+	average.resize(file->trace_size, 3);
+	double t = -0.5 * file->trace_size * dt;
+	for (uint64_t j = 0; j < file->trace_size; j++) {
+		average.at(j, 0) = t;
+		average.at(j, 1) = 0.0;
+		average.at(j, 2) = 0.0;
+		t += dt;
+	}
+	for (uint64_t k = first; k < last; k++) {
+		const int16_t* frame = file->frames + (file->triggers[k] - file->trace_size / 2) * CHN_SIZE;
+		for (uint64_t j = 0; j < file->trace_size; j++) {
+			average.at(j, 1) += frame[j * CHN_SIZE] * options->scope.y_vps[0] / n;
+			average.at(j, 2) += frame[j * CHN_SIZE + 1] * options->scope.y_vps[1] / n;
+		}
+	}
+	return;
+}
+
+// Writes <base>.frames.txt, <base>.average.txt and <base>.measurements.txt.
+int oXs_batch_write(const BatchFile & file, const BatchOptions & options)
+{
+	int err = 0;
+	char line[256];
+	double dt = 1.0 / (double) file.sample_rate;
+	TextSerializer text(TEXT_DOUBLE);
+
+	if (options.mode != MODE_VOLTMETER) {
+		text.clear();
+		sprintf(line, "# %s: %lu triggered frames of %lu samples, first %lu shown\n", file.name.c_str(), (unsigned long) file.triggers.size(), (unsigned long) file.trace_size, (unsigned long) ((file.triggers.size() < options.max_frames)? file.triggers.size() : options.max_frames));
+		text.appendText(line);
+		text.appendText("# t\tch1\tch2\n");
+		int fd = open((file.output_base + ".frames.txt").c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+		if ((fd < 0) || (text.writeToDescriptor(fd) < 0))
+			err = -1;
+		for (int t = 0; (fd >= 0) && (err == 0) && (t < file.frame_text.size()); t++) {
+			if (file.frame_text[t]->writeToDescriptor(fd) < 0)
+				err = -1;
+		}
+		if (fd >= 0)
+			close(fd);
+	}
+
+	if (!file.averages.empty()) {
+		uint64_t group_size = (options.group_size > 0)? options.group_size : file.triggers.size();
+		text.clear();
+		text.appendText("# t\tch1\tch2\n");
+		for (int g = 0; g < file.averages.size(); g++) {
+			uint64_t last = ((g + 1) * group_size < file.triggers.size())? (g + 1) * group_size : file.triggers.size();
+			sprintf(line, "# average of frames %lu to %lu\n", (unsigned long) (g * group_size), (unsigned long) (last - 1));
+			text.appendText(line);
+			text.appendRows(file.averages[g]);
+			text.appendText("\n\n");
+		}
+		if (text.writeToFile((file.output_base + ".average.txt").c_str()) < 0)
+			err = -1;
+	}
+
+	text.clear();
+	text.appendText("# t_start\tvoltmeter_ch1\tvoltmeter_ch2\tmean_ch1\tmean_ch2\trms_ch1\trms_ch2\tmin_ch1\tmin_ch2\tmax_ch1\tmax_ch2\n");
+	DisplayFrame rows;
+	for (int s = 0; s < file.measurements.size(); s++) {
+		rows.resize(file.measurements[s].size(), 11);
+		for (int w = 0; w < file.measurements[s].size(); w++) {
+			const WindowMeasurement & m = file.measurements[s][w];
+			const double row[11] = {m.first_frame * dt, m.voltmeter[0], m.voltmeter[1], m.mean[0], m.mean[1], m.rms[0], m.rms[1], m.min[0], m.min[1], m.max[0], m.max[1]};
+			for (int k = 0; k < 11; k++)
+				rows.at(w, k) = row[k];
+		}
+		text.appendRows(rows);
+	}
+	if (text.writeToFile((file.output_base + ".measurements.txt").c_str()) < 0)
+		err = -1;
+
+	return err;
+}
@@ -0,0 +1,93 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "xoscilloscope-engine_pipeline.h"
+#include "xoscilloscope-engine_pool.h"
+#include "xoscilloscope-engine_output.h"
+
+#define BATCH_SEGMENT_FRAMES 1048576
+#define BATCH_FRAMES_PER_TASK 256
+#define BATCH_DEFAULT_RATE 44100
+#define BATCH_DEFAULT_MAX_FRAMES 100
+#define WAV_FORMAT_PCM 1
+#define WAV_FORMAT_IEEE_FLOAT 3
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+struct BatchOptions {
+	osc_mode		mode;
+	ScopeParameters		scope;
+	unsigned int		raw_sample_rate;
+	unsigned int		nr_threads;
+	unsigned int		max_frames;
+	unsigned int		group_size;
+	std::string		output_directory;
+};
+
+// One input file and everything computed on it. Samples are always seen as
+// interleaved int16 frames of CHN_SIZE channels: 16-bit stereo files are
+// used in place through a memory map, the others are converted.
+struct BatchFile {
+	std::string					name;
+	std::string					output_base;
+	const char*					map;
+	size_t						map_size;
+	const int16_t*					frames;
+	std::vector<int16_t>				converted;
+	uint64_t					nr_frames;
+	unsigned int					sample_rate;
+	uint64_t					trace_size;
+	uint64_t					segment_frames;
+	std::vector<uint8_t>				states;
+	std::vector< std::vector<uint64_t> >		candidates;
+	std::vector<uint64_t>				triggers;
+	std::vector< std::vector<WindowMeasurement> >	measurements;
+	std::vector< std::unique_ptr<TextSerializer> >	frame_text;
+	std::vector<DisplayFrame>			averages;
+};
+
+void oXs_batch_usage(const char*);
+bool oXs_batch_open(BatchFile &, const BatchOptions &);
+void oXs_batch_close(BatchFile &);
+void oXs_batch_digital_segment(BatchFile*, uint64_t);
+void oXs_batch_scan_segment(BatchFile*, const BatchOptions*, uint64_t);
+void oXs_batch_frames(BatchFile*, const BatchOptions*, uint64_t);
+void oXs_batch_average(BatchFile*, const BatchOptions*, uint64_t);
+int oXs_batch_write(const BatchFile &, const BatchOptions &);
@@ -95,37 +95,55 @@ wxThread::ExitCode WorkerThread::Entry ()
 	while (true) {
 		bzero(paramsg, (SOCKET_BUFFER_SIZE - 2) * sizeof(char));
 		n = read(newsockfd, buf, (SOCKET_BUFFER_SIZE - 2) * sizeof(char));
-		if (buf[0] == 'g') {
+		if (n < 1)
+			break;
+		buf[n] = '\0';
+		if ((buf[0] == 'g') || (buf[0] == 'w')) {
+			// Requests carry the number of channels acquired by the engine.
+			unsigned int nr_channels = atoi(buf + 1);
+			if ((nr_channels > 0) && (nr_channels <= MAX_CHANNELS) && (nr_channels != this->data_container->nr_channels)) {
+				this->data_container->nr_channels = nr_channels;
+				wxQueueEvent(this->parent_frame, new wxThreadEvent(wxEVT_THREAD, EVENT_WORKER_CHANNELS));
+			}
+			// An idle engine ('w') sleeps until it gets an answer, which
+			// is held back as long as there is nothing but the pause.
+			if (buf[0] == 'w')
+				this->data_container->waitForCommand();
 			if (this->data_container->send_changes) {
 				char temp_string[32];
 				std::string tdiv_msg = this->data_container->list_tdiv[this->data_container->tdiv_idx];
-				std::string y1dv_msg;
-				if (this->data_container->y1_vps != 1.0)
-					y1dv_msg = this->data_container->list_ydiv_volts[this->data_container->y1div_idx];
-				else
-					y1dv_msg = this->data_container->list_ydiv_samples[this->data_container->y1div_idx];
-				std::string y2dv_msg;
-				if (this->data_container->y2_vps != 1.0)
-					y2dv_msg = this->data_container->list_ydiv_volts[this->data_container->y2div_idx];
-				else
-					y2dv_msg = this->data_container->list_ydiv_samples[this->data_container->y2div_idx];
 				char edge = (this->data_container->trig_edge == 0)? 'r' : 'f';
 				int ch = this->data_container->trig_channel + 1;
 				sprintf(temp_string, "%+.2e", this->data_container->trig_level);
 				std::string trig_level_msg = temp_string;
 				bzero(temp_string, 32 * sizeof(char));
-				sprintf(temp_string, "%+.2e", this->data_container->y1_vps);
-				std::string y1factor_msg = temp_string;
-				bzero(temp_string, 32 * sizeof(char));
-				sprintf(temp_string, "%+.2e", this->data_container->y2_vps);
-				std::string y2factor_msg = temp_string;
-				bzero(temp_string, 32 * sizeof(char));
 				sprintf(temp_string, "%.3d", this->data_container->navg);
 				std::string navg_msg = temp_string;
 				bzero(temp_string, 32 * sizeof(char));
 
-				sprintf(paramsg, "y%s%s%s%c%d%s%s%s%s", tdiv_msg.c_str(), y1dv_msg.c_str(), y2dv_msg.c_str(), edge, ch, trig_level_msg.c_str(), y1factor_msg.c_str(), y2factor_msg.c_str(), navg_msg.c_str());
+				sprintf(paramsg, "y%s%c%d%s%s", tdiv_msg.c_str(), edge, ch, trig_level_msg.c_str(), navg_msg.c_str());
+				// One block per channel: enabled flag (1 char), volts per
+				// division (4 chars), volts per sample unit (9 chars).
+				for (int c = 0; c < MAX_CHANNELS; c++) {
+					std::string ydv_msg;
+					if (this->data_container->y_vps[c] != 1.0)
+						ydv_msg = this->data_container->list_ydiv_volts[this->data_container->ydiv_idx[c]];
+					else
+						ydv_msg = this->data_container->list_ydiv_samples[this->data_container->ydiv_idx[c]];
+					sprintf(temp_string, "%+.2e", this->data_container->y_vps[c]);
+					sprintf(paramsg + strlen(paramsg), "%c%s%s", (this->data_container->channel_enabled[c])? '1' : '0', ydv_msg.c_str(), temp_string);
+					bzero(temp_string, 32 * sizeof(char));
+				}
 				this->data_container->send_changes = false;
+			} else if (this->data_container->record_command) {
+				sprintf(paramsg, "r%s", this->data_container->record_file.c_str());
+				this->data_container->record_command = false;
+			} else if (this->data_container->event_record_command) {
+				sprintf(paramsg, "e%s", this->data_container->event_record_file.c_str());
+				this->data_container->event_record_command = false;
+			} else if (this->data_container->history_command) {
+				sprintf(paramsg, "h%.6f", this->data_container->history_position);
+				this->data_container->history_command = false;
 			} else if (this->data_container->pause_command) {
 				sprintf(paramsg, "p");
 			} else if (this->data_container->save_command) {
@@ -145,5 +163,30 @@ wxThread::ExitCode WorkerThread::Entry ()
 
 	close(newsockfd);
 	close(sockfd);
+	return (wxThread::ExitCode) 0;
+}
+
+// True if the next answer to the engine would be anything but a pause
+// request; saving and changing mode are only possible while running.
+bool ContainerWorkspace::hasPendingCommand() const
+{
+	return (send_changes || record_command || event_record_command || history_command || !pause_command);
+}
+
+// Called by the GUI after raising a command flag; taking the lock orders the
+// notification after the check made by a worker about to wait.
+void ContainerWorkspace::signalCommand()
+{
+	{
+		std::lock_guard<std::mutex> lock(command_lock);
+	}
+	command_queued.notify_one();
+	return;
+}
 
+void ContainerWorkspace::waitForCommand()
+{
+	std::unique_lock<std::mutex> lock(command_lock);
+	command_queued.wait(lock, [this] { return hasPendingCommand(); });
+	return;
 }
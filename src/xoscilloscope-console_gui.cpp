@@ -59,45 +59,31 @@ GuiFrame::GuiFrame (const wxString& title)
 	Connect(EVENT_BUTTON_TDUP, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::knobTdivUp));
 	Connect(EVENT_BUTTON_TDDW, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::knobTdivDw));
 
-	statictext_title_y1dv = new wxStaticText(this, wxID_ANY, wxT("Vertical scale, channel 1"), wxDefaultPosition, wxDefaultSize, 0);
-	statictext_title_y1dv->SetFont(font_bold);
-	staticline_title_y1dv = new wxStaticLine(this, wxID_ANY, wxDefaultPosition, wxSize(-1,1));
-	statictext_value_y1dv = new wxStaticText(this, wxID_ANY, "", wxDefaultPosition, wxDefaultSize, 0);
-	statictext_value_y1dv->SetFont(font_bold);
-	button_y1dv_up = new wxButton(this, EVENT_BUTTON_Y1UP, wxT("+"), wxDefaultPosition, wxSize(50,50));
-	button_y1dv_dw = new wxButton(this, EVENT_BUTTON_Y1DW, wxT("-"), wxDefaultPosition, wxSize(50,50));
-	Connect(EVENT_BUTTON_Y1UP, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::knobY1dvUp));
-	Connect(EVENT_BUTTON_Y1DW, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::knobY1dvDw));
-	staticline_calibr_ch1 = new wxStaticLine(this, wxID_ANY, wxDefaultPosition, wxSize(-1,1));
-	statictext_title_calibration_ch1 = new wxStaticText(this, wxID_ANY, "Calibration:", wxDefaultPosition, wxDefaultSize);
-	statictext_title_calibration_ch1->SetFont(font_bold);
-	statictext_calibration_ch1 = new wxStaticText(this, wxID_ANY, "No calibration", wxDefaultPosition, wxDefaultSize, wxST_NO_AUTORESIZE);
-	button_calibrate_ch1 = new wxButton(this, EVENT_CALIBRATION_CH1, "Set", wxDefaultPosition, wxDefaultSize);
-	Connect(EVENT_CALIBRATION_CH1, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::changedCalibrationCh1));
-
-	statictext_title_y2dv = new wxStaticText(this, wxID_ANY, wxT("Vertical scale, channel 2"), wxDefaultPosition, wxDefaultSize, 0);
-	statictext_title_y2dv->SetFont(font_bold);
-	staticline_title_y2dv = new wxStaticLine(this, wxID_ANY, wxDefaultPosition, wxSize(-1,1));
-	statictext_value_y2dv = new wxStaticText(this, wxID_ANY, "", wxDefaultPosition, wxDefaultSize, 0);
-	statictext_value_y2dv->SetFont(font_bold);
-	button_y2dv_up = new wxButton(this, EVENT_BUTTON_Y2UP, wxT("+"), wxDefaultPosition, wxSize(50,50));
-	button_y2dv_dw = new wxButton(this, EVENT_BUTTON_Y2DW, wxT("-"), wxDefaultPosition, wxSize(50,50));
-	Connect(EVENT_BUTTON_Y2UP, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::knobY2dvUp));
-	Connect(EVENT_BUTTON_Y2DW, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::knobY2dvDw));
-	staticline_calibr_ch2 = new wxStaticLine(this, wxID_ANY, wxDefaultPosition, wxSize(-1,1));
-	statictext_title_calibration_ch2 = new wxStaticText(this, wxID_ANY, "Calibration:", wxDefaultPosition, wxDefaultSize);
-	statictext_title_calibration_ch2->SetFont(font_bold);
-	statictext_calibration_ch2 = new wxStaticText(this, wxID_ANY, "No calibration", wxDefaultPosition, wxDefaultSize, wxST_NO_AUTORESIZE);
-	button_calibrate_ch2 = new wxButton(this, EVENT_CALIBRATION_CH2, "Set", wxDefaultPosition, wxDefaultSize);
-	Connect(EVENT_CALIBRATION_CH2, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::changedCalibrationCh2));
+	for (int c = 0; c < MAX_CHANNELS; c++) {
+		wxString channel_name = wxString::Format("Channel %d", c + 1);
+		checkbox_channel[c] = new wxCheckBox(this, EVENT_CHECKBOX_CHANNEL + c, channel_name, wxDefaultPosition, wxDefaultSize);
+		checkbox_channel[c]->SetFont(font_bold);
+		Connect(EVENT_CHECKBOX_CHANNEL + c, wxEVT_CHECKBOX, wxCommandEventHandler(GuiFrame::toggleChannel));
+		staticline_title_ydv[c] = new wxStaticLine(this, wxID_ANY, wxDefaultPosition, wxSize(-1,1));
+		statictext_value_ydv[c] = new wxStaticText(this, wxID_ANY, "", wxDefaultPosition, wxDefaultSize, 0);
+		statictext_value_ydv[c]->SetFont(font_bold);
+		button_ydv_up[c] = new wxButton(this, EVENT_BUTTON_YUP + c, wxT("+"), wxDefaultPosition, wxSize(40,40));
+		button_ydv_dw[c] = new wxButton(this, EVENT_BUTTON_YDW + c, wxT("-"), wxDefaultPosition, wxSize(40,40));
+		Connect(EVENT_BUTTON_YUP + c, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::knobYdivUp));
+		Connect(EVENT_BUTTON_YDW + c, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::knobYdivDw));
+		statictext_calibration[c] = new wxStaticText(this, wxID_ANY, "No calibration", wxDefaultPosition, wxDefaultSize, wxST_NO_AUTORESIZE);
+		button_calibrate[c] = new wxButton(this, EVENT_CALIBRATION + c, "Set", wxDefaultPosition, wxDefaultSize);
+		Connect(EVENT_CALIBRATION + c, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::changedCalibration));
+	}
+	Connect(EVENT_WORKER_CHANNELS, wxEVT_THREAD, wxThreadEventHandler(GuiFrame::onChannelCount));
 
 	statictext_title_trig = new wxStaticText(this, wxID_ANY, wxT("Trigger settings"), wxDefaultPosition, wxDefaultSize, 0);
 	statictext_title_trig->SetFont(font_bold);
 	staticline_title_trig = new wxStaticLine(this, wxID_ANY, wxDefaultPosition, wxSize(-1,1));
 	wxArrayString	m_list_channels;
-	m_list_channels.Add(wxT("Ch. 1"));
-	m_list_channels.Add(wxT("Ch. 2"));
-	radiobox_trig_chan = new wxRadioBox(this, EVENT_CHOSEN_TRIG_CHAN, wxT("Trigger channel"), wxDefaultPosition, wxDefaultSize, m_list_channels, 0, wxRA_SPECIFY_ROWS);
+	for (int c = 0; c < MAX_CHANNELS; c++)
+		m_list_channels.Add(wxString::Format("Ch. %d", c + 1));
+	radiobox_trig_chan = new wxRadioBox(this, EVENT_CHOSEN_TRIG_CHAN, wxT("Trigger channel"), wxDefaultPosition, wxDefaultSize, m_list_channels, MAX_CHANNELS / 2, wxRA_SPECIFY_ROWS);
 	Connect(EVENT_CHOSEN_TRIG_CHAN, wxEVT_RADIOBOX, wxCommandEventHandler(GuiFrame::selectTrigChan));
 	wxArrayString	m_list_trigedges;
 	m_list_trigedges.Add(wxT("Rising"));
@@ -117,6 +103,10 @@ GuiFrame::GuiFrame (const wxString& title)
 	Connect(EVENT_BUTTON_TOGGLEMODE, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::toggleMode));
 	button_save = new wxButton(this, EVENT_BUTTON_SAVE, wxT("Save data"), wxDefaultPosition, wxDefaultSize);
 	Connect(EVENT_BUTTON_SAVE, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::selectFileToSave));
+	button_record = new wxButton(this, EVENT_BUTTON_RECORD, wxT("Record"), wxDefaultPosition, wxDefaultSize);
+	Connect(EVENT_BUTTON_RECORD, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::toggleRecording));
+	button_record_events = new wxButton(this, EVENT_BUTTON_RECORD_EVENTS, wxT("Record events"), wxDefaultPosition, wxDefaultSize);
+	Connect(EVENT_BUTTON_RECORD_EVENTS, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::toggleEventRecording));
 	wxArrayString	m_list_averages;
 	m_list_averages.Add(wxT(CHOICES_AVERAGES_0));
 	m_list_averages.Add(wxT(CHOICES_AVERAGES_1));
@@ -126,6 +116,9 @@ GuiFrame::GuiFrame (const wxString& title)
 	m_list_averages.Add(wxT(CHOICES_AVERAGES_5));
 	choice_averages = new wxChoice(this, EVENT_CHOICE_AVERAGES, wxDefaultPosition, wxDefaultSize, m_list_averages);
 	Connect(EVENT_CHOICE_AVERAGES, wxEVT_CHOICE, wxCommandEventHandler(GuiFrame::selectChoiceAverages));
+	statictext_label_history = new wxStaticText(this, wxID_ANY, wxT("History (when paused):"), wxDefaultPosition, wxDefaultSize, 0);
+	slider_history = new wxSlider(this, EVENT_SLIDER_HISTORY, HISTORY_SLIDER_STEPS, 0, HISTORY_SLIDER_STEPS, wxDefaultPosition, wxDefaultSize, wxSL_HORIZONTAL);
+	Connect(EVENT_SLIDER_HISTORY, wxEVT_SLIDER, wxCommandEventHandler(GuiFrame::scrollHistory));
 
 	wxBoxSizer *vbox_all = new wxBoxSizer(wxVERTICAL);
 		wxBoxSizer *hbox_tdtr_all = new wxBoxSizer(wxHORIZONTAL);
@@ -155,49 +148,28 @@ GuiFrame::GuiFrame (const wxString& title)
 		hbox_tdtr_all->Add(vbox_tdiv_all, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 		hbox_tdtr_all->Add(vbox_trig_all, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 
-		wxBoxSizer *hbox_y1y2_all = new wxBoxSizer(wxHORIZONTAL);
-			wxBoxSizer *vbox_y1div_all = new wxBoxSizer(wxVERTICAL);
-				wxBoxSizer *hbox_y1div_title = new wxBoxSizer(wxHORIZONTAL);
-				hbox_y1div_title->Add(statictext_title_y1dv, 3, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
-				hbox_y1div_title->Add(staticline_title_y1dv, 1, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
-				wxBoxSizer *hbox_y1div_btns = new wxBoxSizer(wxHORIZONTAL);
-					wxBoxSizer *vbox_y1div_left = new wxBoxSizer(wxVERTICAL);
-						wxBoxSizer *hbox_y1calibr = new wxBoxSizer(wxHORIZONTAL);
-						hbox_y1calibr->Add(statictext_calibration_ch1, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
-						hbox_y1calibr->Add(button_calibrate_ch1, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
-					vbox_y1div_left->Add(statictext_value_y1dv, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
-					vbox_y1div_left->Add(staticline_calibr_ch1, 1, wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
-					vbox_y1div_left->Add(statictext_title_calibration_ch1, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
-					vbox_y1div_left->Add(hbox_y1calibr, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
-					wxBoxSizer *vbox_y1div_btns = new wxBoxSizer(wxVERTICAL);
-					vbox_y1div_btns->Add(button_y1dv_up, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
-					vbox_y1div_btns->Add(button_y1dv_dw, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
-				hbox_y1div_btns->Add(vbox_y1div_btns, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
-				hbox_y1div_btns->Add(vbox_y1div_left, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
-			vbox_y1div_all->Add(hbox_y1div_title, 0, wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
-			vbox_y1div_all->Add(hbox_y1div_btns, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
-			wxBoxSizer *vbox_y2div_all = new wxBoxSizer(wxVERTICAL);
-				wxBoxSizer *hbox_y2div_title = new wxBoxSizer(wxHORIZONTAL);
-				hbox_y2div_title->Add(statictext_title_y2dv, 3, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
-				hbox_y2div_title->Add(staticline_title_y2dv, 1, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
-				wxBoxSizer *hbox_y2div_btns = new wxBoxSizer(wxHORIZONTAL);
-					wxBoxSizer *vbox_y2div_left = new wxBoxSizer(wxVERTICAL);
-						wxBoxSizer *hbox_y2calibr = new wxBoxSizer(wxHORIZONTAL);
-						hbox_y2calibr->Add(statictext_calibration_ch2, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
-						hbox_y2calibr->Add(button_calibrate_ch2, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
-					vbox_y2div_left->Add(statictext_value_y2dv, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
-					vbox_y2div_left->Add(staticline_calibr_ch2, 1, wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
-					vbox_y2div_left->Add(statictext_title_calibration_ch2, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
-					vbox_y2div_left->Add(hbox_y2calibr, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
-					wxBoxSizer *vbox_y2div_btns = new wxBoxSizer(wxVERTICAL);
-					vbox_y2div_btns->Add(button_y2dv_up, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
-					vbox_y2div_btns->Add(button_y2dv_dw, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
-				hbox_y2div_btns->Add(vbox_y2div_btns, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
-				hbox_y2div_btns->Add(vbox_y2div_left, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
-			vbox_y2div_all->Add(hbox_y2div_title, 0, wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
-			vbox_y2div_all->Add(hbox_y2div_btns, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
-		hbox_y1y2_all->Add(vbox_y1div_all, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
-		hbox_y1y2_all->Add(vbox_y2div_all, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+		grid_ydiv_all = new wxFlexGridSizer(CHANNEL_GRID_COLUMNS);
+		for (int c = 0; c < MAX_CHANNELS; c++) {
+			vbox_ydiv_channel[c] = new wxBoxSizer(wxVERTICAL);
+				wxBoxSizer *hbox_ydiv_title = new wxBoxSizer(wxHORIZONTAL);
+				hbox_ydiv_title->Add(checkbox_channel[c], 3, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
+				hbox_ydiv_title->Add(staticline_title_ydv[c], 1, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
+				wxBoxSizer *hbox_ydiv_btns = new wxBoxSizer(wxHORIZONTAL);
+					wxBoxSizer *vbox_ydiv_left = new wxBoxSizer(wxVERTICAL);
+						wxBoxSizer *hbox_calibr = new wxBoxSizer(wxHORIZONTAL);
+						hbox_calibr->Add(statictext_calibration[c], 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+						hbox_calibr->Add(button_calibrate[c], 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+					vbox_ydiv_left->Add(statictext_value_ydv[c], 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+					vbox_ydiv_left->Add(hbox_calibr, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+					wxBoxSizer *vbox_ydiv_btns = new wxBoxSizer(wxVERTICAL);
+					vbox_ydiv_btns->Add(button_ydv_up[c], 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 2);
+					vbox_ydiv_btns->Add(button_ydv_dw[c], 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 2);
+				hbox_ydiv_btns->Add(vbox_ydiv_btns, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+				hbox_ydiv_btns->Add(vbox_ydiv_left, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+			vbox_ydiv_channel[c]->Add(hbox_ydiv_title, 0, wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+			vbox_ydiv_channel[c]->Add(hbox_ydiv_btns, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+			grid_ydiv_all->Add(vbox_ydiv_channel[c], 0, wxALL, 1);
+		}
 
 		wxBoxSizer *vbox_misc_all = new wxBoxSizer(wxVERTICAL);
 			wxBoxSizer *hbox_misc_title = new wxBoxSizer(wxHORIZONTAL);
@@ -206,16 +178,22 @@ GuiFrame::GuiFrame (const wxString& title)
 			wxBoxSizer *hbox_misc_all = new wxBoxSizer(wxHORIZONTAL);
 			hbox_misc_all->Add(button_runpause, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
 			hbox_misc_all->Add(button_save, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
+			hbox_misc_all->Add(button_record, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
+			hbox_misc_all->Add(button_record_events, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
 			hbox_misc_all->Add(button_togglemode, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
 			hbox_misc_all->Add(choice_averages, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
 		vbox_misc_all->Add(hbox_misc_title, 0, wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+			wxBoxSizer *hbox_history = new wxBoxSizer(wxHORIZONTAL);
+			hbox_history->Add(statictext_label_history, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
+			hbox_history->Add(slider_history, 1, wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
 		vbox_misc_all->Add(hbox_misc_all, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+		vbox_misc_all->Add(hbox_history, 0, wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 	vbox_all->Add(hbox_tdtr_all, 1, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
-	vbox_all->Add(hbox_y1y2_all, 1, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+	vbox_all->Add(grid_ydiv_all, 0, wxALL, 1);
 	vbox_all->Add(vbox_misc_all, 1, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 
 	this->SetSizer(vbox_all);
-	SetSize(1080,550,650,500);
+	SetSize(1080,550,960,560);
 	SetMinSize(wxSize(650,500));
 	Show();
 	GuiFrame::initializeConstants();
@@ -246,6 +224,7 @@ void GuiFrame::knobTdivUp (wxCommandEvent& WXUNUSED(event))
 	}
 	this->scope_parameters->tdiv_idx = ti;
 	this->scope_parameters->send_changes = true;
+	this->scope_parameters->signalCommand();
 	this->updateTdiv();
 
 	return;
@@ -268,6 +247,7 @@ void GuiFrame::knobTdivDw (wxCommandEvent& WXUNUSED(event))
 	}
 	this->scope_parameters->tdiv_idx = ti;
 	this->scope_parameters->send_changes = true;
+	this->scope_parameters->signalCommand();
 	this->updateTdiv();
 
 	return;
@@ -281,119 +261,102 @@ void GuiFrame::updateTdiv()
 	return;
 }
 
-void GuiFrame::knobY1dvUp (wxCommandEvent& WXUNUSED(event))
+void GuiFrame::knobYdivUp (wxCommandEvent& event)
 {
-	int yi = this->scope_parameters->y1div_idx;
+	unsigned int c = event.GetId() - EVENT_BUTTON_YUP;
+	int yi = this->scope_parameters->ydiv_idx[c];
 	int yi_max = this->scope_parameters->ydiv_size;
 	if (yi == yi_max - 1) {
 		return;
 	} else if (yi == 0) {
-		this->button_y1dv_dw->Enable();
+		this->button_ydv_dw[c]->Enable();
 		yi++;
 	} else if (yi == yi_max - 2){
-		this->button_y1dv_up->Disable();
+		this->button_ydv_up[c]->Disable();
 		yi++;
 	} else {
 		yi++;
 	}
-	this->scope_parameters->y1div_idx = yi;
+	this->scope_parameters->ydiv_idx[c] = yi;
 	this->setSpinnerTrigLevelExtrema();
 	this->scope_parameters->send_changes = true;
-	this->updateY1div();
+	this->scope_parameters->signalCommand();
+	this->updateYdiv(c);
 
 	return;
 }
 
-void GuiFrame::knobY1dvDw (wxCommandEvent& WXUNUSED(event))
+void GuiFrame::knobYdivDw (wxCommandEvent& event)
 {
-	int yi = this->scope_parameters->y1div_idx;
+	unsigned int c = event.GetId() - EVENT_BUTTON_YDW;
+	int yi = this->scope_parameters->ydiv_idx[c];
 	int yi_max = this->scope_parameters->ydiv_size;
 	if (yi == 0) {
 		return;
 	} else if (yi == yi_max - 1) {
-		this->button_y1dv_up->Enable();
+		this->button_ydv_up[c]->Enable();
 		yi--;
 	} else if (yi == 1){
-		this->button_y1dv_dw->Disable();
+		this->button_ydv_dw[c]->Disable();
 		yi--;
 	} else {
 		yi--;
 	}
-	this->scope_parameters->y1div_idx = yi;
+	this->scope_parameters->ydiv_idx[c] = yi;
 	this->setSpinnerTrigLevelExtrema();
 	this->scope_parameters->send_changes = true;
-	this->updateY1div();
+	this->scope_parameters->signalCommand();
+	this->updateYdiv(c);
 
 	return;
 }
 
-void GuiFrame::updateY1div()
+void GuiFrame::updateYdiv(unsigned int c)
 {
 	std::stringstream	displayed_value;
-	if (this->scope_parameters->y1_vps != 1.0) {
-		displayed_value << "V scale: " << this->scope_parameters->list_ydiv_volts_txt[this->scope_parameters->y1div_idx] << " / div";
+	if (this->scope_parameters->y_vps[c] != 1.0) {
+		displayed_value << "V scale: " << this->scope_parameters->list_ydiv_volts_txt[this->scope_parameters->ydiv_idx[c]] << " / div";
 	} else {
-		displayed_value << "V scale: " << this->scope_parameters->list_ydiv_samples_txt[this->scope_parameters->y1div_idx] << " / div";
+		displayed_value << "V scale: " << this->scope_parameters->list_ydiv_samples_txt[this->scope_parameters->ydiv_idx[c]] << " / div";
 	}
-	this->statictext_value_y1dv->SetLabel(displayed_value.str());
+	this->statictext_value_ydv[c]->SetLabel(displayed_value.str());
 	return;
 }
 
-void GuiFrame::knobY2dvUp (wxCommandEvent& WXUNUSED(event))
+// A disabled channel is neither processed nor displayed by the engine,
+// unless it is the trigger channel.
+void GuiFrame::toggleChannel(wxCommandEvent& event)
 {
-	int yi = this->scope_parameters->y2div_idx;
-	int yi_max = this->scope_parameters->ydiv_size;
-	if (yi == yi_max - 1) {
-		return;
-	} else if (yi == 0) {
-		this->button_y2dv_dw->Enable();
-		yi++;
-	} else if (yi == yi_max - 2){
-		this->button_y2dv_up->Disable();
-		yi++;
-	} else {
-		yi++;
-	}
-	this->scope_parameters->y2div_idx = yi;
-	this->setSpinnerTrigLevelExtrema();
+	unsigned int c = event.GetId() - EVENT_CHECKBOX_CHANNEL;
+	this->scope_parameters->channel_enabled[c] = this->checkbox_channel[c]->GetValue();
 	this->scope_parameters->send_changes = true;
-	this->updateY2div();
-
+	this->scope_parameters->signalCommand();
 	return;
 }
 
-void GuiFrame::knobY2dvDw (wxCommandEvent& WXUNUSED(event))
+// The engine reports the number of channels it acquires with each request;
+// the worker thread posts this event when the number changes.
+void GuiFrame::onChannelCount(wxThreadEvent& WXUNUSED(event))
 {
-	int yi = this->scope_parameters->y2div_idx;
-	int yi_max = this->scope_parameters->ydiv_size;
-	if (yi == 0) {
-		return;
-	} else if (yi == yi_max - 1) {
-		this->button_y2dv_up->Enable();
-		yi--;
-	} else if (yi == 1){
-		this->button_y2dv_dw->Disable();
-		yi--;
-	} else {
-		yi--;
+	if (this->scope_parameters->trig_channel >= this->scope_parameters->nr_channels) {
+		this->scope_parameters->trig_channel = 0;
+		this->radiobox_trig_chan->SetSelection(0);
+		this->setSpinnerTrigLevelExtrema();
+		this->scope_parameters->send_changes = true;
+		this->scope_parameters->signalCommand();
 	}
-	this->scope_parameters->y2div_idx = yi;
-	this->setSpinnerTrigLevelExtrema();
-	this->scope_parameters->send_changes = true;
-	this->updateY2div();
-
+	this->showChannels();
 	return;
 }
 
-void GuiFrame::updateY2div()
+void GuiFrame::showChannels()
 {
-	std::stringstream	displayed_value;
-	if (this->scope_parameters->y2_vps != 1.0) {
-		displayed_value << "V scale: " << this->scope_parameters->list_ydiv_volts_txt[this->scope_parameters->y2div_idx] << " / div";
-	} else {
-		displayed_value << "V scale: " << this->scope_parameters->list_ydiv_samples_txt[this->scope_parameters->y2div_idx] << " / div";
+	for (unsigned int c = 0; c < MAX_CHANNELS; c++) {
+		bool shown = (c < this->scope_parameters->nr_channels);
+		this->grid_ydiv_all->Show(this->vbox_ydiv_channel[c], shown, true);
+		this->radiobox_trig_chan->Show(c, shown);
 	}
-	this->statictext_value_y2dv->SetLabel(displayed_value.str());
+	this->Layout();
 	return;
 }
 
@@ -402,6 +365,7 @@ void GuiFrame::selectTrigChan(wxCommandEvent& WXUNUSED(event))
 	this->scope_parameters->trig_channel = this->radiobox_trig_chan->GetSelection();
 	this->setSpinnerTrigLevelExtrema();
 	this->scope_parameters->send_changes = true;
+	this->scope_parameters->signalCommand();
 	return;
 }
 
@@ -409,6 +373,7 @@ void GuiFrame::selectTrigEdge(wxCommandEvent& WXUNUSED(event))
 {
 	this->scope_parameters->trig_edge = this->radiobox_trig_edge->GetSelection();
 	this->scope_parameters->send_changes = true;
+	this->scope_parameters->signalCommand();
 	return;
 }
 
@@ -416,13 +381,14 @@ void GuiFrame::selectTrigLevel(wxCommandEvent& WXUNUSED(event))
 {
 	this->scope_parameters->trig_level = this->spinner_trig_level->GetValue();
 	this->scope_parameters->send_changes = true;
+	this->scope_parameters->signalCommand();
 	return;
 }
 
 void GuiFrame::setSpinnerTrigLevelExtrema()
 {
 	unsigned int chan = this->scope_parameters->trig_channel;
-	double ymax = 4.0 * atof(this->scope_parameters->list_ydiv_samples[(chan == 0)? this->scope_parameters->y1div_idx : this->scope_parameters->y2div_idx].c_str());
+	double ymax = 4.0 * atof(this->scope_parameters->list_ydiv_samples[this->scope_parameters->ydiv_idx[chan]].c_str());
 	double previous_value = this->spinner_trig_level->GetValue();
 	this->spinner_trig_level->SetRange(-ymax, ymax);
 	this->spinner_trig_level->SetIncrement(ymax / 100);
@@ -460,49 +426,31 @@ void GuiFrame::selectChoiceAverages(wxCommandEvent& WXUNUSED(event))
 			break;
 	}
 	this->scope_parameters->send_changes = true;
+	this->scope_parameters->signalCommand();
 
 	return;
 }
 
-void GuiFrame::changedCalibrationCh1(wxCommandEvent& WXUNUSED(event))
+void GuiFrame::changedCalibration(wxCommandEvent& event)
 {
-	unsigned int user_value = (unsigned int) wxGetNumberFromUser("Insert calibration factor, i.e. an integer number corresponding to 1 Volt.", "[1,65535]", "Set calibration for Channel 1", 1, 1, 65535, this, wxDefaultPosition);
+	unsigned int c = event.GetId() - EVENT_CALIBRATION;
+	wxString title = wxString::Format("Set calibration for Channel %u", c + 1);
+	unsigned int user_value = (unsigned int) wxGetNumberFromUser("Insert calibration factor, i.e. an integer number corresponding to 1 Volt.", "[1,65535]", title, 1, 1, 65535, this, wxDefaultPosition);
 
 	char	*display_label = (char*) malloc(32 * sizeof(char));
 	if (user_value == 1) {
-		this->scope_parameters->y1_vps = 1.0;
-		this->statictext_calibration_ch1->SetLabel("No calibration");
-		this->statictext_calibration_ch1->Refresh();
+		this->scope_parameters->y_vps[c] = 1.0;
+		this->statictext_calibration[c]->SetLabel("No calibration");
+		this->statictext_calibration[c]->Refresh();
 	} else {
-		this->scope_parameters->y1_vps = 1.0 / (double) user_value;
+		this->scope_parameters->y_vps[c] = 1.0 / (double) user_value;
 		sprintf(display_label, "%d units/V", user_value);
-		this->statictext_calibration_ch1->SetLabel(display_label);
-		this->statictext_calibration_ch1->Refresh();
+		this->statictext_calibration[c]->SetLabel(display_label);
+		this->statictext_calibration[c]->Refresh();
 	}
-	this->updateY1div();
-	this->scope_parameters->send_changes = true;
-
-	free(display_label);
-	return;
-}
-
-void GuiFrame::changedCalibrationCh2(wxCommandEvent& WXUNUSED(event))
-{
-	unsigned int user_value = (unsigned int) wxGetNumberFromUser("Insert calibration factor, i.e. an integer number corresponding to 1 Volt.", "[1,65535]", "Set calibration for Channel 2", 1, 1, 65535, this, wxDefaultPosition);
-
-	char	*display_label = (char*) malloc(32 * sizeof(char));
-	if (user_value == 1) {
-		this->scope_parameters->y2_vps = 1.0;
-		this->statictext_calibration_ch2->SetLabel("No calibration");
-		this->statictext_calibration_ch2->Refresh();
-	} else {
-		this->scope_parameters->y2_vps = 1.0 / (double) user_value;
-		sprintf(display_label, "%d units/V", user_value);
-		this->statictext_calibration_ch2->SetLabel(display_label);
-		this->statictext_calibration_ch2->Refresh();
-	}
-	this->updateY1div();
+	this->updateYdiv(c);
 	this->scope_parameters->send_changes = true;
+	this->scope_parameters->signalCommand();
 
 	free(display_label);
 	return;
@@ -517,6 +465,16 @@ void GuiFrame::initializeConstants()
 	this->button_runpause->SetLabel("Pause");
 	this->scope_parameters->save_command = false;
 	this->scope_parameters->output_file.clear();
+	this->scope_parameters->record_command = false;
+	this->scope_parameters->recording = false;
+	this->scope_parameters->record_file.clear();
+	this->scope_parameters->event_record_command = false;
+	this->scope_parameters->event_recording = false;
+	this->scope_parameters->event_record_file.clear();
+	this->scope_parameters->history_command = false;
+	this->scope_parameters->history_position = 0.0;
+	this->slider_history->SetValue(HISTORY_SLIDER_STEPS);
+	this->slider_history->Disable();
 
 	this->scope_parameters->list_tdiv.resize(16, "");
 	this->scope_parameters->list_tdiv_txt.resize(16, "");
@@ -533,31 +491,32 @@ void GuiFrame::initializeConstants()
 	this->scope_parameters->list_ydiv_samples_txt = {"4 units", "8 units", "20 units", "40 units", "80 units", "200 units", "400 units", "800 units", "2000 units", "4000 units", "8000 units", "20000 units"};
 	this->scope_parameters->list_ydiv_volts = {"1e-3", "2e-3", "5e-3", "1e-2", "2e-2", "5e-2", "1e-1", "2e-1", "5e-1", "1e+0", "2e+0", "5e+1"};
 	this->scope_parameters->list_ydiv_volts_txt = {"1 mV", "2 mV", "5 mV", "10 mV", "20 mV", "50 mV", "100 mV", "200 mV", "500 mV", "1 V", "2 V", "5 V"};
-	this->scope_parameters->y1div_idx = this->scope_parameters->ydiv_size - 2;
-	this->scope_parameters->y2div_idx = this->scope_parameters->ydiv_size - 2;
+	this->scope_parameters->nr_channels = 2;
+	for (int c = 0; c < MAX_CHANNELS; c++) {
+		this->scope_parameters->channel_enabled[c] = true;
+		this->scope_parameters->ydiv_idx[c] = this->scope_parameters->ydiv_size - 2;
+		this->scope_parameters->y_vps[c] = 1.0;
+		this->checkbox_channel[c]->SetValue(true);
+	}
 
 	this->scope_parameters->trig_edge = 0;
 	this->scope_parameters->trig_channel = 0;
 	this->scope_parameters->trig_level = 0.0;
-	this->scope_parameters->y1_vps = 1.0;
-	this->scope_parameters->y2_vps = 1.0;
 
 	this->updateTdiv();
-	this->updateY1div();
-	this->updateY2div();
+	for (int c = 0; c < MAX_CHANNELS; c++)
+		this->updateYdiv(c);
 
 	if (this->scope_parameters->tdiv_idx == this->scope_parameters->list_tdiv.size() - 1)
 		this->button_tdiv_up->Disable();
 	else if (this->scope_parameters->tdiv_idx == 0)
 		this->button_tdiv_dw->Disable();
-	if (this->scope_parameters->y1div_idx == this->scope_parameters->ydiv_size - 1)
-		this->button_y1dv_up->Disable();
-	else if (this->scope_parameters->y1div_idx == 0)
-		this->button_y1dv_dw->Disable();
-	if (this->scope_parameters->y2div_idx == this->scope_parameters->ydiv_size - 1)
-		this->button_y2dv_up->Disable();
-	else if (this->scope_parameters->y2div_idx == 0)
-		this->button_y2dv_dw->Disable();
+	for (int c = 0; c < MAX_CHANNELS; c++) {
+		if (this->scope_parameters->ydiv_idx[c] == this->scope_parameters->ydiv_size - 1)
+			this->button_ydv_up[c]->Disable();
+		else if (this->scope_parameters->ydiv_idx[c] == 0)
+			this->button_ydv_dw[c]->Disable();
+	}
 
 	this->scope_parameters->navg = 1;
 	this->choice_averages->SetSelection(0);
@@ -565,6 +524,7 @@ void GuiFrame::initializeConstants()
 	this->radiobox_trig_chan->SetSelection(this->scope_parameters->trig_channel);
 	this->radiobox_trig_edge->SetSelection(this->scope_parameters->trig_edge);
 	this->setSpinnerTrigLevelExtrema();
+	this->showChannels();
 
 	return;
 }
@@ -577,16 +537,77 @@ void GuiFrame::selectFileToSave(wxCommandEvent& WXUNUSED(event))
 
 	wxString	selected_file_name;
 	std::string	file_name;
-	wxFileDialog saveFileDialog(this, _("Save data file"), "", "", "all files (*.*)|*.*", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+	wxFileDialog saveFileDialog(this, _("Save data file"), "", "", SAVE_FILE_WILDCARD, wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
 	if (saveFileDialog.ShowModal() == wxID_OK) {
 		selected_file_name = saveFileDialog.GetPath();
 		file_name = selected_file_name.ToStdString();
+		// The engine picks the file format from the extension
+		const char *extensions[] = SAVE_FILE_EXTENSIONS;
+		int filter = saveFileDialog.GetFilterIndex();
+		if ((filter > 0) && (file_name.find('.', file_name.find_last_of('/') + 1) == std::string::npos))
+			file_name += extensions[filter];
 
 		this->scope_parameters->output_file = file_name;
 		this->scope_parameters->save_command = true;
+		this->scope_parameters->signalCommand();
 	}
 	this->scope_parameters->pause_command = false;
+	this->scope_parameters->signalCommand();
 	this->button_runpause->SetLabel("Pause");
+	this->slider_history->SetValue(HISTORY_SLIDER_STEPS);
+	this->slider_history->Disable();
+
+	return;
+}
+
+void GuiFrame::toggleRecording(wxCommandEvent& WXUNUSED(event))
+{
+	if (this->scope_parameters->recording) {
+		this->scope_parameters->record_file.clear();
+		this->scope_parameters->recording = false;
+		this->scope_parameters->record_command = true;
+		this->scope_parameters->signalCommand();
+		this->button_record->SetLabel("Record");
+		return;
+	}
+
+	wxFileDialog recordFileDialog(this, _("Record to file"), "", "", "XELab recordings (*.xrec)|*.xrec", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+	if (recordFileDialog.ShowModal() == wxID_OK) {
+		std::string file_name = recordFileDialog.GetPath().ToStdString();
+		if (file_name.find('.', file_name.find_last_of('/') + 1) == std::string::npos)
+			file_name += ".xrec";
+		this->scope_parameters->record_file = file_name;
+		this->scope_parameters->recording = true;
+		this->scope_parameters->record_command = true;
+		this->scope_parameters->signalCommand();
+		this->button_record->SetLabel("Stop recording");
+	}
+
+	return;
+}
+
+void GuiFrame::toggleEventRecording(wxCommandEvent& WXUNUSED(event))
+{
+	if (this->scope_parameters->event_recording) {
+		this->scope_parameters->event_record_file.clear();
+		this->scope_parameters->event_recording = false;
+		this->scope_parameters->event_record_command = true;
+		this->scope_parameters->signalCommand();
+		this->button_record_events->SetLabel("Record events");
+		return;
+	}
+
+	wxFileDialog recordFileDialog(this, _("Record trigger events to file"), "", "", "XELab event segments (*.xseg)|*.xseg", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+	if (recordFileDialog.ShowModal() == wxID_OK) {
+		std::string file_name = recordFileDialog.GetPath().ToStdString();
+		if (file_name.find('.', file_name.find_last_of('/') + 1) == std::string::npos)
+			file_name += ".xseg";
+		this->scope_parameters->event_record_file = file_name;
+		this->scope_parameters->event_recording = true;
+		this->scope_parameters->event_record_command = true;
+		this->scope_parameters->signalCommand();
+		this->button_record_events->SetLabel("Stop events");
+	}
 
 	return;
 }
@@ -596,65 +617,78 @@ void GuiFrame::togglePauseRun(wxCommandEvent& WXUNUSED(event))
 	if (this->scope_parameters->pause_command) {
 		this->button_runpause->SetLabel("Pause");
 		this->scope_parameters->pause_command = false;
+		this->scope_parameters->signalCommand();
+		this->slider_history->SetValue(HISTORY_SLIDER_STEPS);
+		this->slider_history->Disable();
 	} else {
 		this->button_runpause->SetLabel("Run");
 		this->scope_parameters->pause_command = true;
+		this->slider_history->Enable();
 	}
 	return;
 }
 
+// The right end of the slider is the moment of the pause, the left end the
+// oldest data kept by the engine.
+void GuiFrame::scrollHistory(wxCommandEvent& WXUNUSED(event))
+{
+	if (!this->scope_parameters->pause_command)
+		return;
+	this->scope_parameters->history_position = 1.0 - (double) this->slider_history->GetValue() / (double) HISTORY_SLIDER_STEPS;
+	this->scope_parameters->history_command = true;
+	this->scope_parameters->signalCommand();
+	return;
+}
+
 void GuiFrame::toggleMode(wxCommandEvent& WXUNUSED(event))
 {
 	if (this->scope_parameters->mode == 'a') {
 		this->button_togglemode->SetLabel("MODE: X-Y");
 		this->scope_parameters->mode = 'x';
-		this->button_y1dv_up->Enable();
-		this->button_y1dv_dw->Enable();
-		this->button_y2dv_up->Enable();
-		this->button_y2dv_dw->Enable();
-		this->statictext_value_y1dv->Show();
-		this->statictext_value_y2dv->Show();
+		for (unsigned int c = 0; c < this->scope_parameters->nr_channels; c++) {
+			this->button_ydv_up[c]->Enable();
+			this->button_ydv_dw[c]->Enable();
+			this->statictext_value_ydv[c]->Show();
+		}
 		this->spinner_trig_level->Disable();
 		this->statictext_label_trig->Disable();
 		this->choice_averages->Disable();
 	} else if (this->scope_parameters->mode == 'x') {
 		this->button_togglemode->SetLabel("MODE: Digital");
 		this->scope_parameters->mode = 'd';
-		this->button_y1dv_up->Disable();
-		this->button_y1dv_dw->Disable();
-		this->button_y2dv_up->Disable();
-		this->button_y2dv_dw->Disable();
-		this->statictext_value_y1dv->Hide();
-		this->statictext_value_y2dv->Hide();
+		for (unsigned int c = 0; c < this->scope_parameters->nr_channels; c++) {
+			this->button_ydv_up[c]->Disable();
+			this->button_ydv_dw[c]->Disable();
+			this->statictext_value_ydv[c]->Hide();
+		}
 		this->spinner_trig_level->Disable();
 		this->statictext_label_trig->Disable();
 		this->choice_averages->Disable();
 	} else if (this->scope_parameters->mode == 'd') {
 		this->button_togglemode->SetLabel("MODE: Voltmeter");
 		this->scope_parameters->mode = 'v';
-		this->button_y1dv_up->Disable();
-		this->button_y1dv_dw->Disable();
-		this->button_y2dv_up->Disable();
-		this->button_y2dv_dw->Disable();
-		this->statictext_value_y1dv->Hide();
-		this->statictext_value_y2dv->Hide();
+		for (unsigned int c = 0; c < this->scope_parameters->nr_channels; c++) {
+			this->button_ydv_up[c]->Disable();
+			this->button_ydv_dw[c]->Disable();
+			this->statictext_value_ydv[c]->Hide();
+		}
 		this->spinner_trig_level->Disable();
 		this->statictext_label_trig->Disable();
 		this->choice_averages->Disable();
 	} else if (this->scope_parameters->mode == 'v') {
 		this->button_togglemode->SetLabel("MODE: Analog");
 		this->scope_parameters->mode = 'a';
-		this->button_y1dv_up->Enable();
-		this->button_y1dv_dw->Enable();
-		this->button_y2dv_up->Enable();
-		this->button_y2dv_dw->Enable();
-		this->statictext_value_y1dv->Show();
-		this->statictext_value_y2dv->Show();
+		for (unsigned int c = 0; c < this->scope_parameters->nr_channels; c++) {
+			this->button_ydv_up[c]->Enable();
+			this->button_ydv_dw[c]->Enable();
+			this->statictext_value_ydv[c]->Show();
+		}
 		this->spinner_trig_level->Enable();
 		this->statictext_label_trig->Enable();
 		this->choice_averages->Enable();
 	}
 	this->scope_parameters->change_mode = true;
+	this->scope_parameters->signalCommand();
 	return;
 }
 
@@ -0,0 +1,522 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#include "xoscilloscope-engine_capture.h"
+
+ClockEstimator::ClockEstimator()
+{
+	reset(1.0);
+}
+
+void ClockEstimator::reset(double rate)
+{
+	nominal_rate = rate;
+	t_origin = 0.0;
+	p_origin = 0.0;
+	t_last = 0.0;
+	p_last = 0.0;
+	s_w = 0.0;
+	mean_t = 0.0;
+	mean_p = 0.0;
+	c_tt = 0.0;
+	c_tp = 0.0;
+	nr_updates = 0;
+	return;
+}
+
+void ClockEstimator::update(double t, double p)
+{
+	if (nr_updates == 0) {
+		t_origin = t;
+		p_origin = p;
+	}
+	double t_rel = t - t_origin;
+	double p_rel = p - p_origin;
+	s_w = CAPTURE_CLOCK_FORGET * s_w + 1.0;
+	double dt = t_rel - mean_t;
+	double dp = p_rel - mean_p;
+	mean_t += dt / s_w;
+	mean_p += dp / s_w;
+	c_tt = CAPTURE_CLOCK_FORGET * c_tt + dt * (t_rel - mean_t);
+	c_tp = CAPTURE_CLOCK_FORGET * c_tp + dt * (p_rel - mean_p);
+	t_last = t;
+	p_last = p;
+	nr_updates++;
+	return;
+}
+
+// Until enough periods have been seen, the nominal rate is assumed.
+double ClockEstimator::rate() const
+{
+	if ((nr_updates < CAPTURE_CLOCK_WARMUP) || (c_tt <= 0.0))
+		return nominal_rate;
+	return c_tp / c_tt;
+}
+
+double ClockEstimator::position(double t) const
+{
+	if (nr_updates < CAPTURE_CLOCK_WARMUP)
+		return p_last + (t - t_last) * nominal_rate;
+	return p_origin + mean_p + rate() * (t - t_origin - mean_t);
+}
+
+double ClockEstimator::time(double p) const
+{
+	if (nr_updates < CAPTURE_CLOCK_WARMUP)
+		return t_last + (p - p_last) / nominal_rate;
+	return t_origin + mean_t + (p - p_origin - mean_p) / rate();
+}
+
+StreamAligner::StreamAligner()
+{
+	nr_resyncs = 0;
+	reset(1);
+}
+
+// The storage is written once, so that its pages are resident before the
+// capture starts.
+void StreamAligner::reset(unsigned int channels)
+{
+	fifo.assign((CAPTURE_FIFO_FRAMES + CAPTURE_PERIOD_FRAMES) * channels, 0);
+	fifo.clear();
+	nr_channels = channels;
+	fifo_start = 0;
+	phase = 0.0;
+	integral = 0.0;
+	locked = false;
+	return;
+}
+
+// Frames beyond CAPTURE_FIFO_FRAMES (a device running well ahead of the
+// reference) are dropped from the front.
+void StreamAligner::push(const int16_t* frames, unsigned int nr_frames)
+{
+	fifo.insert(fifo.end(), frames, frames + nr_frames * nr_channels);
+	size_t available = fifo.size() / nr_channels;
+	if (available > CAPTURE_FIFO_FRAMES) {
+		size_t drop = available - CAPTURE_FIFO_FRAMES;
+		fifo.erase(fifo.begin(), fifo.begin() + drop * nr_channels);
+		fifo_start += drop;
+		locked = false;
+	}
+	return;
+}
+
+// Writes nr_frames frames of nr_channels samples to out, one every stride
+// samples. target is the device position matching the first output frame
+// and ratio the device frames per output frame. Returns false if the
+// output is not continuous with the previous one.
+bool StreamAligner::align(int16_t* out, unsigned int stride, unsigned int nr_frames, double target, double ratio)
+{
+	bool continuous = true;
+	if (locked && (fabs(target - phase) > CAPTURE_RESYNC_FRAMES))
+		locked = false;
+	if (!locked) {
+		phase = target;
+		integral = 0.0;
+		locked = true;
+		continuous = false;
+		nr_resyncs++;
+	} else {
+		double error = target - phase;
+		integral += error;
+		ratio += (CAPTURE_LOOP_KP * error + CAPTURE_LOOP_KI * integral) / nr_frames;
+	}
+
+	long available = fifo.size() / nr_channels;
+	for (unsigned int j = 0; j < nr_frames; j++) {
+		double p = phase + j * ratio - (double) fifo_start;
+		long i = (long) floor(p);
+		double f = p - i;
+		int16_t* y = &out[j * stride];
+		if ((i < 1) || (i + 2 >= available)) {
+			for (unsigned int c = 0; c < nr_channels; c++)
+				y[c] = 0;
+			locked = false;
+			continue;
+		}
+		const int16_t* x = &fifo[(i - 1) * nr_channels];
+		for (unsigned int c = 0; c < nr_channels; c++) {
+			double xm1 = x[c];
+			double x0 = x[nr_channels + c];
+			double x1 = x[2 * nr_channels + c];
+			double x2 = x[3 * nr_channels + c];
+			double v = x0 + 0.5 * f * (x1 - xm1 + f * (2.0 * xm1 - 5.0 * x0 + 4.0 * x1 - x2 + f * (3.0 * (x0 - x1) + x2 - xm1)));
+			if (v > 32767.0)
+				v = 32767.0;
+			else if (v < -32768.0)
+				v = -32768.0;
+			y[c] = (int16_t) lrint(v);
+		}
+	}
+	phase += nr_frames * ratio;
+
+	// Keep the frame before the phase, needed by the next interpolation.
+	long consumed = (long) floor(phase - (double) fifo_start) - 1;
+	if (consumed > available)
+		consumed = available;
+	if (consumed > 0) {
+		fifo.erase(fifo.begin(), fifo.begin() + consumed * nr_channels);
+		fifo_start += consumed;
+	}
+	return continuous && locked;
+}
+
+uint64_t StreamAligner::resyncs() const
+{
+	return nr_resyncs;
+}
+
+CaptureGroup::CaptureGroup()
+{
+	reference_start = 0;
+	status = NULL;
+	nr_channels = 0;
+	next_report = 0;
+	suspended = false;
+}
+
+CaptureGroup::~CaptureGroup()
+{
+	close();
+}
+
+// Opens the devices in order; each is given channels_per_device channels
+// (zero: all those it offers) within the MAX_CHANNELS of the merged frame.
+// The sample rate is negotiated by the first device and requested from the
+// others.
+bool CaptureGroup::open(const std::vector<std::string> & names, unsigned int* sample_rate, unsigned int channels_per_device, unsigned int* total_channels)
+{
+	close();
+	nr_channels = 0;
+	for (size_t k = 0; k < names.size(); k++) {
+		CaptureDevice device;
+		device.name = names[k];
+		device.sample_rate = (k == 0)? *sample_rate : devices[0].sample_rate;
+		device.nr_channels = channels_per_device;
+		device.first_channel = nr_channels;
+		device.nr_frames = 0;
+		device.linked = false;
+		if (nr_channels >= MAX_CHANNELS) {
+			std::cerr << "No channel left for device <" << device.name << ">, at most " << MAX_CHANNELS << " supported\n";
+			close();
+			return false;
+		}
+		if (snd_pcm_open(&device.handle, device.name.c_str(), SND_PCM_STREAM_CAPTURE, 0) < 0) {
+			std::cerr << "Could not open audio device <" << device.name << ">\n";
+			close();
+			return false;
+		}
+		oXs_hardware_setup_capture(device.handle, &device.sample_rate, &device.nr_channels, MAX_CHANNELS - nr_channels, (names.size() > 1)? CAPTURE_PERIOD_FRAMES : 0);
+		if (k > 0)
+			snd_pcm_nonblock(device.handle, 1);
+		nr_channels += device.nr_channels;
+		devices.push_back(device);
+	}
+	*sample_rate = devices[0].sample_rate;
+	*total_channels = nr_channels;
+
+	// Devices that can be linked to the reference (usually those of the
+	// same card) start and stop with it; the others start one after the
+	// other, the offset being measured by the timestamps anyway.
+	for (size_t k = 1; k < devices.size(); k++)
+		devices[k].linked = (snd_pcm_link(devices[0].handle, devices[k].handle) == 0);
+
+	if (devices.size() > 1) {
+		snd_pcm_status_malloc(&status);
+		device_buf.resize(CAPTURE_PERIOD_FRAMES * MAX_CHANNELS);
+		start();
+	}
+	return true;
+}
+
+void CaptureGroup::close()
+{
+	for (size_t k = 0; k < devices.size(); k++)
+		snd_pcm_close(devices[k].handle);
+	devices.clear();
+	if (status != NULL)
+		snd_pcm_status_free(status);
+	status = NULL;
+	return;
+}
+
+// Starting the reference also starts the devices linked to it.
+void CaptureGroup::start()
+{
+	for (size_t k = 0; k < devices.size(); k++) {
+		devices[k].nr_frames = 0;
+		devices[k].clock.reset(devices[k].sample_rate);
+		devices[k].aligner.reset(devices[k].nr_channels);
+		if (!devices[k].linked && (snd_pcm_state(devices[k].handle) != SND_PCM_STATE_RUNNING))
+			snd_pcm_start(devices[k].handle);
+	}
+	reference.assign((CAPTURE_ALIGN_LATENCY + 4 * CAPTURE_PERIOD_FRAMES) * devices[0].nr_channels, 0);
+	reference.clear();
+	reference_start = 0;
+	next_report = (uint64_t) (CAPTURE_REPORT_INTERVAL * devices[0].sample_rate);
+	return;
+}
+
+// Dropping or preparing the reference acts on the linked devices as well.
+void CaptureGroup::restart()
+{
+	for (size_t k = 0; k < devices.size(); k++) {
+		if (devices[k].linked)
+			continue;
+		snd_pcm_drop(devices[k].handle);
+		snd_pcm_prepare(devices[k].handle);
+	}
+	start();
+	return;
+}
+
+// Reads nr_frames frames into buf. With several devices, an overrun of the
+// reference or of a device linked to it restarts all of them, while one of
+// an unlinked device restarts that device only; both are reported as
+// discontinuities.
+int CaptureGroup::read(int16_t* buf, unsigned int nr_frames, bool & discontinuity)
+{
+	discontinuity = false;
+	if (devices.size() == 1) {
+		snd_pcm_sframes_t nr_read = snd_pcm_readi(devices[0].handle, buf, nr_frames);
+		if (nr_read < 0) {
+			snd_pcm_recover(devices[0].handle, nr_read, 1);
+			discontinuity = true;
+			return 0;
+		}
+		return nr_read;
+	}
+
+	CaptureDevice & reference_device = devices[0];
+	unsigned int reference_channels = reference_device.nr_channels;
+	while (reference.size() / reference_channels < nr_frames + CAPTURE_ALIGN_LATENCY) {
+		if (!readReference(nr_frames)) {
+			restart();
+			discontinuity = true;
+			return 0;
+		}
+		for (size_t k = 1; k < devices.size(); k++) {
+			if (readDevice(devices[k]))
+				continue;
+			discontinuity = true;
+			if (devices[k].linked) {
+				restart();
+				return 0;
+			}
+		}
+	}
+
+	for (unsigned int j = 0; j < nr_frames; j++)
+		memcpy(&buf[j * nr_channels], &reference[j * reference_channels], sizeof(int16_t) * reference_channels);
+	double t_first = reference_device.clock.time(reference_start);
+	double reference_rate = reference_device.clock.rate();
+	for (size_t k = 1; k < devices.size(); k++) {
+		CaptureDevice & device = devices[k];
+		if (!device.aligner.align(&buf[device.first_channel], nr_channels, nr_frames, device.clock.position(t_first), device.clock.rate() / reference_rate))
+			discontinuity = true;
+	}
+	reference.erase(reference.begin(), reference.begin() + nr_frames * reference_channels);
+	reference_start += nr_frames;
+
+	if (reference_start >= next_report)
+		report();
+	return nr_frames;
+}
+
+// Stops the devices, e.g. while the display is paused, so that nothing is
+// captured nor processed. The stream is dropped rather than paused: on
+// resume, capture starts over from fresh samples instead of those held in
+// the device buffer.
+void CaptureGroup::suspend()
+{
+	for (size_t k = 0; k < devices.size(); k++) {
+		if (!devices[k].linked)
+			snd_pcm_drop(devices[k].handle);
+	}
+	suspended = true;
+	return;
+}
+
+void CaptureGroup::resume()
+{
+	for (size_t k = 0; k < devices.size(); k++) {
+		if (!devices[k].linked)
+			snd_pcm_prepare(devices[k].handle);
+	}
+	if (devices.size() > 1)
+		start();
+	suspended = false;
+	return;
+}
+
+bool CaptureGroup::isSuspended() const
+{
+	return suspended;
+}
+
+bool CaptureGroup::readReference(unsigned int nr_frames)
+{
+	CaptureDevice & device = devices[0];
+	if (nr_frames > CAPTURE_PERIOD_FRAMES)
+		nr_frames = CAPTURE_PERIOD_FRAMES;
+	snd_pcm_sframes_t nr_read = snd_pcm_readi(device.handle, device_buf.data(), nr_frames);
+	if (nr_read < 0)
+		return false;
+	reference.insert(reference.end(), device_buf.begin(), device_buf.begin() + nr_read * device.nr_channels);
+	device.nr_frames += nr_read;
+	timestamp(device);
+	return true;
+}
+
+// Drains whatever the (non-blocking) device has captured so far. A linked
+// device is left as is on errors: recovering it would prepare the whole
+// group, which is restarted by the caller instead.
+bool CaptureGroup::readDevice(CaptureDevice & device)
+{
+	while (true) {
+		snd_pcm_sframes_t nr_read = snd_pcm_readi(device.handle, device_buf.data(), CAPTURE_PERIOD_FRAMES);
+		if ((nr_read == -EAGAIN) || (nr_read == 0))
+			break;
+		if ((nr_read < 0) && device.linked)
+			return false;
+		if (nr_read < 0) {
+			snd_pcm_recover(device.handle, nr_read, 1);
+			device.nr_frames = 0;
+			device.clock.reset(device.sample_rate);
+			device.aligner.reset(device.nr_channels);
+			snd_pcm_start(device.handle);
+			return false;
+		}
+		device.aligner.push(device_buf.data(), nr_read);
+		device.nr_frames += nr_read;
+	}
+	timestamp(device);
+	return true;
+}
+
+// With timestamps enabled, the driver takes the timestamp when it updates
+// the hardware position, so that the position derived from the delay and
+// the time refer to the same instant.
+void CaptureGroup::timestamp(CaptureDevice & device)
+{
+	if (snd_pcm_status(device.handle, status) < 0)
+		return;
+	if (snd_pcm_status_get_state(status) != SND_PCM_STATE_RUNNING)
+		return;
+	snd_htimestamp_t stamp;
+	snd_pcm_status_get_htstamp(status, &stamp);
+	double t = (double) stamp.tv_sec + 1.0e-9 * (double) stamp.tv_nsec;
+	device.clock.update(t, (double) device.nr_frames + (double) snd_pcm_status_get_delay(status));
+	return;
+}
+
+void CaptureGroup::report()
+{
+	const CaptureDevice & reference_device = devices[0];
+	double reference_ratio = reference_device.clock.rate() / reference_device.sample_rate;
+	for (size_t k = 1; k < devices.size(); k++) {
+		const CaptureDevice & device = devices[k];
+		double drift = 1.0e6 * (device.clock.rate() / device.sample_rate / reference_ratio - 1.0);
+		std::cerr << "Device <" << device.name << ">: drift " << drift << " ppm against <" << reference_device.name << ">, " << device.aligner.resyncs() << " resynchronizations.\n";
+	}
+	next_report += (uint64_t) (CAPTURE_REPORT_INTERVAL * reference_device.sample_rate);
+	return;
+}
+
+// The channel count is negotiated with the device: the nearest supported
+// one is taken, and zero asks for all the channels of the device, up to
+// max_channels. A non-zero period_size also enables the timestamps used to
+// align several devices.
+int oXs_hardware_setup_capture(snd_pcm_t* device_handle, unsigned int* sample_rate, unsigned int* nr_channels, unsigned int max_channels, snd_pcm_uframes_t period_size)
+{
+	int err;
+	snd_pcm_hw_params_t* device_parameters;
+	if (snd_pcm_hw_params_malloc(&device_parameters) < 0) {
+		std::cerr <<  "Could not allocate hardware parameter structure\n";
+		exit(1);
+	}
+	if ((err = snd_pcm_hw_params_any(device_handle, device_parameters)) < 0) {
+		std::cerr <<  "cannot initialize hardware parameter structure\n";
+		exit(1);
+	}
+	if ((err = snd_pcm_hw_params_set_access(device_handle, device_parameters, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0) {
+		std::cerr <<  "cannot set access type\n";
+		exit(1);
+	}
+	if ((err = snd_pcm_hw_params_set_format(device_handle, device_parameters, SND_PCM_FORMAT_S16_LE)) < 0) {
+		std::cerr <<  "cannot set sample format\n";
+		exit(1);
+	}
+	if ((err = snd_pcm_hw_params_set_rate_near(device_handle, device_parameters, sample_rate, 0)) < 0) {
+		std::cerr <<  "cannot set sample rate\n";
+		exit(1);
+	}
+	if (*nr_channels == 0) {
+		if ((err = snd_pcm_hw_params_get_channels_max(device_parameters, nr_channels)) < 0) {
+			std::cerr <<  "cannot get channel count\n";
+			exit(1);
+		}
+		if (*nr_channels > max_channels)
+			*nr_channels = max_channels;
+	}
+	if ((err = snd_pcm_hw_params_set_channels_near(device_handle, device_parameters, nr_channels)) < 0) {
+		std::cerr <<  "cannot set channel count\n";
+		exit(1);
+	}
+	if (*nr_channels > max_channels) {
+		std::cerr <<  "device requires " << *nr_channels << " channels, at most " << max_channels << " available\n";
+		exit(1);
+	}
+	if ((period_size > 0) && ((err = snd_pcm_hw_params_set_period_size_near(device_handle, device_parameters, &period_size, 0)) < 0)) {
+		std::cerr <<  "cannot set period size\n";
+		exit(1);
+	}
+	if ((err = snd_pcm_hw_params(device_handle, device_parameters)) < 0) {
+		std::cerr <<  "cannot set parameters\n";
+		exit(1);
+	}
+	snd_pcm_hw_params_free(device_parameters);
+	if (period_size > 0) {
+		snd_pcm_sw_params_t* software_parameters;
+		if (snd_pcm_sw_params_malloc(&software_parameters) < 0) {
+			std::cerr <<  "Could not allocate software parameter structure\n";
+			exit(1);
+		}
+		snd_pcm_sw_params_current(device_handle, software_parameters);
+		snd_pcm_sw_params_set_tstamp_mode(device_handle, software_parameters, SND_PCM_TSTAMP_ENABLE);
+		snd_pcm_sw_params_set_tstamp_type(device_handle, software_parameters, SND_PCM_TSTAMP_TYPE_MONOTONIC);
+		if ((err = snd_pcm_sw_params(device_handle, software_parameters)) < 0) {
+			std::cerr <<  "cannot enable timestamps\n";
+			exit(1);
+		}
+		snd_pcm_sw_params_free(software_parameters);
+	}
+	snd_pcm_nonblock(device_handle, 0);
+	if ((err = snd_pcm_prepare(device_handle)) < 0) {
+		std::cerr <<  "cannot prepare audio interface for use\n";
+		exit(1);
+	}
+
+	return 0;
+}
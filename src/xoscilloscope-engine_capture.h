@@ -0,0 +1,163 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#ifndef INCLUDED_ENGINE_CAPTURE
+#define INCLUDED_ENGINE_CAPTURE
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <alsa/asoundlib.h>
+
+#include "xoscilloscope-engine_pipeline.h"
+
+#define CAPTURE_DEFAULT_DEVICE "default"
+#define CAPTURE_PERIOD_FRAMES 512
+#define CAPTURE_ALIGN_LATENCY 4096
+#define CAPTURE_FIFO_FRAMES 65536
+#define CAPTURE_CLOCK_FORGET 0.999
+#define CAPTURE_CLOCK_WARMUP 16
+#define CAPTURE_RESYNC_FRAMES 64.0
+#define CAPTURE_LOOP_KP 0.05
+#define CAPTURE_LOOP_KI 0.002
+#define CAPTURE_REPORT_INTERVAL 60.0
+
+// Model of a device clock: the number of frames captured by the device as a
+// linear function of the system time, fitted by least squares over the
+// (timestamp, position) pairs of the last periods, older pairs being
+// forgotten exponentially. The slope is the actual sample rate, whose ratio
+// to the nominal one gives the drift of the device. The weighted means and
+// the centered (co)variance sums are updated incrementally (West's
+// algorithm), so that the fit keeps its precision over hours of capture.
+class ClockEstimator
+{
+public:
+	ClockEstimator();
+
+	void reset(double);
+	void update(double, double);
+	double rate() const;
+	double position(double) const;
+	double time(double) const;
+
+private:
+	double		nominal_rate;
+	double		t_origin;
+	double		p_origin;
+	double		t_last;
+	double		p_last;
+	double		s_w;
+	double		mean_t;
+	double		mean_p;
+	double		c_tt;
+	double		c_tp;
+	unsigned int	nr_updates;
+};
+
+// Fractional resampler bringing the stream of a device onto the time axis
+// of another one. Frames are queued as they are read; align() interpolates
+// them (cubic Hermite) at the device positions matching the output frames,
+// starting from the target position predicted by the clock models and
+// advancing by the estimated rate ratio. A PI loop on the distance between
+// the resampler phase and the target keeps the two from walking apart; a
+// distance beyond CAPTURE_RESYNC_FRAMES, or running out of queued frames,
+// makes the phase jump to the target.
+class StreamAligner
+{
+public:
+	StreamAligner();
+
+	void reset(unsigned int);
+	void push(const int16_t*, unsigned int);
+	bool align(int16_t*, unsigned int, unsigned int, double, double);
+	uint64_t resyncs() const;
+
+private:
+	std::vector<int16_t>	fifo;
+	unsigned int		nr_channels;
+	uint64_t		fifo_start;
+	double			phase;
+	double			integral;
+	bool			locked;
+	uint64_t		nr_resyncs;
+};
+
+struct CaptureDevice {
+	std::string	name;
+	snd_pcm_t*	handle;
+	unsigned int	sample_rate;
+	unsigned int	nr_channels;
+	unsigned int	first_channel;
+	uint64_t	nr_frames;
+	bool		linked;
+	ClockEstimator	clock;
+	StreamAligner	aligner;
+};
+
+// The capture devices of the engine, read as a single stream. With one
+// device, frames are read straight from it. With several, the first one is
+// the reference: its frames are delayed by CAPTURE_ALIGN_LATENCY frames,
+// so that the others have delivered the matching samples, and the channels
+// of the other devices are resampled onto its time axis and appended to
+// each frame. Every period is timestamped through snd_pcm_status, which
+// feeds the clock models. The merged frame can be triggered on any of its
+// channels.
+class CaptureGroup
+{
+public:
+	CaptureGroup();
+	~CaptureGroup();
+
+	bool open(const std::vector<std::string> &, unsigned int*, unsigned int, unsigned int*);
+	void close();
+	int read(int16_t*, unsigned int, bool &);
+	void suspend();
+	void resume();
+	bool isSuspended() const;
+
+private:
+	void start();
+	void restart();
+	bool readReference(unsigned int);
+	bool readDevice(CaptureDevice &);
+	void timestamp(CaptureDevice &);
+	void report();
+
+	std::vector<CaptureDevice>	devices;
+	std::vector<int16_t>		device_buf;
+	std::vector<int16_t>		reference;
+	uint64_t			reference_start;
+	snd_pcm_status_t*		status;
+	unsigned int			nr_channels;
+	uint64_t			next_report;
+	bool				suspended;
+};
+
+int oXs_hardware_setup_capture(snd_pcm_t*, unsigned int*, unsigned int*, unsigned int, snd_pcm_uframes_t);
+
+#endif
@@ -23,7 +23,9 @@
 
 #include "xoscilloscope-engine_gnuplot.h"
 
-int GnuplotInterface(FILE* gnuplotPipe, const char* fifo_name, const char* command, const char* content, std::vector< std::vector<double> >& pointSet) {
+int GnuplotInterface(FILE* gnuplotPipe, const char* fifo_name, const char* command, const char* content, const DisplayFrame & pointSet) {
+
+	static TextSerializer fifo_text(TEXT_FLOAT);
 
 	if (!(strcmp(command, "wait"))) {
 		usleep((int) (1.e6*atof(content)));
@@ -36,31 +38,15 @@ int GnuplotInterface(FILE* gnuplotPipe, const char* fifo_name, const char* comma
 	} else if (strstr(command, "plot")) {
 		fprintf(gnuplotPipe, "%s %s%s%s %s\n", command, "\"", fifo_name, "\"", (strlen(content))? content : "");
 		fflush(gnuplotPipe);
-		std::ofstream data(fifo_name);
-		for (int n = 0; n < pointSet.size(); n++) {
-			if (pointSet[n].size() == 0)
-				continue;
-			data << pointSet[n][0];
-			for(int m = 1; m < pointSet[n].size(); m++)
-				data << "\t" << pointSet[n][m];
-			data << "\n";
-		}
-		data.flush();
-		data.close();
+		fifo_text.clear();
+		fifo_text.appendRows(pointSet);
+		fifo_text.writeToFile(fifo_name);
 	} else if (strstr(command, "refresh")) {
 		fprintf(gnuplotPipe, "rep\n");
 		fflush(gnuplotPipe);
-		std::ofstream data(fifo_name);
-		for (int n = 0; n < pointSet.size(); n++) {
-			if (pointSet[n].size() == 0)
-				data << "\n\n";
-			data << pointSet[n][0];
-			for(int m = 1; m < pointSet[n].size(); m++)
-				data << "\t" << pointSet[n][m];
-			data << "\n";
-		}
-		data.flush();
-		data.close();
+		fifo_text.clear();
+		fifo_text.appendRows(pointSet);
+		fifo_text.writeToFile(fifo_name);
 	}
 
 	return 0;
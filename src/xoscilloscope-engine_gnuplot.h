@@ -38,6 +38,8 @@
 #include <sys/stat.h>
 #include <sys/wait.h>
 
-int GnuplotInterface(FILE*, const char*, const char*, const char*, std::vector< std::vector<double> >&);
+#include "xoscilloscope-engine_output.h"
+
+int GnuplotInterface(FILE*, const char*, const char*, const char*, const DisplayFrame &);
 int pclose2(FILE *, pid_t);
 FILE * popen2(int &);
@@ -0,0 +1,211 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#include "xoscilloscope-engine_history.h"
+
+HistoryRing::HistoryRing()
+{
+	ring = NULL;
+	ring_size = 0;
+	spilled = false;
+	nr_channels = 0;
+	capacity = 0;
+	nr_frames = 0;
+	frozen = false;
+}
+
+HistoryRing::~HistoryRing()
+{
+	release();
+}
+
+bool HistoryRing::allocate(unsigned int sample_rate, unsigned int channels, double seconds, const std::string & spill_file)
+{
+	release();
+
+	nr_channels = channels;
+	capacity = (uint64_t) (seconds * sample_rate);
+	capacity = (capacity + HISTORY_BLOCK_FRAMES - 1) / HISTORY_BLOCK_FRAMES * HISTORY_BLOCK_FRAMES;
+	if (capacity == 0)
+		return false;
+	ring_size = capacity * nr_channels * sizeof(int16_t);
+
+	void* map;
+	spilled = (ring_size > HISTORY_MEMORY_LIMIT);
+	if (!spilled) {
+		map = mmap(NULL, ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	} else {
+		int fd = open(spill_file.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+		if (fd < 0) {
+			std::cerr << "Could not create history file '" << spill_file << "'\n";
+			return false;
+		}
+		// The file is only reachable through the mapping, and is removed
+		// by the system when the engine exits.
+		unlink(spill_file.c_str());
+		if (ftruncate(fd, ring_size) < 0) {
+			std::cerr << "Could not size history file '" << spill_file << "'\n";
+			close(fd);
+			return false;
+		}
+		map = mmap(NULL, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+	}
+	if (map == MAP_FAILED) {
+		std::cerr << "Could not map " << ring_size << " bytes of history\n";
+		ring_size = 0;
+		return false;
+	}
+	ring = (int16_t*) map;
+
+	block_min.assign(capacity / HISTORY_BLOCK_FRAMES * nr_channels, 0);
+	block_max.assign(capacity / HISTORY_BLOCK_FRAMES * nr_channels, 0);
+	nr_frames = 0;
+	frozen = false;
+
+	std::cerr << "History of " << capacity / (double) sample_rate << " s allocated" << ((ring_size > HISTORY_MEMORY_LIMIT)? " (backed by file)" : "") << "\n";
+	return true;
+}
+
+void HistoryRing::release()
+{
+	if (ring != NULL)
+		munmap(ring, ring_size);
+	ring = NULL;
+	ring_size = 0;
+	capacity = 0;
+	nr_frames = 0;
+	block_min.clear();
+	block_max.clear();
+	return;
+}
+
+bool HistoryRing::isAllocated() const
+{
+	return (ring != NULL);
+}
+
+// Touches every page of a ring in memory, so that appending to it never
+// waits for the kernel. A ring backed by the spill file is meant to be paged
+// out, and is excluded from memory locking instead.
+void HistoryRing::prefault()
+{
+	if (ring == NULL)
+		return;
+	if (spilled) {
+		munlock(ring, ring_size);
+		return;
+	}
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	for (size_t i = 0; i < ring_size; i += page_size)
+		((volatile char*) ring)[i] = 0;
+	return;
+}
+
+// While frozen the history is left untouched, so that it can be browsed.
+void HistoryRing::setFrozen(bool state)
+{
+	frozen = state;
+	return;
+}
+
+void HistoryRing::append(const int16_t* samples, unsigned int count)
+{
+	if ((ring == NULL) || frozen)
+		return;
+
+	for (unsigned int i = 0; i < count; i++) {
+		uint64_t position = nr_frames % capacity;
+		int16_t* low = &block_min[position / HISTORY_BLOCK_FRAMES * nr_channels];
+		int16_t* high = &block_max[position / HISTORY_BLOCK_FRAMES * nr_channels];
+		if (position % HISTORY_BLOCK_FRAMES == 0) {
+			for (unsigned int c = 0; c < nr_channels; c++) {
+				low[c] = INT16_MAX;
+				high[c] = INT16_MIN;
+			}
+		}
+		int16_t* destination = ring + position * nr_channels;
+		for (unsigned int c = 0; c < nr_channels; c++) {
+			int16_t y = samples[c];
+			destination[c] = y;
+			if (y < low[c])
+				low[c] = y;
+			if (y > high[c])
+				high[c] = y;
+		}
+		samples += nr_channels;
+		nr_frames++;
+	}
+	return;
+}
+
+uint64_t HistoryRing::oldest() const
+{
+	return (nr_frames > capacity)? nr_frames - capacity : 0;
+}
+
+uint64_t HistoryRing::newest() const
+{
+	return nr_frames;
+}
+
+const int16_t* HistoryRing::frame(uint64_t index) const
+{
+	return ring + (index % capacity) * nr_channels;
+}
+
+// Extremes of each channel over the frames [first, last), which must lie
+// within [oldest(), newest()). Blocks entirely inside the range are read
+// from the index, the partial ones at both ends from the samples.
+void HistoryRing::range(uint64_t first, uint64_t last, int16_t* low, int16_t* high) const
+{
+	for (unsigned int c = 0; c < nr_channels; c++) {
+		low[c] = INT16_MAX;
+		high[c] = INT16_MIN;
+	}
+
+	uint64_t index = first;
+	while (index < last) {
+		uint64_t block_first = index / HISTORY_BLOCK_FRAMES * HISTORY_BLOCK_FRAMES;
+		if ((index == block_first) && (block_first + HISTORY_BLOCK_FRAMES <= last) && (block_first + HISTORY_BLOCK_FRAMES <= nr_frames)) {
+			uint64_t slot = (block_first % capacity) / HISTORY_BLOCK_FRAMES * nr_channels;
+			for (unsigned int c = 0; c < nr_channels; c++) {
+				if (block_min[slot + c] < low[c])
+					low[c] = block_min[slot + c];
+				if (block_max[slot + c] > high[c])
+					high[c] = block_max[slot + c];
+			}
+			index += HISTORY_BLOCK_FRAMES;
+		} else {
+			const int16_t* y = frame(index);
+			for (unsigned int c = 0; c < nr_channels; c++) {
+				if (y[c] < low[c])
+					low[c] = y[c];
+				if (y[c] > high[c])
+					high[c] = y[c];
+			}
+			index++;
+		}
+	}
+	return;
+}
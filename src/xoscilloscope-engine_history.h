@@ -0,0 +1,79 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#ifndef INCLUDED_ENGINE_HISTORY
+#define INCLUDED_ENGINE_HISTORY
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#define HISTORY_BLOCK_FRAMES 1024
+#define HISTORY_MEMORY_LIMIT 268435456
+#define HISTORY_DEFAULT_FILE "xoscilloscope.history"
+
+// Deep memory: keeps the last minutes of the raw stream in a ring, so that a
+// paused display can be scrolled back to any past moment. Rings larger than
+// HISTORY_MEMORY_LIMIT are backed by a (deleted) file instead of anonymous
+// memory, letting the kernel spill them to disk. A min/max index per block
+// of HISTORY_BLOCK_FRAMES frames answers range queries without touching
+// most of the samples. Frames are addressed by their absolute index since
+// allocation; only [oldest(), newest()) is available.
+class HistoryRing
+{
+public:
+	HistoryRing();
+	~HistoryRing();
+
+	bool allocate(unsigned int, unsigned int, double, const std::string &);
+	void release();
+	bool isAllocated() const;
+	void prefault();
+	void setFrozen(bool);
+	void append(const int16_t*, unsigned int);
+	uint64_t oldest() const;
+	uint64_t newest() const;
+	const int16_t* frame(uint64_t) const;
+	void range(uint64_t, uint64_t, int16_t*, int16_t*) const;
+
+private:
+	int16_t*		ring;
+	size_t			ring_size;
+	bool			spilled;
+	std::vector<int16_t>	block_min;
+	std::vector<int16_t>	block_max;
+	unsigned int		nr_channels;
+	uint64_t		capacity;
+	uint64_t		nr_frames;
+	bool			frozen;
+};
+
+#endif
@@ -27,22 +27,64 @@
 int main (int argc, char *argv[])
 {
 	int err, readbytes;
-	int16_t * buf = (int16_t *) malloc(sizeof(int16_t) * BUF_SIZE * CHN_SIZE);
-	snd_pcm_t *device_handle;
-	snd_pcm_hw_params_t *device_parameters;
+	int16_t * buf;
+	CaptureGroup capture;
+	std::vector<std::string> device_names;
 	unsigned int sample_rate = SAMPLING_RATE;
+	unsigned int nr_channels = CHN_SIZE;
+
+	bool record_direct_io = false;
+	const char* view_file = NULL;
+	double history_minutes = 0.0;
+	std::string history_file = HISTORY_DEFAULT_FILE;
+	unsigned int nr_threads = std::thread::hardware_concurrency();
+	RealtimeSettings realtime;
+	realtime.priority = 0;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--direct-io")) {
+			record_direct_io = true;
+		} else if (!strcmp(argv[i], "--view") && (i + 1 < argc)) {
+			view_file = argv[++i];
+		} else if (!strcmp(argv[i], "--history") && (i + 1 < argc)) {
+			history_minutes = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "--history-file") && (i + 1 < argc)) {
+			history_file = argv[++i];
+		} else if (!strcmp(argv[i], "--threads") && (i + 1 < argc)) {
+			nr_threads = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--realtime") && (i + 1 < argc) && (atoi(argv[i + 1]) >= 1) && (atoi(argv[i + 1]) <= REALTIME_MAX_PRIORITY)) {
+			realtime.priority = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--capture-cpus") && (i + 1 < argc) && oXs_parse_cpu_list(argv[i + 1], realtime.capture_cpus)) {
+			i++;
+		} else if (!strcmp(argv[i], "--processing-cpus") && (i + 1 < argc) && oXs_parse_cpu_list(argv[i + 1], realtime.processing_cpus)) {
+			i++;
+		} else if (!strcmp(argv[i], "--device") && (i + 1 < argc)) {
+			device_names.push_back(argv[++i]);
+		} else if (!strcmp(argv[i], "--channels") && (i + 1 < argc) && (atoi(argv[i + 1]) >= 0) && (atoi(argv[i + 1]) <= MAX_CHANNELS)) {
+			nr_channels = atoi(argv[++i]);
+		} else {
+			std::cerr << "Usage: " << argv[0] << " [--direct-io] [--device <name>]... [--channels <n>] [--history <minutes>] [--history-file <file>] [--threads <n>] [--realtime <priority>] [--capture-cpus <list>] [--processing-cpus <list>] [--view <recording.xrec>]\n";
+			std::cerr << "  --channels 0 acquires as many channels as the device offers (up to " << MAX_CHANNELS << ").\n";
+			std::cerr << "  --realtime runs the capture thread SCHED_FIFO (priority 1-" << REALTIME_MAX_PRIORITY << ") with locked memory; CPU lists read e.g. 2,4-7.\n";
+			std::cerr << "  --device may be repeated: the devices are captured together, aligned on the clock of the first one.\n";
+			exit(1);
+		}
+	}
 
 	requested_termination = false;
 	signal(SIGINT, signalHandler);
 
+	if (view_file != NULL) {
+		oXs_view_recording(view_file);
+		exit(0);
+	}
+
 	std::cerr << "Setting up acquisition device...";
-	if (snd_pcm_open (&device_handle, "default", SND_PCM_STREAM_CAPTURE, 0) < 0) {
-		std::cerr <<  "Could not open audio device <default>\n",
+	if (device_names.empty())
+		device_names.push_back(CAPTURE_DEFAULT_DEVICE);
+	if (!capture.open(device_names, &sample_rate, nr_channels, &nr_channels))
 		exit(1);
-	}
-	oXs_hardware_setup_capture(device_handle, device_parameters, &sample_rate);
-	snd_pcm_hw_params_free(device_parameters);
-	std::cerr << " done.\n";
+	buf = (int16_t *) malloc(sizeof(int16_t) * BUF_SIZE * nr_channels);
+	std::cerr << " done (" << nr_channels << " channels).\n";
 
 	std::cerr << "Setting up connection with console...";
 	int sockfd, servlen,n;
@@ -66,17 +108,12 @@ int main (int argc, char *argv[])
 
 	int pid;
 	std::cerr << "Setting up oscilloscope display...";
-	std::vector<double>			txy(3, 0.0);
-	std::vector< std::vector<double> >	gnuplot_data;
-	std::vector<double>			xy(2, 0.0);
-	std::deque< std::vector<double> >	trigger_data;
-	std::deque< std::vector<double> >	sr;
-	std::deque< std::vector<double> >	accumulator_ch1;
-	std::deque< std::vector<double> >	accumulator_ch2;
-	std::vector<double>			aux_double_vec;
-	std::string				string_voltmeter_1, string_voltmeter_2;
+	std::shared_ptr<DisplayFrame>		gnuplot_frame = std::make_shared<DisplayFrame>();
+	ModeContext				context;
+	const ModeKernel*			mode = oXs_find_mode(AnalogMode::command);
 	ScopeParameters*			scope_parameters = (ScopeParameters *) malloc(sizeof(ScopeParameters));
 	oXs_default_scope_parameters(scope_parameters);
+	scope_parameters->nr_channels = nr_channels;
 	FILE*	gnuplot_pipe;
 	char*	gnuplot_fifo = (char *) malloc(sizeof(char) * 64);
 	char*	clean_fifo = (char *) malloc(sizeof(char) * 64);
@@ -87,217 +124,61 @@ int main (int argc, char *argv[])
 	setvbuf(gnuplot_pipe, NULL, _IONBF, 0);
 	mkfifo(gnuplot_fifo, S_IRUSR | S_IWUSR);
 	oXs_setup_oscilloscope_screen(gnuplot_pipe, gnuplot_fifo);
-	oXs_setup_gnuplot_analog_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+	mode->setupDisplay(gnuplot_pipe, gnuplot_fifo, scope_parameters);
 	std::cerr << " done.\n";
 
+	SaveWriter	save_writer(sample_rate);
+	FrameProcessor	processor(nr_threads);
+	CaptureTaps	taps;
+	oXs_setup_segment_recorder(taps.segments, scope_parameters, sample_rate);
+	if (history_minutes > 0.0)
+		taps.history.allocate(sample_rate, nr_channels, 60.0 * history_minutes, history_file);
+
+	context.capture = &capture;
+	context.buf = buf;
+	context.taps = &taps;
+	context.processor = &processor;
+	context.scope_parameters = scope_parameters;
+	context.dt = 1.0 / (double) sample_rate;
+	oXs_configure_channels(context);
+	// The trigger queues are sized once for the largest time base, so that
+	// changing tdiv never allocates on the capture thread.
+	size_t max_trace_size = ceil(TDIV_MAX * HORIZ_DIVS * sample_rate) + BUF_SIZE;
+	context.trigger_data.allocate(max_trace_size, nr_channels);
+	context.digital_data.allocate(max_trace_size, nr_channels);
+	oXs_setup_realtime(realtime, processor, taps.history);
+
 	std::cerr << "Oscilloscope running.\n";
-	double dt = 1.0 / (double) sample_rate;
-	double t = 0.0;
-	int niter = 0, ntrig = 0;
-	bool triggered = false;
+	int niter = 0;
 	bool pause_command = false;
-	osc_mode operation_mode = MODE_ANALOG;
+	bool history_view = false;
+	double history_position = 0.0;
 	while(!requested_termination) {
 		int trace_size = ceil(scope_parameters->tdiv * HORIZ_DIVS * sample_rate);
-		int nr_of_averages = scope_parameters->navg;
-		triggered = false;
-		trigger_data.clear();
+		if (!pause_command)
+			history_view = false;
+		taps.history.setFrozen(pause_command);
+		// While paused, samples are only needed by a running recorder.
+		bool recording = taps.stream.isRecording() || taps.segments.isRecording();
+		bool idle = pause_command && !recording;
+		if (!idle && capture.isSuspended())
+			capture.resume();
+
+		// Copy-on-write: frames still referenced by a pending save are left
+		// untouched and a new one is built.
+		if (!pause_command && (gnuplot_frame.use_count() > 1))
+			gnuplot_frame = std::make_shared<DisplayFrame>();
+		DisplayFrame &				gnuplot_data = *gnuplot_frame;
 
 		if (!pause_command) {
-			if (operation_mode == MODE_ANALOG) {
-				while (trigger_data.size() < trace_size / 2) {
-					snd_pcm_readi(device_handle, buf, BUF_SIZE);
-					for (int j = 0; (j < BUF_SIZE * CHN_SIZE); j = j + CHN_SIZE) {
-						xy[0] = buf[j];
-						xy[1] = buf[j+1];
-						trigger_data.push_back(xy);
-						if (trigger_data.size() > trace_size / 2)
-							trigger_data.pop_front();
-					}
-				}
-
-				ntrig = 0;
-				while (!triggered) {
-					snd_pcm_readi(device_handle, buf, BUF_SIZE);
-					for (int j = 0; ((j < BUF_SIZE * CHN_SIZE) && (trigger_data.size() < trace_size)); j = j + CHN_SIZE) {
-						xy[0] = buf[j];
-						xy[1] = buf[j+1];
-						if (!triggered && !oXs_trigger_crossing(trigger_data, xy, scope_parameters)) {
-							trigger_data.pop_front();
-						} else {
-							triggered = true;
-						}
-						trigger_data.push_back(xy);
-						ntrig++;
-					}
-					if (ntrig > 1.0 * trace_size) {
-						std::cerr << "Trigger? (graphing anyway...)\n";
-						break;
-					}
-				}
-
-				while (trigger_data.size() < trace_size) {
-					snd_pcm_readi(device_handle, buf, BUF_SIZE);
-					for (int j = 0; ((j < BUF_SIZE * CHN_SIZE) && (trigger_data.size() < trace_size)); j = j + CHN_SIZE) {
-						xy[0] = buf[j];
-						xy[1] = buf[j+1];
-						trigger_data.push_back(xy);
-					}
-				}
-
-				if (nr_of_averages > 1) {
-					aux_double_vec.clear();
-					for (int j = 0; j < trigger_data.size(); j++)
-						aux_double_vec.push_back(trigger_data[j][0] * scope_parameters->y1_vps);
-					accumulator_ch1.push_back(aux_double_vec);
-					if (accumulator_ch1.size() > nr_of_averages)
-						accumulator_ch1.pop_front();
-
-					aux_double_vec.clear();
-					for (int j = 0; j < trigger_data.size(); j++)
-						aux_double_vec.push_back(trigger_data[j][1] * scope_parameters->y2_vps);
-					accumulator_ch2.push_back(aux_double_vec);
-					if (accumulator_ch2.size() > nr_of_averages)
-						accumulator_ch2.pop_front();
-
-					gnuplot_data.clear();
-					t = -0.5*trigger_data.size()*dt;
-					for (int j = 0; j < trigger_data.size(); j++) {
-						txy[0] = t;
-						txy[1] = 0.0;
-						for (int i = 0; i < accumulator_ch1.size(); i++)
-							txy[1] += accumulator_ch1[i][j] / (double) accumulator_ch1.size();
-						txy[2] = 0.0;
-						for (int i = 0; i < accumulator_ch2.size(); i++)
-							txy[2] += accumulator_ch2[i][j] / (double) accumulator_ch2.size();
-						gnuplot_data.push_back(txy);
-						t += dt;
-					}
-				} else {
-					gnuplot_data.clear();
-					t = -0.5*trigger_data.size()*dt;
-					for (int j = 0; j < trigger_data.size(); j++) {
-						txy[0] = t;
-						txy[1] = trigger_data[j][0] * scope_parameters->y1_vps;
-						txy[2] = trigger_data[j][1] * scope_parameters->y2_vps;
-						gnuplot_data.push_back(txy);
-						t += dt;
-					}
-				}
-
-			} else if (operation_mode == MODE_XY) {
-				while (trigger_data.size() < trace_size) {
-					snd_pcm_readi(device_handle, buf, BUF_SIZE);
-					for (int j = 0; (j < BUF_SIZE * CHN_SIZE); j = j + CHN_SIZE) {
-						xy[0] = buf[j];
-						xy[1] = buf[j+1];
-						trigger_data.push_back(xy);
-						if (trigger_data.size() > trace_size)
-							trigger_data.pop_front();
-					}
-				}
-				gnuplot_data.clear();
-				t = -0.5*trigger_data.size()*dt;
-				for (int j = 0; j < trigger_data.size(); j++) {
-					txy[0] = t;
-					txy[1] = trigger_data[j][0] * scope_parameters->y1_vps;
-					txy[2] = trigger_data[j][1] * scope_parameters->y2_vps;
-					gnuplot_data.push_back(txy);
-					t += dt;
-				}
-			} else if (operation_mode == MODE_DIGITAL) {
-				while (trigger_data.size() < trace_size / 2) {
-					snd_pcm_readi(device_handle, buf, BUF_SIZE);
-					for (int j = 0; (j < BUF_SIZE * CHN_SIZE); j = j + CHN_SIZE) {
-						oXs_digital_acquisition(xy, sr, buf, j);
-						trigger_data.push_back(xy);
-						if (trigger_data.size() > trace_size / 2)
-							trigger_data.pop_front();
-					}
-				}
-
-				ntrig = 0;
-				while (!triggered) {
-					snd_pcm_readi(device_handle, buf, BUF_SIZE);
-					for (int j = 0; ((j < BUF_SIZE * CHN_SIZE) && (trigger_data.size() < trace_size)); j = j + CHN_SIZE) {
-						oXs_digital_acquisition(xy, sr, buf, j);
-						if (!triggered && !oXs_trigger_digital(trigger_data, xy, scope_parameters)) {
-							trigger_data.pop_front();
-						} else {
-							triggered = true;
-						}
-						trigger_data.push_back(xy);
-						ntrig++;
-					}
-					if (ntrig > 1.0 * trace_size) {
-						std::cerr << "Trigger? [graphing anyway...]\n";
-						break;
-					}
-				}
-
-				while (trigger_data.size() < trace_size) {
-					snd_pcm_readi(device_handle, buf, BUF_SIZE);
-					for (int j = 0; ((j < BUF_SIZE * CHN_SIZE) && (trigger_data.size() < trace_size)); j = j + CHN_SIZE) {
-						oXs_digital_acquisition(xy, sr, buf, j);
-						trigger_data.push_back(xy);
-					}
-				}
-
-				gnuplot_data.clear();
-				t = -0.5*trigger_data.size()*dt;
-				for (int j = 0; j < trigger_data.size(); j++) {
-					txy[0] = t;
-					txy[1] = trigger_data[j][0];
-					txy[2] = trigger_data[j][1];
-					gnuplot_data.push_back(txy);
-					t += dt;
-				}
-			} else if (operation_mode == MODE_VOLTMETER) {
-				while (trigger_data.size() < trace_size) {
-					snd_pcm_readi(device_handle, buf, BUF_SIZE);
-					for (int j = 0; (j < BUF_SIZE * CHN_SIZE); j = j + CHN_SIZE) {
-						xy[0] = buf[j];
-						xy[1] = buf[j+1];
-						trigger_data.push_back(xy);
-						if (trigger_data.size() > trace_size)
-							trigger_data.pop_front();
-					}
-				}
-				gnuplot_data.clear();
-				t = -0.5*trigger_data.size()*dt;
-				for (int j = 0; j < trigger_data.size(); j++) {
-					txy[0] = t;
-					txy[1] = 0.0;
-					txy[2] = 0.0;
-					gnuplot_data.push_back(txy);
-					t += dt;
-				}
-				oXs_voltmeter_acquisition(string_voltmeter_1, string_voltmeter_2, trigger_data, scope_parameters);
-			}
-		} else {
-			while (trigger_data.size() < ((trace_size > 4410)? 4410 : trace_size)) {
-				snd_pcm_readi(device_handle, buf, BUF_SIZE);
-				for (int j = 0; (j < BUF_SIZE * CHN_SIZE); j = j + CHN_SIZE) {
-					xy[0] = buf[j];
-					xy[1] = buf[j+1];
-					trigger_data.push_back(xy);
-				}
-			}
+			mode->acquire(context, trace_size, gnuplot_data);
+		} else if (recording) {
+			oXs_capture(capture, buf, taps);
 		}
 
 		if (!pause_command) {
 			if (niter % REFRESH_GP == 0) {
-				if (operation_mode == MODE_ANALOG) {
-					GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", "u 1:2 axis x1y1 w l lw 3 lc rgb 'yellow', \"\" u 1:3 axis x1y2 w l lw 3 lc rgb 'cyan'", gnuplot_data);
-				} else if (operation_mode == MODE_XY) {
-					GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", "u 2:3 w l lw 2 lc rgb 'magenta'", gnuplot_data);
-				} else if (operation_mode == MODE_DIGITAL) {
-					GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", "u 1:($2+1.2) axis x1y1 w l lw 3 lc rgb 'yellow', \"\" u 1:3 axis x1y2 w l lw 3 lc rgb 'cyan'", gnuplot_data);
-				} else if (operation_mode == MODE_VOLTMETER) {
-					GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", string_voltmeter_1.c_str(), gnuplot_data);
-					GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", string_voltmeter_2.c_str(), gnuplot_data);
-					GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", "u 1:2 axis x1y1 w l lw 3 lc rgb 'yellow', \"\" u 1:3 axis x1y2 w l lw 3 lc rgb 'cyan'", gnuplot_data);
-				}
+				mode->plot(gnuplot_pipe, gnuplot_fifo, context, gnuplot_data);
 				usleep(10000);
 				niter = 0;
 			} else if (niter % REFRESH_GP == (REFRESH_GP - 1)){
@@ -306,38 +187,30 @@ int main (int argc, char *argv[])
 				usleep(10000);
 				gnuplot_pipe = popen2(pid);
 				oXs_setup_oscilloscope_screen(gnuplot_pipe, gnuplot_fifo);
-				if (operation_mode == MODE_ANALOG) {
-					oXs_setup_gnuplot_analog_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
-				} else if (operation_mode == MODE_XY) {
-					oXs_setup_gnuplot_xy_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
-				} else if (operation_mode == MODE_DIGITAL) {
-					oXs_setup_gnuplot_digital_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
-				} else if (operation_mode == MODE_VOLTMETER) {
-					oXs_setup_gnuplot_voltmeter_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
-				}
+				mode->setupDisplay(gnuplot_pipe, gnuplot_fifo, scope_parameters);
 				usleep(10000);
 			} else {
-				if (operation_mode == MODE_VOLTMETER) {
-					GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", string_voltmeter_1.c_str(), gnuplot_data);
-					GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", string_voltmeter_2.c_str(), gnuplot_data);
-					if (niter < (REFRESH_GP - 250))
-						niter = REFRESH_GP - 250;
-				}
-				GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "refresh", "", gnuplot_data);
+				mode->refresh(gnuplot_pipe, gnuplot_fifo, context, gnuplot_data);
+				if (niter < (REFRESH_GP - mode->restart_interval))
+					niter = REFRESH_GP - mode->restart_interval;
 				usleep(10000);
 			}
-		} else {
-			usleep(10000);
 		}
 
 		if (requested_termination)
 			break;
+		// When idle the devices are stopped and the engine asks the console
+		// to answer only once a command is pending ('w'), sleeping in the
+		// read below; otherwise the console answers right away ('g').
+		if (idle && !capture.isSuspended())
+			capture.suspend();
 		bzero(socket_buffer, SOCKET_BUFFER_SIZE);
-		socket_buffer[0] = 'g';
-		socket_buffer[1] = '\0';
+		sprintf(socket_buffer, "%c%u", (idle)? 'w' : 'g', nr_channels);
 		write(sockfd, socket_buffer, strlen(socket_buffer));
 		readbytes = read(sockfd, socket_buffer, SOCKET_BUFFER_SIZE-2);
 		if (readbytes < 1) {
+			if (requested_termination)
+				break;
 			kill(-pid, 9);
 			pclose2(gnuplot_pipe, pid);
 			exit(1);
@@ -346,55 +219,65 @@ int main (int argc, char *argv[])
 			std::string socket_buffer_msg(socket_buffer);
 			socket_buffer_msg.erase(socket_buffer_msg.begin());
 			std::string msg_tdiv = socket_buffer_msg.substr(0, 4);
-			std::string msg_y1div = socket_buffer_msg.substr(4, 4);
-			std::string msg_y2div = socket_buffer_msg.substr(8, 4);
-			std::string msg_tredge = socket_buffer_msg.substr(12, 1);
-			std::string msg_trchan = socket_buffer_msg.substr(13, 1);
-			std::string msg_trlevel = socket_buffer_msg.substr(14, 9);
-			std::string msg_y1vps = socket_buffer_msg.substr(23, 9);
-			std::string msg_y2vps = socket_buffer_msg.substr(32, 9);
-			std::string msg_navg = socket_buffer_msg.substr(41, 3);
+			std::string msg_tredge = socket_buffer_msg.substr(4, 1);
+			std::string msg_trchan = socket_buffer_msg.substr(5, 1);
+			std::string msg_trlevel = socket_buffer_msg.substr(6, 9);
+			std::string msg_navg = socket_buffer_msg.substr(15, 3);
 
 			scope_parameters->tdiv = atof(msg_tdiv.c_str());
-			scope_parameters->y1div = atof(msg_y1div.c_str());
-			scope_parameters->y2div = atof(msg_y2div.c_str());
 			scope_parameters->trig_rising_edge = (msg_tredge == "r")? true : false;
 			scope_parameters->trig_chan = atoi(msg_trchan.c_str());
+			if ((scope_parameters->trig_chan < 1) || (scope_parameters->trig_chan > nr_channels))
+				scope_parameters->trig_chan = 1;
 			scope_parameters->trig_level = atof(msg_trlevel.c_str());
-			scope_parameters->y1_vps = atof(msg_y1vps.c_str());
-			scope_parameters->y2_vps = atof(msg_y2vps.c_str());
 			scope_parameters->navg = atoi(msg_navg.c_str());
+			// One block per channel: enabled flag, volts per division,
+			// volts per sample unit.
+			for (int c = 0; c < MAX_CHANNELS; c++) {
+				std::string msg_channel = socket_buffer_msg.substr(18 + 14 * c, 14);
+				scope_parameters->enabled[c] = (msg_channel[0] == '1');
+				scope_parameters->ydiv[c] = atof(msg_channel.substr(1, 4).c_str());
+				scope_parameters->y_vps[c] = atof(msg_channel.substr(5, 9).c_str());
+			}
+			oXs_configure_channels(context);
+			taps.stream.setCalibration(scope_parameters->y_vps);
+			oXs_setup_segment_recorder(taps.segments, scope_parameters, sample_rate);
+			if (history_view) {
+				if (gnuplot_frame.use_count() > 1)
+					gnuplot_frame = std::make_shared<DisplayFrame>();
+				oXs_history_frame(*gnuplot_frame, taps.history, scope_parameters, context.channels, history_position, sample_rate);
+			}
 
-			accumulator_ch1.clear();
-			accumulator_ch2.clear();
+			context.accumulator.clear();
 			kill(-pid, 9);
 			pclose2(gnuplot_pipe, pid);
 			usleep(10000);
 			gnuplot_pipe = popen2(pid);
 			oXs_setup_oscilloscope_screen(gnuplot_pipe, gnuplot_fifo);
-			if (operation_mode == MODE_ANALOG) {
-				oXs_setup_gnuplot_analog_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
-				GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", "u 1:2 axis x1y1 w l lw 3 lc rgb 'yellow', \"\" u 1:3 axis x1y2 w l lw 3 lc rgb 'cyan'", gnuplot_data);
-			} else if (operation_mode == MODE_XY) {
-				oXs_setup_gnuplot_xy_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
-				GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", "u 2:3 w l lw 2 lc rgb 'magenta'", gnuplot_data);
-			} else if (operation_mode == MODE_DIGITAL) {
-				oXs_setup_gnuplot_digital_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
-				GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", "u 1:($2+1.2) axis x1y1 w l lw 3 lc rgb 'yellow', \"\" u 1:3 axis x1y2 w l lw 3 lc rgb 'cyan'", gnuplot_data);
-			} else if (operation_mode == MODE_VOLTMETER) {
-				oXs_setup_gnuplot_voltmeter_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
-				GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", string_voltmeter_1.c_str(), gnuplot_data);
-				GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", string_voltmeter_2.c_str(), gnuplot_data);
-				GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", "u 1:($2+1.2) axis x1y1 w l lw 3 lc rgb 'yellow', \"\" u 1:3 axis x1y2 w l lw 3 lc rgb 'cyan'", gnuplot_data);
-			}
+			mode->setupDisplay(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+			mode->plot(gnuplot_pipe, gnuplot_fifo, context, *gnuplot_frame);
 			usleep(10000);
-			pause_command = false;
+			pause_command = history_view;
 		} else if (socket_buffer[0] == 'p') {
 			pause_command = true;
+		} else if (socket_buffer[0] == 'h') {
+			if (!taps.history.isAllocated()) {
+				std::cerr << "No history available (start the engine with --history <minutes>).\n";
+			} else if (!mode->browses_history) {
+				std::cerr << "History can be browsed in analog and X-Y modes only.\n";
+			} else {
+				history_position = atof(socket_buffer + 1);
+				history_view = true;
+				pause_command = true;
+				if (gnuplot_frame.use_count() > 1)
+					gnuplot_frame = std::make_shared<DisplayFrame>();
+				oXs_history_frame(*gnuplot_frame, taps.history, scope_parameters, context.channels, history_position, sample_rate);
+				mode->plot(gnuplot_pipe, gnuplot_fifo, context, *gnuplot_frame);
+			}
 		} else if (socket_buffer[0] == 's') {
 			std::string socket_buffer_msg(socket_buffer);
 			socket_buffer_msg.erase(socket_buffer_msg.begin());
-			oXs_save_output_file(socket_buffer_msg, gnuplot_data);
+			save_writer.submit(socket_buffer_msg, gnuplot_frame, context.channels);
 			pause_command = false;
 		} else if (socket_buffer[0] == 'm') {
 			kill(-pid, 9);
@@ -402,23 +285,24 @@ int main (int argc, char *argv[])
 			usleep(10000);
 			gnuplot_pipe = popen2(pid);
 			oXs_setup_oscilloscope_screen(gnuplot_pipe, gnuplot_fifo);
-			if (socket_buffer[1] == 'a') {
-				oXs_setup_gnuplot_analog_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
-				operation_mode = MODE_ANALOG;
-				niter = -1;
-			} else if (socket_buffer[1] == 'x') {
-				oXs_setup_gnuplot_xy_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
-				operation_mode = MODE_XY;
-				niter = -1;
-			} else if (socket_buffer[1] == 'd') {
-				oXs_setup_gnuplot_digital_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
-				operation_mode = MODE_DIGITAL;
-				niter = -1;
-			} else if (socket_buffer[1] == 'v') {
-				oXs_setup_gnuplot_voltmeter_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
-				operation_mode = MODE_VOLTMETER;
+			const ModeKernel* requested_mode = oXs_find_mode(socket_buffer[1]);
+			if (requested_mode != NULL) {
+				mode = requested_mode;
+				mode->setupDisplay(gnuplot_pipe, gnuplot_fifo, scope_parameters);
 				niter = -1;
 			}
+		} else if (socket_buffer[0] == 'r') {
+			std::string socket_buffer_msg(socket_buffer);
+			socket_buffer_msg.erase(socket_buffer_msg.begin());
+			taps.stream.stop();
+			if (!socket_buffer_msg.empty())
+				taps.stream.start(socket_buffer_msg, sample_rate, nr_channels, scope_parameters->y_vps, record_direct_io);
+		} else if (socket_buffer[0] == 'e') {
+			std::string socket_buffer_msg(socket_buffer);
+			socket_buffer_msg.erase(socket_buffer_msg.begin());
+			taps.segments.stop();
+			if (!socket_buffer_msg.empty())
+				taps.segments.start(socket_buffer_msg, sample_rate, nr_channels, scope_parameters->y_vps);
 		} else if (socket_buffer[0] == 'n') {
 			pause_command = false;
 		} else {
@@ -430,9 +314,12 @@ int main (int argc, char *argv[])
 	}
 
 	free(buf);
-	snd_pcm_close(device_handle);
+	capture.close();
 	close(sockfd);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "execute", "q", gnuplot_data);
+	save_writer.stop();
+	taps.stream.stop();
+	taps.segments.stop();
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "execute", "q", *gnuplot_frame);
 	usleep(100000);
 	free(gnuplot_fifo);
 	kill(-pid, 9);
@@ -441,104 +328,155 @@ int main (int argc, char *argv[])
 	exit(0);
 }
 
-bool oXs_trigger_crossing(std::deque<std::vector<double> > & data, std::vector<double> & xy_new, ScopeParameters* scope_parameters)
+// Offline viewer: displays a recording through the same gnuplot path as the
+// live display. Commands are read from the standard input, one per line:
+//	+ / -		zoom in / out by a factor 2 around the window center
+//	< / >		pan by half a window
+//	a		show the whole recording
+//	g t0 t1		show the window [t0, t1] (seconds)
+//	q		quit
+void oXs_view_recording(const char* file_name)
 {
-	bool crossed = false;
-
-	std::vector <double> xy_last = data.back();
-	double y_new = xy_new[scope_parameters->trig_chan - 1];
-	double y_last = xy_last[scope_parameters->trig_chan - 1];
-
-	if (scope_parameters->trig_rising_edge) {
-		if ((y_last < scope_parameters->trig_level) && (y_new >= scope_parameters->trig_level))
-			crossed = true;
-	} else {
-		if ((y_last > scope_parameters->trig_level) && (y_new <= scope_parameters->trig_level))
-			crossed = true;
+	RecordingView view;
+	std::cerr << "Opening recording '" << file_name << "'...";
+	if (!view.open(file_name))
+		exit(1);
+	std::cerr << " done (" << view.nrFrames() << " frames).\n";
+	if (view.nrFrames() == 0) {
+		std::cerr << "Empty recording, nothing to show.\n";
+		return;
 	}
 
-	return crossed;
-}
+	int pid;
+	FILE*	gnuplot_pipe;
+	char*	gnuplot_fifo = (char *) malloc(sizeof(char) * 64);
+	char*	clean_fifo = (char *) malloc(sizeof(char) * 64);
+	sprintf(gnuplot_fifo, "scope.fifo");
+	sprintf(clean_fifo, "rm -f scope.fifo");
+	system(clean_fifo);
+	gnuplot_pipe = popen2(pid);
+	setvbuf(gnuplot_pipe, NULL, _IONBF, 0);
+	mkfifo(gnuplot_fifo, S_IRUSR | S_IWUSR);
+	oXs_setup_oscilloscope_screen(gnuplot_pipe, gnuplot_fifo);
 
-void oXs_digital_acquisition(std::vector<double> & xy, std::deque< std::vector<double> > & sr, const int16_t* buf, int j)
-{
-	double m0 = 0.0, m1 = 0.0, s0 = 0.0, s1 = 0.0;
-	std::vector<double> x(2, 0.0);
-	x[0] = buf[j];
-	x[1] = buf[j+1];
-	sr.push_back(x);
-	if (sr.size() > DIG_SR_SIZE)
-		sr.pop_front();
-	for (int i = 0; i < sr.size(); i++) {
-		m0 += sr[i][0];
-		m1 += sr[i][1];
-		s0 += sr[i][0]*sr[i][0];
-		s1 += sr[i][1]*sr[i][1];
-	}
-	m0 /= (double) sr.size();
-	m1 /= (double) sr.size();
-	s0 /= (double) sr.size();
-	s1 /= (double) sr.size();
-	s0 -= m0*m0;
-	s1 -= m1*m1;
+	std::string plot_command = oXs_viewer_plot_command(view.nrChannels());
+	double rate = view.sampleRate();
+	uint64_t total = view.nrFrames();
+	uint64_t first = 0, last = total;
+	DisplayFrame gnuplot_data;
+	std::string command;
+	std::cerr << "Viewer commands: + - < > a 'g t0 t1' q\n";
+	while (!requested_termination) {
+		oXs_setup_gnuplot_viewer_parameters(gnuplot_pipe, gnuplot_fifo, view, first, last);
+		unsigned int level = view.query(first, last, VIEWER_NR_PIXELS, gnuplot_data);
+		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", plot_command.c_str(), gnuplot_data);
+		std::cerr << "[" << first / rate << " s, " << last / rate << " s] ";
+		if (level == 0)
+			std::cerr << "(samples)> ";
+		else
+			std::cerr << "(pyramid level " << level - 1 << ")> ";
+
+		if (!std::getline(std::cin, command) || command.empty() || (command[0] == 'q'))
+			break;
 
-	xy[0] = (sqrt(s0) < DIG_SIG_THR)? 0 : 1;
-	xy[1] = (sqrt(s1) < DIG_SIG_THR)? 0 : 1;
+		uint64_t width = last - first;
+		uint64_t center = first + width / 2;
+		if (command[0] == '+') {
+			width = (width / 2 > 1)? width / 2 : 1;
+			first = (center > width / 2)? center - width / 2 : 0;
+		} else if (command[0] == '-') {
+			width *= 2;
+			first = (center > width / 2)? center - width / 2 : 0;
+		} else if (command[0] == '<') {
+			first = (first > width / 2)? first - width / 2 : 0;
+		} else if (command[0] == '>') {
+			first += width / 2;
+		} else if (command[0] == 'a') {
+			first = 0;
+			width = total;
+		} else if (command[0] == 'g') {
+			double t0, t1;
+			if ((sscanf(command.c_str() + 1, "%lf %lf", &t0, &t1) == 2) && (t0 >= 0.0) && (t1 * rate >= t0 * rate + 1.0)) {
+				first = t0 * rate;
+				width = (t1 - t0) * rate;
+			} else {
+				std::cerr << "Usage: g t0 t1\n";
+			}
+		}
+		if (width > total)
+			width = total;
+		if (first + width > total)
+			first = total - width;
+		last = first + width;
+	}
 
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "execute", "q", gnuplot_data);
+	usleep(100000);
+	system(clean_fifo);
+	free(gnuplot_fifo);
+	free(clean_fifo);
+	kill(-pid, 9);
+	pclose2(gnuplot_pipe, pid);
 	return;
 }
 
-bool oXs_trigger_digital(std::deque<std::vector<double> > & data, std::vector<double> & xy_new, ScopeParameters* scope_parameters)
+// Builds a screen-wide frame out of the history. The position is a fraction
+// of the available history: 0 shows the latest frames, 1 the oldest ones.
+// Windows longer than HISTORY_DISPLAY_POINTS frames are reduced to a min/max
+// pair per point, so that peaks remain visible at any time scale. Columns
+// are those of the live display: the time and the given channels.
+void oXs_history_frame(DisplayFrame & data, const HistoryRing & history, const ScopeParameters* scope_parameters, const std::vector<unsigned int> & channels, double position, unsigned int sample_rate)
 {
-	bool crossed = false;
-
-	std::vector <double> xy_last = data.back();
-	double y_new = xy_new[scope_parameters->trig_chan - 1];
-	double y_last = xy_last[scope_parameters->trig_chan - 1];
+	uint64_t window = ceil(scope_parameters->tdiv * HORIZ_DIVS * sample_rate);
+	uint64_t available = history.newest() - history.oldest();
+	if (window > available)
+		window = available;
+	if (position < 0.0)
+		position = 0.0;
+	if (position > 1.0)
+		position = 1.0;
+	uint64_t last = history.newest() - (uint64_t) (position * (available - window));
+	uint64_t first = last - window;
 
-	if (scope_parameters->trig_rising_edge) {
-		if ((y_last == 0) && (y_new == 1))
-			crossed = true;
+	double dt = 1.0 / (double) sample_rate;
+	double t0 = -0.5 * window * dt;
+	const double* y_vps = scope_parameters->y_vps;
+	if (window <= HISTORY_DISPLAY_POINTS) {
+		data.resize(window, channels.size() + 1);
+		for (uint64_t i = first; i < last; i++) {
+			const int16_t* y = history.frame(i);
+			data.at(i - first, 0) = t0 + (i - first) * dt;
+			for (size_t k = 0; k < channels.size(); k++)
+				data.at(i - first, k + 1) = y[channels[k]] * y_vps[channels[k]];
+		}
 	} else {
-		if ((y_last == 1) && (y_new == 0))
-			crossed = true;
+		unsigned int nr_points = HISTORY_DISPLAY_POINTS / 2;
+		int16_t low[MAX_CHANNELS], high[MAX_CHANNELS];
+		data.resize(2 * nr_points, channels.size() + 1);
+		for (unsigned int p = 0; p < nr_points; p++) {
+			uint64_t bin_first = first + window * p / nr_points;
+			uint64_t bin_last = first + window * (p + 1) / nr_points;
+			history.range(bin_first, bin_last, low, high);
+			data.at(2 * p, 0) = t0 + (bin_first - first) * dt;
+			data.at(2 * p + 1, 0) = t0 + ((bin_first + bin_last) / 2 - first) * dt;
+			for (size_t k = 0; k < channels.size(); k++) {
+				data.at(2 * p, k + 1) = low[channels[k]] * y_vps[channels[k]];
+				data.at(2 * p + 1, k + 1) = high[channels[k]] * y_vps[channels[k]];
+			}
+		}
 	}
 
-	return crossed;
+	std::cerr << "History: " << (history.newest() - last) * dt << " s before pause (" << available * dt << " s available)\n";
+	return;
 }
 
-void oXs_voltmeter_acquisition(std::string & string_voltmeter_1, std::string & string_voltmeter_2, const std::deque< std::vector<double> > & collected_data, const ScopeParameters * scope_parameters)
+// Event segments span the same window as the screen, centered on the trigger.
+void oXs_setup_segment_recorder(SegmentRecorder & segments, const ScopeParameters* scope_parameters, unsigned int sample_rate)
 {
-	double V1 = 0.0, V2 = 0.0;
-
-	for (int i = 0; i < collected_data.size(); i++) {
-		V1 += fabs(collected_data[i][0]);
-		V2 += fabs(collected_data[i][1]);
-	}
-	V1 *= 2.0 * scope_parameters->y1_vps / (double) collected_data.size();
-	V2 *= 2.0 * scope_parameters->y2_vps / (double) collected_data.size();
-
-	string_voltmeter_1.clear();
-	string_voltmeter_2.clear();
-	char *str_V1 = (char *) malloc(sizeof(char) * 256);
-	char *str_V2 = (char *) malloc(sizeof(char) * 256);
-	if (scope_parameters->y1_vps != 1.0) {
-		sprintf(str_V1, "label 1 \"Ch1 = %.4f V\" at 0,0.5 center textcolor rgb '#d0d0d0' font \"mbfont:Courier,24\"", V1);
-	} else {
-		sprintf(str_V1, "label 1 \"Ch1 = %.f (a.u.)\" at 0,0.5 center textcolor rgb '#d0d0d0' font \"mbfont:Courier,24\"", V1);
-	}
-	if (scope_parameters->y2_vps != 1.0) {
-		sprintf(str_V2, "label 2 \"Ch2 = %.4f V\" at 0,-0.5 center textcolor rgb '#d0d0d0' font \"mbfont:Courier,24\"", V2);
-	} else {
-		sprintf(str_V2, "label 2 \"Ch2 = %.f (a.u.)\" at 0,-0.5 center textcolor rgb '#d0d0d0' font \"mbfont:Courier,24\"", V2);
-	}
-
-	string_voltmeter_1 = str_V1;
-	string_voltmeter_2 = str_V2;
-
-	free(str_V1);
-	free(str_V2);
-
+	unsigned int window = ceil(scope_parameters->tdiv * HORIZ_DIVS * sample_rate);
+	segments.setWindow(window / 2, window - window / 2);
+	segments.setTrigger(scope_parameters->trig_chan - 1, scope_parameters->trig_level, scope_parameters->trig_rising_edge);
+	segments.setCalibration(scope_parameters->y_vps);
 	return;
 }
 
@@ -549,208 +487,75 @@ void signalHandler(int signum)
 	return;
 }
 
-void oXs_save_output_file(std::string file_name_and_path, std::vector< std::vector<double> > & data_txy)
+// Each channel of a recording is drawn as its min/max band plus its mean.
+// As on the live display, the second channel goes against the right axis
+// and all the others against the left one.
+std::string oXs_viewer_plot_command(unsigned int nr_channels)
 {
-	std::ofstream	output_file;
-	output_file.open(file_name_and_path.c_str(), std::ofstream::out);
-	for (int i = 0; i < data_txy.size(); i++) {
-		for (int j = 0; j < data_txy[j].size(); j++) {
-			if (j > 0) output_file << "\t";
-			output_file << data_txy[i][j];
-		}
-		output_file << "\n";
+	static const char* line_colors[MAX_CHANNELS] = {"yellow", "cyan", "orchid", "green", "orange", "skyblue", "white", "salmon"};
+	static const char* band_colors[MAX_CHANNELS] = {"#808000", "#008080", "#6d386b", "#008000", "#805200", "#446776", "#808080", "#7d4039"};
+	std::string command;
+	char* item = (char *) malloc(sizeof(char) * 256);
+	for (unsigned int c = 0; c < nr_channels; c++) {
+		unsigned int axis = (c == 1)? 2 : 1;
+		sprintf(item, "%su 1:%u:%u axis x1y%u w filledcurves lc rgb '%s', \"\" u 1:%u axis x1y%u w l lw 2 lc rgb '%s'", (c == 0)? "" : ", \"\" ",
+			2 + 3 * c, 3 + 3 * c, axis, band_colors[c % MAX_CHANNELS], 4 + 3 * c, axis, line_colors[c % MAX_CHANNELS]);
+		command += item;
 	}
-	output_file.close();
-
-	std::cerr << "Data saved at '" << file_name_and_path << "'\n";
-
-	return;
-}
-
-void oXs_default_scope_parameters(ScopeParameters* scope_parameters)
-{
-	scope_parameters->tdiv = 1e-4;
-	scope_parameters->y1div = 1e4;
-	scope_parameters->y2div = 1e4;
-	scope_parameters->trig_level = 0.0;
-	scope_parameters->trig_chan = 1;
-	scope_parameters->trig_rising_edge = true;
-	scope_parameters->y1_vps = 1.0;
-	scope_parameters->y2_vps = 1.0;
-	scope_parameters->navg = 1;
-
-	return;
-}
-
-void oXs_setup_gnuplot_analog_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo, ScopeParameters* scope_parameters)
-{
-	double tlim = scope_parameters->tdiv * HORIZ_DIVS / 2.0;
-	double y1lim = scope_parameters->y1div * VERTC_DIVS / 2.0;
-	double y2lim = scope_parameters->y2div * VERTC_DIVS / 2.0;
-
-	char* xrange = (char *) malloc(sizeof(char) * 128);
-	char* y1range = (char *) malloc(sizeof(char) * 128);
-	char* y2range = (char *) malloc(sizeof(char) * 128);
-	char* xtics = (char *) malloc(sizeof(char) * 128);
-	char* y1tics = (char *) malloc(sizeof(char) * 128);
-	char* y2tics = (char *) malloc(sizeof(char) * 128);
-
-	sprintf(xrange, "xrange [%f:%f]", -tlim, tlim);
-	sprintf(y1range, "yrange [%f:%f]", -y1lim, y1lim);
-	sprintf(y2range, "y2range [%f:%f]", -y2lim, y2lim);
-	sprintf(xtics, "xtics %f, %f, %f format \"\"", -tlim, scope_parameters->tdiv, tlim);
-	sprintf(y1tics, "ytics %f, %f, %f", -y1lim, scope_parameters->y1div, y1lim);
-	sprintf(y2tics, "y2tics %f, %f, %f", -y2lim, scope_parameters->y2div, y2lim);
-
-	std::vector< std::vector<double> > dummy;
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xrange, dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1range, dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y2range, dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xtics, dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1tics, dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y2tics, dummy);
-	if (scope_parameters->y1_vps != 1.0)
-		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "ylabel \"Channel 1 (V)\" textcolor rgb '#d0d0d0' offset 0,0", dummy);
-	else
-		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "ylabel \"Channel 1 (a.u.)\" textcolor rgb '#d0d0d0' offset 0,0", dummy);
-
-	if (scope_parameters->y2_vps != 1.0)
-		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "y2label \"Channel 2 (V)\" textcolor rgb '#d0d0d0' offset 0,0", dummy);
-	else
-		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "y2label \"Channel 2 (a.u.)\" textcolor rgb '#d0d0d0' offset 0,0", dummy);
-
-	free(xrange);
-	free(y1range);
-	free(y2range);
-	free(xtics);
-	free(y1tics);
-	free(y2tics);
-
-	return;
-}
-
-void oXs_setup_gnuplot_xy_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo, ScopeParameters* scope_parameters)
-{
-	double y1lim = scope_parameters->y1div * XY_DIVS / 2.0;
-	double y2lim = scope_parameters->y2div * XY_DIVS / 2.0;
-
-	char* xrange = (char *) malloc(sizeof(char) * 128);
-	char* y1range = (char *) malloc(sizeof(char) * 128);
-	char* xtics = (char *) malloc(sizeof(char) * 128);
-	char* y1tics = (char *) malloc(sizeof(char) * 128);
-	char* y2tics = (char *) malloc(sizeof(char) * 128);
-
-	sprintf(xrange, "xrange [%f:%f]", -y1lim, y1lim);
-	sprintf(y1range, "yrange [%f:%f]", -y2lim, y2lim);
-	sprintf(xtics, "xtics %f, %f, %f format \"%%.3f\"", -y1lim, scope_parameters->y1div, y1lim);
-	sprintf(y1tics, "ytics %f, %f, %f format \"%%.3f\"", -y2lim, scope_parameters->y2div, y2lim);
-	sprintf(y2tics, "y2tics format \"\"");
-
-	std::vector< std::vector<double> > dummy;
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "size ratio 1", dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xrange, dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1range, dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xtics, dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1tics, dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y2tics, dummy);
-	if (scope_parameters->y1_vps != 1.0)
-		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "xlabel \"Channel 1 (V)\" textcolor rgb '#d0d0d0' offset 0,0", dummy);
-	else
-		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "xlabel \"Channel 1 (a.u.)\" textcolor rgb '#d0d0d0' offset 0,0", dummy);
-	if (scope_parameters->y2_vps != 1.0)
-		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "y1label \"Channel 2 (V)\" textcolor rgb '#d0d0d0' offset 0,0", dummy);
-	else
-		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "y1label \"Channel 2 (a.u.)\" textcolor rgb '#d0d0d0' offset 0,0", dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "y2label \"\"", dummy);
-
-	free(xrange);
-	free(y1range);
-	free(xtics);
-	free(y1tics);
-	free(y2tics);
-
-	return;
+	free(item);
+	return command;
 }
 
-void oXs_setup_gnuplot_digital_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo, ScopeParameters* scope_parameters)
+void oXs_setup_gnuplot_viewer_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo, const RecordingView & view, uint64_t first, uint64_t last)
 {
-	double tlim = scope_parameters->tdiv * HORIZ_DIVS / 2.0;
+	// Left axis: union of all channels but the second one; right axis: the
+	// second channel, or the same as the left one for mono recordings.
+	double y1min = 0.0, y1max = 0.0, y2min, y2max;
+	for (unsigned int c = 0; c < view.nrChannels(); c++) {
+		double y_min, y_max;
+		if (c == 1)
+			continue;
+		view.valueRange(c, y_min, y_max);
+		if ((c == 0) || (y_min < y1min))
+			y1min = y_min;
+		if ((c == 0) || (y_max > y1max))
+			y1max = y_max;
+	}
+	if (view.nrChannels() > 1) {
+		view.valueRange(1, y2min, y2max);
+	} else {
+		y2min = y1min;
+		y2max = y1max;
+	}
+	double y1margin = (y1max > y1min)? 0.05 * (y1max - y1min) : 1.0;
+	double y2margin = (y2max > y2min)? 0.05 * (y2max - y2min) : 1.0;
 
 	char* xrange = (char *) malloc(sizeof(char) * 128);
 	char* y1range = (char *) malloc(sizeof(char) * 128);
 	char* y2range = (char *) malloc(sizeof(char) * 128);
-	char* xtics = (char *) malloc(sizeof(char) * 128);
-	char* y1tics = (char *) malloc(sizeof(char) * 128);
-	char* y2tics = (char *) malloc(sizeof(char) * 128);
-
-	sprintf(xrange, "xrange [%f:%f]", -tlim, tlim);
-	sprintf(y1range, "yrange [-0.2:2.4]");
-	sprintf(y2range, "y2range [-0.2:2.4]");
-	sprintf(xtics, "xtics %f, %f, %f format \"\"", -tlim, scope_parameters->tdiv, tlim);
-	sprintf(y1tics, "ytics (\"0\" 1.2, \"1\" 2.2)");
-	sprintf(y2tics, "y2tics 0, 1, 1");
-
-	std::vector< std::vector<double> > dummy;
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xrange, dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1range, dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y2range, dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xtics, dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1tics, dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y2tics, dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "ylabel \"Channel 1\" textcolor rgb '#d0d0d0' offset 0,7", dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "y2label \"Channel 2\" textcolor rgb '#d0d0d0' offset 0,-6", dummy);
 
-	free(xrange);
-	free(y1range);
-	free(y2range);
-	free(xtics);
-	free(y1tics);
-	free(y2tics);
+	sprintf(xrange, "xrange [%.9g:%.9g]", first / (double) view.sampleRate(), last / (double) view.sampleRate());
+	sprintf(y1range, "yrange [%f:%f]", y1min - y1margin, y1max + y1margin);
+	sprintf(y2range, "y2range [%f:%f]", y2min - y2margin, y2max + y2margin);
 
-	return;
-}
-
-void oXs_setup_gnuplot_voltmeter_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo, ScopeParameters* scope_parameters)
-{
-	double tlim = scope_parameters->tdiv * HORIZ_DIVS / 2.0;
-
-	char* xrange = (char *) malloc(sizeof(char) * 128);
-	char* y1range = (char *) malloc(sizeof(char) * 128);
-	char* y2range = (char *) malloc(sizeof(char) * 128);
-	char* xtics = (char *) malloc(sizeof(char) * 128);
-	char* y1tics = (char *) malloc(sizeof(char) * 128);
-	char* y2tics = (char *) malloc(sizeof(char) * 128);
-
-	sprintf(xrange, "xrange [%f:%f]", -tlim, tlim);
-	sprintf(y1range, "yrange [-1:1]");
-	sprintf(y2range, "y2range [-1:1]");
-	sprintf(xtics, "xtics");
-	sprintf(y1tics, "ytics");
-	sprintf(y2tics, "y2tics");
-
-	std::vector< std::vector<double> > dummy;
+	DisplayFrame dummy;
 	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xrange, dummy);
 	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1range, dummy);
 	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y2range, dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "unset", xtics, dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "unset", y1tics, dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "unset", y2tics, dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "unset", "ylabel", dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "unset", "y2label", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "xtics autofreq format \"%g\"", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "ytics autofreq", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "y2tics autofreq", dummy);
 
 	free(xrange);
 	free(y1range);
 	free(y2range);
-	free(xtics);
-	free(y1tics);
-	free(y2tics);
 
 	return;
 }
 
 void oXs_setup_oscilloscope_screen(FILE* gnuplot_pipe, char* gnuplot_fifo)
 {
-	std::vector< std::vector<double> >	dummy;
+	DisplayFrame	dummy;
 	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "term x11 background rgb '#151515' size 1000,500 position 50,550 font \"mbfont:Courier,18\"", dummy);
 	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "unset", "key", dummy);
 	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "style line 12 lc rgb '#c0c0c0' dt 3 lw 0.2", dummy);
@@ -764,43 +569,3 @@ void oXs_setup_oscilloscope_screen(FILE* gnuplot_pipe, char* gnuplot_fifo)
 
 	return;
 }
-
-int oXs_hardware_setup_capture(snd_pcm_t* device_handle, snd_pcm_hw_params_t* device_parameters, unsigned int* sample_rate)
-{
-	int err;
-	if (snd_pcm_hw_params_malloc(&device_parameters) < 0) {
-		std::cerr <<  "Could not allocate hardware parameter structure\n";
-		exit(1);
-	}
-	if ((err = snd_pcm_hw_params_any(device_handle, device_parameters)) < 0) {
-		std::cerr <<  "cannot initialize hardware parameter structure\n";
-		exit(1);
-	}
-	if ((err = snd_pcm_hw_params_set_access(device_handle, device_parameters, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0) {
-		std::cerr <<  "cannot set access type\n";
-		exit(1);
-	}
-	if ((err = snd_pcm_hw_params_set_format(device_handle, device_parameters, SND_PCM_FORMAT_S16_LE)) < 0) {
-		std::cerr <<  "cannot set sample format\n";
-		exit(1);
-	}
-	if ((err = snd_pcm_hw_params_set_rate_near(device_handle, device_parameters, sample_rate, 0)) < 0) {
-		std::cerr <<  "cannot set sample rate\n";
-		exit(1);
-	}
-	if ((err = snd_pcm_hw_params_set_channels(device_handle, device_parameters, 2)) < 0) {
-		std::cerr <<  "cannot set channel count\n";
-		exit(1);
-	}
-	if ((err = snd_pcm_hw_params(device_handle, device_parameters)) < 0) {
-		std::cerr <<  "cannot set parameters\n";
-		exit(1);
-	}
-	snd_pcm_nonblock(device_handle, 0);
-	if ((err = snd_pcm_prepare(device_handle)) < 0) {
-		std::cerr <<  "cannot prepare audio interface for use\n";
-		exit(1);
-	}
-
-	return 0;
-}
@@ -0,0 +1,489 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#include "xoscilloscope-engine_modes.h"
+
+static const char* channel_colors[MAX_CHANNELS] = {"yellow", "cyan", "orchid", "green", "orange", "skyblue", "white", "salmon"};
+static const double unit_scale[MAX_CHANNELS] = {1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0};
+static const double zero_scale[MAX_CHANNELS] = {0.0};
+
+static const ModeKernel mode_kernels[] = {
+	oXs_mode_kernel<AnalogMode>(),
+	oXs_mode_kernel<XYMode>(),
+	oXs_mode_kernel<DigitalMode>(),
+	oXs_mode_kernel<VoltmeterMode>()
+};
+
+// Returns the mode selected by a console command letter, or NULL.
+const ModeKernel* oXs_find_mode(char command)
+{
+	for (int i = 0; i < sizeof(mode_kernels) / sizeof(mode_kernels[0]); i++) {
+		if (mode_kernels[i].command == command)
+			return &mode_kernels[i];
+	}
+	return NULL;
+}
+
+void oXs_configure_channels(ModeContext & context)
+{
+	oXs_active_channels(context.scope_parameters, context.active);
+	oXs_displayed_channels(context.scope_parameters, context.channels);
+	context.digital_detector.configure(context.scope_parameters->nr_channels, context.active);
+	return;
+}
+
+// Plot command drawing column k+2 of the frame for each channel. The first
+// channel is drawn against the left axis and the second one against the
+// right axis; further channels are rescaled to their own volts per division
+// and drawn against the left axis.
+static std::string oXs_channels_plot_command(const ScopeParameters* scope_parameters, const std::vector<unsigned int> & channels)
+{
+	std::string command;
+	char* item = (char *) malloc(sizeof(char) * 128);
+	for (size_t k = 0; k < channels.size(); k++) {
+		unsigned int c = channels[k];
+		if (k < 2)
+			sprintf(item, "%su 1:%zu axis x1y%zu w l lw 3 lc rgb '%s'", (k == 0)? "" : ", \"\" ", k + 2, k + 1, channel_colors[c]);
+		else
+			sprintf(item, ", \"\" u 1:($%zu*%g) axis x1y1 w l lw 3 lc rgb '%s'", k + 2, scope_parameters->ydiv[channels[0]] / scope_parameters->ydiv[c], channel_colors[c]);
+		command += item;
+	}
+	free(item);
+	return command;
+}
+
+int oXs_capture(CaptureGroup & capture, int16_t* buf, CaptureTaps & taps)
+{
+	bool discontinuity;
+	int nr_frames = capture.read(buf, BUF_SIZE, discontinuity);
+	if (discontinuity) {
+		taps.stream.markDiscontinuity();
+		taps.segments.markDiscontinuity();
+	}
+	if (nr_frames <= 0)
+		return 0;
+	taps.stream.append(buf, nr_frames);
+	taps.segments.append(buf, nr_frames);
+	taps.history.append(buf, nr_frames);
+	return nr_frames;
+}
+
+// Fills the queue of the source with trace_size frames, the trigger being at
+// trace_size/2. If no trigger occurs within trace_size frames, the frame is
+// shown anyway.
+template <class Source>
+void oXs_acquire_triggered(ModeContext & context, int trace_size, const char* warning)
+{
+	typedef typename Source::Sample Sample;
+	FrameQueue<Sample> & data = Source::queue(context);
+	int nr_channels = context.scope_parameters->nr_channels;
+	Sample converted[MAX_CHANNELS];
+	const Sample* xy;
+	bool triggered = false;
+
+	data.reset(trace_size + BUF_SIZE, nr_channels, context.active);
+	while (data.size() < trace_size / 2) {
+		oXs_capture(*context.capture, context.buf, *context.taps);
+		for (int j = 0; (j < BUF_SIZE * nr_channels); j = j + nr_channels) {
+			xy = Source::convert(context, &context.buf[j], converted);
+			data.push_back(xy);
+			if (data.size() > trace_size / 2)
+				data.pop_front();
+		}
+	}
+
+	int ntrig = 0;
+	while (!triggered) {
+		oXs_capture(*context.capture, context.buf, *context.taps);
+		for (int j = 0; ((j < BUF_SIZE * nr_channels) && (data.size() < trace_size)); j = j + nr_channels) {
+			xy = Source::convert(context, &context.buf[j], converted);
+			if (!triggered && !Source::crossing(data, xy, context.scope_parameters)) {
+				data.pop_front();
+			} else {
+				triggered = true;
+			}
+			data.push_back(xy);
+			ntrig++;
+		}
+		if (ntrig > 1.0 * trace_size) {
+			std::cerr << warning;
+			break;
+		}
+	}
+
+	while (data.size() < trace_size) {
+		oXs_capture(*context.capture, context.buf, *context.taps);
+		for (int j = 0; ((j < BUF_SIZE * nr_channels) && (data.size() < trace_size)); j = j + nr_channels) {
+			xy = Source::convert(context, &context.buf[j], converted);
+			data.push_back(xy);
+		}
+	}
+
+	return;
+}
+
+// Fills trigger_data with the latest trace_size frames (free-running modes).
+void oXs_acquire_window(ModeContext & context, int trace_size)
+{
+	FrameQueue<int16_t> & data = context.trigger_data;
+	int nr_channels = context.scope_parameters->nr_channels;
+	data.reset(trace_size + BUF_SIZE, nr_channels, context.active);
+	while (data.size() < trace_size) {
+		oXs_capture(*context.capture, context.buf, *context.taps);
+		for (int j = 0; (j < BUF_SIZE * nr_channels); j = j + nr_channels) {
+			data.push_back(&context.buf[j]);
+			if (data.size() > trace_size)
+				data.pop_front();
+		}
+	}
+	return;
+}
+
+void AnalogMode::acquire(ModeContext & context, int trace_size, DisplayFrame & frame)
+{
+	ScopeParameters* scope_parameters = context.scope_parameters;
+	oXs_acquire_triggered<RawSource>(context, trace_size, "Trigger? (graphing anyway...)\n");
+
+	FrameQueue<int16_t> & data = context.trigger_data;
+	data.linearize();
+	if (scope_parameters->navg > 1) {
+		std::deque<AverageEntry> & accumulator = context.accumulator;
+		accumulator.emplace_back();
+		AverageEntry & entry = accumulator.back();
+		entry.nr_frames = data.size();
+		entry.planes.resize(scope_parameters->nr_channels);
+		for (size_t k = 0; k < context.channels.size(); k++) {
+			unsigned int c = context.channels[k];
+			entry.planes[c].assign(data.plane(c), data.plane(c) + data.size());
+			entry.y_vps[c] = scope_parameters->y_vps[c];
+		}
+		if (accumulator.size() > scope_parameters->navg)
+			accumulator.pop_front();
+
+		context.processor->averageFrame(accumulator, context.channels, context.dt, frame);
+	} else {
+		context.processor->scaleFrame(data, context.channels, scope_parameters->y_vps, context.dt, frame);
+	}
+	return;
+}
+
+void AnalogMode::setupDisplay(FILE* gnuplot_pipe, char* gnuplot_fifo, ScopeParameters* scope_parameters)
+{
+	oXs_setup_gnuplot_analog_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+	return;
+}
+
+void AnalogMode::plot(FILE* gnuplot_pipe, char* gnuplot_fifo, ModeContext & context, DisplayFrame & frame)
+{
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", oXs_channels_plot_command(context.scope_parameters, context.channels).c_str(), frame);
+	return;
+}
+
+void AnalogMode::refresh(FILE* gnuplot_pipe, char* gnuplot_fifo, ModeContext &, DisplayFrame & frame)
+{
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "refresh", "", frame);
+	return;
+}
+
+void XYMode::acquire(ModeContext & context, int trace_size, DisplayFrame & frame)
+{
+	oXs_acquire_window(context, trace_size);
+	context.trigger_data.linearize();
+	context.processor->scaleFrame(context.trigger_data, context.channels, context.scope_parameters->y_vps, context.dt, frame);
+	return;
+}
+
+void XYMode::setupDisplay(FILE* gnuplot_pipe, char* gnuplot_fifo, ScopeParameters* scope_parameters)
+{
+	oXs_setup_gnuplot_xy_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+	return;
+}
+
+// The first two displayed channels are drawn one against the other.
+void XYMode::plot(FILE* gnuplot_pipe, char* gnuplot_fifo, ModeContext & context, DisplayFrame & frame)
+{
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", (context.channels.size() > 1)? "u 2:3 w l lw 2 lc rgb 'magenta'" : "u 2:2 w l lw 2 lc rgb 'magenta'", frame);
+	return;
+}
+
+void XYMode::refresh(FILE* gnuplot_pipe, char* gnuplot_fifo, ModeContext &, DisplayFrame & frame)
+{
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "refresh", "", frame);
+	return;
+}
+
+void DigitalMode::acquire(ModeContext & context, int trace_size, DisplayFrame & frame)
+{
+	oXs_acquire_triggered<DigitalSource>(context, trace_size, "Trigger? [graphing anyway...]\n");
+	context.digital_data.linearize();
+	context.processor->scaleFrame(context.digital_data, context.channels, unit_scale, context.dt, frame);
+	return;
+}
+
+void DigitalMode::setupDisplay(FILE* gnuplot_pipe, char* gnuplot_fifo, ScopeParameters* scope_parameters)
+{
+	oXs_setup_gnuplot_digital_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+	return;
+}
+
+// Channels are stacked from top to bottom, DIG_TRACE_OFFSET apart.
+void DigitalMode::plot(FILE* gnuplot_pipe, char* gnuplot_fifo, ModeContext & context, DisplayFrame & frame)
+{
+	std::string command;
+	char* item = (char *) malloc(sizeof(char) * 128);
+	size_t n = context.channels.size();
+	for (size_t k = 0; k < n; k++) {
+		sprintf(item, "%su 1:($%zu+%.1f) axis x1y1 w l lw 3 lc rgb '%s'", (k == 0)? "" : ", \"\" ", k + 2, (n - 1 - k) * DIG_TRACE_OFFSET, channel_colors[context.channels[k]]);
+		command += item;
+	}
+	free(item);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", command.c_str(), frame);
+	return;
+}
+
+void DigitalMode::refresh(FILE* gnuplot_pipe, char* gnuplot_fifo, ModeContext &, DisplayFrame & frame)
+{
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "refresh", "", frame);
+	return;
+}
+
+void VoltmeterMode::acquire(ModeContext & context, int trace_size, DisplayFrame & frame)
+{
+	double voltmeter[MAX_CHANNELS];
+	oXs_acquire_window(context, trace_size);
+	context.trigger_data.linearize();
+	context.processor->scaleFrame(context.trigger_data, context.channels, zero_scale, context.dt, frame);
+	context.processor->voltmeter(context.trigger_data, context.channels, context.scope_parameters, voltmeter);
+	oXs_voltmeter_labels(context.voltmeter_labels, context.channels, voltmeter, context.scope_parameters);
+	return;
+}
+
+void VoltmeterMode::setupDisplay(FILE* gnuplot_pipe, char* gnuplot_fifo, ScopeParameters* scope_parameters)
+{
+	oXs_setup_gnuplot_voltmeter_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+	return;
+}
+
+void VoltmeterMode::plot(FILE* gnuplot_pipe, char* gnuplot_fifo, ModeContext & context, DisplayFrame & frame)
+{
+	for (size_t k = 0; k < context.voltmeter_labels.size(); k++)
+		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", context.voltmeter_labels[k].c_str(), frame);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", oXs_channels_plot_command(context.scope_parameters, context.channels).c_str(), frame);
+	return;
+}
+
+void VoltmeterMode::refresh(FILE* gnuplot_pipe, char* gnuplot_fifo, ModeContext & context, DisplayFrame & frame)
+{
+	for (size_t k = 0; k < context.voltmeter_labels.size(); k++)
+		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", context.voltmeter_labels[k].c_str(), frame);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "refresh", "", frame);
+	return;
+}
+
+// The axes are those of the first two displayed channels (the same one
+// twice if only one is displayed).
+void oXs_setup_gnuplot_analog_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo, ScopeParameters* scope_parameters)
+{
+	std::vector<unsigned int> channels;
+	oXs_displayed_channels(scope_parameters, channels);
+	unsigned int c1 = channels[0];
+	unsigned int c2 = channels[(channels.size() > 1)? 1 : 0];
+	double tlim = scope_parameters->tdiv * HORIZ_DIVS / 2.0;
+	double y1lim = scope_parameters->ydiv[c1] * VERTC_DIVS / 2.0;
+	double y2lim = scope_parameters->ydiv[c2] * VERTC_DIVS / 2.0;
+
+	char* xrange = (char *) malloc(sizeof(char) * 128);
+	char* y1range = (char *) malloc(sizeof(char) * 128);
+	char* y2range = (char *) malloc(sizeof(char) * 128);
+	char* xtics = (char *) malloc(sizeof(char) * 128);
+	char* y1tics = (char *) malloc(sizeof(char) * 128);
+	char* y2tics = (char *) malloc(sizeof(char) * 128);
+	char* y1label = (char *) malloc(sizeof(char) * 128);
+	char* y2label = (char *) malloc(sizeof(char) * 128);
+
+	sprintf(xrange, "xrange [%f:%f]", -tlim, tlim);
+	sprintf(y1range, "yrange [%f:%f]", -y1lim, y1lim);
+	sprintf(y2range, "y2range [%f:%f]", -y2lim, y2lim);
+	sprintf(xtics, "xtics %f, %f, %f format \"\"", -tlim, scope_parameters->tdiv, tlim);
+	sprintf(y1tics, "ytics %f, %f, %f", -y1lim, scope_parameters->ydiv[c1], y1lim);
+	sprintf(y2tics, "y2tics %f, %f, %f", -y2lim, scope_parameters->ydiv[c2], y2lim);
+	sprintf(y1label, "ylabel \"Channel %u (%s)\" textcolor rgb '#d0d0d0' offset 0,0", c1 + 1, (scope_parameters->y_vps[c1] != 1.0)? "V" : "a.u.");
+	sprintf(y2label, "y2label \"Channel %u (%s)\" textcolor rgb '#d0d0d0' offset 0,0", c2 + 1, (scope_parameters->y_vps[c2] != 1.0)? "V" : "a.u.");
+
+	DisplayFrame dummy;
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xrange, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1range, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y2range, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xtics, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1tics, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y2tics, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1label, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y2label, dummy);
+
+	free(xrange);
+	free(y1range);
+	free(y2range);
+	free(xtics);
+	free(y1tics);
+	free(y2tics);
+	free(y1label);
+	free(y2label);
+
+	return;
+}
+
+void oXs_setup_gnuplot_xy_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo, ScopeParameters* scope_parameters)
+{
+	std::vector<unsigned int> channels;
+	oXs_displayed_channels(scope_parameters, channels);
+	unsigned int c1 = channels[0];
+	unsigned int c2 = channels[(channels.size() > 1)? 1 : 0];
+	double y1lim = scope_parameters->ydiv[c1] * XY_DIVS / 2.0;
+	double y2lim = scope_parameters->ydiv[c2] * XY_DIVS / 2.0;
+
+	char* xrange = (char *) malloc(sizeof(char) * 128);
+	char* y1range = (char *) malloc(sizeof(char) * 128);
+	char* xtics = (char *) malloc(sizeof(char) * 128);
+	char* y1tics = (char *) malloc(sizeof(char) * 128);
+	char* y2tics = (char *) malloc(sizeof(char) * 128);
+	char* xlabel = (char *) malloc(sizeof(char) * 128);
+	char* y1label = (char *) malloc(sizeof(char) * 128);
+
+	sprintf(xrange, "xrange [%f:%f]", -y1lim, y1lim);
+	sprintf(y1range, "yrange [%f:%f]", -y2lim, y2lim);
+	sprintf(xtics, "xtics %f, %f, %f format \"%%.3f\"", -y1lim, scope_parameters->ydiv[c1], y1lim);
+	sprintf(y1tics, "ytics %f, %f, %f format \"%%.3f\"", -y2lim, scope_parameters->ydiv[c2], y2lim);
+	sprintf(y2tics, "y2tics format \"\"");
+	sprintf(xlabel, "xlabel \"Channel %u (%s)\" textcolor rgb '#d0d0d0' offset 0,0", c1 + 1, (scope_parameters->y_vps[c1] != 1.0)? "V" : "a.u.");
+	sprintf(y1label, "y1label \"Channel %u (%s)\" textcolor rgb '#d0d0d0' offset 0,0", c2 + 1, (scope_parameters->y_vps[c2] != 1.0)? "V" : "a.u.");
+
+	DisplayFrame dummy;
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "size ratio 1", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xrange, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1range, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xtics, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1tics, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y2tics, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xlabel, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1label, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "y2label \"\"", dummy);
+
+	free(xrange);
+	free(y1range);
+	free(xtics);
+	free(y1tics);
+	free(y2tics);
+	free(xlabel);
+	free(y1label);
+
+	return;
+}
+
+// The states of each channel are drawn as 0/1 levels, DIG_TRACE_OFFSET
+// apart, and named on the right axis.
+void oXs_setup_gnuplot_digital_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo, ScopeParameters* scope_parameters)
+{
+	std::vector<unsigned int> channels;
+	oXs_displayed_channels(scope_parameters, channels);
+	size_t n = channels.size();
+	double tlim = scope_parameters->tdiv * HORIZ_DIVS / 2.0;
+	double ylim = n * DIG_TRACE_OFFSET;
+
+	char* xrange = (char *) malloc(sizeof(char) * 128);
+	char* y1range = (char *) malloc(sizeof(char) * 128);
+	char* y2range = (char *) malloc(sizeof(char) * 128);
+	char* xtics = (char *) malloc(sizeof(char) * 128);
+	char* item = (char *) malloc(sizeof(char) * 128);
+	std::string y1tics = "ytics (";
+	std::string y2tics = "y2tics (";
+
+	sprintf(xrange, "xrange [%f:%f]", -tlim, tlim);
+	sprintf(y1range, "yrange [-0.2:%.1f]", ylim);
+	sprintf(y2range, "y2range [-0.2:%.1f]", ylim);
+	sprintf(xtics, "xtics %f, %f, %f format \"\"", -tlim, scope_parameters->tdiv, tlim);
+	for (size_t k = 0; k < n; k++) {
+		double offset = (n - 1 - k) * DIG_TRACE_OFFSET;
+		sprintf(item, "%s\"0\" %.1f, \"1\" %.1f", (k == 0)? "" : ", ", offset, offset + 1.0);
+		y1tics += item;
+		sprintf(item, "%s\"Ch%u\" %.1f", (k == 0)? "" : ", ", channels[k] + 1, offset + 0.5);
+		y2tics += item;
+	}
+	y1tics += ")";
+	y2tics += ")";
+
+	DisplayFrame dummy;
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xrange, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1range, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y2range, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xtics, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1tics.c_str(), dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y2tics.c_str(), dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "ylabel \"State\" textcolor rgb '#d0d0d0' offset 0,0", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "y2label \"\"", dummy);
+
+	free(xrange);
+	free(y1range);
+	free(y2range);
+	free(xtics);
+	free(item);
+
+	return;
+}
+
+void oXs_setup_gnuplot_voltmeter_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo, ScopeParameters* scope_parameters)
+{
+	double tlim = scope_parameters->tdiv * HORIZ_DIVS / 2.0;
+
+	char* xrange = (char *) malloc(sizeof(char) * 128);
+	char* y1range = (char *) malloc(sizeof(char) * 128);
+	char* y2range = (char *) malloc(sizeof(char) * 128);
+	char* xtics = (char *) malloc(sizeof(char) * 128);
+	char* y1tics = (char *) malloc(sizeof(char) * 128);
+	char* y2tics = (char *) malloc(sizeof(char) * 128);
+
+	sprintf(xrange, "xrange [%f:%f]", -tlim, tlim);
+	sprintf(y1range, "yrange [-1:1]");
+	sprintf(y2range, "y2range [-1:1]");
+	sprintf(xtics, "xtics");
+	sprintf(y1tics, "ytics");
+	sprintf(y2tics, "y2tics");
+
+	DisplayFrame dummy;
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xrange, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1range, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y2range, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "unset", xtics, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "unset", y1tics, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "unset", y2tics, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "unset", "ylabel", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "unset", "y2label", dummy);
+
+	free(xrange);
+	free(y1range);
+	free(y2range);
+	free(xtics);
+	free(y1tics);
+	free(y2tics);
+
+	return;
+}
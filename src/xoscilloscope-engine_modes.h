@@ -0,0 +1,165 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#ifndef INCLUDED_ENGINE_MODES
+#define INCLUDED_ENGINE_MODES
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <deque>
+#include <alsa/asoundlib.h>
+
+#include "xoscilloscope-engine_gnuplot.h"
+#include "xoscilloscope-engine_pipeline.h"
+#include "xoscilloscope-engine_record.h"
+#include "xoscilloscope-engine_capture.h"
+
+#define BUF_SIZE 441
+#define REFRESH_GP 5000
+#define DIG_TRACE_OFFSET 1.2
+
+// Acquisition state shared by the modes of the engine. The buffer holds
+// BUF_SIZE interleaved frames of scope_parameters->nr_channels samples;
+// active and channels are refreshed by oXs_configure_channels() whenever
+// the channel settings change.
+struct ModeContext {
+	CaptureGroup*			capture;
+	int16_t*			buf;
+	CaptureTaps*			taps;
+	FrameProcessor*			processor;
+	ScopeParameters*		scope_parameters;
+	double				dt;
+	bool				active[MAX_CHANNELS];
+	std::vector<unsigned int>	channels;
+	FrameQueue<int16_t>		trigger_data;
+	FrameQueue<uint8_t>		digital_data;
+	DigitalDetector			digital_detector;
+	std::deque<AverageEntry>	accumulator;
+	std::vector<std::string>	voltmeter_labels;
+};
+
+// Sample sources of the triggered acquisition: raw samples compared with
+// the trigger level, or digital states looking for a transition.
+struct RawSource {
+	typedef int16_t Sample;
+
+	static FrameQueue<int16_t> & queue(ModeContext & context) { return context.trigger_data; }
+	static const int16_t* convert(ModeContext &, const int16_t* frame, int16_t*) { return frame; }
+	static bool crossing(const FrameQueue<int16_t> & data, const int16_t* y, const ScopeParameters* scope_parameters) { return oXs_trigger_crossing(data, y, scope_parameters); }
+};
+
+struct DigitalSource {
+	typedef uint8_t Sample;
+
+	static FrameQueue<uint8_t> & queue(ModeContext & context) { return context.digital_data; }
+	static const uint8_t* convert(ModeContext & context, const int16_t* frame, uint8_t* state) { context.digital_detector.push(frame, state); return state; }
+	static bool crossing(const FrameQueue<uint8_t> & data, const uint8_t* y, const ScopeParameters* scope_parameters) { return oXs_trigger_digital(data, y, scope_parameters); }
+};
+
+// Each operating mode is a policy class providing the acquisition and
+// processing of a frame and the setup and drawing of the display. The
+// engine reaches them through a ModeKernel, so that the mode is dispatched
+// once per frame and the per-sample loops, instantiated from templates for
+// each mode, carry no mode tests.
+struct AnalogMode {
+	static const osc_mode	mode = MODE_ANALOG;
+	static const char	command = 'a';
+	static const bool	browses_history = true;
+	static const int	restart_interval = REFRESH_GP;
+
+	static void acquire(ModeContext &, int, DisplayFrame &);
+	static void setupDisplay(FILE*, char*, ScopeParameters*);
+	static void plot(FILE*, char*, ModeContext &, DisplayFrame &);
+	static void refresh(FILE*, char*, ModeContext &, DisplayFrame &);
+};
+
+struct XYMode {
+	static const osc_mode	mode = MODE_XY;
+	static const char	command = 'x';
+	static const bool	browses_history = true;
+	static const int	restart_interval = REFRESH_GP;
+
+	static void acquire(ModeContext &, int, DisplayFrame &);
+	static void setupDisplay(FILE*, char*, ScopeParameters*);
+	static void plot(FILE*, char*, ModeContext &, DisplayFrame &);
+	static void refresh(FILE*, char*, ModeContext &, DisplayFrame &);
+};
+
+struct DigitalMode {
+	static const osc_mode	mode = MODE_DIGITAL;
+	static const char	command = 'd';
+	static const bool	browses_history = false;
+	static const int	restart_interval = REFRESH_GP;
+
+	static void acquire(ModeContext &, int, DisplayFrame &);
+	static void setupDisplay(FILE*, char*, ScopeParameters*);
+	static void plot(FILE*, char*, ModeContext &, DisplayFrame &);
+	static void refresh(FILE*, char*, ModeContext &, DisplayFrame &);
+};
+
+// Labels are redrawn at every frame, so gnuplot is restarted more often.
+struct VoltmeterMode {
+	static const osc_mode	mode = MODE_VOLTMETER;
+	static const char	command = 'v';
+	static const bool	browses_history = false;
+	static const int	restart_interval = 250;
+
+	static void acquire(ModeContext &, int, DisplayFrame &);
+	static void setupDisplay(FILE*, char*, ScopeParameters*);
+	static void plot(FILE*, char*, ModeContext &, DisplayFrame &);
+	static void refresh(FILE*, char*, ModeContext &, DisplayFrame &);
+};
+
+struct ModeKernel {
+	osc_mode	mode;
+	char		command;
+	bool		browses_history;
+	int		restart_interval;
+	void		(*acquire)(ModeContext &, int, DisplayFrame &);
+	void		(*setupDisplay)(FILE*, char*, ScopeParameters*);
+	void		(*plot)(FILE*, char*, ModeContext &, DisplayFrame &);
+	void		(*refresh)(FILE*, char*, ModeContext &, DisplayFrame &);
+};
+
+template <class Mode>
+ModeKernel oXs_mode_kernel()
+{
+	ModeKernel kernel = {Mode::mode, Mode::command, Mode::browses_history, Mode::restart_interval, Mode::acquire, Mode::setupDisplay, Mode::plot, Mode::refresh};
+	return kernel;
+}
+
+const ModeKernel* oXs_find_mode(char);
+void oXs_configure_channels(ModeContext &);
+int oXs_capture(CaptureGroup &, int16_t*, CaptureTaps &);
+void oXs_acquire_window(ModeContext &, int);
+void oXs_setup_gnuplot_analog_parameters(FILE*, char*, ScopeParameters*);
+void oXs_setup_gnuplot_xy_parameters(FILE*, char*, ScopeParameters*);
+void oXs_setup_gnuplot_digital_parameters(FILE*, char*, ScopeParameters*);
+void oXs_setup_gnuplot_voltmeter_parameters(FILE*, char*, ScopeParameters*);
+
+#endif
@@ -0,0 +1,403 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#include <iostream>
+#include <cstdint>
+
+#include "xoscilloscope-engine_output.h"
+
+#if defined(__has_include)
+	#if __has_include(<charconv>)
+		#include <charconv>
+	#endif
+#endif
+
+// Shortest round-trip formatting requires floating-point std::to_chars
+// (libstdc++ 11 or later); older toolchains fall back to printf with the
+// number of digits that guarantees an exact round trip.
+#if defined(__cpp_lib_to_chars) && (__cpp_lib_to_chars >= 201611L)
+	#define OXS_HAS_FP_TO_CHARS 1
+#else
+	#define OXS_HAS_FP_TO_CHARS 0
+#endif
+
+static inline char* oXs_format_number(char* p, char* end, double value, text_precision precision)
+{
+#if OXS_HAS_FP_TO_CHARS
+	if (precision == TEXT_FLOAT)
+		return std::to_chars(p, end, (float) value).ptr;
+	return std::to_chars(p, end, value).ptr;
+#else
+	int n = (precision == TEXT_FLOAT)? snprintf(p, end - p, "%.9g", (float) value) : snprintf(p, end - p, "%.17g", value);
+	return p + n;
+#endif
+}
+
+TextSerializer::TextSerializer(text_precision requested_precision)
+{
+	precision = requested_precision;
+	buffer.resize(TEXT_BUFFER_INITIAL_SIZE);
+	used = 0;
+}
+
+void TextSerializer::clear()
+{
+	used = 0;
+	return;
+}
+
+void TextSerializer::reserve(size_t additional)
+{
+	if (used + additional > buffer.size())
+		buffer.resize(2 * (used + additional));
+	return;
+}
+
+void TextSerializer::appendNumber(double value)
+{
+	reserve(TEXT_NUMBER_MAX_SIZE);
+	char* p = buffer.data() + used;
+	used = oXs_format_number(p, p + TEXT_NUMBER_MAX_SIZE, value, precision) - buffer.data();
+	return;
+}
+
+void TextSerializer::appendText(const char* text)
+{
+	size_t length = strlen(text);
+	reserve(length);
+	memcpy(buffer.data() + used, text, length);
+	used += length;
+	return;
+}
+
+// Appends one line per row, values being tab-separated unless a different
+// separator is given.
+void TextSerializer::appendRows(const DisplayFrame & frame, char separator)
+{
+	size_t nr_rows = frame.rows();
+	size_t nr_columns = frame.columns();
+	if (frame.empty())
+		return;
+	reserve(nr_rows * (nr_columns * (TEXT_NUMBER_MAX_SIZE + 1) + 1));
+
+	char* p = buffer.data() + used;
+	for (size_t j = 0; j < nr_rows; j++) {
+		p = oXs_format_number(p, p + TEXT_NUMBER_MAX_SIZE, frame.at(j, 0), precision);
+		for (size_t m = 1; m < nr_columns; m++) {
+			*p++ = separator;
+			p = oXs_format_number(p, p + TEXT_NUMBER_MAX_SIZE, frame.at(j, m), precision);
+		}
+		*p++ = '\n';
+	}
+	used = p - buffer.data();
+
+	return;
+}
+
+int TextSerializer::writeToDescriptor(int fd) const
+{
+	return oXs_write_all(fd, buffer.data(), used);
+}
+
+int TextSerializer::writeToFile(const char* file_name) const
+{
+	int fd = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (fd < 0)
+		return -1;
+	int err = writeToDescriptor(fd);
+	close(fd);
+	return err;
+}
+
+const char* TextSerializer::data() const
+{
+	return buffer.data();
+}
+
+size_t TextSerializer::size() const
+{
+	return used;
+}
+
+// Writes the whole block with as few write() calls as the kernel allows
+// (a single one for regular files; pipes may accept it in pieces).
+int oXs_write_all(int fd, const char* data, size_t size)
+{
+	size_t written = 0;
+	while (written < size) {
+		ssize_t n = write(fd, data + written, size - written);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		written += n;
+	}
+	return 0;
+}
+
+SaveWriter::SaveWriter(unsigned int rate)
+: text(TEXT_DOUBLE)
+{
+	sample_rate = rate;
+	stopping = false;
+	worker = std::thread(&SaveWriter::run, this);
+}
+
+SaveWriter::~SaveWriter()
+{
+	stop();
+}
+
+void SaveWriter::submit(const std::string & file_name, FrameSnapshot frame, const std::vector<unsigned int> & channels)
+{
+	SaveJob job;
+	job.file_name = file_name;
+	job.frame = frame;
+	job.channels = channels;
+	{
+		std::lock_guard<std::mutex> guard(jobs_lock);
+		jobs.push_back(job);
+	}
+	jobs_available.notify_one();
+	return;
+}
+
+// Completes the pending saves and terminates the writer thread.
+void SaveWriter::stop()
+{
+	{
+		std::lock_guard<std::mutex> guard(jobs_lock);
+		stopping = true;
+	}
+	jobs_available.notify_one();
+	if (worker.joinable())
+		worker.join();
+	return;
+}
+
+void SaveWriter::run()
+{
+	while (true) {
+		SaveJob job;
+		{
+			std::unique_lock<std::mutex> guard(jobs_lock);
+			jobs_available.wait(guard, [this] { return stopping || !jobs.empty(); });
+			if (jobs.empty())
+				break;
+			job = jobs.front();
+			jobs.pop_front();
+		}
+		if (save(job) < 0)
+			std::cerr << "Could not save data at '" << job.file_name << "'\n";
+		else
+			std::cerr << "Data saved at '" << job.file_name << "'\n";
+	}
+	return;
+}
+
+// CSV header naming the channel of each column, e.g. "t,ch1,ch3".
+static std::string oXs_csv_header(const SaveJob & job)
+{
+	std::string header = "t";
+	unsigned int nr_columns = job.frame->columns();
+	for (unsigned int k = 1; k < nr_columns; k++) {
+		unsigned int channel = (job.channels.size() == nr_columns - 1)? job.channels[k - 1] + 1 : k;
+		header += ",ch" + std::to_string(channel);
+	}
+	return header + "\n";
+}
+
+int SaveWriter::save(const SaveJob & job)
+{
+	const DisplayFrame & data_txy = *job.frame;
+	int fd = open(job.file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (fd < 0)
+		return -1;
+
+	int err;
+	switch (oXs_export_format_from_name(job.file_name)) {
+		case EXPORT_CSV :
+			text.clear();
+			text.appendText(oXs_csv_header(job).c_str());
+			text.appendRows(data_txy, ',');
+			err = text.writeToDescriptor(fd);
+			break;
+		case EXPORT_WAV :
+			oXs_export_wav(binary, data_txy, sample_rate);
+			err = oXs_write_all(fd, binary.data(), binary.size());
+			break;
+		case EXPORT_NPY :
+			oXs_export_npy(binary, data_txy);
+			err = oXs_write_all(fd, binary.data(), binary.size());
+			break;
+		case EXPORT_RAW_FLOAT32 :
+			oXs_export_raw_float32(binary, data_txy);
+			err = oXs_write_all(fd, binary.data(), binary.size());
+			break;
+		default :
+			text.clear();
+			text.appendRows(data_txy);
+			err = text.writeToDescriptor(fd);
+			break;
+	}
+	close(fd);
+
+	return err;
+}
+
+export_format oXs_export_format_from_name(const std::string & file_name)
+{
+	size_t dot = file_name.find_last_of('.');
+	if (dot == std::string::npos)
+		return EXPORT_TEXT;
+	std::string extension = file_name.substr(dot + 1);
+	for (int i = 0; i < extension.size(); i++)
+		extension[i] = tolower(extension[i]);
+
+	if (extension == "csv")
+		return EXPORT_CSV;
+	else if (extension == "wav")
+		return EXPORT_WAV;
+	else if (extension == "npy")
+		return EXPORT_NPY;
+	else if ((extension == "f32") || (extension == "raw"))
+		return EXPORT_RAW_FLOAT32;
+	return EXPORT_TEXT;
+}
+
+// Binary formats below are little-endian, which is the byte order of all
+// the platforms the package runs on; values are therefore copied verbatim.
+static inline void oXs_append_bytes(std::vector<char> & out, const void* data, size_t size)
+{
+	const char* bytes = (const char*) data;
+	out.insert(out.end(), bytes, bytes + size);
+	return;
+}
+
+static inline void oXs_append_u32(std::vector<char> & out, uint32_t value)
+{
+	oXs_append_bytes(out, &value, sizeof(value));
+	return;
+}
+
+static inline void oXs_append_u16(std::vector<char> & out, uint16_t value)
+{
+	oXs_append_bytes(out, &value, sizeof(value));
+	return;
+}
+
+// Channel samples (every column but the time one) as interleaved float32.
+static size_t oXs_append_channels_float32(std::vector<char> & out, const DisplayFrame & data_txy)
+{
+	size_t start = out.size();
+	size_t nr_frames = data_txy.rows();
+	size_t nr_channels = data_txy.columns() - 1;
+	out.resize(start + nr_frames * nr_channels * sizeof(float));
+	float* p = (float*) (out.data() + start);
+	for (size_t m = 1; m <= nr_channels; m++) {
+		const double* y = data_txy.column(m);
+		for (size_t i = 0; i < nr_frames; i++)
+			p[i * nr_channels + m - 1] = (float) y[i];
+	}
+	return nr_frames;
+}
+
+void oXs_export_raw_float32(std::vector<char> & out, const DisplayFrame & data_txy)
+{
+	out.clear();
+	if (data_txy.empty() || (data_txy.columns() < 2))
+		return;
+	oXs_append_channels_float32(out, data_txy);
+	return;
+}
+
+// IEEE-float WAV file: fmt chunk with extension size, fact chunk, data chunk.
+void oXs_export_wav(std::vector<char> & out, const DisplayFrame & data_txy, unsigned int sample_rate)
+{
+	out.clear();
+	bool has_samples = !data_txy.empty() && (data_txy.columns() >= 2);
+	unsigned int nr_channels = (has_samples)? data_txy.columns() - 1 : 1;
+	uint16_t block_align = nr_channels * sizeof(float);
+
+	oXs_append_bytes(out, "RIFF", 4);
+	oXs_append_u32(out, 0);
+	oXs_append_bytes(out, "WAVE", 4);
+	oXs_append_bytes(out, "fmt ", 4);
+	oXs_append_u32(out, 18);
+	oXs_append_u16(out, 3);
+	oXs_append_u16(out, nr_channels);
+	oXs_append_u32(out, sample_rate);
+	oXs_append_u32(out, sample_rate * block_align);
+	oXs_append_u16(out, block_align);
+	oXs_append_u16(out, 8 * sizeof(float));
+	oXs_append_u16(out, 0);
+	oXs_append_bytes(out, "fact", 4);
+	oXs_append_u32(out, 4);
+	size_t fact_position = out.size();
+	oXs_append_u32(out, 0);
+	oXs_append_bytes(out, "data", 4);
+	size_t data_position = out.size();
+	oXs_append_u32(out, 0);
+
+	uint32_t nr_frames = (has_samples)? oXs_append_channels_float32(out, data_txy) : 0;
+	uint32_t data_size = nr_frames * block_align;
+	uint32_t riff_size = out.size() - 8;
+	memcpy(out.data() + 4, &riff_size, sizeof(uint32_t));
+	memcpy(out.data() + fact_position, &nr_frames, sizeof(uint32_t));
+	memcpy(out.data() + data_position, &data_size, sizeof(uint32_t));
+
+	return;
+}
+
+// NumPy format version 1.0: a (rows, columns) C-ordered float64 array.
+void oXs_export_npy(std::vector<char> & out, const DisplayFrame & data_txy)
+{
+	out.clear();
+	size_t nr_columns = data_txy.columns();
+	size_t nr_rows = (nr_columns > 0)? data_txy.rows() : 0;
+
+	char header[128];
+	int header_length = sprintf(header, "{'descr': '<f8', 'fortran_order': False, 'shape': (%zu, %zu), }", nr_rows, nr_columns);
+	size_t preamble = 10;
+	size_t padded_length = ((preamble + header_length + 1 + NPY_HEADER_ALIGNMENT - 1) / NPY_HEADER_ALIGNMENT) * NPY_HEADER_ALIGNMENT - preamble;
+
+	oXs_append_bytes(out, "\x93NUMPY", 6);
+	out.push_back(1);
+	out.push_back(0);
+	oXs_append_u16(out, padded_length);
+	oXs_append_bytes(out, header, header_length);
+	out.insert(out.end(), padded_length - header_length - 1, ' ');
+	out.push_back('\n');
+
+	size_t start = out.size();
+	out.resize(start + nr_rows * nr_columns * sizeof(double));
+	double* p = (double*) (out.data() + start);
+	for (size_t m = 0; m < nr_columns; m++) {
+		const double* y = data_txy.column(m);
+		for (size_t i = 0; i < nr_rows; i++)
+			p[i * nr_columns + m] = y[i];
+	}
+
+	return;
+}
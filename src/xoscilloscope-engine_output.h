@@ -0,0 +1,167 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#ifndef INCLUDED_ENGINE_OUTPUT
+#define INCLUDED_ENGINE_OUTPUT
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#define TEXT_BUFFER_INITIAL_SIZE 1048576
+#define TEXT_NUMBER_MAX_SIZE 32
+#define NPY_HEADER_ALIGNMENT 64
+
+// Precision of the text representation: values are written with the
+// shortest string that reads back to the same float (display data sent
+// to gnuplot) or to the same double (data saved to file).
+enum text_precision : unsigned int {
+	TEXT_FLOAT,
+	TEXT_DOUBLE
+};
+
+// Frame sent to gnuplot or saved: rows made of the time followed by one
+// value per channel. Columns are stored planar, one after the other in a
+// single flat buffer, as the planes of a FrameQueue: a frame costs one
+// allocation whatever its length, and none when it is rebuilt with no more
+// values than before. Values are undefined after resize().
+class DisplayFrame
+{
+public:
+	DisplayFrame() : nr_rows(0), nr_columns(0) {}
+
+	void resize(size_t rows, size_t columns)
+	{
+		if (values.size() < rows * columns)
+			values.resize(rows * columns);
+		nr_rows = rows;
+		nr_columns = columns;
+		return;
+	}
+
+	void clear()
+	{
+		nr_rows = 0;
+		nr_columns = 0;
+		return;
+	}
+
+	size_t rows() const { return nr_rows; }
+	size_t columns() const { return nr_columns; }
+	bool empty() const { return (nr_rows == 0) || (nr_columns == 0); }
+	double* column(size_t m) { return values.data() + m * nr_rows; }
+	const double* column(size_t m) const { return values.data() + m * nr_rows; }
+	double & at(size_t j, size_t m) { return values[m * nr_rows + j]; }
+	double at(size_t j, size_t m) const { return values[m * nr_rows + j]; }
+
+private:
+	std::vector<double>	values;
+	size_t			nr_rows;
+	size_t			nr_columns;
+};
+
+// File formats available for saved frames, selected by file extension.
+enum export_format : unsigned int {
+	EXPORT_TEXT,
+	EXPORT_CSV,
+	EXPORT_WAV,
+	EXPORT_NPY,
+	EXPORT_RAW_FLOAT32
+};
+
+typedef std::shared_ptr<const DisplayFrame> FrameSnapshot;
+
+class TextSerializer
+{
+public:
+	TextSerializer(text_precision);
+
+	void clear();
+	void appendNumber(double);
+	void appendText(const char*);
+	void appendRows(const DisplayFrame &, char separator = '\t');
+	int writeToDescriptor(int) const;
+	int writeToFile(const char*) const;
+	const char* data() const;
+	size_t size() const;
+
+private:
+	void reserve(size_t);
+
+	std::vector<char>	buffer;
+	size_t			used;
+	text_precision		precision;
+};
+
+// channels holds the zero-based channel shown in each column of the frame
+// after the time one.
+struct SaveJob {
+	std::string			file_name;
+	FrameSnapshot			frame;
+	std::vector<unsigned int>	channels;
+};
+
+// Saves frames from a background thread, so that the acquisition loop only
+// has to hand over a reference to the (copy-on-write) frame being displayed.
+class SaveWriter
+{
+public:
+	SaveWriter(unsigned int);
+	~SaveWriter();
+
+	void submit(const std::string &, FrameSnapshot, const std::vector<unsigned int> &);
+	void stop();
+
+private:
+	void run();
+	int save(const SaveJob &);
+
+	unsigned int			sample_rate;
+	std::thread			worker;
+	std::mutex			jobs_lock;
+	std::condition_variable		jobs_available;
+	std::deque<SaveJob>		jobs;
+	bool				stopping;
+	TextSerializer			text;
+	std::vector<char>		binary;
+};
+
+int oXs_write_all(int, const char*, size_t);
+export_format oXs_export_format_from_name(const std::string &);
+void oXs_export_wav(std::vector<char> &, const DisplayFrame &, unsigned int);
+void oXs_export_npy(std::vector<char> &, const DisplayFrame &);
+void oXs_export_raw_float32(std::vector<char> &, const DisplayFrame &);
+
+#endif
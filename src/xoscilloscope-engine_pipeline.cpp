@@ -0,0 +1,400 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#include "xoscilloscope-engine_pipeline.h"
+
+void oXs_default_scope_parameters(ScopeParameters* scope_parameters)
+{
+	scope_parameters->tdiv = 1e-4;
+	scope_parameters->trig_level = 0.0;
+	scope_parameters->trig_chan = 1;
+	scope_parameters->trig_rising_edge = true;
+	scope_parameters->nr_channels = CHN_SIZE;
+	for (int c = 0; c < MAX_CHANNELS; c++) {
+		scope_parameters->enabled[c] = true;
+		scope_parameters->ydiv[c] = 1e4;
+		scope_parameters->y_vps[c] = 1.0;
+	}
+	scope_parameters->navg = 1;
+
+	return;
+}
+
+// Channels to be acquired: the enabled ones and the trigger channel, which
+// is needed to trigger even when it is not displayed.
+void oXs_active_channels(const ScopeParameters* scope_parameters, bool* active)
+{
+	for (unsigned int c = 0; c < scope_parameters->nr_channels; c++)
+		active[c] = scope_parameters->enabled[c] || (c + 1 == scope_parameters->trig_chan);
+	return;
+}
+
+// Channels to be displayed, in increasing order. If all of them are
+// disabled, the trigger channel is shown.
+void oXs_displayed_channels(const ScopeParameters* scope_parameters, std::vector<unsigned int> & channels)
+{
+	channels.clear();
+	for (unsigned int c = 0; c < scope_parameters->nr_channels; c++) {
+		if (scope_parameters->enabled[c])
+			channels.push_back(c);
+	}
+	if (channels.empty())
+		channels.push_back(scope_parameters->trig_chan - 1);
+	return;
+}
+
+bool oXs_trigger_crossing(const FrameQueue<int16_t> & data, const int16_t* xy_new, const ScopeParameters* scope_parameters)
+{
+	int16_t y_new = xy_new[scope_parameters->trig_chan - 1];
+	int16_t y_last = data.back(scope_parameters->trig_chan - 1);
+
+	return oXs_level_crossing(y_last, y_new, scope_parameters->trig_level, scope_parameters->trig_rising_edge);
+}
+
+DigitalDetector::DigitalDetector()
+{
+	nr_channels = 0;
+	reset();
+}
+
+void DigitalDetector::configure(unsigned int channels, const bool* active)
+{
+	std::vector<unsigned int> requested;
+	for (unsigned int c = 0; c < channels; c++) {
+		if (active[c])
+			requested.push_back(c);
+	}
+	if ((channels == nr_channels) && (requested == active_channels))
+		return;
+	nr_channels = channels;
+	active_channels = requested;
+	reset();
+	return;
+}
+
+void DigitalDetector::reset()
+{
+	for (int c = 0; c < MAX_CHANNELS; c++) {
+		sum[c] = 0;
+		sum_squares[c] = 0;
+	}
+	count = 0;
+	next = 0;
+	return;
+}
+
+// Frames and states are interleaved, nr_channels samples each; the states
+// of inactive channels are left untouched.
+void DigitalDetector::push(const int16_t* frame, uint8_t* state)
+{
+	int16_t* y_old = &window[next * MAX_CHANNELS];
+	for (size_t k = 0; k < active_channels.size(); k++) {
+		unsigned int c = active_channels[k];
+		if (count == DIG_SR_SIZE) {
+			sum[c] -= y_old[c];
+			sum_squares[c] -= (int64_t) y_old[c] * y_old[c];
+		}
+		y_old[c] = frame[c];
+		sum[c] += frame[c];
+		sum_squares[c] += (int64_t) frame[c] * frame[c];
+	}
+	if (count < DIG_SR_SIZE)
+		count++;
+	next = (next + 1) % DIG_SR_SIZE;
+
+	double n = count;
+	for (size_t k = 0; k < active_channels.size(); k++) {
+		unsigned int c = active_channels[k];
+		double m = sum[c] / n;
+		double s = sum_squares[c] / n - m*m;
+		state[c] = (sqrt(s) < DIG_SIG_THR)? 0 : 1;
+	}
+	return;
+}
+
+bool oXs_trigger_digital(const FrameQueue<uint8_t> & data, const uint8_t* xy_new, const ScopeParameters* scope_parameters)
+{
+	bool crossed = false;
+
+	int y_new = xy_new[scope_parameters->trig_chan - 1];
+	int y_last = data.back(scope_parameters->trig_chan - 1);
+
+	if (scope_parameters->trig_rising_edge) {
+		if ((y_last == 0) && (y_new == 1))
+			crossed = true;
+	} else {
+		if ((y_last == 1) && (y_new == 0))
+			crossed = true;
+	}
+
+	return crossed;
+}
+
+// One label per displayed channel, spread over the screen from top to
+// bottom; the font shrinks when there are many channels.
+void oXs_voltmeter_labels(std::vector<std::string> & labels, const std::vector<unsigned int> & channels, const double* V, const ScopeParameters * scope_parameters)
+{
+	int n = channels.size();
+	int font_size = (n > 4)? 16 : 24;
+	char *str_V = (char *) malloc(sizeof(char) * 256);
+
+	labels.clear();
+	for (int k = 0; k < n; k++) {
+		unsigned int c = channels[k];
+		double y = 1.0 - (2.0 * k + 1.0) / n;
+		if (scope_parameters->y_vps[c] != 1.0) {
+			sprintf(str_V, "label %d \"Ch%u = %.4f V\" at 0,%.3f center textcolor rgb '#d0d0d0' font \"mbfont:Courier,%d\"", k + 1, c + 1, V[c], y, font_size);
+		} else {
+			sprintf(str_V, "label %d \"Ch%u = %.f (a.u.)\" at 0,%.3f center textcolor rgb '#d0d0d0' font \"mbfont:Courier,%d\"", k + 1, c + 1, V[c], y, font_size);
+		}
+		labels.push_back(str_V);
+	}
+
+	free(str_V);
+
+	return;
+}
+
+// Digital level of each frame in [first, last), from the standard deviation
+// over the last DIG_SR_SIZE frames as in DigitalDetector. The
+// window reaches back before first, so segments need no warm-up; at the
+// start of the stream it is shorter, as after the engine starts. Sums are
+// kept as integers and are thus exact.
+void oXs_digital_states(const int16_t* frames, uint64_t first, uint64_t last, uint8_t* states)
+{
+	int64_t sum[CHN_SIZE] = {0}, sum_squares[CHN_SIZE] = {0};
+	uint64_t window_first = (first > DIG_SR_SIZE)? first - DIG_SR_SIZE : 0;
+	for (uint64_t i = window_first; i < first; i++) {
+		for (int c = 0; c < CHN_SIZE; c++) {
+			int64_t y = frames[i * CHN_SIZE + c];
+			sum[c] += y;
+			sum_squares[c] += y * y;
+		}
+	}
+
+	for (uint64_t i = first; i < last; i++) {
+		if (i >= DIG_SR_SIZE) {
+			for (int c = 0; c < CHN_SIZE; c++) {
+				int64_t y = frames[(i - DIG_SR_SIZE) * CHN_SIZE + c];
+				sum[c] -= y;
+				sum_squares[c] -= y * y;
+			}
+		}
+		double n = (i + 1 < DIG_SR_SIZE)? i + 1 : DIG_SR_SIZE;
+		for (int c = 0; c < CHN_SIZE; c++) {
+			int64_t y = frames[i * CHN_SIZE + c];
+			sum[c] += y;
+			sum_squares[c] += y * y;
+			double m = sum[c] / n;
+			double s = sum_squares[c] / n - m*m;
+			states[i * CHN_SIZE + c] = (sqrt(s) < DIG_SIG_THR)? 0 : 1;
+		}
+	}
+
+	return;
+}
+
+// Appends the frames i in [first, last) at which the trigger condition holds
+// between frames i-1 and i. Digital states are used when given, the samples
+// otherwise.
+void oXs_find_triggers(const int16_t* frames, const uint8_t* states, uint64_t first, uint64_t last, const ScopeParameters* scope_parameters, std::vector<uint64_t> & triggers)
+{
+	int c = scope_parameters->trig_chan - 1;
+	if (first == 0)
+		first = 1;
+	for (uint64_t i = first; i < last; i++) {
+		bool crossed;
+		if (states != NULL) {
+			int y_last = states[(i - 1) * CHN_SIZE + c];
+			int y_new = states[i * CHN_SIZE + c];
+			crossed = (scope_parameters->trig_rising_edge)? ((y_last == 0) && (y_new == 1)) : ((y_last == 1) && (y_new == 0));
+		} else {
+			crossed = oXs_level_crossing(frames[(i - 1) * CHN_SIZE + c], frames[i * CHN_SIZE + c], scope_parameters->trig_level, scope_parameters->trig_rising_edge);
+		}
+		if (crossed)
+			triggers.push_back(i);
+	}
+	return;
+}
+
+// Turns sorted trigger candidates into frames of trace_size frames, the
+// trigger being at trace_size/2 as on screen. A frame must fit in the
+// stream, and the next trigger is searched after its end (hold-off), as
+// the engine does between two displayed frames.
+void oXs_select_triggers(const std::vector<uint64_t> & candidates, uint64_t trace_size, uint64_t nr_frames, std::vector<uint64_t> & triggers)
+{
+	uint64_t half = trace_size / 2;
+	uint64_t next = half;
+	for (int k = 0; k < candidates.size(); k++) {
+		uint64_t i = candidates[k];
+		if (i < next)
+			continue;
+		if (i - half + trace_size > nr_frames)
+			break;
+		triggers.push_back(i);
+		next = i + trace_size;
+	}
+	return;
+}
+
+void oXs_measure_window(const int16_t* frames, uint64_t first, uint64_t last, const ScopeParameters* scope_parameters, WindowMeasurement & measurement)
+{
+	const double* y_vps = scope_parameters->y_vps;
+	double sum[CHN_SIZE] = {0.0}, sum_abs[CHN_SIZE] = {0.0}, sum_squares[CHN_SIZE] = {0.0};
+	int low[CHN_SIZE] = {INT16_MAX, INT16_MAX}, high[CHN_SIZE] = {INT16_MIN, INT16_MIN};
+	for (uint64_t i = first; i < last; i++) {
+		for (int c = 0; c < CHN_SIZE; c++) {
+			int y = frames[i * CHN_SIZE + c];
+			sum[c] += y;
+			sum_abs[c] += abs(y);
+			sum_squares[c] += (double) y * y;
+			if (y < low[c])
+				low[c] = y;
+			if (y > high[c])
+				high[c] = y;
+		}
+	}
+
+	double n = (last > first)? last - first : 1;
+	measurement.first_frame = first;
+	for (int c = 0; c < CHN_SIZE; c++) {
+		measurement.voltmeter[c] = sum_abs[c] * 2.0 * y_vps[c] / n;
+		measurement.mean[c] = sum[c] * y_vps[c] / n;
+		measurement.rms[c] = sqrt(sum_squares[c] / n) * y_vps[c];
+		measurement.min[c] = low[c] * y_vps[c];
+		measurement.max[c] = high[c] * y_vps[c];
+	}
+	return;
+}
+
+FrameProcessor::FrameProcessor(unsigned int nr_threads)
+	: pool(nr_threads)
+{
+}
+
+unsigned int FrameProcessor::size() const
+{
+	return pool.size();
+}
+
+bool FrameProcessor::setAffinity(const std::vector<int> & cpus)
+{
+	return pool.setAffinity(cpus);
+}
+
+// Calls task(first, last) for every chunk of [0, n) and returns when all of
+// them are done.
+void FrameProcessor::forChunks(size_t n, const ChunkTask & task)
+{
+	if ((n <= FRAME_CHUNK_SIZE) || (pool.size() < 2)) {
+		for (size_t first = 0; first < n; first += FRAME_CHUNK_SIZE)
+			task(first, (first + FRAME_CHUNK_SIZE < n)? first + FRAME_CHUNK_SIZE : n);
+		return;
+	}
+	for (size_t first = 0; first < n; first += FRAME_CHUNK_SIZE) {
+		size_t last = (first + FRAME_CHUNK_SIZE < n)? first + FRAME_CHUNK_SIZE : n;
+		pool.submit([&task, first, last]() { task(first, last); });
+	}
+	pool.wait();
+	return;
+}
+
+// The frame is resized in place, so that a frame of the same size is reused
+// without allocations; each chunk fills its own rows of every column. The
+// queue must have been linearized.
+template <typename T>
+void FrameProcessor::scaleFrame(const FrameQueue<T> & data, const std::vector<unsigned int> & channels, const double* y_vps, double dt, DisplayFrame & frame)
+{
+	size_t n = data.size();
+	double t0 = -0.5 * n * dt;
+	frame.resize(n, channels.size() + 1);
+	forChunks(n, [&](size_t first, size_t last) {
+		double* t = frame.column(0);
+		for (size_t j = first; j < last; j++)
+			t[j] = t0 + j * dt;
+		for (size_t k = 0; k < channels.size(); k++) {
+			const T* y = data.plane(channels[k]);
+			double* v = frame.column(k + 1);
+			double vps = y_vps[channels[k]];
+			for (size_t j = first; j < last; j++)
+				v[j] = y[j] * vps;
+		}
+	});
+	return;
+}
+
+template void FrameProcessor::scaleFrame<int16_t>(const FrameQueue<int16_t> &, const std::vector<unsigned int> &, const double*, double, DisplayFrame &);
+template void FrameProcessor::scaleFrame<uint8_t>(const FrameQueue<uint8_t> &, const std::vector<unsigned int> &, const double*, double, DisplayFrame &);
+
+void FrameProcessor::averageFrame(const std::deque<AverageEntry> & accumulator, const std::vector<unsigned int> & channels, double dt, DisplayFrame & frame)
+{
+	size_t n = accumulator.back().nr_frames;
+	double nr_frames = accumulator.size();
+	double t0 = -0.5 * n * dt;
+	frame.resize(n, channels.size() + 1);
+	forChunks(n, [&](size_t first, size_t last) {
+		double* t = frame.column(0);
+		for (size_t j = first; j < last; j++)
+			t[j] = t0 + j * dt;
+		for (size_t k = 0; k < channels.size(); k++)
+			std::fill(frame.column(k + 1) + first, frame.column(k + 1) + last, 0.0);
+		for (int i = 0; i < accumulator.size(); i++) {
+			const AverageEntry & entry = accumulator[i];
+			for (size_t k = 0; k < channels.size(); k++) {
+				const int16_t* y = entry.planes[channels[k]].data();
+				double* v = frame.column(k + 1);
+				double vps = entry.y_vps[channels[k]];
+				for (size_t j = first; j < last; j++)
+					v[j] += y[j] * vps / nr_frames;
+			}
+		}
+	});
+	return;
+}
+
+// Voltmeter readings (twice the mean of the absolute value, calibrated) of
+// the given channels, stored at their index in V. Partial sums are integers
+// and thus exact.
+void FrameProcessor::voltmeter(const FrameQueue<int16_t> & data, const std::vector<unsigned int> & channels, const ScopeParameters* scope_parameters, double* V)
+{
+	size_t n = data.size();
+	size_t nr_sums = channels.size();
+	size_t nr_chunks = (n + FRAME_CHUNK_SIZE - 1) / FRAME_CHUNK_SIZE;
+	std::vector<int64_t> sum(nr_chunks * nr_sums, 0);
+	forChunks(n, [&](size_t first, size_t last) {
+		int64_t* chunk_sum = &sum[first / FRAME_CHUNK_SIZE * nr_sums];
+		for (size_t k = 0; k < nr_sums; k++) {
+			const int16_t* y = data.plane(channels[k]);
+			for (size_t j = first; j < last; j++)
+				chunk_sum[k] += abs(y[j]);
+		}
+	});
+
+	for (size_t k = 0; k < nr_sums; k++) {
+		int64_t total = 0;
+		for (size_t i = 0; i < nr_chunks; i++)
+			total += sum[i * nr_sums + k];
+		V[channels[k]] = total * (2.0 * scope_parameters->y_vps[channels[k]] / (double) n);
+	}
+	return;
+}
@@ -0,0 +1,269 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#ifndef INCLUDED_ENGINE_PIPELINE
+#define INCLUDED_ENGINE_PIPELINE
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <string>
+#include <deque>
+#include <algorithm>
+
+#include "xoscilloscope-engine_trigger.h"
+#include "xoscilloscope-engine_pool.h"
+#include "xoscilloscope-engine_output.h"
+
+#define CHN_SIZE 2
+#define MAX_CHANNELS 8
+#define HORIZ_DIVS 14
+#define TDIV_MAX 5.0
+#define VERTC_DIVS 8
+#define XY_DIVS 6
+#define DIG_SR_SIZE 24
+#define DIG_SIG_THR 8192
+#define FRAME_CHUNK_SIZE 65536
+
+// Settings of the display and of the trigger. Channels are numbered from 0
+// in the per-channel arrays, from 1 in trig_chan as on the console; only the
+// first nr_channels entries are meaningful.
+struct ScopeParameters {
+	bool trig_rising_edge;
+	unsigned int trig_chan;
+	unsigned int nr_channels;
+	double tdiv;
+	double trig_level;
+	bool enabled[MAX_CHANNELS];
+	double ydiv[MAX_CHANNELS];
+	double y_vps[MAX_CHANNELS];
+	unsigned int navg;
+};
+
+enum osc_mode : unsigned int {
+	MODE_ANALOG,
+	MODE_XY,
+	MODE_DIGITAL,
+	MODE_VOLTMETER
+};
+
+// Statistics of a window of frames, per channel and calibrated. The
+// voltmeter value is the one shown in voltmeter mode (twice the mean of
+// the absolute value).
+struct WindowMeasurement {
+	uint64_t	first_frame;
+	double		voltmeter[CHN_SIZE];
+	double		mean[CHN_SIZE];
+	double		rms[CHN_SIZE];
+	double		min[CHN_SIZE];
+	double		max[CHN_SIZE];
+};
+
+// Queue of frames of samples of type T, kept in a ring of fixed capacity,
+// so that the acquisition path stores samples in their native type instead
+// of one heap-allocated row per frame. Frames are pushed interleaved, as
+// read from the device, and stored planar: one plane per channel, inactive
+// channels being neither copied nor, unless allocated, kept. Pushing into a full
+// queue drops the oldest frame. linearize() rotates the ring so that each
+// plane can be read as one array. After allocate(), every plane is resident
+// at the given size and reset() only changes the capacity in use, up to
+// that size, so that changing the time scale allocates nothing.
+template <typename T>
+class FrameQueue
+{
+public:
+	FrameQueue() : first(0), count(0), nr_frames(0), nr_channels(0), nr_allocated(0) {}
+
+	void allocate(size_t capacity, unsigned int channels)
+	{
+		planes.resize(channels);
+		for (unsigned int c = 0; c < channels; c++)
+			planes[c].assign(capacity, 0);
+		nr_allocated = capacity;
+		return;
+	}
+
+	void reset(size_t capacity, unsigned int channels, const bool* active)
+	{
+		bool allocated = (capacity <= nr_allocated) && (channels <= planes.size());
+		if (!allocated) {
+			planes.resize(channels);
+			nr_allocated = 0;
+		}
+		active_flags.assign(channels, false);
+		active_channels.clear();
+		for (unsigned int c = 0; c < channels; c++) {
+			if (!active[c]) {
+				if (!allocated)
+					std::vector<T>().swap(planes[c]);
+				continue;
+			}
+			if (!allocated && (planes[c].size() != capacity))
+				planes[c].assign(capacity, 0);
+			active_flags[c] = true;
+			active_channels.push_back(c);
+		}
+		nr_frames = capacity;
+		nr_channels = channels;
+		first = 0;
+		count = 0;
+		return;
+	}
+
+	void clear()
+	{
+		first = 0;
+		count = 0;
+		return;
+	}
+
+	size_t size() const { return count; }
+	size_t capacity() const { return nr_frames; }
+	unsigned int channels() const { return nr_channels; }
+	bool isActive(unsigned int c) const { return (c < nr_channels) && active_flags[c]; }
+
+	void push_back(const T* frame)
+	{
+		if (count == nr_frames)
+			pop_front();
+		size_t j = (first + count) % nr_frames;
+		for (size_t k = 0; k < active_channels.size(); k++)
+			planes[active_channels[k]][j] = frame[active_channels[k]];
+		count++;
+		return;
+	}
+
+	void pop_front()
+	{
+		first = (first + 1) % nr_frames;
+		count--;
+		return;
+	}
+
+	T at(size_t j, unsigned int c) const { return planes[c][(first + j) % nr_frames]; }
+	T back(unsigned int c) const { return at(count - 1, c); }
+	const T* plane(unsigned int c) const { return planes[c].data(); }
+
+	void linearize()
+	{
+		if (first != 0) {
+			for (size_t k = 0; k < active_channels.size(); k++) {
+				std::vector<T> & y = planes[active_channels[k]];
+				std::rotate(y.begin(), y.begin() + first, y.begin() + nr_frames);
+			}
+			first = 0;
+		}
+		return;
+	}
+
+private:
+	std::vector< std::vector<T> >	planes;
+	std::vector<bool>		active_flags;
+	std::vector<unsigned int>	active_channels;
+	size_t				first;
+	size_t				count;
+	size_t				nr_frames;
+	unsigned int			nr_channels;
+	size_t				nr_allocated;
+};
+
+// Digital level detection on raw samples: the standard deviation over the
+// last DIG_SR_SIZE frames is compared with DIG_SIG_THR. Sums are integers,
+// so the states are those of oXs_digital_states() on the same stream. Only
+// the active channels are tracked; configure() restarts the detection when
+// the set of active channels changes.
+class DigitalDetector
+{
+public:
+	DigitalDetector();
+
+	void configure(unsigned int, const bool*);
+	void reset();
+	void push(const int16_t*, uint8_t*);
+
+private:
+	int16_t				window[DIG_SR_SIZE * MAX_CHANNELS];
+	int64_t				sum[MAX_CHANNELS];
+	int64_t				sum_squares[MAX_CHANNELS];
+	std::vector<unsigned int>	active_channels;
+	unsigned int			nr_channels;
+	unsigned int			count;
+	unsigned int			next;
+};
+
+// Calibrated averaging of the last navg frames. Frames are stored as raw
+// samples, one plane per displayed channel, together with the calibration
+// they were taken with, and the average is accumulated in double precision.
+struct AverageEntry {
+	size_t					nr_frames;
+	std::vector< std::vector<int16_t> >	planes;
+	double					y_vps[MAX_CHANNELS];
+};
+
+// Processing stages shared by the interactive engine and the batch analyzer.
+// The array-based stages work on interleaved stereo frames (CHN_SIZE
+// channels, as in the files handled by the batch analyzer) and only depend
+// on the frame indices, so that a stream can be cut into segments processed
+// independently.
+void oXs_default_scope_parameters(ScopeParameters*);
+void oXs_active_channels(const ScopeParameters*, bool*);
+void oXs_displayed_channels(const ScopeParameters*, std::vector<unsigned int> &);
+bool oXs_trigger_crossing(const FrameQueue<int16_t> &, const int16_t*, const ScopeParameters*);
+bool oXs_trigger_digital(const FrameQueue<uint8_t> &, const uint8_t*, const ScopeParameters*);
+void oXs_voltmeter_labels(std::vector<std::string> &, const std::vector<unsigned int> &, const double*, const ScopeParameters *);
+void oXs_digital_states(const int16_t*, uint64_t, uint64_t, uint8_t*);
+void oXs_find_triggers(const int16_t*, const uint8_t*, uint64_t, uint64_t, const ScopeParameters*, std::vector<uint64_t> &);
+void oXs_select_triggers(const std::vector<uint64_t> &, uint64_t, uint64_t, std::vector<uint64_t> &);
+void oXs_measure_window(const int16_t*, uint64_t, uint64_t, const ScopeParameters*, WindowMeasurement &);
+
+typedef std::function<void(size_t, size_t)> ChunkTask;
+
+// Per-frame processing on a persistent pool of threads. A frame of n rows
+// is cut into chunks of FRAME_CHUNK_SIZE rows, whatever the number of
+// threads; every row is computed with the same arithmetic as a serial loop
+// (times are t0 + j*dt rather than accumulated) and partial sums are merged
+// in chunk order, so the result does not depend on the scheduling. Frames
+// up to one chunk are processed by the calling thread. Stages are templated
+// on the sample type (int16_t samples, uint8_t digital states) and read the
+// planes of the given channels only, so that their cost grows with the
+// number of displayed channels; the frame columns are the time followed by
+// one column per channel, in the given order.
+class FrameProcessor
+{
+public:
+	FrameProcessor(unsigned int);
+
+	void forChunks(size_t, const ChunkTask &);
+	template <typename T> void scaleFrame(const FrameQueue<T> &, const std::vector<unsigned int> &, const double*, double, DisplayFrame &);
+	void averageFrame(const std::deque<AverageEntry> &, const std::vector<unsigned int> &, double, DisplayFrame &);
+	void voltmeter(const FrameQueue<int16_t> &, const std::vector<unsigned int> &, const ScopeParameters*, double*);
+	unsigned int size() const;
+	bool setAffinity(const std::vector<int> &);
+
+private:
+	WorkStealingPool	pool;
+};
+
+#endif
@@ -0,0 +1,161 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#include "xoscilloscope-engine_pool.h"
+
+// Index of the queue owned by the calling thread, -1 outside the pool.
+static thread_local int pool_worker_index = -1;
+static thread_local const WorkStealingPool* pool_worker_owner = NULL;
+
+WorkStealingPool::WorkStealingPool(unsigned int nr_workers)
+{
+	if (nr_workers == 0)
+		nr_workers = 1;
+	nr_queued = 0;
+	nr_unfinished = 0;
+	next_queue = 0;
+	stopping = false;
+	for (unsigned int i = 0; i < nr_workers; i++)
+		queues.push_back(std::unique_ptr<PoolQueue>(new PoolQueue));
+	for (unsigned int i = 0; i < nr_workers; i++)
+		workers.push_back(std::thread(&WorkStealingPool::run, this, i));
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+	wait();
+	{
+		std::lock_guard<std::mutex> guard(state_lock);
+		stopping = true;
+	}
+	work_available.notify_all();
+	for (int i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+
+unsigned int WorkStealingPool::size() const
+{
+	return queues.size();
+}
+
+// Restricts all the workers to the given CPUs.
+bool WorkStealingPool::setAffinity(const std::vector<int> & cpus)
+{
+	cpu_set_t cpu_set;
+	CPU_ZERO(&cpu_set);
+	for (size_t k = 0; k < cpus.size(); k++)
+		CPU_SET(cpus[k], &cpu_set);
+	bool success = true;
+	for (size_t i = 0; i < workers.size(); i++) {
+		if (pthread_setaffinity_np(workers[i].native_handle(), sizeof(cpu_set_t), &cpu_set) != 0)
+			success = false;
+	}
+	return success;
+}
+
+void WorkStealingPool::submit(PoolTask task)
+{
+	unsigned int index;
+	{
+		std::lock_guard<std::mutex> guard(state_lock);
+		if ((pool_worker_owner == this) && (pool_worker_index >= 0)) {
+			index = pool_worker_index;
+		} else {
+			index = next_queue;
+			next_queue = (next_queue + 1) % queues.size();
+		}
+		nr_unfinished++;
+	}
+	{
+		std::lock_guard<std::mutex> guard(queues[index]->lock);
+		queues[index]->tasks.push_back(std::move(task));
+	}
+	// Announced only once queued, so that a woken worker always finds it
+	{
+		std::lock_guard<std::mutex> guard(state_lock);
+		nr_queued++;
+	}
+	work_available.notify_one();
+	return;
+}
+
+// Blocks until every submitted task, including those submitted by tasks,
+// has completed. Must not be called from a worker.
+void WorkStealingPool::wait()
+{
+	std::unique_lock<std::mutex> guard(state_lock);
+	work_done.wait(guard, [this] { return nr_unfinished == 0; });
+	return;
+}
+
+bool WorkStealingPool::take(unsigned int index, PoolTask & task)
+{
+	{
+		PoolQueue & own = *queues[index];
+		std::lock_guard<std::mutex> guard(own.lock);
+		if (!own.tasks.empty()) {
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			return true;
+		}
+	}
+	for (unsigned int k = 1; k < queues.size(); k++) {
+		PoolQueue & victim = *queues[(index + k) % queues.size()];
+		std::lock_guard<std::mutex> guard(victim.lock);
+		if (!victim.tasks.empty()) {
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void WorkStealingPool::run(unsigned int index)
+{
+	pool_worker_index = index;
+	pool_worker_owner = this;
+	PoolTask task;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> guard(state_lock);
+			work_available.wait(guard, [this] { return stopping || (nr_queued > 0); });
+			if (stopping && (nr_queued == 0))
+				break;
+			nr_queued--;
+		}
+		// Claims never outnumber the queued tasks, so a scan can only fail
+		// if the task it missed was pushed to a queue already visited.
+		while (!take(index, task))
+			std::this_thread::yield();
+		task();
+		task = nullptr;
+		{
+			std::lock_guard<std::mutex> guard(state_lock);
+			nr_unfinished--;
+			if (nr_unfinished == 0)
+				work_done.notify_all();
+		}
+	}
+	return;
+}
@@ -0,0 +1,77 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#ifndef INCLUDED_ENGINE_POOL
+#define INCLUDED_ENGINE_POOL
+
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <pthread.h>
+#include <sched.h>
+
+typedef std::function<void()> PoolTask;
+
+struct PoolQueue {
+	std::mutex		lock;
+	std::deque<PoolTask>	tasks;
+};
+
+// Persistent pool of worker threads with one task queue each. Workers take
+// tasks from the back of their own queue and, when it is empty, steal from
+// the front of the others', so that uneven tasks (segments of different
+// files, triggers clustered in time) keep all cores busy. Tasks submitted
+// from a worker go to its own queue; the others are dealt round-robin.
+class WorkStealingPool
+{
+public:
+	WorkStealingPool(unsigned int);
+	~WorkStealingPool();
+
+	void submit(PoolTask);
+	void wait();
+	unsigned int size() const;
+	bool setAffinity(const std::vector<int> &);
+
+private:
+	void run(unsigned int);
+	bool take(unsigned int, PoolTask &);
+
+	std::vector< std::unique_ptr<PoolQueue> >	queues;
+	std::vector<std::thread>			workers;
+	std::mutex					state_lock;
+	std::condition_variable				work_available;
+	std::condition_variable				work_done;
+	uint64_t					nr_queued;
+	uint64_t					nr_unfinished;
+	unsigned int					next_queue;
+	bool						stopping;
+};
+
+#endif
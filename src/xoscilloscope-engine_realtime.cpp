@@ -0,0 +1,147 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#include "xoscilloscope-engine_realtime.h"
+
+// Parses a comma-separated list of CPU numbers and ranges, e.g. "2,4-7".
+bool oXs_parse_cpu_list(const char* text, std::vector<int> & cpus)
+{
+	cpus.clear();
+	const char* p = text;
+	while (*p != '\0') {
+		char* end;
+		long first = strtol(p, &end, 10);
+		if ((end == p) || (first < 0) || (first >= CPU_SETSIZE))
+			return false;
+		long last = first;
+		p = end;
+		if (*p == '-') {
+			last = strtol(p + 1, &end, 10);
+			if ((end == p + 1) || (last < first) || (last >= CPU_SETSIZE))
+				return false;
+			p = end;
+		}
+		for (long cpu = first; cpu <= last; cpu++)
+			cpus.push_back(cpu);
+		if (*p == ',')
+			p++;
+		else if (*p != '\0')
+			return false;
+	}
+	return !cpus.empty();
+}
+
+bool oXs_set_thread_affinity(const std::vector<int> & cpus)
+{
+	cpu_set_t cpu_set;
+	CPU_ZERO(&cpu_set);
+	for (size_t k = 0; k < cpus.size(); k++)
+		CPU_SET(cpus[k], &cpu_set);
+	return (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set) == 0);
+}
+
+// Threads and processes started afterwards (recorder and save writers,
+// gnuplot) fall back to normal scheduling thanks to SCHED_RESET_ON_FORK.
+bool oXs_set_thread_realtime(int priority)
+{
+	struct sched_param parameters;
+	memset(&parameters, 0, sizeof(parameters));
+	parameters.sched_priority = priority;
+	int policy = SCHED_FIFO;
+#ifdef SCHED_RESET_ON_FORK
+	policy |= SCHED_RESET_ON_FORK;
+#endif
+	return (sched_setscheduler(0, policy, &parameters) == 0);
+}
+
+// Locks current and future pages. Where available, pages are locked as they
+// are faulted in rather than all at once, so that the mappings which must
+// stay pageable can be unlocked before they are ever populated. Freed heap
+// memory is kept by the allocator instead of being returned to the system
+// and faulted in again later.
+bool oXs_lock_memory()
+{
+	int flags = MCL_CURRENT | MCL_FUTURE;
+#ifdef MCL_ONFAULT
+	flags |= MCL_ONFAULT;
+#endif
+	if (mlockall(flags) != 0)
+		return false;
+	mallopt(M_TRIM_THRESHOLD, -1);
+	mallopt(M_MMAP_MAX, 0);
+	return true;
+}
+
+void oXs_prefault_stack()
+{
+	char stack[REALTIME_STACK_PREFAULT];
+	volatile char* page = stack;
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	for (size_t i = 0; i < REALTIME_STACK_PREFAULT; i += page_size)
+		page[i] = 0;
+	return;
+}
+
+static std::string oXs_cpu_list_string(const std::vector<int> & cpus)
+{
+	std::string text;
+	for (size_t k = 0; k < cpus.size(); k++)
+		text += ((k == 0)? "" : ",") + std::to_string(cpus[k]);
+	return text;
+}
+
+// Called from the capture thread once everything has been allocated. Each
+// step that fails is reported and skipped; the engine keeps running with
+// whatever could be set up.
+void oXs_setup_realtime(const RealtimeSettings & settings, FrameProcessor & processor, HistoryRing & history)
+{
+	if (!settings.processing_cpus.empty()) {
+		if (processor.setAffinity(settings.processing_cpus))
+			std::cerr << "Processing threads bound to CPUs " << oXs_cpu_list_string(settings.processing_cpus) << ".\n";
+		else
+			std::cerr << "Could not bind processing threads to CPUs " << oXs_cpu_list_string(settings.processing_cpus) << ".\n";
+	}
+	if (!settings.capture_cpus.empty()) {
+		if (oXs_set_thread_affinity(settings.capture_cpus))
+			std::cerr << "Capture thread bound to CPUs " << oXs_cpu_list_string(settings.capture_cpus) << ".\n";
+		else
+			std::cerr << "Could not bind capture thread to CPUs " << oXs_cpu_list_string(settings.capture_cpus) << ".\n";
+	}
+	if (settings.priority == 0)
+		return;
+
+	if (oXs_lock_memory()) {
+		std::cerr << "Memory locked.\n";
+	} else {
+		std::cerr << "Could not lock memory (" << strerror(errno) << "): raise the memlock limit or grant CAP_IPC_LOCK. Memory stays pageable.\n";
+	}
+	history.prefault();
+	oXs_prefault_stack();
+
+	if (oXs_set_thread_realtime(settings.priority)) {
+		std::cerr << "Capture thread running SCHED_FIFO at priority " << settings.priority << ".\n";
+	} else {
+		std::cerr << "Could not switch to SCHED_FIFO (" << strerror(errno) << "): raise the rtprio limit or grant CAP_SYS_NICE. Running with normal scheduling.\n";
+	}
+	return;
+}
@@ -0,0 +1,63 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#ifndef INCLUDED_ENGINE_REALTIME
+#define INCLUDED_ENGINE_REALTIME
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <malloc.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include "xoscilloscope-engine_pipeline.h"
+#include "xoscilloscope-engine_history.h"
+
+#define REALTIME_MAX_PRIORITY 99
+#define REALTIME_STACK_PREFAULT 524288
+
+// Opt-in real-time operation of the engine. With a non-zero priority the
+// capture thread (the main one) runs SCHED_FIFO, memory is locked and the
+// buffers used while capturing are faulted in beforehand. The CPU lists
+// apply in any case; empty lists leave the affinity alone.
+struct RealtimeSettings {
+	int			priority;
+	std::vector<int>	capture_cpus;
+	std::vector<int>	processing_cpus;
+};
+
+bool oXs_parse_cpu_list(const char*, std::vector<int> &);
+bool oXs_set_thread_affinity(const std::vector<int> &);
+bool oXs_set_thread_realtime(int);
+bool oXs_lock_memory();
+void oXs_prefault_stack();
+void oXs_setup_realtime(const RealtimeSettings &, FrameProcessor &, HistoryRing &);
+
+#endif
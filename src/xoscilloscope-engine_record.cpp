@@ -0,0 +1,752 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#include "xoscilloscope-engine_record.h"
+#include "xoscilloscope-engine_output.h"
+
+static_assert(sizeof(RecordFileHeader) <= RECORD_HEADER_SIZE, "record file header too large");
+static_assert(sizeof(RecordChunkHeader) <= RECORD_CHUNK_HEADER_SIZE, "record chunk header too large");
+static_assert(sizeof(PyramidFileHeader) <= PYRAMID_HEADER_SIZE, "pyramid file header too large");
+
+// Calibration of the first n channels; the remaining entries are set to 1.
+static void oXs_copy_calibration(double* y_vps, const double* source, unsigned int n)
+{
+	for (unsigned int c = 0; c < RECORD_MAX_CHANNELS; c++)
+		y_vps[c] = ((source != NULL) && (c < n))? source[c] : 1.0;
+	return;
+}
+
+PyramidBuilder::PyramidBuilder()
+{
+	fd = -1;
+	nr_channels = 0;
+	nr_frames = 0;
+	nr_level_zero = 0;
+	write_failed = false;
+}
+
+PyramidBuilder::~PyramidBuilder()
+{
+	if (fd >= 0)
+		close(fd);
+}
+
+bool PyramidBuilder::start(const std::string & name, unsigned int channels)
+{
+	if (fd >= 0)
+		close(fd);
+	fd = open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (fd < 0) {
+		std::cerr << "Could not open pyramid file '" << name << "'\n";
+		return false;
+	}
+	// Level 0 is streamed right after the (yet to be written) header
+	if (lseek(fd, PYRAMID_HEADER_SIZE, SEEK_SET) < 0) {
+		close(fd);
+		fd = -1;
+		return false;
+	}
+
+	nr_channels = channels;
+	nr_frames = 0;
+	nr_level_zero = 0;
+	write_failed = false;
+	// Levels are added by emit(); no reallocation may happen meanwhile, as
+	// references to the accumulators are held across calls.
+	accumulators.reserve(PYRAMID_MAX_LEVELS);
+	accumulators.assign(1, PyramidAccumulator());
+	reset(accumulators[0]);
+	levels.assign(1, std::vector<PyramidValue>());
+	levels[0].reserve(PYRAMID_WRITE_SIZE / sizeof(PyramidValue));
+	return true;
+}
+
+void PyramidBuilder::reset(PyramidAccumulator & accumulator)
+{
+	accumulator.min.assign(nr_channels, INT16_MAX);
+	accumulator.max.assign(nr_channels, INT16_MIN);
+	accumulator.sum.assign(nr_channels, 0.0);
+	accumulator.nr_frames = 0;
+	accumulator.count = 0;
+	return;
+}
+
+// Turns the accumulator of a level into an entry of that level, and merges
+// it into the accumulator of the level above.
+void PyramidBuilder::emit(unsigned int level)
+{
+	if (level + 1 == accumulators.size()) {
+		if (level + 1 == PYRAMID_MAX_LEVELS) {
+			reset(accumulators[level]);
+			return;
+		}
+		accumulators.push_back(PyramidAccumulator());
+		reset(accumulators.back());
+		levels.push_back(std::vector<PyramidValue>());
+	}
+
+	PyramidAccumulator & accumulator = accumulators[level];
+	PyramidAccumulator & parent = accumulators[level + 1];
+	for (int c = 0; c < nr_channels; c++) {
+		PyramidValue value;
+		value.min = accumulator.min[c];
+		value.max = accumulator.max[c];
+		value.mean = accumulator.sum[c] / accumulator.nr_frames;
+		levels[level].push_back(value);
+		if (value.min < parent.min[c])
+			parent.min[c] = value.min;
+		if (value.max > parent.max[c])
+			parent.max[c] = value.max;
+		parent.sum[c] += accumulator.sum[c];
+	}
+	parent.nr_frames += accumulator.nr_frames;
+	parent.count++;
+	reset(accumulator);
+
+	if (level == 0) {
+		nr_level_zero++;
+		if (levels[0].size() * sizeof(PyramidValue) >= PYRAMID_WRITE_SIZE)
+			flushLevelZero();
+	}
+	if (parent.count == PYRAMID_FACTOR)
+		emit(level + 1);
+	return;
+}
+
+void PyramidBuilder::flushLevelZero()
+{
+	if (levels[0].empty())
+		return;
+	if (!write_failed && (oXs_write_all(fd, (const char*) levels[0].data(), levels[0].size() * sizeof(PyramidValue)) < 0))
+		write_failed = true;
+	levels[0].clear();
+	return;
+}
+
+void PyramidBuilder::append(const int16_t* samples, unsigned int count)
+{
+	if (fd < 0)
+		return;
+
+	PyramidAccumulator & accumulator = accumulators[0];
+	for (unsigned int i = 0; i < count; i++) {
+		for (int c = 0; c < nr_channels; c++) {
+			int16_t y = samples[c];
+			if (y < accumulator.min[c])
+				accumulator.min[c] = y;
+			if (y > accumulator.max[c])
+				accumulator.max[c] = y;
+			accumulator.sum[c] += y;
+		}
+		samples += nr_channels;
+		accumulator.nr_frames++;
+		if (++accumulator.count == PYRAMID_FACTOR)
+			emit(0);
+	}
+	nr_frames += count;
+	return;
+}
+
+// Flushes the partial entries (which cover fewer frames than a full one) up
+// to the first level made of a single entry, then writes the upper levels
+// after level 0 and finally the header.
+bool PyramidBuilder::finish()
+{
+	if (fd < 0)
+		return false;
+
+	unsigned int nr_levels = 0;
+	uint64_t entries = 0;
+	if (nr_frames > 0) {
+		for (unsigned int level = 0; level < accumulators.size(); level++) {
+			if (accumulators[level].count > 0)
+				emit(level);
+			entries = (level == 0)? nr_level_zero : levels[level].size() / nr_channels;
+			nr_levels = level + 1;
+			if ((entries <= 1) || (nr_levels == PYRAMID_MAX_LEVELS))
+				break;
+		}
+	}
+	flushLevelZero();
+
+	char header_block[PYRAMID_HEADER_SIZE];
+	bzero(header_block, PYRAMID_HEADER_SIZE);
+	PyramidFileHeader* header = (PyramidFileHeader*) header_block;
+	memcpy(header->magic, PYRAMID_MAGIC, sizeof(header->magic));
+	header->version = RECORD_VERSION;
+	header->header_size = PYRAMID_HEADER_SIZE;
+	header->factor = PYRAMID_FACTOR;
+	header->nr_channels = nr_channels;
+	header->nr_levels = nr_levels;
+	header->nr_frames = nr_frames;
+	uint64_t offset = PYRAMID_HEADER_SIZE;
+	for (unsigned int level = 0; level < nr_levels; level++) {
+		header->level_offset[level] = offset;
+		header->level_entries[level] = (level == 0)? nr_level_zero : levels[level].size() / nr_channels;
+		offset += header->level_entries[level] * nr_channels * sizeof(PyramidValue);
+		if ((level > 0) && !write_failed && (oXs_write_all(fd, (const char*) levels[level].data(), levels[level].size() * sizeof(PyramidValue)) < 0))
+			write_failed = true;
+	}
+	if (!write_failed && ((lseek(fd, 0, SEEK_SET) < 0) || (oXs_write_all(fd, header_block, PYRAMID_HEADER_SIZE) < 0)))
+		write_failed = true;
+
+	close(fd);
+	fd = -1;
+	accumulators.clear();
+	levels.clear();
+	return !write_failed;
+}
+
+StreamRecorder::StreamRecorder()
+{
+	fd = -1;
+	recording = false;
+	stopping = false;
+	write_failed = false;
+	discontinuity = false;
+	active = -1;
+	nr_channels = 0;
+	chunk_capacity = 0;
+	nr_chunks = 0;
+	nr_frames = 0;
+	nr_dropped_frames = 0;
+	oXs_copy_calibration(y_vps, NULL, 0);
+}
+
+StreamRecorder::~StreamRecorder()
+{
+	stop();
+}
+
+bool StreamRecorder::start(const std::string & name, unsigned int sample_rate, unsigned int channels, const double* channel_vps, bool direct_io)
+{
+	if (recording)
+		stop();
+	if ((channels == 0) || (channels > RECORD_MAX_CHANNELS)) {
+		std::cerr << "Cannot record " << channels << " channels (at most " << RECORD_MAX_CHANNELS << ")\n";
+		return false;
+	}
+
+	int flags = O_WRONLY | O_CREAT | O_TRUNC;
+	fd = -1;
+	if (direct_io)
+		fd = open(name.c_str(), flags | O_DIRECT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (fd < 0)
+		fd = open(name.c_str(), flags, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (fd < 0) {
+		std::cerr << "Could not open recording file '" << name << "'\n";
+		return false;
+	}
+
+	file_name = name;
+	nr_channels = channels;
+	chunk_capacity = (RECORD_CHUNK_SIZE - RECORD_CHUNK_HEADER_SIZE) / (nr_channels * sizeof(int16_t));
+	oXs_copy_calibration(y_vps, channel_vps, nr_channels);
+
+	char* header_block;
+	if (posix_memalign((void**) &header_block, RECORD_ALIGNMENT, RECORD_HEADER_SIZE) != 0) {
+		close(fd);
+		fd = -1;
+		return false;
+	}
+	bzero(header_block, RECORD_HEADER_SIZE);
+	RecordFileHeader* header = (RecordFileHeader*) header_block;
+	memcpy(header->magic, RECORD_MAGIC, sizeof(header->magic));
+	header->version = RECORD_VERSION;
+	header->header_size = RECORD_HEADER_SIZE;
+	header->chunk_size = RECORD_CHUNK_SIZE;
+	header->chunk_header_size = RECORD_CHUNK_HEADER_SIZE;
+	header->nr_channels = nr_channels;
+	header->sample_rate = sample_rate;
+	header->sample_format = RECORD_SAMPLE_FORMAT_S16_LE;
+	memcpy(header->y_vps, y_vps, sizeof(header->y_vps));
+	int64_t start_ns = oXs_realtime_ns();
+	header->start_time_sec = start_ns / 1000000000;
+	header->start_time_nsec = start_ns % 1000000000;
+	int err = oXs_write_all(fd, header_block, RECORD_HEADER_SIZE);
+	free(header_block);
+	if (err < 0) {
+		std::cerr << "Could not write recording file '" << name << "'\n";
+		close(fd);
+		fd = -1;
+		return false;
+	}
+
+	buffers.resize(RECORD_NR_BUFFERS);
+	free_buffers.clear();
+	full_buffers.clear();
+	for (int i = 0; i < RECORD_NR_BUFFERS; i++) {
+		if (posix_memalign((void**) &buffers[i].data, RECORD_ALIGNMENT, RECORD_CHUNK_SIZE) != 0) {
+			std::cerr << "Could not allocate recording buffers\n";
+			exit(1);
+		}
+		// Touch every page now, so that the capture thread never faults
+		memset(buffers[i].data, 0, RECORD_CHUNK_SIZE);
+		buffers[i].nr_frames = 0;
+		free_buffers.push_back(i);
+	}
+
+	active = -1;
+	nr_chunks = 0;
+	nr_frames = 0;
+	nr_dropped_frames = 0;
+	discontinuity = false;
+	write_failed = false;
+	stopping = false;
+	recording = true;
+	pyramid.start(file_name + PYRAMID_SUFFIX, nr_channels);
+	writer = std::thread(&StreamRecorder::run, this);
+
+	std::cerr << "Recording to '" << file_name << "'" << ((direct_io)? " (direct I/O)" : "") << "\n";
+	return true;
+}
+
+void StreamRecorder::stop()
+{
+	if (!recording)
+		return;
+
+	if (active >= 0)
+		submitActiveChunk();
+	{
+		std::lock_guard<std::mutex> guard(buffers_lock);
+		stopping = true;
+	}
+	buffers_available.notify_all();
+	writer.join();
+	close(fd);
+	fd = -1;
+	if (!pyramid.finish())
+		std::cerr << "Could not write the pyramid of '" << file_name << "'\n";
+	for (int i = 0; i < buffers.size(); i++)
+		free(buffers[i].data);
+	buffers.clear();
+	recording = false;
+
+	std::cerr << "Recording stopped: " << nr_frames - nr_dropped_frames << " frames saved at '" << file_name << "'";
+	if (nr_dropped_frames > 0)
+		std::cerr << ", " << nr_dropped_frames << " frames dropped (disk too slow)";
+	if (write_failed)
+		std::cerr << ", WRITE ERRORS occurred";
+	std::cerr << "\n";
+	return;
+}
+
+bool StreamRecorder::isRecording() const
+{
+	return recording;
+}
+
+void StreamRecorder::setCalibration(const double* channel_vps)
+{
+	oXs_copy_calibration(y_vps, channel_vps, nr_channels);
+	return;
+}
+
+// Called by the capture thread when samples have been lost (overrun).
+void StreamRecorder::markDiscontinuity()
+{
+	discontinuity = true;
+	return;
+}
+
+void StreamRecorder::openChunk(int index)
+{
+	RecordChunkHeader* chunk = (RecordChunkHeader*) buffers[index].data;
+	bzero(chunk, RECORD_CHUNK_HEADER_SIZE);
+	memcpy(chunk->magic, RECORD_CHUNK_MAGIC, sizeof(chunk->magic));
+	chunk->flags = (discontinuity)? RECORD_CHUNK_DISCONTINUITY : 0;
+	chunk->sequence = nr_chunks++;
+	chunk->first_frame = nr_frames;
+	chunk->timestamp_ns = oXs_realtime_ns();
+	memcpy(chunk->y_vps, y_vps, sizeof(chunk->y_vps));
+	buffers[index].nr_frames = 0;
+	discontinuity = false;
+	active = index;
+	return;
+}
+
+void StreamRecorder::submitActiveChunk()
+{
+	RecordBuffer & buffer = buffers[active];
+	((RecordChunkHeader*) buffer.data)->nr_frames = buffer.nr_frames;
+	size_t used = RECORD_CHUNK_HEADER_SIZE + buffer.nr_frames * nr_channels * sizeof(int16_t);
+	bzero(buffer.data + used, RECORD_CHUNK_SIZE - used);
+	{
+		std::lock_guard<std::mutex> guard(buffers_lock);
+		full_buffers.push_back(active);
+	}
+	buffers_available.notify_all();
+	active = -1;
+	return;
+}
+
+// Capture thread side: never waits for the disk.
+void StreamRecorder::append(const int16_t* samples, unsigned int count)
+{
+	if (!recording)
+		return;
+
+	while (count > 0) {
+		if (active < 0) {
+			int index = -1;
+			{
+				std::lock_guard<std::mutex> guard(buffers_lock);
+				if (!free_buffers.empty()) {
+					index = free_buffers.front();
+					free_buffers.pop_front();
+				}
+			}
+			if (index < 0) {
+				nr_dropped_frames += count;
+				nr_frames += count;
+				discontinuity = true;
+				return;
+			}
+			openChunk(index);
+		}
+
+		RecordBuffer & buffer = buffers[active];
+		unsigned int n = chunk_capacity - buffer.nr_frames;
+		if (n > count)
+			n = count;
+		memcpy(buffer.data + RECORD_CHUNK_HEADER_SIZE + buffer.nr_frames * nr_channels * sizeof(int16_t), samples, n * nr_channels * sizeof(int16_t));
+		buffer.nr_frames += n;
+		nr_frames += n;
+		samples += n * nr_channels;
+		count -= n;
+
+		if (buffer.nr_frames == chunk_capacity)
+			submitActiveChunk();
+	}
+
+	return;
+}
+
+void StreamRecorder::run()
+{
+	while (true) {
+		int index;
+		{
+			std::unique_lock<std::mutex> guard(buffers_lock);
+			buffers_available.wait(guard, [this] { return stopping || !full_buffers.empty(); });
+			if (full_buffers.empty())
+				break;
+			index = full_buffers.front();
+			full_buffers.pop_front();
+		}
+		if (!write_failed && (oXs_write_all(fd, buffers[index].data, RECORD_CHUNK_SIZE) < 0)) {
+			std::cerr << "Error while writing recording file '" << file_name << "'\n";
+			write_failed = true;
+		}
+		pyramid.append((const int16_t*) (buffers[index].data + RECORD_CHUNK_HEADER_SIZE), buffers[index].nr_frames);
+		{
+			std::lock_guard<std::mutex> guard(buffers_lock);
+			free_buffers.push_back(index);
+		}
+	}
+	return;
+}
+
+SegmentRecorder::SegmentRecorder()
+{
+	fd = -1;
+	index_fd = -1;
+	file_offset = 0;
+	pending_size = 0;
+	recording = false;
+	stopping = false;
+	write_failed = false;
+	triggered = false;
+	discontinuity = false;
+	nr_channels = 2;
+	sample_rate = 1;
+	pre_frames = 0;
+	post_frames = 0;
+	trig_chan = 0;
+	requested_trig_chan = 0;
+	trig_level = 0.0;
+	trig_rising_edge = true;
+	oXs_copy_calibration(y_vps, NULL, 0);
+	y_last = 0.0;
+	nr_frames = 0;
+	history_frames = 0;
+	nr_segments = 0;
+	nr_dropped_segments = 0;
+}
+
+SegmentRecorder::~SegmentRecorder()
+{
+	stop();
+}
+
+bool SegmentRecorder::start(const std::string & name, unsigned int rate, unsigned int channels, const double* channel_vps)
+{
+	if (recording)
+		stop();
+	if ((channels == 0) || (channels > RECORD_MAX_CHANNELS)) {
+		std::cerr << "Cannot record " << channels << " channels (at most " << RECORD_MAX_CHANNELS << ")\n";
+		return false;
+	}
+
+	std::string index_name = name + SEGMENT_INDEX_SUFFIX;
+	fd = open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	index_fd = open(index_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if ((fd < 0) || (index_fd < 0)) {
+		std::cerr << "Could not open segment files '" << name << "'\n";
+		if (fd >= 0)
+			close(fd);
+		if (index_fd >= 0)
+			close(index_fd);
+		fd = -1;
+		index_fd = -1;
+		return false;
+	}
+
+	file_name = name;
+	sample_rate = rate;
+	nr_channels = channels;
+	trig_chan = (requested_trig_chan < nr_channels)? requested_trig_chan : 0;
+	oXs_copy_calibration(y_vps, channel_vps, nr_channels);
+
+	std::vector<char> header_block(RECORD_HEADER_SIZE, 0);
+	RecordFileHeader* header = (RecordFileHeader*) header_block.data();
+	memcpy(header->magic, SEGMENT_MAGIC, sizeof(header->magic));
+	header->version = RECORD_VERSION;
+	header->header_size = RECORD_HEADER_SIZE;
+	header->nr_channels = nr_channels;
+	header->sample_rate = sample_rate;
+	header->sample_format = RECORD_SAMPLE_FORMAT_S16_LE;
+	memcpy(header->y_vps, y_vps, sizeof(header->y_vps));
+	int64_t start_ns = oXs_realtime_ns();
+	header->start_time_sec = start_ns / 1000000000;
+	header->start_time_nsec = start_ns % 1000000000;
+	if (oXs_write_all(fd, header_block.data(), RECORD_HEADER_SIZE) < 0) {
+		std::cerr << "Could not write segment file '" << name << "'\n";
+		close(fd);
+		close(index_fd);
+		fd = -1;
+		index_fd = -1;
+		return false;
+	}
+
+	file_offset = RECORD_HEADER_SIZE;
+	history.assign((size_t) (pre_frames + post_frames) * nr_channels, 0);
+	pending_segments.clear();
+	pending_size = 0;
+	nr_frames = 0;
+	history_frames = 0;
+	nr_segments = 0;
+	nr_dropped_segments = 0;
+	triggered = false;
+	discontinuity = false;
+	write_failed = false;
+	stopping = false;
+	recording = true;
+	writer = std::thread(&SegmentRecorder::run, this);
+
+	std::cerr << "Recording trigger events to '" << file_name << "'\n";
+	return true;
+}
+
+void SegmentRecorder::stop()
+{
+	if (!recording)
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(segments_lock);
+		stopping = true;
+	}
+	segments_available.notify_all();
+	writer.join();
+	close(fd);
+	close(index_fd);
+	fd = -1;
+	index_fd = -1;
+	recording = false;
+
+	std::cerr << "Event recording stopped: " << nr_segments - nr_dropped_segments << " segments saved at '" << file_name << "'";
+	if (nr_dropped_segments > 0)
+		std::cerr << ", " << nr_dropped_segments << " dropped (disk too slow)";
+	if (write_failed)
+		std::cerr << ", WRITE ERRORS occurred";
+	std::cerr << "\n";
+	return;
+}
+
+bool SegmentRecorder::isRecording() const
+{
+	return recording;
+}
+
+// Pre- and post-trigger window, in frames. Changing it restarts the history.
+void SegmentRecorder::setWindow(unsigned int pre, unsigned int post)
+{
+	if ((pre == pre_frames) && (post == post_frames))
+		return;
+	pre_frames = pre;
+	post_frames = post;
+	if (recording)
+		history.assign((size_t) (pre_frames + post_frames) * nr_channels, 0);
+	history_frames = 0;
+	triggered = false;
+	return;
+}
+
+// Trigger channel is zero-based; level is in raw sample units. The channel
+// is checked against the number of recorded channels once it is known, by
+// start(); a channel that is not recorded falls back to the first one.
+void SegmentRecorder::setTrigger(unsigned int channel, double level, bool rising_edge)
+{
+	requested_trig_chan = channel;
+	trig_chan = (channel < nr_channels)? channel : 0;
+	trig_level = level;
+	trig_rising_edge = rising_edge;
+	return;
+}
+
+void SegmentRecorder::setCalibration(const double* channel_vps)
+{
+	oXs_copy_calibration(y_vps, channel_vps, nr_channels);
+	return;
+}
+
+void SegmentRecorder::markDiscontinuity()
+{
+	discontinuity = true;
+	return;
+}
+
+void SegmentRecorder::append(const int16_t* samples, unsigned int count)
+{
+	if (!recording || (pre_frames + post_frames == 0))
+		return;
+
+	uint64_t ring_frames = pre_frames + post_frames;
+	int64_t now_ns = oXs_realtime_ns();
+	double frame_ns = 1.0e9 / (double) sample_rate;
+
+	for (unsigned int i = 0; i < count; i++) {
+		const int16_t* frame = samples + i * nr_channels;
+		memcpy(history.data() + (nr_frames % ring_frames) * nr_channels, frame, nr_channels * sizeof(int16_t));
+		double y_new = frame[trig_chan];
+
+		if (!triggered && (history_frames >= pre_frames) && oXs_level_crossing(y_last, y_new, trig_level, trig_rising_edge)) {
+			triggered = true;
+			SegmentHeader & header = current.header;
+			bzero(&header, sizeof(header));
+			memcpy(header.magic, SEGMENT_RECORD_MAGIC, sizeof(header.magic));
+			header.flags = (discontinuity)? RECORD_CHUNK_DISCONTINUITY : 0;
+			header.sequence = nr_segments;
+			header.trigger_frame = nr_frames;
+			header.timestamp_ns = now_ns - (int64_t) ((count - 1 - i) * frame_ns);
+			header.nr_frames = ring_frames;
+			header.pre_frames = pre_frames;
+			header.trig_chan = trig_chan + 1;
+			header.trig_rising_edge = trig_rising_edge;
+			header.trig_level = trig_level;
+			memcpy(header.y_vps, y_vps, sizeof(header.y_vps));
+			discontinuity = false;
+		}
+
+		y_last = y_new;
+		nr_frames++;
+		history_frames++;
+
+		if (triggered && (nr_frames == current.header.trigger_frame + post_frames))
+			completeSegment();
+	}
+
+	return;
+}
+
+// The history now ends post_frames after the trigger: unroll it into the
+// segment and hand it over to the writer thread.
+void SegmentRecorder::completeSegment()
+{
+	uint64_t ring_frames = pre_frames + post_frames;
+	size_t start = nr_frames % ring_frames;
+
+	triggered = false;
+	nr_segments++;
+	if (discontinuity)
+		current.header.flags |= RECORD_CHUNK_DISCONTINUITY;
+
+	std::lock_guard<std::mutex> guard(segments_lock);
+	size_t segment_size = ring_frames * nr_channels * sizeof(int16_t);
+	if (!pending_segments.empty() && (pending_size + segment_size > SEGMENT_MAX_PENDING_SIZE)) {
+		nr_dropped_segments++;
+		return;
+	}
+	pending_size += segment_size;
+	pending_segments.push_back(current);
+	std::vector<int16_t> & data = pending_segments.back().data;
+	data.resize(ring_frames * nr_channels);
+	memcpy(data.data(), history.data() + start * nr_channels, (ring_frames - start) * nr_channels * sizeof(int16_t));
+	memcpy(data.data() + (ring_frames - start) * nr_channels, history.data(), start * nr_channels * sizeof(int16_t));
+	segments_available.notify_one();
+
+	return;
+}
+
+void SegmentRecorder::run()
+{
+	while (true) {
+		Segment segment;
+		{
+			std::unique_lock<std::mutex> guard(segments_lock);
+			segments_available.wait(guard, [this] { return stopping || !pending_segments.empty(); });
+			if (pending_segments.empty())
+				break;
+			segment = std::move(pending_segments.front());
+			pending_segments.pop_front();
+			pending_size -= segment.data.size() * sizeof(int16_t);
+		}
+		if (write_failed)
+			continue;
+
+		SegmentIndexEntry entry;
+		entry.sequence = segment.header.sequence;
+		entry.trigger_frame = segment.header.trigger_frame;
+		entry.timestamp_ns = segment.header.timestamp_ns;
+		entry.offset = file_offset;
+		size_t data_size = segment.data.size() * sizeof(int16_t);
+		if ((oXs_write_all(fd, (const char*) &segment.header, sizeof(SegmentHeader)) < 0) ||
+		    (oXs_write_all(fd, (const char*) segment.data.data(), data_size) < 0) ||
+		    (oXs_write_all(index_fd, (const char*) &entry, sizeof(SegmentIndexEntry)) < 0)) {
+			std::cerr << "Error while writing segment file '" << file_name << "'\n";
+			write_failed = true;
+			continue;
+		}
+		file_offset += sizeof(SegmentHeader) + data_size;
+	}
+	return;
+}
+
+int64_t oXs_realtime_ns()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	return (int64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
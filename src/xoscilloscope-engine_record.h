@@ -0,0 +1,304 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#ifndef INCLUDED_ENGINE_RECORD
+#define INCLUDED_ENGINE_RECORD
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "xoscilloscope-engine_trigger.h"
+#include "xoscilloscope-engine_history.h"
+
+#define RECORD_MAGIC "XELABREC"
+#define RECORD_VERSION 2
+#define RECORD_MAX_CHANNELS 8
+#define RECORD_CHUNK_MAGIC "CHNK"
+#define RECORD_ALIGNMENT 4096
+#define RECORD_HEADER_SIZE 4096
+#define RECORD_CHUNK_SIZE 1048576
+#define RECORD_CHUNK_HEADER_SIZE 128
+#define RECORD_NR_BUFFERS 4
+#define RECORD_SAMPLE_FORMAT_S16_LE 1
+#define RECORD_CHUNK_DISCONTINUITY 0x1
+#define SEGMENT_MAGIC "XELABSEG"
+#define SEGMENT_RECORD_MAGIC "SEGM"
+#define SEGMENT_INDEX_SUFFIX ".idx"
+#define SEGMENT_MAX_PENDING_SIZE 67108864
+#define PYRAMID_MAGIC "XELABPYR"
+#define PYRAMID_SUFFIX ".pyr"
+#define PYRAMID_HEADER_SIZE 4096
+#define PYRAMID_FACTOR 32
+#define PYRAMID_MAX_LEVELS 16
+#define PYRAMID_WRITE_SIZE 65536
+
+// Recording files ("*.xrec") consist of a header block followed by chunks
+// of fixed size. Every chunk starts with its own header and carries up to
+// (RECORD_CHUNK_SIZE - RECORD_CHUNK_HEADER_SIZE) bytes of interleaved int16
+// samples; the last chunk is zero-padded. Headers hold the volts per sample
+// unit of each channel, the entries beyond nr_channels being unused. All sizes are multiples of
+// RECORD_ALIGNMENT, so the file can be written with O_DIRECT.
+struct RecordFileHeader {
+	char		magic[8];
+	uint32_t	version;
+	uint32_t	header_size;
+	uint32_t	chunk_size;
+	uint32_t	chunk_header_size;
+	uint32_t	nr_channels;
+	uint32_t	sample_rate;
+	uint32_t	sample_format;
+	uint32_t	reserved;
+	double		y_vps[RECORD_MAX_CHANNELS];
+	int64_t		start_time_sec;
+	int64_t		start_time_nsec;
+};
+
+struct RecordChunkHeader {
+	char		magic[4];
+	uint32_t	flags;
+	uint64_t	sequence;
+	uint64_t	first_frame;
+	uint32_t	nr_frames;
+	uint32_t	reserved;
+	int64_t		timestamp_ns;
+	double		y_vps[RECORD_MAX_CHANNELS];
+};
+
+// Pyramid files ("*.xrec.pyr") hold min/max/mean summaries of a recording.
+// Entry i of level k covers the stored frames [i*F^(k+1), (i+1)*F^(k+1)),
+// F being PYRAMID_FACTOR, and is made of one PyramidValue per channel.
+struct PyramidFileHeader {
+	char		magic[8];
+	uint32_t	version;
+	uint32_t	header_size;
+	uint32_t	factor;
+	uint32_t	nr_channels;
+	uint32_t	nr_levels;
+	uint32_t	reserved;
+	uint64_t	nr_frames;
+	uint64_t	level_offset[PYRAMID_MAX_LEVELS];
+	uint64_t	level_entries[PYRAMID_MAX_LEVELS];
+};
+
+struct PyramidValue {
+	int16_t		min;
+	int16_t		max;
+	float		mean;
+};
+
+struct PyramidAccumulator {
+	std::vector<int16_t>	min;
+	std::vector<int16_t>	max;
+	std::vector<double>	sum;
+	uint64_t		nr_frames;
+	unsigned int		count;
+};
+
+// Builds the pyramid incrementally while samples are stored. Level 0, the
+// largest one, is streamed to the file as it grows; the upper levels are
+// kept in memory and appended by finish(), which also writes the header.
+class PyramidBuilder
+{
+public:
+	PyramidBuilder();
+	~PyramidBuilder();
+
+	bool start(const std::string &, unsigned int);
+	void append(const int16_t*, unsigned int);
+	bool finish();
+
+private:
+	void reset(PyramidAccumulator &);
+	void emit(unsigned int);
+	void flushLevelZero();
+
+	int					fd;
+	unsigned int				nr_channels;
+	uint64_t				nr_frames;
+	uint64_t				nr_level_zero;
+	bool					write_failed;
+	std::vector<PyramidAccumulator>		accumulators;
+	std::vector< std::vector<PyramidValue> >	levels;
+};
+
+struct RecordBuffer {
+	char*		data;
+	uint32_t	nr_frames;
+};
+
+// Tees the captured stream to disk. The capture thread copies samples into
+// one of RECORD_NR_BUFFERS aligned chunk buffers; full chunks are written
+// by a dedicated I/O thread. If the disk falls behind and no buffer is
+// free, samples are dropped (and the next chunk flagged as discontinuous)
+// rather than stalling the acquisition.
+class StreamRecorder
+{
+public:
+	StreamRecorder();
+	~StreamRecorder();
+
+	bool start(const std::string &, unsigned int, unsigned int, const double*, bool);
+	void stop();
+	bool isRecording() const;
+	void append(const int16_t*, unsigned int);
+	void markDiscontinuity();
+	void setCalibration(const double*);
+
+private:
+	void run();
+	void openChunk(int);
+	void submitActiveChunk();
+
+	std::vector<RecordBuffer>	buffers;
+	std::deque<int>			free_buffers;
+	std::deque<int>			full_buffers;
+	std::mutex			buffers_lock;
+	std::condition_variable		buffers_available;
+	std::thread			writer;
+	std::string			file_name;
+	int				fd;
+	bool				recording;
+	bool				stopping;
+	bool				write_failed;
+	bool				discontinuity;
+	int				active;
+	unsigned int			nr_channels;
+	unsigned int			chunk_capacity;
+	uint64_t			nr_chunks;
+	uint64_t			nr_frames;
+	uint64_t			nr_dropped_frames;
+	double				y_vps[RECORD_MAX_CHANNELS];
+	PyramidBuilder			pyramid;
+};
+
+// Segment files ("*.xseg") start with a RecordFileHeader (chunk fields set
+// to zero) and contain one record per trigger event: a SegmentHeader
+// followed by nr_frames interleaved int16 frames, the trigger being at
+// frame pre_frames. Both the segment file and its index ("*.xseg.idx",
+// one SegmentIndexEntry per event) are append-only.
+struct SegmentHeader {
+	char		magic[4];
+	uint32_t	flags;
+	uint64_t	sequence;
+	uint64_t	trigger_frame;
+	int64_t		timestamp_ns;
+	uint32_t	nr_frames;
+	uint32_t	pre_frames;
+	uint32_t	trig_chan;
+	uint32_t	trig_rising_edge;
+	double		trig_level;
+	double		y_vps[RECORD_MAX_CHANNELS];
+};
+
+struct SegmentIndexEntry {
+	uint64_t	sequence;
+	uint64_t	trigger_frame;
+	int64_t		timestamp_ns;
+	uint64_t	offset;
+};
+
+struct Segment {
+	SegmentHeader		header;
+	std::vector<int16_t>	data;
+};
+
+// Keeps a circular history of the stream and, on each trigger event,
+// stores the pre- and post-trigger window in a segment file. Disk usage
+// thus grows with the number of events, not with the elapsed time.
+// Triggers occurring while a window is being completed are ignored.
+class SegmentRecorder
+{
+public:
+	SegmentRecorder();
+	~SegmentRecorder();
+
+	bool start(const std::string &, unsigned int, unsigned int, const double*);
+	void stop();
+	bool isRecording() const;
+	void setWindow(unsigned int, unsigned int);
+	void setTrigger(unsigned int, double, bool);
+	void setCalibration(const double*);
+	void append(const int16_t*, unsigned int);
+	void markDiscontinuity();
+
+private:
+	void run();
+	void completeSegment();
+
+	std::vector<int16_t>		history;
+	std::deque<Segment>		pending_segments;
+	size_t				pending_size;
+	std::mutex			segments_lock;
+	std::condition_variable		segments_available;
+	std::thread			writer;
+	std::string			file_name;
+	int				fd;
+	int				index_fd;
+	uint64_t			file_offset;
+	bool				recording;
+	bool				stopping;
+	bool				write_failed;
+	bool				triggered;
+	bool				discontinuity;
+	unsigned int			nr_channels;
+	unsigned int			sample_rate;
+	unsigned int			pre_frames;
+	unsigned int			post_frames;
+	unsigned int			trig_chan;
+	unsigned int			requested_trig_chan;
+	double				trig_level;
+	bool				trig_rising_edge;
+	double				y_vps[RECORD_MAX_CHANNELS];
+	double				y_last;
+	uint64_t			nr_frames;
+	uint64_t			history_frames;
+	uint64_t			nr_segments;
+	uint64_t			nr_dropped_segments;
+	Segment				current;
+};
+
+// Everything that receives a copy of the captured stream.
+struct CaptureTaps {
+	StreamRecorder		stream;
+	SegmentRecorder		segments;
+	HistoryRing		history;
+};
+
+int64_t oXs_realtime_ns();
+
+#endif
@@ -0,0 +1,35 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#ifndef INCLUDED_ENGINE_TRIGGER
+#define INCLUDED_ENGINE_TRIGGER
+
+// Level-crossing condition shared by the display trigger and the recorders.
+inline bool oXs_level_crossing(double y_last, double y_new, double level, bool rising_edge)
+{
+	if (rising_edge)
+		return ((y_last < level) && (y_new >= level));
+	return ((y_last > level) && (y_new <= level));
+}
+
+#endif
@@ -0,0 +1,280 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#include "xoscilloscope-engine_viewer.h"
+
+RecordingView::RecordingView()
+{
+	record_map = NULL;
+	record_size = 0;
+	pyramid_map = NULL;
+	pyramid_size = 0;
+	header = NULL;
+	pyramid = NULL;
+	chunk_capacity = 0;
+	nr_chunks = 0;
+	nr_frames = 0;
+}
+
+RecordingView::~RecordingView()
+{
+	close();
+}
+
+static const char* oXs_map_file(const std::string & name, size_t & size)
+{
+	int fd = ::open(name.c_str(), O_RDONLY);
+	if (fd < 0)
+		return NULL;
+	struct stat file_status;
+	if ((fstat(fd, &file_status) < 0) || (file_status.st_size == 0)) {
+		::close(fd);
+		return NULL;
+	}
+	size = file_status.st_size;
+	void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (map == MAP_FAILED)
+		return NULL;
+	// Accesses follow the zoom/pan requests, not the file order
+	madvise(map, size, MADV_RANDOM);
+	return (const char*) map;
+}
+
+bool RecordingView::open(const std::string & name)
+{
+	close();
+
+	record_map = oXs_map_file(name, record_size);
+	if (record_map == NULL) {
+		std::cerr << "Could not map recording file '" << name << "'\n";
+		return false;
+	}
+	header = (const RecordFileHeader*) record_map;
+	if ((record_size < RECORD_HEADER_SIZE) || memcmp(header->magic, RECORD_MAGIC, sizeof(header->magic)) || (header->version != RECORD_VERSION)
+	    || (header->sample_format != RECORD_SAMPLE_FORMAT_S16_LE) || (header->nr_channels == 0) || (header->nr_channels > RECORD_MAX_CHANNELS)
+	    || (header->chunk_size <= header->chunk_header_size) || (header->header_size > record_size)) {
+		std::cerr << "'" << name << "' is not a valid recording file\n";
+		close();
+		return false;
+	}
+
+	// All chunks but the last are full, so the frame count follows from the
+	// file size and the header of the last chunk.
+	chunk_capacity = (header->chunk_size - header->chunk_header_size) / (header->nr_channels * sizeof(int16_t));
+	nr_chunks = (record_size - header->header_size) / header->chunk_size;
+	nr_frames = 0;
+	if (nr_chunks > 0) {
+		const RecordChunkHeader* last = (const RecordChunkHeader*) (record_map + header->header_size + (nr_chunks - 1) * header->chunk_size);
+		nr_frames = (nr_chunks - 1) * chunk_capacity + ((last->nr_frames <= chunk_capacity)? last->nr_frames : chunk_capacity);
+	}
+
+	std::string pyramid_name = name + PYRAMID_SUFFIX;
+	if (!mapPyramid(pyramid_name)) {
+		std::cerr << "Building pyramid of '" << name << "'...";
+		if (!buildPyramid(pyramid_name) || !mapPyramid(pyramid_name)) {
+			std::cerr << " failed.\n";
+			close();
+			return false;
+		}
+		std::cerr << " done.\n";
+	}
+	return true;
+}
+
+bool RecordingView::mapPyramid(const std::string & name)
+{
+	pyramid_map = oXs_map_file(name, pyramid_size);
+	if (pyramid_map == NULL)
+		return false;
+	pyramid = (const PyramidFileHeader*) pyramid_map;
+
+	bool valid = (pyramid_size >= PYRAMID_HEADER_SIZE) && !memcmp(pyramid->magic, PYRAMID_MAGIC, sizeof(pyramid->magic))
+			&& (pyramid->factor == PYRAMID_FACTOR) && (pyramid->nr_channels == header->nr_channels)
+			&& (pyramid->nr_frames == nr_frames) && (pyramid->nr_levels <= PYRAMID_MAX_LEVELS);
+	for (unsigned int level = 0; valid && (level < pyramid->nr_levels); level++)
+		valid = (pyramid->level_offset[level] + pyramid->level_entries[level] * pyramid->nr_channels * sizeof(PyramidValue) <= pyramid_size);
+	if (!valid) {
+		munmap((void*) pyramid_map, pyramid_size);
+		pyramid_map = NULL;
+		pyramid = NULL;
+		return false;
+	}
+	return true;
+}
+
+bool RecordingView::buildPyramid(const std::string & name)
+{
+	PyramidBuilder builder;
+	if (!builder.start(name, header->nr_channels))
+		return false;
+	for (uint64_t first = 0; first < nr_frames; first += chunk_capacity) {
+		unsigned int count = ((nr_frames - first) < chunk_capacity)? (nr_frames - first) : chunk_capacity;
+		builder.append(frame(first), count);
+	}
+	return builder.finish();
+}
+
+void RecordingView::close()
+{
+	if (record_map != NULL)
+		munmap((void*) record_map, record_size);
+	if (pyramid_map != NULL)
+		munmap((void*) pyramid_map, pyramid_size);
+	record_map = NULL;
+	pyramid_map = NULL;
+	header = NULL;
+	pyramid = NULL;
+	nr_chunks = 0;
+	nr_frames = 0;
+	return;
+}
+
+uint64_t RecordingView::nrFrames() const
+{
+	return nr_frames;
+}
+
+unsigned int RecordingView::sampleRate() const
+{
+	return (header != NULL)? header->sample_rate : 0;
+}
+
+unsigned int RecordingView::nrChannels() const
+{
+	return (header != NULL)? header->nr_channels : 0;
+}
+
+const int16_t* RecordingView::frame(uint64_t index) const
+{
+	uint64_t chunk = index / chunk_capacity;
+	return (const int16_t*) (record_map + header->header_size + chunk * header->chunk_size + header->chunk_header_size) + (index - chunk * chunk_capacity) * header->nr_channels;
+}
+
+const PyramidValue* RecordingView::entry(unsigned int level, uint64_t index) const
+{
+	return (const PyramidValue*) (pyramid_map + pyramid->level_offset[level]) + index * pyramid->nr_channels;
+}
+
+// Calibrated extremes of a channel over the whole recording, read from the
+// top level of the pyramid. Channels not in the recording yield [0, 0].
+void RecordingView::valueRange(unsigned int channel, double & y_min, double & y_max) const
+{
+	y_min = 0.0;
+	y_max = 0.0;
+	if ((pyramid == NULL) || (pyramid->nr_levels == 0) || (channel >= pyramid->nr_channels))
+		return;
+
+	unsigned int level = pyramid->nr_levels - 1;
+	double y_vps = header->y_vps[channel];
+	int16_t low = INT16_MAX, high = INT16_MIN;
+	for (uint64_t i = 0; i < pyramid->level_entries[level]; i++) {
+		const PyramidValue & value = entry(level, i)[channel];
+		if (value.min < low)
+			low = value.min;
+		if (value.max > high)
+			high = value.max;
+	}
+	y_min = low * y_vps;
+	y_max = high * y_vps;
+	return;
+}
+
+// Fills the frame with one row per pixel over the frames [first, last): time
+// followed by min, max and mean of each channel, calibrated with the volts
+// per step of that channel in the file header. Returns the pyramid level
+// used, 0 meaning the raw samples and L > 0 level L - 1 of the pyramid.
+unsigned int RecordingView::query(uint64_t first, uint64_t last, unsigned int nr_pixels, DisplayFrame & rows) const
+{
+	rows.clear();
+	if (last > nr_frames)
+		last = nr_frames;
+	if ((header == NULL) || (first >= last) || (nr_pixels == 0))
+		return 0;
+
+	unsigned int channels = header->nr_channels;
+	uint64_t span = last - first;
+	if (span < nr_pixels)
+		nr_pixels = span;
+	double frames_per_pixel = (double) span / nr_pixels;
+	rows.resize(nr_pixels, 1 + 3 * channels);
+
+	// The coarsest level whose entries still fit within a pixel
+	unsigned int source = 0;
+	uint64_t entry_frames = 1;
+	while ((source < pyramid->nr_levels) && (entry_frames * PYRAMID_FACTOR <= frames_per_pixel)) {
+		entry_frames *= PYRAMID_FACTOR;
+		source++;
+	}
+
+	const double* y_vps = header->y_vps;
+	std::vector<int16_t>	low(channels), high(channels);
+	std::vector<double>	sum(channels);
+	for (unsigned int p = 0; p < nr_pixels; p++) {
+		uint64_t bin_first = first + (uint64_t) (p * frames_per_pixel);
+		uint64_t bin_last = (p + 1 == nr_pixels)? last : first + (uint64_t) ((p + 1) * frames_per_pixel);
+		uint64_t i_first = bin_first / entry_frames;
+		uint64_t i_last = (bin_last + entry_frames - 1) / entry_frames;
+		if (i_last <= i_first)
+			i_last = i_first + 1;
+
+		low.assign(channels, INT16_MAX);
+		high.assign(channels, INT16_MIN);
+		sum.assign(channels, 0.0);
+		uint64_t weight = 0;
+		for (uint64_t i = i_first; i < i_last; i++) {
+			uint64_t n = entry_frames;
+			if ((i + 1) * entry_frames > nr_frames)
+				n = nr_frames - i * entry_frames;
+			if (source == 0) {
+				const int16_t* y = frame(i);
+				for (unsigned int c = 0; c < channels; c++) {
+					if (y[c] < low[c])
+						low[c] = y[c];
+					if (y[c] > high[c])
+						high[c] = y[c];
+					sum[c] += y[c];
+				}
+			} else {
+				const PyramidValue* value = entry(source - 1, i);
+				for (unsigned int c = 0; c < channels; c++) {
+					if (value[c].min < low[c])
+						low[c] = value[c].min;
+					if (value[c].max > high[c])
+						high[c] = value[c].max;
+					sum[c] += (double) value[c].mean * n;
+				}
+			}
+			weight += n;
+		}
+
+		rows.at(p, 0) = (double) bin_first / header->sample_rate;
+		for (unsigned int c = 0; c < channels; c++) {
+			rows.at(p, 1 + 3 * c) = low[c] * y_vps[c];
+			rows.at(p, 2 + 3 * c) = high[c] * y_vps[c];
+			rows.at(p, 3 + 3 * c) = sum[c] / weight * y_vps[c];
+		}
+	}
+
+	return source;
+}
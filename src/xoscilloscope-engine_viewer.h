@@ -0,0 +1,80 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the XELab software package.
+//
+// Version 1.1 - January 2024
+//
+//
+// The XELab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Leonardo Ricci, Alessio Perinelli, Marco Prevedelli
+//		leonardo.ricci@unitn.it
+//		alessio.perinelli@unitn.it
+//		marco.prevedelli@unibo.it
+//		nse.physics.unitn.it
+//		https://github.com/PhysicsBehindElectronics/XELab
+//
+// --------------------------------------------------------------------------
+
+#ifndef INCLUDED_ENGINE_VIEWER
+#define INCLUDED_ENGINE_VIEWER
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "xoscilloscope-engine_record.h"
+#include "xoscilloscope-engine_output.h"
+
+#define VIEWER_NR_PIXELS 1000
+
+// Read-only view of a recording ("*.xrec") and of its pyramid ("*.xrec.pyr").
+// Both files are memory-mapped, so opening is immediate whatever their size;
+// the pyramid is rebuilt from the samples only if missing or incomplete.
+// A query over any time window reads the pyramid level whose entries are
+// just finer than a pixel, hence costs O(pixels * PYRAMID_FACTOR) at most.
+class RecordingView
+{
+public:
+	RecordingView();
+	~RecordingView();
+
+	bool open(const std::string &);
+	void close();
+	uint64_t nrFrames() const;
+	unsigned int sampleRate() const;
+	unsigned int nrChannels() const;
+	void valueRange(unsigned int, double &, double &) const;
+	unsigned int query(uint64_t, uint64_t, unsigned int, DisplayFrame &) const;
+
+private:
+	bool mapPyramid(const std::string &);
+	bool buildPyramid(const std::string &);
+	const int16_t* frame(uint64_t) const;
+	const PyramidValue* entry(unsigned int, uint64_t) const;
+
+	const char*			record_map;
+	size_t				record_size;
+	const char*			pyramid_map;
+	size_t				pyramid_size;
+	const RecordFileHeader*		header;
+	const PyramidFileHeader*	pyramid;
+	unsigned int			chunk_capacity;
+	uint64_t			nr_chunks;
+	uint64_t			nr_frames;
+};
+
+#endif